@@ -49,9 +49,93 @@
 #define CASS_FUTURE_MAGIC 71077345
 #define CASS_BATCH_MAGIC 14215469
 #define CASS_PREPARED_MAGIC 713832281
+#define CASS_COUNTER_MAGIC 31245768
+#define CASS_CACHE_MAGIC 52817643
+#define CASS_WRITE_QUEUE_MAGIC 90311752
 
 #define CASSTCL_FUTURE_QUEUE_HEAD_FLAG 1
 #define CASSTCL_FUTURE_CALLBACK_ON_ERROR_ONLY 2
+#define CASSTCL_FUTURE_HANDLE 4
+#define CASSTCL_FUTURE_FIRE_AND_FORGET 8
+#define CASSTCL_FUTURE_CALLBACK_DELIVERED 16
+#define CASSTCL_FUTURE_HAS_DRIVER_CALLBACK 32
+#define CASSTCL_FUTURE_BREAKER 64
+#define CASSTCL_FUTURE_LATENCY_RECORDED 128
+#define CASSTCL_FUTURE_WAIT_WATCHED 256
+
+// which futures "$cass futures" lists
+#define CASSTCL_FUTURES_ALL 0
+#define CASSTCL_FUTURES_PENDING 1
+#define CASSTCL_FUTURES_READY 2
+
+#define CASSTCL_DEFAULT_FIREFORGET_CALLBACK_LIMIT 10
+
+// how many requests multiget and exec_many keep in flight by default
+#define CASSTCL_DEFAULT_BULK_CONCURRENCY 64
+
+// what we add to a batch's size estimate for each statement on top of
+// the statement's text and values, roughly its framing in the protocol
+#define CASSTCL_BATCH_STATEMENT_OVERHEAD 16
+
+// the most statements the coalesce and counter accumulator flushes put
+// in any one partition's batch
+#define CASSTCL_FLUSH_MAX_BATCH_STATEMENTS 100
+
+// default flush thresholds of a counter accumulator
+#define CASSTCL_DEFAULT_COUNTER_INTERVAL 1000
+#define CASSTCL_DEFAULT_COUNTER_MAX_KEYS 10000
+
+// defaults for a row cache, the ttl is in seconds
+#define CASSTCL_DEFAULT_CACHE_TTL 60
+#define CASSTCL_DEFAULT_CACHE_MAX_ENTRIES 10000
+
+// defaults for a write queue, the backoffs are in milliseconds
+#define CASSTCL_DEFAULT_WRITE_QUEUE_MAX_INFLIGHT 256
+#define CASSTCL_DEFAULT_WRITE_QUEUE_MAX_MEMORY (64 * 1024 * 1024)
+#define CASSTCL_DEFAULT_WRITE_QUEUE_RETRIES 8
+#define CASSTCL_DEFAULT_WRITE_QUEUE_BACKOFF 100
+#define CASSTCL_DEFAULT_WRITE_QUEUE_MAX_BACKOFF 30000
+
+// defaults for a circuit breaker, the window and cooldown are in
+// milliseconds.  the window is kept as this many buckets.
+#define CASSTCL_DEFAULT_BREAKER_ERROR_RATE 0.5
+#define CASSTCL_DEFAULT_BREAKER_TIMEOUT_RATE 0.5
+#define CASSTCL_DEFAULT_BREAKER_MIN_REQUESTS 20
+#define CASSTCL_DEFAULT_BREAKER_WINDOW 10000
+#define CASSTCL_DEFAULT_BREAKER_COOLDOWN 5000
+#define CASSTCL_DEFAULT_BREAKER_PROBES 1
+#define CASSTCL_BREAKER_BUCKETS 10
+
+// circuit breaker states
+#define CASSTCL_BREAKER_CLOSED 0
+#define CASSTCL_BREAKER_OPEN 1
+#define CASSTCL_BREAKER_HALF_OPEN 2
+
+// reasons the logging retry policy retries, or ignores, an error
+#define CASSTCL_RETRY_READ_TIMEOUT 0
+#define CASSTCL_RETRY_WRITE_TIMEOUT 1
+#define CASSTCL_RETRY_UNAVAILABLE 2
+#define CASSTCL_RETRY_REQUEST_ERROR 3
+#define CASSTCL_RETRY_IGNORED 4
+#define CASSTCL_RETRY_REASONS 5
+
+// latency histograms have a bucket per microsecond up to this many and
+// then split each power of two into this many, up to about 19 hours
+#define CASSTCL_LATENCY_SUB_BUCKETS 8
+#define CASSTCL_LATENCY_BUCKETS (CASSTCL_LATENCY_SUB_BUCKETS * 34)
+
+// slow query log records waiting to be written beyond this many are
+// dropped, and bound parameters are cut short after this many characters
+#define CASSTCL_SLOWLOG_MAX_PENDING 1000
+#define CASSTCL_SLOWLOG_MAX_PARAMS_LENGTH 200
+
+// the formats export_metrics can render metrics in
+#define CASSTCL_EXPORT_PROMETHEUS 0
+#define CASSTCL_EXPORT_STATSD 1
+
+// future handles look like "::cass0#17", the session command followed
+// by this separator and the future's id within that session
+#define CASSTCL_FUTURE_HANDLE_SEPARATOR '#'
 
 /*
  * This is the absolute limit on the whole number of seconds that we can
@@ -65,8 +149,16 @@
 #define CASS_TIMESTAMP_LOWER_LIMIT (-CASS_TIMESTAMP_UPPER_LIMIT)
 
 extern Tcl_ObjType casstcl_cassTypeTclType;
+extern Tcl_ObjType casstcl_futureHandleTclType;
 extern Tcl_Obj *casstcl_loggingCallbackObj;
 extern Tcl_ThreadId casstcl_loggingCallbackThreadId;
+
+// coroutine support (-coro) needs the non-recursive engine of Tcl 8.6.
+// casstcl_haveNRE says whether the Tcl we were loaded into has it.
+#if (TCL_MAJOR_VERSION > 8) || (TCL_MINOR_VERSION >= 6)
+#define CASSTCL_HAVE_NRE
+#endif
+extern int casstcl_haveNRE;
 /*
 ** NOTE: The types in this section were "borrowed" from version 1.0 of the
 **       cpp-driver.
@@ -96,6 +188,135 @@ typedef struct casstcl_cassTypeInfo {
 	CassValueType valueSubType2;
 } casstcl_cassTypeInfo;
 
+// success and failure accounting for fire-and-forget requests.  this is
+// updated from the cpp-driver's threads so everything in it is protected
+// by the mutex, except the callback object, which only the thread that
+// created the session touches
+typedef struct casstcl_writeStats
+{
+	Tcl_Mutex mutex;
+	Tcl_WideInt issued;
+	Tcl_WideInt succeeded;
+	Tcl_WideInt failed;
+	Tcl_WideInt suppressed;
+	Tcl_HashTable errorCounts;
+	int errorCallbackLimit;
+	long errorWindow;
+	int errorWindowCount;
+	Tcl_Obj *errorCallbackObj;
+} casstcl_writeStats;
+
+struct casstcl_sessionClientData;
+
+// called with the future of a request a rate limit held back once it
+// has been sent
+typedef void (casstcl_rateLimitSubmitProc) (struct casstcl_sessionClientData *ct, CassFuture *future, ClientData clientData);
+
+// a request waiting in a rate limit's queue for a token.  the statement
+// is freed once it's sent if ownsStatement is set
+typedef struct casstcl_rateLimitHeld
+{
+	struct casstcl_rateLimitHeld *next;
+	struct casstcl_rateLimit *limit;
+	Tcl_Obj *tableNameObj;
+	CassStatement *statement;
+	int ownsStatement;
+	casstcl_rateLimitSubmitProc *submitProc;
+	ClientData clientData;
+} casstcl_rateLimitHeld;
+
+// a token bucket limiting the rate requests are sent, for the whole
+// session or for one table, see the rate_limit method.  tokens can go
+// negative when requests that can't wait, like batch flushes, are
+// charged against it, so the ones after them wait longer.  requests
+// that can't be sent yet wait in its queue, which a timer releases as
+// tokens come in.
+typedef struct casstcl_rateLimit
+{
+	struct casstcl_sessionClientData *ct;
+	double rate;
+	double burst;
+	double tokens;
+	Tcl_WideInt updated;
+	Tcl_WideInt throttled;
+	casstcl_rateLimitHeld *heldHead;
+	casstcl_rateLimitHeld *heldTail;
+	Tcl_TimerToken timer;
+} casstcl_rateLimit;
+
+// one slice of a circuit breaker's window
+typedef struct casstcl_breakerBucket
+{
+	Tcl_WideInt start;
+	int requests;
+	int errors;
+	int timeouts;
+} casstcl_breakerBucket;
+
+// a circuit breaker for the whole session or for one table, see the
+// circuit_breaker method.  the session's is updated from the cpp-driver's
+// threads by fire-and-forget requests, so all of them are protected by
+// the session's breakerMutex
+typedef struct casstcl_breaker
+{
+	int enabled;
+	double errorRate;
+	double timeoutRate;
+	int minRequests;
+	int window;
+	int cooldown;
+	int probes;
+	int state;
+	Tcl_WideInt changed;
+	int probesIssued;
+	int probesSucceeded;
+	casstcl_breakerBucket buckets[CASSTCL_BREAKER_BUCKETS];
+	Tcl_WideInt trips;
+	Tcl_WideInt rejected;
+} casstcl_breaker;
+
+// the latencies, in microseconds, of the requests made with one tag,
+// prepared statement or table, see the latency method
+typedef struct casstcl_histogram
+{
+	Tcl_WideInt count;
+	Tcl_WideInt min;
+	Tcl_WideInt max;
+	double sum;
+	double sumSquares;
+	Tcl_WideInt buckets[CASSTCL_LATENCY_BUCKETS];
+} casstcl_histogram;
+
+// the slow query log, see the slowlog method.  records are built as slow
+// requests complete and written when the event loop is next idle.  a
+// threshold of 0 is off.
+typedef struct casstcl_slowLog
+{
+	Tcl_WideInt thresholdMS;
+	double sample;
+	Tcl_Obj *channelNameObj;
+	Tcl_Obj *callbackObj;
+	Tcl_Obj *pendingObj;
+	int flushScheduled;
+	Tcl_WideInt logged;
+	Tcl_WideInt sampledOut;
+	Tcl_WideInt dropped;
+} casstcl_slowLog;
+
+// the metrics exporter, see the export_metrics method.  every intervalMS
+// the session's metrics are rendered and written to the channel or
+// passed to the callback.  an interval of 0 is off.
+typedef struct casstcl_metricsExport
+{
+	int intervalMS;
+	int format;
+	Tcl_Obj *prefixObj;
+	Tcl_Obj *channelNameObj;
+	Tcl_Obj *callbackObj;
+	Tcl_TimerToken timer;
+	Tcl_WideInt exports;
+} casstcl_metricsExport;
+
 typedef struct casstcl_sessionClientData
 {
     int cass_session_magic;
@@ -106,6 +327,31 @@ typedef struct casstcl_sessionClientData
     Tcl_Command cmdToken;
 	Tcl_ThreadId threadId;
 	Tcl_Obj *loggingCallbackObj;
+	Tcl_HashTable futureTable;
+	unsigned long nextFutureId;
+	int futureDeleteAfterCallback;
+	int futureMaxAge;
+	Tcl_TimerToken futureSweepTimer;
+	Tcl_WideInt futuresReclaimed;
+	casstcl_writeStats writeStats;
+	Tcl_HashTable partitionKeyTable;
+	Tcl_HashTable coalesceTable;
+	Tcl_HashTable counterObjectTable;
+	Tcl_HashTable cacheObjectTable;
+	Tcl_HashTable writeQueueObjectTable;
+	casstcl_rateLimit rateLimit;
+	Tcl_HashTable rateLimitTable;
+	Tcl_Mutex breakerMutex;
+	casstcl_breaker breaker;
+	Tcl_HashTable breakerTable;
+	Tcl_HashTable profileTable;
+	Tcl_HashTable latencyTable;
+	casstcl_slowLog slowlog;
+	double traceSample;
+	Tcl_WideInt futuresCreated;
+	Tcl_WideInt callbackEvents;
+	Tcl_WideInt conversionErrors;
+	casstcl_metricsExport metricsExport;
 } casstcl_sessionClientData;
 
 typedef struct casstcl_futureClientData
@@ -114,8 +360,17 @@ typedef struct casstcl_futureClientData
 	int flags;
 	casstcl_sessionClientData *ct;
 	CassFuture *future;
+	casstcl_rateLimitHeld *held;
 	Tcl_Command cmdToken;
+	Tcl_HashEntry *entry;
 	Tcl_Obj *callbackObj;
+	Tcl_WideInt created;
+	Tcl_WideInt resultBytes;
+	Tcl_Obj *tableNameObj;
+	Tcl_Obj *latencyKeysObj;
+	Tcl_Obj *slowlogObj;
+	Tcl_WideInt submitted;
+	Tcl_WideInt completed;
 } casstcl_futureClientData;
 
 typedef struct casstcl_batchClientData
@@ -127,8 +382,38 @@ typedef struct casstcl_batchClientData
 	Tcl_Command cmdToken;
 	CassConsistency consistency;
 	int count;
+	Tcl_WideInt bytes;
+	int maxStatements;
+	Tcl_WideInt maxBytes;
+	Tcl_Obj *flushCallbackObj;
+	Tcl_WideInt flushes;
+	int byPartition;
+	Tcl_HashTable partitionTable;
+	Tcl_Obj *profileObj;
+	Tcl_WideInt timeoutMS;
+	int trace;
 } casstcl_batchClientData;
 
+// one partition's share of a batch grouped by partition
+typedef struct casstcl_batchPartition
+{
+	CassBatch *batch;
+	int count;
+	Tcl_WideInt bytes;
+} casstcl_batchPartition;
+
+// the column types, and for upserts the statement text, that add_many
+// and upsert_many work out for a row and reuse for each following row
+// with the same columns
+typedef struct casstcl_rowTemplate
+{
+	int nColumns;
+	Tcl_Obj **nameObjv;
+	casstcl_cassTypeInfo *typeInfo;
+	int nFields;
+	Tcl_DString query;
+} casstcl_rowTemplate;
+
 typedef struct casstcl_preparedClientData
 {
     int cass_prepared_magic;
@@ -136,9 +421,207 @@ typedef struct casstcl_preparedClientData
 	const CassPrepared *prepared;
 	char *string;
 	Tcl_Obj *tableNameObj;
+	int idempotent;
 	Tcl_Command cmdToken;
 } casstcl_preparedClientData;
 
+// a table whose upserts are held for a window so that repeated writes
+// of the same row collapse into one, see the coalesce method.  rowTable
+// maps each pending row's primary key values to its name-value list
+typedef struct casstcl_coalesceTable
+{
+	casstcl_sessionClientData *ct;
+	Tcl_Obj *tableNameObj;
+	Tcl_Obj *primaryKeyObj;
+	int window;
+	int merge;
+	Tcl_Obj *flushCallbackObj;
+	Tcl_HashTable rowTable;
+	Tcl_TimerToken timer;
+	Tcl_WideInt received;
+	Tcl_WideInt written;
+} casstcl_coalesceTable;
+
+// a counter accumulator, see the counters method.  counterTable maps
+// each table, column and key to the casstcl_counterEntry summing its
+// increments until they're flushed
+typedef struct casstcl_counterClientData
+{
+	int cass_counter_magic;
+	casstcl_sessionClientData *ct;
+	Tcl_Command cmdToken;
+	Tcl_HashTable counterTable;
+	int interval;
+	int maxKeys;
+	CassConsistency consistency;
+	Tcl_Obj *flushCallbackObj;
+	Tcl_TimerToken timer;
+	Tcl_WideInt increments;
+	Tcl_WideInt updates;
+	Tcl_WideInt flushes;
+} casstcl_counterClientData;
+
+typedef struct casstcl_counterEntry
+{
+	Tcl_Obj *tableObj;
+	Tcl_Obj *columnObj;
+	Tcl_Obj *keyObj;
+	Tcl_WideInt delta;
+} casstcl_counterEntry;
+
+typedef struct casstcl_cacheEntry casstcl_cacheEntry;
+
+// a read-through row cache in front of a prepared select, see the cache
+// method.  entryTable maps each key to its casstcl_cacheEntry, and the
+// entries are also kept on a list from newest to oldest use, so the
+// least recently used one is evicted when the cache is full
+typedef struct casstcl_cacheClientData
+{
+	int cass_cache_magic;
+	casstcl_sessionClientData *ct;
+	Tcl_Command cmdToken;
+	Tcl_Obj *preparedObj;
+	Tcl_Obj *columnsObj;
+	int ttl;
+	int maxEntries;
+	CassConsistency consistency;
+	Tcl_HashTable entryTable;
+	casstcl_cacheEntry *newest;
+	casstcl_cacheEntry *oldest;
+	int deleted;
+	Tcl_WideInt hits;
+	Tcl_WideInt misses;
+	Tcl_WideInt collapsed;
+	Tcl_WideInt fills;
+	Tcl_WideInt errors;
+	Tcl_WideInt evictions;
+	Tcl_WideInt expirations;
+	Tcl_WideInt invalidations;
+} casstcl_cacheClientData;
+
+// one key's rows.  while the select that fills it is in flight, future
+// is set and waitersObj holds the callbacks of the gets waiting for it.
+// an entry that is invalidated or evicted while it is being filled is
+// taken out of the cache (hashEntry is NULL) but lives until the fill
+// completes
+struct casstcl_cacheEntry
+{
+	casstcl_cacheClientData *cache;
+	Tcl_HashEntry *hashEntry;
+	Tcl_Obj *keyObj;
+	Tcl_Obj *rowsObj;
+	Tcl_Obj *errorObj;
+	Tcl_Obj *errorCodeObj;
+	Tcl_WideInt expires;
+	CassFuture *future;
+	Tcl_Obj *waitersObj;
+	casstcl_cacheEntry *newer;
+	casstcl_cacheEntry *older;
+};
+
+typedef struct casstcl_cacheEvent
+{
+	Tcl_Event event;
+	casstcl_cacheEntry *entry;
+} casstcl_cacheEvent;
+
+// a trace being fetched for "$future trace callback", both of its
+// queries run at once
+typedef struct casstcl_traceFetch
+{
+	casstcl_sessionClientData *ct;
+	CassFuture *sessionFuture;
+	CassFuture *eventsFuture;
+	Tcl_Obj *callbackObj;
+} casstcl_traceFetch;
+
+typedef struct casstcl_traceEvent
+{
+	Tcl_Event event;
+	casstcl_traceFetch *fetch;
+} casstcl_traceEvent;
+
+// a slow query log record of a traced request waiting for the query of
+// its coordinator before it's queued to be written
+typedef struct casstcl_slowlogLookup
+{
+	casstcl_sessionClientData *ct;
+	Tcl_Obj *recordObj;
+	CassFuture *future;
+} casstcl_slowlogLookup;
+
+typedef struct casstcl_slowlogEvent
+{
+	Tcl_Event event;
+	casstcl_slowlogLookup *lookup;
+} casstcl_slowlogEvent;
+
+typedef struct casstcl_writeQueueClientData casstcl_writeQueueClientData;
+
+// one write in a write queue.  writeObj is the list of upsert arguments,
+// which is also what goes in the journal.  size is what it's counted as
+// against -max_memory.
+typedef struct casstcl_writeQueueItem
+{
+	casstcl_writeQueueClientData *queue;
+	Tcl_Obj *writeObj;
+	int size;
+	int attempts;
+	Tcl_WideInt readyAt;
+	struct casstcl_writeQueueItem *prev;
+	struct casstcl_writeQueueItem *next;
+} casstcl_writeQueueItem;
+
+typedef struct casstcl_writeQueueList
+{
+	casstcl_writeQueueItem *head;
+	casstcl_writeQueueItem *tail;
+	int count;
+} casstcl_writeQueueList;
+
+// a write queue, see the write_queue method.  a write is on exactly one
+// of the lists: waiting to be sent, in flight, or waiting out its
+// backoff before being retried (in order of when it's ready).  writes
+// that don't fit in -max_memory go to the journal file, and journaled
+// is how many of them there are from journalOffset on.
+struct casstcl_writeQueueClientData
+{
+	int cass_write_queue_magic;
+	casstcl_sessionClientData *ct;
+	Tcl_Command cmdToken;
+	int maxInflight;
+	Tcl_WideInt maxMemory;
+	int retries;
+	int backoff;
+	int maxBackoff;
+	CassConsistency consistency;
+	Tcl_Obj *journalObj;
+	Tcl_Obj *failCallbackObj;
+	casstcl_writeQueueList waiting;
+	casstcl_writeQueueList inflight;
+	casstcl_writeQueueList retrying;
+	Tcl_WideInt memory;
+	Tcl_Channel journalChannel;
+	Tcl_WideInt journalOffset;
+	Tcl_WideInt journaled;
+	Tcl_TimerToken timer;
+	unsigned long jitterSeed;
+	int shutDown;
+	Tcl_WideInt queued;
+	Tcl_WideInt written;
+	Tcl_WideInt retried;
+	Tcl_WideInt failed;
+	Tcl_WideInt spilled;
+	Tcl_WideInt replayed;
+};
+
+typedef struct casstcl_writeQueueEvent
+{
+	Tcl_Event event;
+	casstcl_writeQueueItem *item;
+	CassFuture *future;
+} casstcl_writeQueueEvent;
+
 typedef struct casstcl_loggingEvent
 {
 	Tcl_Event event;
@@ -146,12 +629,106 @@ typedef struct casstcl_loggingEvent
 	CassLogMessage message;
 } casstcl_loggingEvent;
 
+// called with the completed future once a command that yielded on it is
+// resumed, or right away if it didn't need to yield
+typedef int (casstcl_coroDoneProc) (casstcl_sessionClientData *ct, CassFuture *future, ClientData clientData);
+
+// casstcl_bulk_execute calls these to make the statement for each item
+// and then to take each item's completed future.  the bind proc returns
+// TCL_CONTINUE to skip an item; TCL_ERROR from either stops issuing more
+typedef int (casstcl_bulkBindProc) (casstcl_sessionClientData *ct, int index, ClientData clientData, CassStatement **statementPtr);
+typedef int (casstcl_bulkDoneProc) (casstcl_sessionClientData *ct, int index, CassFuture *future, ClientData clientData);
+
 typedef struct casstcl_futureEvent
 {
 	Tcl_Event event;
 	casstcl_futureClientData *fcd;
 } casstcl_futureEvent;
 
+// state for a command that yields the current coroutine until a future
+// completes.  it is referenced by the queued completion event and by the
+// suspended command and is only touched in the session's thread.  held
+// is set while the request is waiting for a rate limit, and the time it
+// is sent goes in *submittedPtr.
+typedef struct casstcl_coroWait
+{
+	int refCount;
+	int waiting;
+	int completed;
+	int ownsFuture;
+	casstcl_sessionClientData *ct;
+	CassFuture *future;
+	casstcl_rateLimitHeld *held;
+	Tcl_WideInt *submittedPtr;
+	Tcl_Obj *coroObj;
+	casstcl_coroDoneProc *doneProc;
+	ClientData clientData;
+} casstcl_coroWait;
+
+// what "select -coro" needs to carry from one page to the next
+typedef struct casstcl_selectState
+{
+	CassStatement *statement;
+	Tcl_Obj *arrayNameObj;
+	Tcl_Obj *codeObj;
+	int withNulls;
+	Tcl_WideInt timeoutMS;
+	Tcl_WideInt deadline;
+	Tcl_Obj *latencyKeysObj;
+	Tcl_WideInt submitted;
+	Tcl_Obj *slowlogObj;
+	int pages;
+	Tcl_WideInt requestUS;
+	int traced;
+	CassUuid tracingId;
+} casstcl_selectState;
+
+// what "exec -coro" needs once the request completes
+typedef struct casstcl_execState
+{
+	Tcl_Obj *tableNameObj;
+	Tcl_Obj *latencyKeysObj;
+	Tcl_Obj *slowlogObj;
+	Tcl_WideInt submitted;
+} casstcl_execState;
+
+// what multiget needs to bind each key and hold on to its results
+typedef struct casstcl_multigetState
+{
+	casstcl_preparedClientData *pcd;
+	CassConsistency *consistencyPtr;
+	Tcl_Obj **keyObjv;
+	int columnObjc;
+	Tcl_Obj **columnObjv;
+	Tcl_Obj **pairObjv;
+	Tcl_Obj **rowsObjv;
+	Tcl_Obj **errorObjv;
+} casstcl_multigetState;
+
+// what exec_many needs to bind each row and count how they went
+typedef struct casstcl_execManyState
+{
+	casstcl_preparedClientData *pcd;
+	CassConsistency *consistencyPtr;
+	Tcl_Obj **rowObjv;
+	int succeeded;
+	Tcl_Obj *failedObj;
+} casstcl_execManyState;
+
+typedef struct casstcl_coroEvent
+{
+	Tcl_Event event;
+	casstcl_coroWait *cw;
+} casstcl_coroEvent;
+
+typedef struct casstcl_fireForgetEvent
+{
+	Tcl_Event event;
+	casstcl_sessionClientData *ct;
+	CassFuture *future;
+	int flags;
+} casstcl_fireForgetEvent;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -159,6 +736,18 @@ extern "C" {
 extern int
 casstcl_cassObjCmd(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objvp[]);
 
+extern int
+casstcl_futureHandleObjCmd(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objvp[]);
+
+extern int
+casstcl_futureHandleNRObjCmd(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objvp[]);
+
+extern int
+casstcl_waitAllObjCmd(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objvp[]);
+
+extern int
+casstcl_waitAnyObjCmd(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objvp[]);
+
 extern casstcl_futureClientData *
 casstcl_future_command_to_futureClientData (Tcl_Interp *interp, char *futureCommandName);
 
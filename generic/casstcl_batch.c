@@ -13,9 +13,38 @@
 #include "casstcl_cassandra.h"
 #include "casstcl_error.h"
 #include "casstcl_consistency.h"
+#include "casstcl_future.h"
+#include "casstcl_prepared.h"
+#include "casstcl_types.h"
+#include "casstcl_ratelimit.h"
+#include "casstcl_profile.h"
+#include "casstcl_trace.h"
 
 #include <assert.h>
 
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_batch_free_partitions -- throw away the per-partition
+ *   batches of a batch grouped by partition
+ *
+ *--------------------------------------------------------------
+ */
+void
+casstcl_batch_free_partitions (casstcl_batchClientData *bcd)
+{
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+
+	while ((entry = Tcl_FirstHashEntry (&bcd->partitionTable, &search)) != NULL) {
+		casstcl_batchPartition *part = (casstcl_batchPartition *)Tcl_GetHashValue (entry);
+
+		cass_batch_free (part->batch);
+		ckfree ((char *)part);
+		Tcl_DeleteHashEntry (entry);
+	}
+}
+
 /*
  *--------------------------------------------------------------
  *
@@ -37,8 +66,32 @@ casstcl_batchObjectDelete (ClientData clientData)
 
     assert (bcd->cass_batch_magic == CASS_BATCH_MAGIC);
 
+	casstcl_batch_free_client_data (bcd);
+}
+
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_batch_free_client_data -- free a batch client data and
+ *   everything in it
+ *
+ *--------------------------------------------------------------
+ */
+void
+casstcl_batch_free_client_data (casstcl_batchClientData *bcd)
+{
 	cass_batch_free (bcd->batch);
-    ckfree((char *)clientData);
+	casstcl_batch_free_partitions (bcd);
+	Tcl_DeleteHashTable (&bcd->partitionTable);
+
+	if (bcd->flushCallbackObj != NULL) {
+		Tcl_DecrRefCount (bcd->flushCallbackObj);
+	}
+
+	if (bcd->profileObj != NULL) {
+		Tcl_DecrRefCount (bcd->profileObj);
+	}
+    ckfree((char *)bcd);
 }
 
 /*
@@ -167,22 +220,21 @@ casstcl_batch_command_to_batchClientData (Tcl_Interp *interp, char *batchCommand
 /*
  *----------------------------------------------------------------------
  *
- * casstcl_createBatchObjectCommand --
+ * casstcl_batch_new_client_data --
  *
- *    given a casstcl_sessionClientData pointer, an object name (or "#auto"),
- *    and a CASS_BATCH_TYPE, create a corresponding batch object command
+ *    allocate and set up a batch client data with an empty CassBatch of
+ *    the given type, not yet attached to a command
  *
  * Results:
- *    A standard Tcl result
+ *    The new batch client data
  *
  *----------------------------------------------------------------------
  */
-int
-casstcl_createBatchObjectCommand (casstcl_sessionClientData *ct, char *commandName, CassBatchType cassBatchType)
+casstcl_batchClientData *
+casstcl_batch_new_client_data (casstcl_sessionClientData *ct, CassBatchType cassBatchType)
 {
 	// allocate one of our cass client data objects for Tcl and configure it
 	casstcl_batchClientData *bcd = (casstcl_batchClientData *)ckalloc (sizeof (casstcl_batchClientData));
-	Tcl_Interp *interp = ct->interp;
 
 	bcd->cass_batch_magic = CASS_BATCH_MAGIC;
 	bcd->ct = ct;
@@ -190,6 +242,39 @@ casstcl_createBatchObjectCommand (casstcl_sessionClientData *ct, char *commandNa
 	bcd->batchType = cassBatchType;
 	bcd->consistency = CASS_CONSISTENCY_ONE;
 	bcd->count = 0;
+	bcd->bytes = 0;
+	bcd->maxStatements = 0;
+	bcd->maxBytes = 0;
+	bcd->flushCallbackObj = NULL;
+	bcd->flushes = 0;
+	bcd->byPartition = 0;
+	Tcl_InitHashTable (&bcd->partitionTable, TCL_STRING_KEYS);
+	bcd->profileObj = NULL;
+	bcd->timeoutMS = -1;
+	bcd->trace = 0;
+	bcd->cmdToken = NULL;
+
+	return bcd;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_createBatchObjectCommand --
+ *
+ *    given a casstcl_sessionClientData pointer, an object name (or "#auto"),
+ *    and a CASS_BATCH_TYPE, create a corresponding batch object command
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_createBatchObjectCommand (casstcl_sessionClientData *ct, char *commandName, CassBatchType cassBatchType)
+{
+	casstcl_batchClientData *bcd = casstcl_batch_new_client_data (ct, cassBatchType);
+	Tcl_Interp *interp = ct->interp;
 
 #define BATCH_STRING_FORMAT "batch%lu"
 	// if commandName is #auto, generate a unique name for the object
@@ -217,147 +302,1297 @@ casstcl_createBatchObjectCommand (casstcl_sessionClientData *ct, char *commandNa
 /*
  *----------------------------------------------------------------------
  *
- * casstcl_batchObjectObjCmd --
+ * casstcl_batch_apply_settings --
  *
- *    dispatches the subcommands of a casstcl batch-handling command
+ *    give a CassBatch belonging to a batch object the object's -profile
+ *    and -timeout, or the cluster's settings if it has none.  it's
+ *    traced if the object has -trace set or it's picked by the
+ *    session's trace_sample rate, which is decided again each time
+ *    this is called.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_batch_apply_settings (casstcl_batchClientData *bcd, CassBatch *batch)
+{
+	cass_batch_set_execution_profile (batch, (bcd->profileObj != NULL) ? Tcl_GetString (bcd->profileObj) : NULL);
+	cass_batch_set_request_timeout (batch, (bcd->timeoutMS >= 0) ? (cass_uint64_t)bcd->timeoutMS : CASS_UINT64_MAX);
+	cass_batch_set_tracing (batch, casstcl_trace_wanted (bcd->ct, bcd->trace) ? cass_true : cass_false);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_reset --
+ *
+ *    throw away everything in the batch and start over with a fresh
+ *    CassBatch of the same type, consistency, profile and timeout
  *
  * Results:
- *    stuff
+ *    A standard Tcl result
  *
  *----------------------------------------------------------------------
  */
 int
-casstcl_batchObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[])
+casstcl_batch_reset (casstcl_batchClientData *bcd)
 {
-    int         optIndex;
-	casstcl_batchClientData *bcd = (casstcl_batchClientData *)cData;
-	int resultCode = TCL_OK;
-
-    static CONST char *options[] = {
-        "add",
-		"upsert",
-		"count",
-        "consistency",
-		"reset",
-        "delete",
-        NULL
-    };
+	cass_batch_free (bcd->batch);
+	casstcl_batch_free_partitions (bcd);
+	bcd->batch = cass_batch_new (bcd->batchType);
+	bcd->count = 0;
+	bcd->bytes = 0;
 
-    enum options {
-        OPT_ADD,
-        OPT_UPSERT,
-		OPT_COUNT,
-        OPT_CONSISTENCY,
-		OPT_RESET,
-		OPT_DELETE
-    };
+	casstcl_batch_apply_settings (bcd, bcd->batch);
 
-    /* basic validation of command line arguments */
-    if (objc < 2) {
-        Tcl_WrongNumArgs (interp, 1, objv, "subcommand ?args?");
-        return TCL_ERROR;
-    }
+	return casstcl_cass_error_to_tcl (bcd->ct, cass_batch_set_consistency (bcd->batch, bcd->consistency));
+}
 
-    if (Tcl_GetIndexFromObj (interp, objv[1], options, "option", TCL_EXACT, &optIndex) != TCL_OK) {
-		return TCL_ERROR;
-    }
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_execute_async --
+ *
+ *    execute a CassBatch belonging to a batch object asynchronously.
+ *
+ *    if the batch object has a flush callback, a future object is
+ *    created to invoke it when the batch completes, just like async
+ *    -callback.  that doesn't wait for the batch, so adds that flush
+ *    and flushes from timers never block, and the callback gets the
+ *    future whether the batch succeeded or failed.  otherwise the
+ *    batch is executed fire-and-forget, so failures are counted by
+ *    write_stats and go to the session's fireforget_callback.
+ *
+ *    batches are flushed from timers and the like, so they don't wait
+ *    for the session's rate limit, but they count against it.
+ *
+ *    the batch is executed with the batch object's -profile and -timeout,
+ *    if any.
+ *
+ * Results:
+ *    A standard Tcl result.  The interpreter result is left alone.
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_batch_execute_async (casstcl_batchClientData *bcd, CassBatch *batch)
+{
+	casstcl_sessionClientData *ct = bcd->ct;
+	Tcl_Interp *interp = ct->interp;
+	CassFuture *future;
+	int tclReturn = TCL_OK;
 
-    switch ((enum options) optIndex) {
-		case OPT_ADD: {
-			CassStatement* statement = NULL;
-			if (casstcl_make_statement_from_objv (bcd->ct, objc, objv, 2, &statement) == TCL_ERROR) {
-				return TCL_ERROR;
-			}
+	casstcl_batch_apply_settings (bcd, batch);
 
-			CassError cassError = cass_batch_add_statement (bcd->batch, statement);
-			cass_statement_free (statement);
+	casstcl_rate_limit_charge (ct, NULL);
+	future = cass_session_execute_batch (ct->session, batch);
+	bcd->flushes++;
 
-			if (cassError == CASS_OK) {
-				bcd->count++;
-			} else {
-				Tcl_AppendResult (interp, " while adding statement to batch", NULL);
-				return casstcl_cass_error_to_tcl (bcd->ct, cassError);
-			}
+	if (bcd->flushCallbackObj != NULL) {
+		Tcl_Obj *savedResultObj = Tcl_GetObjResult (interp);
 
-			break;
+		Tcl_IncrRefCount (savedResultObj);
+		tclReturn = casstcl_createFutureObjectCommand (ct, future, bcd->flushCallbackObj, CASSTCL_FUTURE_BREAKER, NULL, NULL, NULL);
+		if (tclReturn == TCL_OK) {
+			Tcl_SetObjResult (interp, savedResultObj);
 		}
+		Tcl_DecrRefCount (savedResultObj);
+	} else {
+		casstcl_fireforget (ct, future, CASSTCL_FUTURE_FIRE_AND_FORGET);
+	}
 
-		case OPT_UPSERT: {
-			CassStatement* statement = NULL;
+	return tclReturn;
+}
 
-			resultCode = casstcl_make_upsert_statement_from_objv (bcd->ct, objc - 2, &objv[2], NULL, &statement);
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_flush_partition --
+ *
+ *    execute one partition's batch of a batch grouped by partition
+ *    asynchronously and forget about the partition
+ *
+ * Results:
+ *    A standard Tcl result.  The interpreter result is left alone.
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_batch_flush_partition (casstcl_batchClientData *bcd, Tcl_HashEntry *entry)
+{
+	casstcl_batchPartition *part = (casstcl_batchPartition *)Tcl_GetHashValue (entry);
+	int tclReturn = casstcl_batch_execute_async (bcd, part->batch);
 
-			if (resultCode != TCL_ERROR) {
-//printf("calling cass_batch_add_statement\n");
-				CassError cassError;
-				cassError = cass_batch_add_statement (bcd->batch, statement);
-				cass_statement_free (statement);
-//printf("returned from cass_batch_add_statement, cassError %d\n", cassError);
+	bcd->count -= part->count;
+	bcd->bytes -= part->bytes;
 
-				if (cassError == CASS_OK) {
-				bcd->count++;
-				} else {
-					return casstcl_cass_error_to_tcl (bcd->ct, cassError);
-				}
-			}
+	cass_batch_free (part->batch);
+	ckfree ((char *)part);
+	Tcl_DeleteHashEntry (entry);
+	return tclReturn;
+}
 
-			break;
-		}
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_flush --
+ *
+ *    if the batch has anything in it, execute it asynchronously and
+ *    swap in a fresh CassBatch so more can be added right away.  a
+ *    batch grouped by partition executes one batch per partition.
+ *
+ *    see casstcl_batch_execute_async for what happens when they
+ *    complete.
+ *
+ * Results:
+ *    A standard Tcl result.  The interpreter result is left alone.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_batch_flush (casstcl_batchClientData *bcd)
+{
+	int tclReturn = TCL_OK;
 
-		// count - return a count of rows in the batch
-		case OPT_COUNT: {
-			if (objc != 2) {
-				Tcl_WrongNumArgs (interp, 2, objv, "");
-				return TCL_ERROR;
+	if (bcd->count == 0) {
+		return TCL_OK;
+	}
+
+	if (bcd->byPartition) {
+		Tcl_HashSearch search;
+		Tcl_HashEntry *entry;
+
+		while ((entry = Tcl_FirstHashEntry (&bcd->partitionTable, &search)) != NULL) {
+			if (casstcl_batch_flush_partition (bcd, entry) == TCL_ERROR) {
+				tclReturn = TCL_ERROR;
 			}
+		}
 
-			Tcl_SetObjResult (interp, Tcl_NewIntObj (bcd->count));
-			break;
+		return tclReturn;
+	}
+
+	tclReturn = casstcl_batch_execute_async (bcd, bcd->batch);
+
+	if (casstcl_batch_reset (bcd) == TCL_ERROR) {
+		return TCL_ERROR;
+	}
+
+	return tclReturn;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_estimate_bytes --
+ *
+ *    estimate how much a statement made from the arguments of an add
+ *    or upsert will add to the serialized size of the batch.  this is
+ *    just the length of the query and values as strings plus a bit for
+ *    framing, which is close enough to stay under Cassandra's
+ *    batch_size_fail_threshold_in_kb.
+ *
+ * Results:
+ *    The estimate in bytes
+ *
+ *----------------------------------------------------------------------
+ */
+static Tcl_WideInt
+casstcl_batch_estimate_bytes (int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_WideInt bytes = CASSTCL_BATCH_STATEMENT_OVERHEAD;
+	int i;
+
+	for (i = 0; i < objc; i++) {
+		int length;
+
+		Tcl_GetStringFromObj (objv[i], &length);
+		bytes += length;
+	}
+
+	return bytes;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_add_with_flush --
+ *
+ *    add a statement to the batch, flushing the batch first if the
+ *    statement would take it over its byte limit and afterwards if it
+ *    has reached its statement or byte limit.  a statement that's
+ *    bigger than the byte limit all by itself goes in a batch alone.
+ *
+ *    the statement is freed either way.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_batch_add_with_flush (casstcl_batchClientData *bcd, CassStatement *statement, Tcl_WideInt estimate)
+{
+	CassError cassError;
+
+	if (bcd->maxBytes > 0 && bcd->count > 0 && bcd->bytes + estimate > bcd->maxBytes) {
+		if (casstcl_batch_flush (bcd) == TCL_ERROR) {
+			cass_statement_free (statement);
+			return TCL_ERROR;
 		}
+	}
 
+	cassError = cass_batch_add_statement (bcd->batch, statement);
+	cass_statement_free (statement);
 
-		case OPT_CONSISTENCY: {
-			CassConsistency cassConsistency;
+	if (cassError != CASS_OK) {
+		return casstcl_cass_error_to_tcl (bcd->ct, cassError);
+	}
 
-			if ((objc < 2) || (objc > 3)) {
-				Tcl_WrongNumArgs (interp, 2, objv, "?consistency?");
-				return TCL_ERROR;
-			}
+	bcd->count++;
+	bcd->bytes += estimate;
 
-			if (objc == 2) {
-				Tcl_SetObjResult (interp, Tcl_NewStringObj (casstcl_cass_consistency_to_string (bcd->consistency), -1));
-				return TCL_OK;
-			}
+	if ((bcd->maxStatements > 0 && bcd->count >= bcd->maxStatements) || (bcd->maxBytes > 0 && bcd->bytes >= bcd->maxBytes)) {
+		return casstcl_batch_flush (bcd);
+	}
 
-			if (casstcl_obj_to_cass_consistency(bcd->ct, objv[2], &cassConsistency) == TCL_ERROR) {
-				return TCL_ERROR;
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_partition_of --
+ *
+ *    figure out which partition the statement made from the arguments
+ *    of an add or upsert writes to, from the values it gives for the
+ *    table's partition key columns.  this works for upserts and for
+ *    adds with -prepared or -table and -array.
+ *
+ *    for upserts, which are plain statements, also tell the driver
+ *    which values make up the partition key and what the keyspace is,
+ *    so the batch they end up in can be routed token aware the same as
+ *    batches of prepared statements are.  typeInfo, if not NULL, is the
+ *    column types of a row template the upsert's row matches, which
+ *    saves looking them up again to work out where the key columns are
+ *    bound.
+ *
+ * Results:
+ *    A new object holding a list of the table name and the partition
+ *    key values, or an empty object if the partition can't be figured
+ *    out, in which case the statement goes in with the others that
+ *    couldn't be.
+ *
+ *----------------------------------------------------------------------
+ */
+static Tcl_Obj *
+casstcl_batch_partition_of (casstcl_batchClientData *bcd, int upsert, casstcl_cassTypeInfo *typeInfo, int objc, Tcl_Obj *CONST objv[], CassStatement *statement)
+{
+	casstcl_sessionClientData *ct = bcd->ct;
+	Tcl_Interp *interp = ct->interp;
+	char *tableName = NULL;
+	char *arrayName = NULL;
+	Tcl_Obj **pairObjv = NULL;
+	int pairObjc = 0;
+	Tcl_Obj *partitionKeyObj;
+	Tcl_Obj **columnObjv;
+	int columnObjc;
+	Tcl_Obj *keyObj;
+	int arg = 0;
+	int i;
+
+	if (upsert) {
+		if (objc < 2 || Tcl_ListObjGetElements (NULL, objv[objc - 1], &pairObjc, &pairObjv) == TCL_ERROR) {
+			return Tcl_NewObj ();
+		}
+		tableName = Tcl_GetString (objv[objc - 2]);
+	} else {
+		while (arg + 1 < objc) {
+			char *option = Tcl_GetString (objv[arg]);
+
+			if (strcmp (option, "-prepared") == 0) {
+				casstcl_preparedClientData *pcd = casstcl_prepared_command_to_preparedClientData (interp, Tcl_GetString (objv[arg + 1]));
+
+				if (pcd == NULL) {
+					return Tcl_NewObj ();
+				}
+				tableName = Tcl_GetString (pcd->tableNameObj);
+			} else if (strcmp (option, "-table") == 0) {
+				tableName = Tcl_GetString (objv[arg + 1]);
+			} else if (strcmp (option, "-array") == 0) {
+				arrayName = Tcl_GetString (objv[arg + 1]);
+			} else if (strcmp (option, "-consistency") != 0) {
+				break;
 			}
+			arg += 2;
+		}
 
-			CassError cassError = cass_batch_set_consistency (bcd->batch, cassConsistency);
-			bcd->consistency = cassConsistency;
-			if (cassError != CASS_OK) {
-				return casstcl_cass_error_to_tcl (bcd->ct, cassError);
+		// with -prepared, what's left is the list of name-value pairs
+		if (arrayName == NULL && arg < objc) {
+			if (Tcl_ListObjGetElements (NULL, objv[arg], &pairObjc, &pairObjv) == TCL_ERROR) {
+				return Tcl_NewObj ();
 			}
-			break;
 		}
+	}
 
-		case OPT_RESET: {
+	if (tableName == NULL || casstcl_table_partition_key (ct, tableName, &partitionKeyObj) == TCL_ERROR || partitionKeyObj == NULL) {
+		return Tcl_NewObj ();
+	}
+
+	Tcl_ListObjGetElements (NULL, partitionKeyObj, &columnObjc, &columnObjv);
+
+	keyObj = Tcl_NewObj ();
+	Tcl_ListObjAppendElement (NULL, keyObj, Tcl_NewStringObj (tableName, -1));
+
+	for (i = 0; i < columnObjc; i++) {
+		char *columnName = Tcl_GetString (columnObjv[i]);
+		Tcl_Obj *valueObj = NULL;
+
+		if (arrayName != NULL) {
+			valueObj = Tcl_GetVar2Ex (interp, arrayName, columnName, 0);
+		} else {
+			int j;
+
+			for (j = 0; j < pairObjc; j += 2) {
+				if (strcmp (Tcl_GetString (pairObjv[j]), columnName) == 0) {
+					valueObj = pairObjv[j + 1];
+					break;
+				}
+			}
+
+			// an upsert binds the known columns in order, so the key
+			// column's value is bound at the number of known ones before it
+			if (upsert && valueObj != NULL) {
+				casstcl_cassTypeInfo columnTypeInfo;
+				int bindIndex = 0;
+				int k;
+
+				for (k = 0; k < j; k += 2) {
+					if (typeInfo != NULL) {
+						if (typeInfo[k / 2].cassValueType != CASS_VALUE_TYPE_UNKNOWN) {
+							bindIndex++;
+						}
+					} else if (casstcl_typename_obj_to_cass_value_types (interp, tableName, pairObjv[k], &columnTypeInfo) == TCL_OK) {
+						bindIndex++;
+					}
+				}
+				cass_statement_add_key_index (statement, bindIndex);
+			}
+		}
+
+		if (valueObj == NULL) {
+			Tcl_DecrRefCount (keyObj);
+			return Tcl_NewObj ();
+		}
+
+		Tcl_ListObjAppendElement (NULL, keyObj, valueObj);
+	}
+
+	if (upsert) {
+		Tcl_DString keyspace;
+
+		Tcl_DStringInit (&keyspace);
+		Tcl_DStringAppend (&keyspace, tableName, strchr (tableName, '.') - tableName);
+		cass_statement_set_keyspace (statement, Tcl_DStringValue (&keyspace));
+		Tcl_DStringFree (&keyspace);
+	}
+
+	return keyObj;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_add_to_partition --
+ *
+ *    add a statement to the batch for its partition in a batch grouped
+ *    by partition, creating the partition's batch if need be.  the
+ *    statement and byte limits apply to each partition's batch, which
+ *    is flushed on its own, the same as casstcl_batch_add_with_flush
+ *    does for a whole batch.
+ *
+ *    the statement is freed either way.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_batch_add_to_partition (casstcl_batchClientData *bcd, Tcl_Obj *keyObj, CassStatement *statement, Tcl_WideInt estimate)
+{
+	casstcl_batchPartition *part;
+	Tcl_HashEntry *entry;
+	CassError cassError;
+	int isNew;
+
+	entry = Tcl_FindHashEntry (&bcd->partitionTable, Tcl_GetString (keyObj));
+
+	if (entry != NULL && bcd->maxBytes > 0) {
+		part = (casstcl_batchPartition *)Tcl_GetHashValue (entry);
+
+		if (part->bytes + estimate > bcd->maxBytes) {
+			if (casstcl_batch_flush_partition (bcd, entry) == TCL_ERROR) {
+				cass_statement_free (statement);
+				return TCL_ERROR;
+			}
+		}
+	}
+
+	entry = Tcl_CreateHashEntry (&bcd->partitionTable, Tcl_GetString (keyObj), &isNew);
+	if (isNew) {
+		part = (casstcl_batchPartition *)ckalloc (sizeof (casstcl_batchPartition));
+		part->batch = cass_batch_new (bcd->batchType);
+		part->count = 0;
+		part->bytes = 0;
+		cass_batch_set_consistency (part->batch, bcd->consistency);
+		Tcl_SetHashValue (entry, part);
+	} else {
+		part = (casstcl_batchPartition *)Tcl_GetHashValue (entry);
+	}
+
+	cassError = cass_batch_add_statement (part->batch, statement);
+	cass_statement_free (statement);
+
+	if (cassError != CASS_OK) {
+		return casstcl_cass_error_to_tcl (bcd->ct, cassError);
+	}
+
+	part->count++;
+	part->bytes += estimate;
+	bcd->count++;
+	bcd->bytes += estimate;
+
+	if ((bcd->maxStatements > 0 && part->count >= bcd->maxStatements) || (bcd->maxBytes > 0 && part->bytes >= bcd->maxBytes)) {
+		return casstcl_batch_flush_partition (bcd, entry);
+	}
+
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_add_typed_statement --
+ *
+ *    casstcl_batch_add_statement for an upsert whose row matches a row
+ *    template, with typeInfo the template's column types, or NULL if
+ *    there isn't one
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_batch_add_typed_statement (casstcl_batchClientData *bcd, int upsert, casstcl_cassTypeInfo *typeInfo, int objc, Tcl_Obj *CONST objv[], CassStatement *statement)
+{
+	Tcl_WideInt estimate = casstcl_batch_estimate_bytes (objc, objv);
+	Tcl_Obj *keyObj;
+	int tclReturn;
+
+	if (!bcd->byPartition) {
+		return casstcl_batch_add_with_flush (bcd, statement, estimate);
+	}
+
+	keyObj = casstcl_batch_partition_of (bcd, upsert, typeInfo, objc, objv, statement);
+	Tcl_IncrRefCount (keyObj);
+	tclReturn = casstcl_batch_add_to_partition (bcd, keyObj, statement, estimate);
+	Tcl_DecrRefCount (keyObj);
+	return tclReturn;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_add_statement --
+ *
+ *    add a statement made from the arguments of an add or upsert (objv
+ *    starting after the method name) to the batch, or to the batch for
+ *    its partition if the batch is grouped by partition
+ *
+ *    the statement is freed either way.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_batch_add_statement (casstcl_batchClientData *bcd, int upsert, int objc, Tcl_Obj *CONST objv[], CassStatement *statement)
+{
+	return casstcl_batch_add_typed_statement (bcd, upsert, NULL, objc, objv, statement);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_template_free --
+ *
+ *    free what a row template holds and make it empty
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_batch_template_free (casstcl_rowTemplate *tmpl)
+{
+	int i;
+
+	for (i = 0; i < tmpl->nColumns; i++) {
+		Tcl_DecrRefCount (tmpl->nameObjv[i]);
+	}
+
+	if (tmpl->nameObjv != NULL) {
+		ckfree ((char *)tmpl->nameObjv);
+		ckfree ((char *)tmpl->typeInfo);
+	}
+
+	tmpl->nColumns = 0;
+	tmpl->nameObjv = NULL;
+	tmpl->typeInfo = NULL;
+	tmpl->nFields = 0;
+	Tcl_DStringFree (&tmpl->query);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_template_matches --
+ *
+ *    return nonzero if a row of name-value pairs has the same columns in
+ *    the same order as the row the template was made for
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_batch_template_matches (casstcl_rowTemplate *tmpl, int rowObjc, Tcl_Obj **rowObjv)
+{
+	int i;
+
+	if (tmpl->nameObjv == NULL || rowObjc != tmpl->nColumns * 2) {
+		return 0;
+	}
+
+	for (i = 0; i < tmpl->nColumns; i++) {
+		Tcl_Obj *nameObj = rowObjv[i * 2];
+
+		if (nameObj != tmpl->nameObjv[i] && strcmp (Tcl_GetString (nameObj), Tcl_GetString (tmpl->nameObjv[i])) != 0) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_template_build --
+ *
+ *    look up the types of the columns of a row of name-value pairs in
+ *    the table and remember them in the template.  for an upsert, also
+ *    build the INSERT statement text for those columns.
+ *
+ *    columns that aren't in the table are an error for an upsert unless
+ *    dropUnknown is set, and are skipped for a prepared statement, the
+ *    same as upsert and add -prepared do.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_batch_template_build (casstcl_sessionClientData *ct, casstcl_rowTemplate *tmpl, char *tableName, int rowObjc, Tcl_Obj **rowObjv, int upsert, int dropUnknown, int ifNotExists)
+{
+	Tcl_Interp *interp = ct->interp;
+	int i;
+
+	casstcl_batch_template_free (tmpl);
+
+	tmpl->nColumns = rowObjc / 2;
+	tmpl->nameObjv = (Tcl_Obj **)ckalloc (sizeof (Tcl_Obj *) * (tmpl->nColumns + 1));
+	tmpl->typeInfo = (casstcl_cassTypeInfo *)ckalloc (sizeof (casstcl_cassTypeInfo) * (tmpl->nColumns + 1));
+
+	for (i = 0; i < tmpl->nColumns; i++) {
+		tmpl->nameObjv[i] = rowObjv[i * 2];
+		Tcl_IncrRefCount (tmpl->nameObjv[i]);
+	}
+
+	if (upsert) {
+		Tcl_DStringAppend (&tmpl->query, "INSERT INTO ", -1);
+		Tcl_DStringAppend (&tmpl->query, tableName, -1);
+		Tcl_DStringAppend (&tmpl->query, " (", 2);
+	}
+
+	for (i = 0; i < tmpl->nColumns; i++) {
+		int tclReturn = casstcl_typename_obj_to_cass_value_types (interp, tableName, tmpl->nameObjv[i], &tmpl->typeInfo[i]);
+
+		if (tclReturn == TCL_ERROR) {
+			casstcl_batch_template_free (tmpl);
+			return TCL_ERROR;
+		}
+
+		if (tclReturn == TCL_CONTINUE) {
+			tmpl->typeInfo[i].cassValueType = CASS_VALUE_TYPE_UNKNOWN;
+
+			if (upsert && !dropUnknown) {
+				Tcl_ResetResult (interp);
+				Tcl_AppendResult (interp, "unknown column '", Tcl_GetString (tmpl->nameObjv[i]), "' in upsert for table '", tableName, "'", NULL);
+				casstcl_batch_template_free (tmpl);
+				return TCL_ERROR;
+			}
+			continue;
+		}
+
+		if (upsert) {
+			if (tmpl->nFields > 0) {
+				Tcl_DStringAppend (&tmpl->query, ",", 1);
+			}
+			Tcl_DStringAppend (&tmpl->query, Tcl_GetString (tmpl->nameObjv[i]), -1);
+		}
+		tmpl->nFields++;
+	}
+
+	if (upsert) {
+		Tcl_DStringAppend (&tmpl->query, ") values (", -1);
+		for (i = 0; i < tmpl->nFields; i++) {
+			Tcl_DStringAppend (&tmpl->query, (i > 0) ? ",?" : "?", -1);
+		}
+		Tcl_DStringAppend (&tmpl->query, ifNotExists ? ") IF NOT EXISTS" : ")", -1);
+	}
+
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_add_row --
+ *
+ *    add the statement for one row of name-value pairs to the batch for
+ *    casstcl_batch_add_rows, rebuilding the template if the row's
+ *    columns differ from the row before it.  row is the row's index in
+ *    the list, for error messages.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_batch_add_row (casstcl_batchClientData *bcd, casstcl_preparedClientData *pcd, Tcl_Obj *nameObj, Tcl_Obj *preparedOptionObj, casstcl_rowTemplate *tmpl, char *tableName, Tcl_Obj *rowObj, int row, int dropUnknown, int ifNotExists)
+{
+	casstcl_sessionClientData *ct = bcd->ct;
+	Tcl_Interp *interp = ct->interp;
+	int upsert = (pcd == NULL);
+	CassStatement *statement;
+	Tcl_Obj *addObjv[3];
+	Tcl_Obj **rowObjv;
+	int rowObjc;
+	int bindField = 0;
+	int tclReturn = TCL_OK;
+	int i;
+	char rowString[TCL_INTEGER_SPACE];
+
+	sprintf (rowString, "%d", row);
+
+	if (Tcl_ListObjGetElements (interp, rowObj, &rowObjc, &rowObjv) == TCL_ERROR) {
+		Tcl_AppendResult (interp, " while parsing row ", rowString, NULL);
+		return TCL_ERROR;
+	}
+
+	if (rowObjc & 1) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "row ", rowString, " must contain an even number of elements", NULL);
+		return TCL_ERROR;
+	}
+
+	if (!casstcl_batch_template_matches (tmpl, rowObjc, rowObjv)) {
+		if (casstcl_batch_template_build (ct, tmpl, tableName, rowObjc, rowObjv, upsert, dropUnknown, ifNotExists) == TCL_ERROR) {
+			Tcl_AppendResult (interp, " while adding row ", rowString, NULL);
+			return TCL_ERROR;
+		}
+	}
+
+	if (upsert) {
+		statement = cass_statement_new (Tcl_DStringValue (&tmpl->query), tmpl->nFields);
+	} else {
+		statement = cass_prepared_bind (pcd->prepared);
+	}
+
+	for (i = 0; i < tmpl->nColumns; i++) {
+		int nameLength;
+		char *name;
+
+		if (tmpl->typeInfo[i].cassValueType == CASS_VALUE_TYPE_UNKNOWN) {
+			continue;
+		}
+
+		if (upsert) {
+			tclReturn = casstcl_bind_tcl_obj (ct, statement, NULL, 0, bindField++, &tmpl->typeInfo[i], rowObjv[i * 2 + 1]);
+		} else {
+			name = Tcl_GetStringFromObj (tmpl->nameObjv[i], &nameLength);
+			tclReturn = casstcl_bind_tcl_obj (ct, statement, name, nameLength, 0, &tmpl->typeInfo[i], rowObjv[i * 2 + 1]);
+		}
+
+		if (tclReturn == TCL_ERROR) {
+			Tcl_AppendResult (interp, " while attempting to bind field '", Tcl_GetString (tmpl->nameObjv[i]), "' of type '", casstcl_cass_value_type_to_string (tmpl->typeInfo[i].cassValueType), "' in row ", rowString, " referencing table '", tableName, "'", NULL);
+			cass_statement_free (statement);
+			return TCL_ERROR;
+		}
+	}
+
+	// look like the arguments of the equivalent add or upsert, for
+	// working out the partition and estimating the size
+	if (upsert) {
+		addObjv[0] = nameObj;
+		addObjv[1] = rowObj;
+	} else {
+		addObjv[0] = preparedOptionObj;
+		addObjv[1] = nameObj;
+		addObjv[2] = rowObj;
+	}
+
+	if (casstcl_batch_add_typed_statement (bcd, upsert, tmpl->typeInfo, upsert ? 2 : 3, addObjv, statement) == TCL_ERROR) {
+		Tcl_AppendResult (interp, " while adding row ", rowString, NULL);
+		return TCL_ERROR;
+	}
+
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_add_rows --
+ *
+ *    add a statement to the batch for each row in a list of rows of
+ *    name-value pairs, all in one go.  with a prepared statement (whose
+ *    command name is nameObj) each row is bound to it by name, otherwise
+ *    each row is upserted into the table named by nameObj.
+ *
+ *    column types are looked up, and upsert statement text is built,
+ *    only when a row's columns differ from the row before it, so a list
+ *    of rows with the same columns costs one lookup per column.
+ *
+ *    if a row can't be added, the rows before it stay in the batch.  if
+ *    skippedObj isn't NULL, the row and its error message are appended
+ *    to it and the rest of the rows are added anyway.
+ *
+ * Results:
+ *    A standard Tcl result.  On success the interpreter result is the
+ *    number of rows added.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_batch_add_rows (casstcl_batchClientData *bcd, casstcl_preparedClientData *pcd, Tcl_Obj *nameObj, Tcl_Obj *rowListObj, int dropUnknown, int ifNotExists, Tcl_Obj *skippedObj)
+{
+	casstcl_sessionClientData *ct = bcd->ct;
+	Tcl_Interp *interp = ct->interp;
+	char *tableName = (pcd != NULL) ? Tcl_GetString (pcd->tableNameObj) : Tcl_GetString (nameObj);
+	casstcl_rowTemplate tmpl;
+	Tcl_Obj *preparedOptionObj = NULL;
+	Tcl_Obj **rowListObjv;
+	int rowListObjc;
+	int added = 0;
+	int tclReturn = TCL_OK;
+	int row;
+
+	if (Tcl_ListObjGetElements (interp, rowListObj, &rowListObjc, &rowListObjv) == TCL_ERROR) {
+		Tcl_AppendResult (interp, " while parsing list of rows", NULL);
+		return TCL_ERROR;
+	}
+
+	tmpl.nColumns = 0;
+	tmpl.nameObjv = NULL;
+	tmpl.typeInfo = NULL;
+	tmpl.nFields = 0;
+	Tcl_DStringInit (&tmpl.query);
+
+	if (pcd != NULL) {
+		preparedOptionObj = Tcl_NewStringObj ("-prepared", -1);
+		Tcl_IncrRefCount (preparedOptionObj);
+	}
+
+	for (row = 0; row < rowListObjc; row++) {
+		if (casstcl_batch_add_row (bcd, pcd, nameObj, preparedOptionObj, &tmpl, tableName, rowListObjv[row], row, dropUnknown, ifNotExists) == TCL_OK) {
+			added++;
+			continue;
+		}
+
+		if (skippedObj == NULL) {
+			tclReturn = TCL_ERROR;
+			break;
+		}
+
+		Tcl_ListObjAppendElement (NULL, skippedObj, rowListObjv[row]);
+		Tcl_ListObjAppendElement (NULL, skippedObj, Tcl_GetObjResult (interp));
+		Tcl_ResetResult (interp);
+	}
+
+	casstcl_batch_template_free (&tmpl);
+
+	if (preparedOptionObj != NULL) {
+		Tcl_DecrRefCount (preparedOptionObj);
+	}
+
+	if (tclReturn == TCL_OK) {
+		Tcl_SetObjResult (interp, Tcl_NewIntObj (added));
+	}
+
+	return tclReturn;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_configure --
+ *
+ *    handle ?-max_statements n? ?-max_bytes b? ?-flush_callback callback?
+ *    ?-by_partition bool? ?-profile name? ?-timeout ms? ?-trace bool? for
+ *    a batch, from
+ *    either the session's batch method or the batch's own configure
+ *    method.  a limit of 0, an empty callback, an empty profile name or
+ *    an empty timeout turns that setting off.  with no arguments, set
+ *    the interpreter result to a list of the settings.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_batch_configure (casstcl_batchClientData *bcd, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Interp *interp = bcd->ct->interp;
+	int maxStatements = bcd->maxStatements;
+	Tcl_WideInt maxBytes = bcd->maxBytes;
+	Tcl_Obj *flushCallbackObj = bcd->flushCallbackObj;
+	int byPartition = bcd->byPartition;
+	Tcl_Obj *profileObj = bcd->profileObj;
+	Tcl_WideInt timeoutMS = bcd->timeoutMS;
+	int trace = bcd->trace;
+	int arg;
+
+	static CONST char *subOptions[] = {
+		"-max_statements",
+		"-max_bytes",
+		"-flush_callback",
+		"-by_partition",
+		"-profile",
+		"-timeout",
+		"-trace",
+		NULL
+	};
+
+	enum subOptions {
+		SUBOPT_MAX_STATEMENTS,
+		SUBOPT_MAX_BYTES,
+		SUBOPT_FLUSH_CALLBACK,
+		SUBOPT_BY_PARTITION,
+		SUBOPT_PROFILE,
+		SUBOPT_TIMEOUT,
+		SUBOPT_TRACE
+	};
+
+	if (objc == 0) {
+		Tcl_Obj *listObj = Tcl_NewObj ();
+
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-max_statements", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (bcd->maxStatements));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-max_bytes", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (bcd->maxBytes));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-flush_callback", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, (bcd->flushCallbackObj != NULL) ? bcd->flushCallbackObj : Tcl_NewObj ());
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-by_partition", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewBooleanObj (bcd->byPartition));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-profile", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, (bcd->profileObj != NULL) ? bcd->profileObj : Tcl_NewObj ());
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-timeout", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, (bcd->timeoutMS >= 0) ? Tcl_NewWideIntObj (bcd->timeoutMS) : Tcl_NewObj ());
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-trace", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewBooleanObj (bcd->trace));
+		Tcl_SetObjResult (interp, listObj);
+		return TCL_OK;
+	}
+
+	if (objc & 1) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "batch options must be given as option value pairs", NULL);
+		return TCL_ERROR;
+	}
+
+	for (arg = 0; arg < objc; arg += 2) {
+		int subOptIndex;
+
+		if (Tcl_GetIndexFromObj (interp, objv[arg], subOptions, "subOption", TCL_EXACT, &subOptIndex) != TCL_OK) {
+			return TCL_ERROR;
+		}
+
+		switch ((enum subOptions) subOptIndex) {
+			case SUBOPT_MAX_STATEMENTS: {
+				if (Tcl_GetIntFromObj (interp, objv[arg + 1], &maxStatements) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting max_statements", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_MAX_BYTES: {
+				if (Tcl_GetWideIntFromObj (interp, objv[arg + 1], &maxBytes) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting max_bytes", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_FLUSH_CALLBACK: {
+				int length;
+
+				Tcl_GetStringFromObj (objv[arg + 1], &length);
+				flushCallbackObj = (length == 0) ? NULL : objv[arg + 1];
+				break;
+			}
+
+			case SUBOPT_BY_PARTITION: {
+				if (Tcl_GetBooleanFromObj (interp, objv[arg + 1], &byPartition) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting by_partition", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_PROFILE: {
+				int length;
+
+				Tcl_GetStringFromObj (objv[arg + 1], &length);
+				profileObj = (length == 0) ? NULL : objv[arg + 1];
+				if (profileObj != NULL && casstcl_profile_check (bcd->ct, profileObj) == TCL_ERROR) {
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_TIMEOUT: {
+				int length;
+
+				Tcl_GetStringFromObj (objv[arg + 1], &length);
+				if (length == 0) {
+					timeoutMS = -1;
+				} else if (Tcl_GetWideIntFromObj (interp, objv[arg + 1], &timeoutMS) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting timeout", NULL);
+					return TCL_ERROR;
+				} else if (timeoutMS < 0) {
+					Tcl_ResetResult (interp);
+					Tcl_AppendResult (interp, "batch -timeout can't be negative", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_TRACE: {
+				if (Tcl_GetBooleanFromObj (interp, objv[arg + 1], &trace) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting trace", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+		}
+	}
+
+	if (maxStatements < 0 || maxBytes < 0) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "batch limits can't be negative", NULL);
+		return TCL_ERROR;
+	}
+
+	if (byPartition != bcd->byPartition && bcd->count > 0) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "can't change -by_partition of a batch that isn't empty", NULL);
+		return TCL_ERROR;
+	}
+
+	bcd->maxStatements = maxStatements;
+	bcd->maxBytes = maxBytes;
+	bcd->byPartition = byPartition;
+
+	if (flushCallbackObj != bcd->flushCallbackObj) {
+		if (flushCallbackObj != NULL) {
+			Tcl_IncrRefCount (flushCallbackObj);
+		}
+
+		if (bcd->flushCallbackObj != NULL) {
+			Tcl_DecrRefCount (bcd->flushCallbackObj);
+		}
+		bcd->flushCallbackObj = flushCallbackObj;
+	}
+
+	if (profileObj != bcd->profileObj) {
+		if (profileObj != NULL) {
+			Tcl_IncrRefCount (profileObj);
+		}
+
+		if (bcd->profileObj != NULL) {
+			Tcl_DecrRefCount (bcd->profileObj);
+		}
+		bcd->profileObj = profileObj;
+	}
+	bcd->timeoutMS = timeoutMS;
+	bcd->trace = trace;
+
+	// the batch being built is executed by the exec method with
+	// whatever settings it has
+	casstcl_batch_apply_settings (bcd, bcd->batch);
+
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batchObjectObjCmd --
+ *
+ *    dispatches the subcommands of a casstcl batch-handling command
+ *
+ * Results:
+ *    stuff
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_batchObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[])
+{
+    int         optIndex;
+	casstcl_batchClientData *bcd = (casstcl_batchClientData *)cData;
+	int resultCode = TCL_OK;
+
+    static CONST char *options[] = {
+        "add",
+		"upsert",
+		"add_many",
+		"upsert_many",
+		"count",
+		"bytes",
+		"partitions",
+        "consistency",
+		"configure",
+		"flush",
+		"reset",
+        "delete",
+        NULL
+    };
+
+    enum options {
+        OPT_ADD,
+        OPT_UPSERT,
+		OPT_ADD_MANY,
+		OPT_UPSERT_MANY,
+		OPT_COUNT,
+		OPT_BYTES,
+		OPT_PARTITIONS,
+        OPT_CONSISTENCY,
+		OPT_CONFIGURE,
+		OPT_FLUSH,
+		OPT_RESET,
+		OPT_DELETE
+    };
+
+    /* basic validation of command line arguments */
+    if (objc < 2) {
+        Tcl_WrongNumArgs (interp, 1, objv, "subcommand ?args?");
+        return TCL_ERROR;
+    }
+
+    if (Tcl_GetIndexFromObj (interp, objv[1], options, "option", TCL_EXACT, &optIndex) != TCL_OK) {
+		return TCL_ERROR;
+    }
+
+    switch ((enum options) optIndex) {
+		case OPT_ADD: {
+			CassStatement* statement = NULL;
+			if (casstcl_make_statement_from_objv (bcd->ct, objc, objv, 2, &statement) == TCL_ERROR) {
+				return TCL_ERROR;
+			}
+
+			if (casstcl_batch_add_statement (bcd, 0, objc - 2, &objv[2], statement) == TCL_ERROR) {
+				Tcl_AppendResult (interp, " while adding statement to batch", NULL);
+				return TCL_ERROR;
+			}
+
+			break;
+		}
+
+		case OPT_UPSERT: {
+			CassStatement* statement = NULL;
+
+			resultCode = casstcl_make_upsert_statement_from_objv (bcd->ct, objc - 2, &objv[2], NULL, &statement);
+
+			if (resultCode != TCL_ERROR) {
+				resultCode = casstcl_batch_add_statement (bcd, 1, objc - 2, &objv[2], statement);
+			}
+
+			break;
+		}
+
+		// add_many -prepared name rowList - add a statement binding each
+		// row of name-value pairs to a prepared statement
+		case OPT_ADD_MANY: {
+			casstcl_preparedClientData *pcd;
+
+			if (objc != 5 || strcmp (Tcl_GetString (objv[2]), "-prepared") != 0) {
+				Tcl_WrongNumArgs (interp, 2, objv, "-prepared preparedName rowList");
+				return TCL_ERROR;
+			}
+
+			pcd = casstcl_prepared_command_to_preparedClientData (interp, Tcl_GetString (objv[3]));
+			if (pcd == NULL) {
+				Tcl_ResetResult (interp);
+				Tcl_AppendResult (interp, "-prepared argument '", Tcl_GetString (objv[3]), "' isn't a valid prepared statement object", NULL);
+				return TCL_ERROR;
+			}
+
+			return casstcl_batch_add_rows (bcd, pcd, objv[3], objv[4], 0, 0, NULL);
+		}
+
+		// upsert_many ?-nocomplain? ?-ifnotexists? table rowList - upsert
+		// each row of name-value pairs into the table
+		case OPT_UPSERT_MANY: {
+			int dropUnknown = 0;
+			int ifNotExists = 0;
+			int arg;
+			int subOptIndex;
+
+			static CONST char *subOptions[] = {
+				"-nocomplain",
+				"-ifnotexists",
+				NULL
+			};
+
+			enum subOptions {
+				SUBOPT_NOCOMPLAIN,
+				SUBOPT_IFNOTEXISTS
+			};
+
+			if (objc < 4) {
+				Tcl_WrongNumArgs (interp, 2, objv, "?-nocomplain? ?-ifnotexists? table rowList");
+				return TCL_ERROR;
+			}
+
+			for (arg = 2; arg < objc - 2; arg++) {
+				if (Tcl_GetIndexFromObj (interp, objv[arg], subOptions, "subOption", TCL_EXACT, &subOptIndex) != TCL_OK) {
+					return TCL_ERROR;
+				}
+
+				switch ((enum subOptions) subOptIndex) {
+					case SUBOPT_NOCOMPLAIN: {
+						dropUnknown = 1;
+						break;
+					}
+
+					case SUBOPT_IFNOTEXISTS: {
+						ifNotExists = 1;
+						break;
+					}
+				}
+			}
+
+			return casstcl_batch_add_rows (bcd, NULL, objv[objc - 2], objv[objc - 1], dropUnknown, ifNotExists, NULL);
+		}
+
+		// count - return a count of rows in the batch
+		case OPT_COUNT: {
+			if (objc != 2) {
+				Tcl_WrongNumArgs (interp, 2, objv, "");
+				return TCL_ERROR;
+			}
+
+			Tcl_SetObjResult (interp, Tcl_NewIntObj (bcd->count));
+			break;
+		}
+
+		// bytes - return the estimated size of the batch
+		case OPT_BYTES: {
 			if (objc != 2) {
 				Tcl_WrongNumArgs (interp, 2, objv, "");
 				return TCL_ERROR;
 			}
 
-			cass_batch_free (bcd->batch);
-			bcd->batch = cass_batch_new (bcd->batchType);
-			bcd->count = 0;
-			CassError cassError = cass_batch_set_consistency (bcd->batch, bcd->consistency);
+			Tcl_SetObjResult (interp, Tcl_NewWideIntObj (bcd->bytes));
+			break;
+		}
+
+		// partitions - return how many partitions a batch grouped by
+		// partition has statements waiting for
+		case OPT_PARTITIONS: {
+			if (objc != 2) {
+				Tcl_WrongNumArgs (interp, 2, objv, "");
+				return TCL_ERROR;
+			}
+
+			Tcl_SetObjResult (interp, Tcl_NewIntObj (bcd->partitionTable.numEntries));
+			break;
+		}
+
+
+		case OPT_CONSISTENCY: {
+			CassConsistency cassConsistency;
+
+			if ((objc < 2) || (objc > 3)) {
+				Tcl_WrongNumArgs (interp, 2, objv, "?consistency?");
+				return TCL_ERROR;
+			}
+
+			if (objc == 2) {
+				Tcl_SetObjResult (interp, Tcl_NewStringObj (casstcl_cass_consistency_to_string (bcd->consistency), -1));
+				return TCL_OK;
+			}
+
+			if (casstcl_obj_to_cass_consistency(bcd->ct, objv[2], &cassConsistency) == TCL_ERROR) {
+				return TCL_ERROR;
+			}
+
+			CassError cassError = cass_batch_set_consistency (bcd->batch, cassConsistency);
+			bcd->consistency = cassConsistency;
+
+			Tcl_HashSearch search;
+			Tcl_HashEntry *entry;
+			for (entry = Tcl_FirstHashEntry (&bcd->partitionTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+				casstcl_batchPartition *part = (casstcl_batchPartition *)Tcl_GetHashValue (entry);
+				cass_batch_set_consistency (part->batch, cassConsistency);
+			}
 			if (cassError != CASS_OK) {
 				return casstcl_cass_error_to_tcl (bcd->ct, cassError);
 			}
-
 			break;
 		}
 
+		case OPT_CONFIGURE: {
+			if (objc & 1) {
+				Tcl_WrongNumArgs (interp, 2, objv, "?-max_statements n? ?-max_bytes b? ?-flush_callback callback? ?-by_partition bool? ?-profile name? ?-timeout ms? ?-trace bool?");
+				return TCL_ERROR;
+			}
+
+			return casstcl_batch_configure (bcd, objc - 2, &objv[2]);
+		}
+
+		case OPT_FLUSH: {
+			if (objc != 2) {
+				Tcl_WrongNumArgs (interp, 2, objv, "");
+				return TCL_ERROR;
+			}
+
+			return casstcl_batch_flush (bcd);
+		}
+
+		case OPT_RESET: {
+			if (objc != 2) {
+				Tcl_WrongNumArgs (interp, 2, objv, "");
+				return TCL_ERROR;
+			}
+
+			return casstcl_batch_reset (bcd);
+		}
+
 		case OPT_DELETE: {
 			if (objc != 2) {
 				Tcl_WrongNumArgs (interp, 2, objv, "");
@@ -58,6 +58,31 @@ const char *casstcl_batch_type_to_batch_type_string (CassBatchType cassBatchType
  */
 casstcl_batchClientData * casstcl_batch_command_to_batchClientData (Tcl_Interp *interp, char *batchCommandName);
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_new_client_data --
+ *
+ *    allocate and set up a batch client data with an empty CassBatch of
+ *    the given type, not yet attached to a command
+ *
+ * Results:
+ *    The new batch client data
+ *
+ *----------------------------------------------------------------------
+ */
+casstcl_batchClientData *casstcl_batch_new_client_data (casstcl_sessionClientData *ct, CassBatchType cassBatchType);
+
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_batch_free_client_data -- free a batch client data and
+ *   everything in it
+ *
+ *--------------------------------------------------------------
+ */
+void casstcl_batch_free_client_data (casstcl_batchClientData *bcd);
+
 /*
  *----------------------------------------------------------------------
  *
@@ -73,6 +98,146 @@ casstcl_batchClientData * casstcl_batch_command_to_batchClientData (Tcl_Interp *
  */
 int casstcl_createBatchObjectCommand (casstcl_sessionClientData *ct, char *commandName, CassBatchType cassBatchType);
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_apply_settings --
+ *
+ *    give a CassBatch belonging to a batch object the object's -profile
+ *    and -timeout, or the cluster's settings if it has none
+ *
+ *----------------------------------------------------------------------
+ */
+void casstcl_batch_apply_settings (casstcl_batchClientData *bcd, CassBatch *batch);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_reset --
+ *
+ *    throw away everything in the batch and start over with a fresh
+ *    CassBatch of the same type, consistency, profile and timeout
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_batch_reset (casstcl_batchClientData *bcd);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_flush --
+ *
+ *    if the batch has anything in it, execute it asynchronously and
+ *    swap in a fresh CassBatch so more can be added right away.  a
+ *    batch grouped by partition executes one batch per partition.
+ *
+ *    if the batch has a flush callback, a future object is created to
+ *    invoke it when the batch completes, just like async -callback.
+ *    otherwise the batch is executed fire-and-forget, so failures are
+ *    counted by write_stats and go to the session's fireforget_callback.
+ *
+ * Results:
+ *    A standard Tcl result.  The interpreter result is left alone.
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_batch_flush (casstcl_batchClientData *bcd);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_add_with_flush --
+ *
+ *    add a statement to the batch, flushing the batch first if the
+ *    statement would take it over its byte limit and afterwards if it
+ *    has reached its statement or byte limit.  a statement that's
+ *    bigger than the byte limit all by itself goes in a batch alone.
+ *
+ *    the statement is freed either way.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_batch_add_with_flush (casstcl_batchClientData *bcd, CassStatement *statement, Tcl_WideInt estimate);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_add_statement --
+ *
+ *    add a statement made from the arguments of an add or upsert (objv
+ *    starting after the method name) to the batch, or to the batch for
+ *    its partition if the batch is grouped by partition
+ *
+ *    the statement is freed either way.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_batch_add_statement (casstcl_batchClientData *bcd, int upsert, int objc, Tcl_Obj *CONST objv[], CassStatement *statement);
+
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_batch_free_partitions -- throw away the per-partition
+ *   batches of a batch grouped by partition
+ *
+ *--------------------------------------------------------------
+ */
+void casstcl_batch_free_partitions (casstcl_batchClientData *bcd);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_add_rows --
+ *
+ *    add a statement to the batch for each row in a list of rows of
+ *    name-value pairs, all in one go.  with a prepared statement (whose
+ *    command name is nameObj) each row is bound to it by name, otherwise
+ *    each row is upserted into the table named by nameObj.
+ *
+ *    column types are looked up, and upsert statement text is built,
+ *    only when a row's columns differ from the row before it, so a list
+ *    of rows with the same columns costs one lookup per column.
+ *
+ *    if a row can't be added, the rows before it stay in the batch.  if
+ *    skippedObj isn't NULL, the row and its error message are appended
+ *    to it and the rest of the rows are added anyway.
+ *
+ * Results:
+ *    A standard Tcl result.  On success the interpreter result is the
+ *    number of rows added.
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_batch_add_rows (casstcl_batchClientData *bcd, casstcl_preparedClientData *pcd, Tcl_Obj *nameObj, Tcl_Obj *rowListObj, int dropUnknown, int ifNotExists, Tcl_Obj *skippedObj);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_batch_configure --
+ *
+ *    handle ?-max_statements n? ?-max_bytes b? ?-flush_callback callback?
+ *    ?-by_partition bool? ?-profile name? ?-timeout ms? for a batch, from
+ *    either the session's batch method or the batch's own configure
+ *    method.  a limit of 0, an empty callback, an empty profile name or
+ *    an empty timeout turns that setting off.  with no arguments, set
+ *    the interpreter result to a list of the settings.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_batch_configure (casstcl_batchClientData *bcd, int objc, Tcl_Obj *CONST objv[]);
+
 /*
  *----------------------------------------------------------------------
  *
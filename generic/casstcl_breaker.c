@@ -0,0 +1,811 @@
+/*
+ * casstcl_breaker - Functions used to implement circuit breakers, which
+ *   fail requests right away while the cluster, or a table, is failing
+ *   most of the requests sent to it
+ *
+ * casstcl - Tcl interface to CassDB
+ *
+ * Copyright (C) 2014 FlightAware LLC
+ *
+ * freely redistributable under the Berkeley license
+ */
+
+#include "casstcl.h"
+#include "casstcl_breaker.h"
+#include "casstcl_error.h"
+#include "casstcl_future.h"
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_breaker_find --
+ *
+ *    return the session's circuit breaker for a table, or NULL if the
+ *    table doesn't have one or tableNameObj is NULL.  the caller holds
+ *    the session's breakerMutex.
+ *
+ *----------------------------------------------------------------------
+ */
+static casstcl_breaker *
+casstcl_breaker_find (casstcl_sessionClientData *ct, Tcl_Obj *tableNameObj)
+{
+	Tcl_HashEntry *entry;
+
+	if (tableNameObj == NULL || ct->breakerTable.numEntries == 0) {
+		return NULL;
+	}
+
+	entry = Tcl_FindHashEntry (&ct->breakerTable, Tcl_GetString (tableNameObj));
+	if (entry == NULL) {
+		return NULL;
+	}
+	return (casstcl_breaker *)Tcl_GetHashValue (entry);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_breaker_bucket --
+ *
+ *    return the bucket of a circuit breaker's window that requests
+ *    completing now are counted in, emptying it if it was last used for
+ *    an earlier slice of time
+ *
+ *----------------------------------------------------------------------
+ */
+static casstcl_breakerBucket *
+casstcl_breaker_bucket (casstcl_breaker *breaker, Tcl_WideInt now)
+{
+	Tcl_WideInt width = breaker->window / CASSTCL_BREAKER_BUCKETS;
+	Tcl_WideInt start;
+	casstcl_breakerBucket *bucket;
+
+	if (width < 1) {
+		width = 1;
+	}
+
+	start = now - (now % width);
+	bucket = &breaker->buckets[(now / width) % CASSTCL_BREAKER_BUCKETS];
+
+	if (bucket->start != start) {
+		bucket->start = start;
+		bucket->requests = 0;
+		bucket->errors = 0;
+		bucket->timeouts = 0;
+	}
+	return bucket;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_breaker_totals --
+ *
+ *    add up the requests, errors and timeouts of a circuit breaker's
+ *    window
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_breaker_totals (casstcl_breaker *breaker, Tcl_WideInt now, int *requestsPtr, int *errorsPtr, int *timeoutsPtr)
+{
+	int i;
+
+	*requestsPtr = *errorsPtr = *timeoutsPtr = 0;
+
+	for (i = 0; i < CASSTCL_BREAKER_BUCKETS; i++) {
+		casstcl_breakerBucket *bucket = &breaker->buckets[i];
+
+		if (bucket->start > now - breaker->window) {
+			*requestsPtr += bucket->requests;
+			*errorsPtr += bucket->errors;
+			*timeoutsPtr += bucket->timeouts;
+		}
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_breaker_close --
+ *
+ *    close a circuit breaker, forgetting the requests in its window
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_breaker_close (casstcl_breaker *breaker, Tcl_WideInt now)
+{
+	breaker->state = CASSTCL_BREAKER_CLOSED;
+	breaker->changed = now;
+	memset (breaker->buckets, 0, sizeof (breaker->buckets));
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_breaker_open --
+ *
+ *    trip a circuit breaker
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_breaker_open (casstcl_breaker *breaker, Tcl_WideInt now)
+{
+	breaker->state = CASSTCL_BREAKER_OPEN;
+	breaker->changed = now;
+	breaker->trips++;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_breaker_would_admit --
+ *
+ *    decide whether casstcl_breaker_admit_one would let a request
+ *    through, without taking a probe or counting a rejection
+ *
+ * Results:
+ *    1 if it would, else 0
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_breaker_would_admit (casstcl_breaker *breaker, Tcl_WideInt now)
+{
+	Tcl_WideInt elapsed = now - breaker->changed;
+
+	switch (breaker->state) {
+		case CASSTCL_BREAKER_CLOSED: {
+			return 1;
+		}
+
+		case CASSTCL_BREAKER_OPEN: {
+			return (elapsed >= breaker->cooldown);
+		}
+
+		case CASSTCL_BREAKER_HALF_OPEN: {
+			return (breaker->probesIssued < breaker->probes || elapsed >= breaker->cooldown);
+		}
+	}
+
+	return 0;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_breaker_admit_one --
+ *
+ *    decide whether a circuit breaker lets a request through.  once it
+ *    has been open for -cooldown it's half open and lets -probes
+ *    requests through to see if things are better.  if those never
+ *    report back, another round of probes is let through after another
+ *    cooldown.
+ *
+ * Results:
+ *    1 if the request can be sent, otherwise 0 and the number of
+ *    milliseconds until one could be in *retryPtr
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_breaker_admit_one (casstcl_breaker *breaker, Tcl_WideInt now, Tcl_WideInt *retryPtr)
+{
+	Tcl_WideInt elapsed = now - breaker->changed;
+
+	switch (breaker->state) {
+		case CASSTCL_BREAKER_CLOSED: {
+			return 1;
+		}
+
+		case CASSTCL_BREAKER_OPEN: {
+			if (elapsed < breaker->cooldown) {
+				break;
+			}
+
+			breaker->state = CASSTCL_BREAKER_HALF_OPEN;
+			breaker->changed = now;
+			breaker->probesIssued = 1;
+			breaker->probesSucceeded = 0;
+			return 1;
+		}
+
+		case CASSTCL_BREAKER_HALF_OPEN: {
+			if (breaker->probesIssued < breaker->probes) {
+				breaker->probesIssued++;
+				return 1;
+			}
+
+			if (elapsed < breaker->cooldown) {
+				break;
+			}
+
+			breaker->changed = now;
+			breaker->probesIssued = 1;
+			breaker->probesSucceeded = 0;
+			return 1;
+		}
+	}
+
+	breaker->rejected++;
+	*retryPtr = breaker->cooldown - elapsed;
+	if (*retryPtr < 1) {
+		*retryPtr = 1;
+	}
+	return 0;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_breaker_admit --
+ *
+ *    decide whether a request to a table, which may be NULL if it isn't
+ *    known, can be sent, checking the table's circuit breaker and then
+ *    the session's.  a half open breaker's probe is only taken once
+ *    both have let the request through, so one isn't used up by a
+ *    request the other breaker refuses.
+ *
+ * Results:
+ *    1 if it can, otherwise 0 and the number of milliseconds until one
+ *    could be in *retryPtr
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_breaker_admit (casstcl_sessionClientData *ct, Tcl_Obj *tableNameObj, Tcl_WideInt *retryPtr)
+{
+	casstcl_breaker *tableBreaker;
+	Tcl_WideInt now;
+	int admitted = 1;
+
+	if (!ct->breaker.enabled && ct->breakerTable.numEntries == 0) {
+		return 1;
+	}
+
+	now = casstcl_now_ms ();
+
+	Tcl_MutexLock (&ct->breakerMutex);
+	tableBreaker = casstcl_breaker_find (ct, tableNameObj);
+	if (tableBreaker != NULL && !casstcl_breaker_would_admit (tableBreaker, now)) {
+		admitted = casstcl_breaker_admit_one (tableBreaker, now, retryPtr);
+	} else if (ct->breaker.enabled && !casstcl_breaker_would_admit (&ct->breaker, now)) {
+		admitted = casstcl_breaker_admit_one (&ct->breaker, now, retryPtr);
+	} else {
+		// both let it through, so take their probes, if they're half open
+		if (tableBreaker != NULL) {
+			casstcl_breaker_admit_one (tableBreaker, now, retryPtr);
+		}
+		if (ct->breaker.enabled) {
+			casstcl_breaker_admit_one (&ct->breaker, now, retryPtr);
+		}
+	}
+	Tcl_MutexUnlock (&ct->breakerMutex);
+
+	return admitted;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_breaker_check --
+ *
+ *    casstcl_breaker_admit for requests that fail right away if they
+ *    can't be sent
+ *
+ * Results:
+ *    A standard Tcl result.  A request that isn't let through is an
+ *    error with an errorCode of CASSTCL CIRCUIT_OPEN and the table name,
+ *    or an empty string for the session's circuit breaker.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_breaker_check (casstcl_sessionClientData *ct, Tcl_Obj *tableNameObj)
+{
+	Tcl_Interp *interp = ct->interp;
+	Tcl_WideInt retry;
+	int tableOpen;
+
+	if (casstcl_breaker_admit (ct, tableNameObj, &retry)) {
+		return TCL_OK;
+	}
+
+	Tcl_MutexLock (&ct->breakerMutex);
+	{
+		casstcl_breaker *tableBreaker = casstcl_breaker_find (ct, tableNameObj);
+		tableOpen = (tableBreaker != NULL && !casstcl_breaker_would_admit (tableBreaker, casstcl_now_ms ()));
+	}
+	Tcl_MutexUnlock (&ct->breakerMutex);
+
+	Tcl_ResetResult (interp);
+	if (tableOpen) {
+		Tcl_SetErrorCode (interp, "CASSTCL", "CIRCUIT_OPEN", Tcl_GetString (tableNameObj), NULL);
+		Tcl_AppendResult (interp, "circuit breaker is open for table \"", Tcl_GetString (tableNameObj), "\"", NULL);
+	} else {
+		Tcl_SetErrorCode (interp, "CASSTCL", "CIRCUIT_OPEN", "", NULL);
+		Tcl_AppendResult (interp, "circuit breaker is open for the session", NULL);
+	}
+	return TCL_ERROR;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_breaker_record_one --
+ *
+ *    count a completed request against a circuit breaker.  transient
+ *    errors, like timeouts and unavailable nodes, are failures; any
+ *    other error means the cluster answered.  a closed breaker trips
+ *    once there are -min_requests in its window and the errors or the
+ *    timeouts reach their rates.  a half open one trips again on any
+ *    failure and closes once its probes succeed.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_breaker_record_one (casstcl_breaker *breaker, Tcl_WideInt now, int failed, int timedOut)
+{
+	switch (breaker->state) {
+		case CASSTCL_BREAKER_CLOSED: {
+			casstcl_breakerBucket *bucket = casstcl_breaker_bucket (breaker, now);
+			int requests, errors, timeouts;
+
+			bucket->requests++;
+			bucket->errors += failed;
+			bucket->timeouts += timedOut;
+
+			if (!failed) {
+				break;
+			}
+
+			casstcl_breaker_totals (breaker, now, &requests, &errors, &timeouts);
+			if (requests >= breaker->minRequests && ((breaker->errorRate > 0 && errors >= breaker->errorRate * requests) || (breaker->timeoutRate > 0 && timeouts >= breaker->timeoutRate * requests))) {
+				casstcl_breaker_open (breaker, now);
+			}
+			break;
+		}
+
+		case CASSTCL_BREAKER_HALF_OPEN: {
+			if (failed) {
+				casstcl_breaker_open (breaker, now);
+			} else if (++breaker->probesSucceeded >= breaker->probes) {
+				casstcl_breaker_close (breaker, now);
+			}
+			break;
+		}
+
+		case CASSTCL_BREAKER_OPEN: {
+			// stragglers sent before it tripped don't count
+			break;
+		}
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_breaker_record --
+ *
+ *    count a completed request to a table, which may be NULL if it
+ *    isn't known, against the table's and the session's circuit
+ *    breakers.
+ *
+ *    this may be called from the cpp-driver's threads, but only with a
+ *    NULL tableNameObj, since Tcl objects belong to the session's thread.
+ *    completions that arrive after the session was deleted (like those
+ *    of a coroutine still waiting on exec) are ignored.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_breaker_record (casstcl_sessionClientData *ct, Tcl_Obj *tableNameObj, CassError rc)
+{
+	casstcl_breaker *tableBreaker;
+	int failed = casstcl_cass_error_is_transient (rc);
+	int timedOut = casstcl_cass_error_is_timeout (rc);
+	Tcl_WideInt now;
+
+	if (ct->session == NULL || (!ct->breaker.enabled && (tableNameObj == NULL || ct->breakerTable.numEntries == 0))) {
+		return;
+	}
+
+	now = casstcl_now_ms ();
+
+	Tcl_MutexLock (&ct->breakerMutex);
+	tableBreaker = casstcl_breaker_find (ct, tableNameObj);
+	if (tableBreaker != NULL) {
+		casstcl_breaker_record_one (tableBreaker, now, failed, timedOut);
+	}
+
+	if (ct->breaker.enabled) {
+		casstcl_breaker_record_one (&ct->breaker, now, failed, timedOut);
+	}
+	Tcl_MutexUnlock (&ct->breakerMutex);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_breaker_configure --
+ *
+ *    set the options of a circuit breaker from a list of option value
+ *    pairs.  nothing is changed if any of them are bad.  the caller
+ *    holds the session's breakerMutex.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_breaker_configure (Tcl_Interp *interp, casstcl_breaker *breaker, int objc, Tcl_Obj *CONST objv[])
+{
+	double errorRate = breaker->errorRate;
+	double timeoutRate = breaker->timeoutRate;
+	int minRequests = breaker->minRequests;
+	int window = breaker->window;
+	int cooldown = breaker->cooldown;
+	int probes = breaker->probes;
+	int arg;
+
+	static CONST char *subOptions[] = {
+		"-error_rate",
+		"-timeout_rate",
+		"-min_requests",
+		"-window",
+		"-cooldown",
+		"-probes",
+		NULL
+	};
+
+	enum subOptions {
+		SUBOPT_ERROR_RATE,
+		SUBOPT_TIMEOUT_RATE,
+		SUBOPT_MIN_REQUESTS,
+		SUBOPT_WINDOW,
+		SUBOPT_COOLDOWN,
+		SUBOPT_PROBES
+	};
+
+	if (objc & 1) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "circuit breaker options must be given as option value pairs", NULL);
+		return TCL_ERROR;
+	}
+
+	for (arg = 0; arg < objc; arg += 2) {
+		int subOptIndex;
+
+		if (Tcl_GetIndexFromObj (interp, objv[arg], subOptions, "subOption", TCL_EXACT, &subOptIndex) != TCL_OK) {
+			return TCL_ERROR;
+		}
+
+		switch ((enum subOptions) subOptIndex) {
+			case SUBOPT_ERROR_RATE: {
+				if (Tcl_GetDoubleFromObj (interp, objv[arg + 1], &errorRate) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting error_rate", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_TIMEOUT_RATE: {
+				if (Tcl_GetDoubleFromObj (interp, objv[arg + 1], &timeoutRate) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting timeout_rate", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_MIN_REQUESTS: {
+				if (Tcl_GetIntFromObj (interp, objv[arg + 1], &minRequests) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting min_requests", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_WINDOW: {
+				if (Tcl_GetIntFromObj (interp, objv[arg + 1], &window) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting window", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_COOLDOWN: {
+				if (Tcl_GetIntFromObj (interp, objv[arg + 1], &cooldown) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting cooldown", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_PROBES: {
+				if (Tcl_GetIntFromObj (interp, objv[arg + 1], &probes) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting probes", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+		}
+	}
+
+	if (errorRate < 0 || errorRate > 1 || timeoutRate < 0 || timeoutRate > 1) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "circuit breaker rates must be between 0 and 1", NULL);
+		return TCL_ERROR;
+	}
+
+	if (minRequests < 1 || window < 1 || cooldown < 0 || probes < 1) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "circuit breaker -min_requests, -window and -probes must be at least 1 and -cooldown can't be negative", NULL);
+		return TCL_ERROR;
+	}
+
+	// a different window means the buckets are sliced differently
+	if (window != breaker->window) {
+		memset (breaker->buckets, 0, sizeof (breaker->buckets));
+	}
+
+	breaker->errorRate = errorRate;
+	breaker->timeoutRate = timeoutRate;
+	breaker->minRequests = minRequests;
+	breaker->window = window;
+	breaker->cooldown = cooldown;
+	breaker->probes = probes;
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_breaker_to_list --
+ *
+ *    return a new list of a circuit breaker's options, or of its state,
+ *    what's in its window and its counts
+ *
+ *----------------------------------------------------------------------
+ */
+static Tcl_Obj *
+casstcl_breaker_to_list (casstcl_breaker *breaker, int stats)
+{
+	Tcl_Obj *listObj = Tcl_NewObj ();
+
+	if (stats) {
+		static CONST char *states[] = {"closed", "open", "half_open"};
+		int requests, errors, timeouts;
+
+		casstcl_breaker_totals (breaker, casstcl_now_ms (), &requests, &errors, &timeouts);
+
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("state", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj (states[breaker->state], -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("requests", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (requests));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("errors", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (errors));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("timeouts", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (timeouts));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("trips", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (breaker->trips));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("rejected", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (breaker->rejected));
+		return listObj;
+	}
+
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-error_rate", -1));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewDoubleObj (breaker->errorRate));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-timeout_rate", -1));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewDoubleObj (breaker->timeoutRate));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-min_requests", -1));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (breaker->minRequests));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-window", -1));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (breaker->window));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-cooldown", -1));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (breaker->cooldown));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-probes", -1));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (breaker->probes));
+	return listObj;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_circuit_breaker --
+ *
+ *    implements the circuit_breaker method of a session,
+ *
+ *      circuit_breaker enable ?-table tableName? ?option value ...?
+ *      circuit_breaker configure ?-table tableName? ?option value ...?
+ *      circuit_breaker disable ?-table tableName?
+ *      circuit_breaker reset ?-table tableName?
+ *      circuit_breaker stats ?-table tableName?
+ *      circuit_breaker names
+ *
+ *    a table's circuit breaker covers the requests casstcl knows are
+ *    for that table.  the session's covers all of them.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_circuit_breaker (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Interp *interp = ct->interp;
+	Tcl_Obj *tableNameObj = NULL;
+	casstcl_breaker *breaker;
+	int tclReturn = TCL_OK;
+	int optIndex;
+	int arg = 3;
+
+	static CONST char *options[] = {
+		"enable",
+		"configure",
+		"disable",
+		"reset",
+		"stats",
+		"names",
+		NULL
+	};
+
+	enum options {
+		OPT_ENABLE,
+		OPT_CONFIGURE,
+		OPT_DISABLE,
+		OPT_RESET,
+		OPT_STATS,
+		OPT_NAMES
+	};
+
+	if (objc < 3) {
+		Tcl_WrongNumArgs (interp, 2, objv, "subcommand ?-table tableName? ?args?");
+		return TCL_ERROR;
+	}
+
+	if (Tcl_GetIndexFromObj (interp, objv[2], options, "subcommand", TCL_EXACT, &optIndex) != TCL_OK) {
+		return TCL_ERROR;
+	}
+
+	if (objc > 4 && strcmp (Tcl_GetString (objv[3]), "-table") == 0) {
+		tableNameObj = objv[4];
+		arg = 5;
+	}
+
+	if (optIndex != OPT_ENABLE && optIndex != OPT_CONFIGURE && arg != objc) {
+		Tcl_WrongNumArgs (interp, 3, objv, (optIndex == OPT_NAMES) ? "" : "?-table tableName?");
+		return TCL_ERROR;
+	}
+
+	Tcl_MutexLock (&ct->breakerMutex);
+	if (tableNameObj != NULL) {
+		breaker = casstcl_breaker_find (ct, tableNameObj);
+	} else {
+		breaker = ct->breaker.enabled ? &ct->breaker : NULL;
+	}
+
+	switch ((enum options) optIndex) {
+		case OPT_ENABLE: {
+			casstcl_breaker newBreaker;
+			int isNew;
+
+			if (breaker != NULL) {
+				tclReturn = casstcl_breaker_configure (interp, breaker, objc - arg, &objv[arg]);
+				break;
+			}
+
+			memset (&newBreaker, 0, sizeof (newBreaker));
+			newBreaker.enabled = 1;
+			newBreaker.errorRate = CASSTCL_DEFAULT_BREAKER_ERROR_RATE;
+			newBreaker.timeoutRate = CASSTCL_DEFAULT_BREAKER_TIMEOUT_RATE;
+			newBreaker.minRequests = CASSTCL_DEFAULT_BREAKER_MIN_REQUESTS;
+			newBreaker.window = CASSTCL_DEFAULT_BREAKER_WINDOW;
+			newBreaker.cooldown = CASSTCL_DEFAULT_BREAKER_COOLDOWN;
+			newBreaker.probes = CASSTCL_DEFAULT_BREAKER_PROBES;
+			newBreaker.state = CASSTCL_BREAKER_CLOSED;
+			newBreaker.changed = casstcl_now_ms ();
+
+			if ((tclReturn = casstcl_breaker_configure (interp, &newBreaker, objc - arg, &objv[arg])) == TCL_ERROR) {
+				break;
+			}
+
+			if (tableNameObj == NULL) {
+				ct->breaker = newBreaker;
+			} else {
+				Tcl_HashEntry *entry = Tcl_CreateHashEntry (&ct->breakerTable, Tcl_GetString (tableNameObj), &isNew);
+
+				breaker = (casstcl_breaker *)ckalloc (sizeof (casstcl_breaker));
+				*breaker = newBreaker;
+				Tcl_SetHashValue (entry, breaker);
+			}
+			break;
+		}
+
+		case OPT_CONFIGURE: {
+			if (breaker == NULL) {
+				Tcl_ResetResult (interp);
+				Tcl_AppendResult (interp, "no circuit breaker is enabled for ", (tableNameObj != NULL) ? "that table" : "the session", NULL);
+				tclReturn = TCL_ERROR;
+				break;
+			}
+
+			if (arg == objc) {
+				Tcl_SetObjResult (interp, casstcl_breaker_to_list (breaker, 0));
+				break;
+			}
+
+			tclReturn = casstcl_breaker_configure (interp, breaker, objc - arg, &objv[arg]);
+			break;
+		}
+
+		case OPT_DISABLE: {
+			if (tableNameObj == NULL) {
+				memset (&ct->breaker, 0, sizeof (ct->breaker));
+			} else if (breaker != NULL) {
+				Tcl_HashEntry *entry = Tcl_FindHashEntry (&ct->breakerTable, Tcl_GetString (tableNameObj));
+
+				ckfree ((char *)breaker);
+				Tcl_DeleteHashEntry (entry);
+			}
+			break;
+		}
+
+		case OPT_RESET: {
+			if (breaker != NULL) {
+				casstcl_breaker_close (breaker, casstcl_now_ms ());
+			}
+			break;
+		}
+
+		case OPT_STATS: {
+			if (breaker != NULL) {
+				Tcl_SetObjResult (interp, casstcl_breaker_to_list (breaker, 1));
+			}
+			break;
+		}
+
+		case OPT_NAMES: {
+			Tcl_Obj *listObj = Tcl_NewObj ();
+			Tcl_HashSearch search;
+			Tcl_HashEntry *entry;
+
+			for (entry = Tcl_FirstHashEntry (&ct->breakerTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+				Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj (Tcl_GetHashKey (&ct->breakerTable, entry), -1));
+			}
+			Tcl_SetObjResult (interp, listObj);
+			break;
+		}
+	}
+	Tcl_MutexUnlock (&ct->breakerMutex);
+
+	return tclReturn;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_breaker_forget_all --
+ *
+ *    free all of a session's per-table circuit breakers.  used when the
+ *    session is deleted, after the driver's threads are done with it.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_breaker_forget_all (casstcl_sessionClientData *ct)
+{
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+
+	for (entry = Tcl_FirstHashEntry (&ct->breakerTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+		ckfree ((char *)Tcl_GetHashValue (entry));
+	}
+	Tcl_DeleteHashTable (&ct->breakerTable);
+	Tcl_MutexFinalize (&ct->breakerMutex);
+}
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
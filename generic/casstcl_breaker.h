@@ -0,0 +1,106 @@
+/*
+ *
+ * Include file for breaker
+ *
+ * Copyright (C) 2015 by FlightAware, All Rights Reserved
+ *
+ * Freely redistributable under the Berkeley copyright, see license.terms
+ * for details.
+ */
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_breaker_admit --
+ *
+ *    decide whether a request to a table, which may be NULL if it isn't
+ *    known, can be sent, checking the table's circuit breaker and then
+ *    the session's.  a half open breaker's probe is only taken once
+ *    both have let the request through, so one isn't used up by a
+ *    request the other breaker refuses.
+ *
+ * Results:
+ *    1 if it can, otherwise 0 and the number of milliseconds until one
+ *    could be in *retryPtr
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_breaker_admit (casstcl_sessionClientData *ct, Tcl_Obj *tableNameObj, Tcl_WideInt *retryPtr);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_breaker_check --
+ *
+ *    casstcl_breaker_admit for requests that fail right away if they
+ *    can't be sent
+ *
+ * Results:
+ *    A standard Tcl result.  A request that isn't let through is an
+ *    error with an errorCode of CASSTCL CIRCUIT_OPEN and the table name,
+ *    or an empty string for the session's circuit breaker.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_breaker_check (casstcl_sessionClientData *ct, Tcl_Obj *tableNameObj);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_breaker_record --
+ *
+ *    count a completed request to a table, which may be NULL if it
+ *    isn't known, against the table's and the session's circuit
+ *    breakers.
+ *
+ *    this may be called from the cpp-driver's threads, but only with a
+ *    NULL tableNameObj, since Tcl objects belong to the session's thread.
+ *    completions that arrive after the session was deleted (like those
+ *    of a coroutine still waiting on exec) are ignored.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_breaker_record (casstcl_sessionClientData *ct, Tcl_Obj *tableNameObj, CassError rc);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_circuit_breaker --
+ *
+ *    implements the circuit_breaker method of a session,
+ *
+ *      circuit_breaker enable ?-table tableName? ?option value ...?
+ *      circuit_breaker configure ?-table tableName? ?option value ...?
+ *      circuit_breaker disable ?-table tableName?
+ *      circuit_breaker reset ?-table tableName?
+ *      circuit_breaker stats ?-table tableName?
+ *      circuit_breaker names
+ *
+ *    a table's circuit breaker covers the requests casstcl knows are
+ *    for that table.  the session's covers all of them.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_circuit_breaker (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[]);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_breaker_forget_all --
+ *
+ *    free all of a session's per-table circuit breakers.  used when the
+ *    session is deleted, after the driver's threads are done with it.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_breaker_forget_all (casstcl_sessionClientData *ct);
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
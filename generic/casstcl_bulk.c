@@ -0,0 +1,693 @@
+/*
+ * casstcl_bulk - Functions used to issue many statements at once while
+ *   keeping a bounded number of them in flight, eg. multiget and
+ *   exec_many
+ *
+ * casstcl - Tcl interface to CassDB
+ *
+ * Copyright (C) 2014 FlightAware LLC
+ *
+ * freely redistributable under the Berkeley license
+ */
+
+#include "casstcl.h"
+#include "casstcl_bulk.h"
+#include "casstcl_prepared.h"
+#include "casstcl_consistency.h"
+#include "casstcl_error.h"
+#include "casstcl_future.h"
+#include "casstcl_ratelimit.h"
+#include "casstcl_breaker.h"
+
+#include <assert.h>
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_bulk_execute --
+ *
+ *    issue count statements against the session, keeping at most
+ *    concurrency of them in flight at once.
+ *
+ *    bindProc is called to make the statement for each item, in order,
+ *    as room opens up in the window.  doneProc is called with each
+ *    item's future as it completes, in whatever order they complete.
+ *    the thread sleeps while the window is full rather than polling.
+ *
+ *    if either proc returns TCL_ERROR, no more statements are issued but
+ *    the ones already in flight are waited for (and not passed to
+ *    doneProc) before returning.
+ *
+ *    prepared statements carry their routing key so with token aware
+ *    routing the driver sends each one straight to a replica.
+ *
+ *    each statement waits for the rate limit of the session and of
+ *    tableNameObj, which may be NULL, sleeping like the window does.
+ *    an open circuit breaker stops issuing statements as an error would
+ *    and the outcome of each one is recorded by the breakers.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_bulk_execute (casstcl_sessionClientData *ct, Tcl_Obj *tableNameObj, int count, int concurrency, casstcl_bulkBindProc *bindProc, casstcl_bulkDoneProc *doneProc, ClientData clientData)
+{
+	CassFuture **futures;
+	int *indexes;
+	int next = 0;
+	int inFlight = 0;
+	int tclReturn = TCL_OK;
+	int slot;
+
+	if (concurrency > count) {
+		concurrency = count;
+	}
+
+	if (concurrency < 1) {
+		concurrency = 1;
+	}
+
+	futures = (CassFuture **)ckalloc (sizeof (CassFuture *) * concurrency);
+	indexes = (int *)ckalloc (sizeof (int) * concurrency);
+	memset (futures, 0, sizeof (CassFuture *) * concurrency);
+
+	while (1) {
+		// fill up the window
+		while (tclReturn == TCL_OK && next < count && inFlight < concurrency) {
+			CassStatement *statement = NULL;
+
+			if (casstcl_breaker_check (ct, tableNameObj) == TCL_ERROR) {
+				tclReturn = TCL_ERROR;
+				break;
+			}
+
+			int bindReturn = (*bindProc) (ct, next, clientData, &statement);
+
+			if (bindReturn == TCL_CONTINUE) {
+				next++;
+				continue;
+			}
+
+			if (bindReturn == TCL_ERROR) {
+				tclReturn = TCL_ERROR;
+				break;
+			}
+
+			for (slot = 0; futures[slot] != NULL; slot++) {
+				continue;
+			}
+
+			casstcl_rate_limit_sleep (ct, tableNameObj);
+			futures[slot] = cass_session_execute (ct->session, statement);
+			cass_statement_free (statement);
+			casstcl_wait_watch (futures[slot]);
+			indexes[slot] = next++;
+			inFlight++;
+		}
+
+		if (inFlight == 0) {
+			break;
+		}
+
+		slot = casstcl_wait_for_ready (futures, concurrency);
+		assert (slot >= 0);
+
+		casstcl_breaker_record (ct, tableNameObj, cass_future_error_code (futures[slot]));
+		if (tclReturn == TCL_OK) {
+			tclReturn = (*doneProc) (ct, indexes[slot], futures[slot], clientData);
+		}
+
+		cass_future_free (futures[slot]);
+		futures[slot] = NULL;
+		inFlight--;
+	}
+
+	ckfree ((char *)futures);
+	ckfree ((char *)indexes);
+	return tclReturn;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_bulk_error_obj --
+ *
+ *    given a failed future and its error code, return a new list of the
+ *    error code like CASS_ERROR_SERVER_READ_TIMEOUT, the description of
+ *    the error and the message from the future, which is what
+ *    casstcl_future_error_to_tcl puts after CASSANDRA in errorCode
+ *
+ * Results:
+ *    A Tcl list object with a reference count of zero
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Obj *
+casstcl_bulk_error_obj (CassError rc, CassFuture *future)
+{
+	Tcl_Obj *errorObj = Tcl_NewObj ();
+	CassString message;
+
+	cass_future_error_message (future, &message.data, &message.length);
+
+	Tcl_ListObjAppendElement (NULL, errorObj, Tcl_NewStringObj (casstcl_cass_error_to_errorcode_string (rc), -1));
+	Tcl_ListObjAppendElement (NULL, errorObj, Tcl_NewStringObj (cass_error_desc (rc), -1));
+	Tcl_ListObjAppendElement (NULL, errorObj, Tcl_NewStringObj (message.data, message.length));
+	return errorObj;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_multiget_bind --
+ *
+ *    bulk bind proc for multiget, binds one key into the prepared
+ *    statement.  with -columns the key is the value of the only column,
+ *    or a list of values, one for each column.  without it the key is
+ *    a list of column name and value pairs.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_multiget_bind (casstcl_sessionClientData *ct, int index, ClientData clientData, CassStatement **statementPtr)
+{
+	casstcl_multigetState *mg = (casstcl_multigetState *)clientData;
+	Tcl_Interp *interp = ct->interp;
+	Tcl_Obj *keyObj = mg->keyObjv[index];
+	Tcl_Obj **valueObjv;
+	int valueObjc;
+	int i;
+
+	if (mg->columnObjc == 0) {
+		if (Tcl_ListObjGetElements (interp, keyObj, &valueObjc, &valueObjv) == TCL_ERROR) {
+			Tcl_AppendResult (interp, " while parsing key", NULL);
+			return TCL_ERROR;
+		}
+
+		if (valueObjc & 1) {
+			Tcl_ResetResult (interp);
+			Tcl_AppendResult (interp, "key '", Tcl_GetString (keyObj), "' must be a list of column name and value pairs when -columns isn't given", NULL);
+			return TCL_ERROR;
+		}
+
+		return casstcl_bind_names_from_prepared (mg->pcd, valueObjc, valueObjv, mg->consistencyPtr, statementPtr);
+	}
+
+	if (mg->columnObjc == 1) {
+		valueObjc = 1;
+		valueObjv = &keyObj;
+	} else {
+		if (Tcl_ListObjGetElements (interp, keyObj, &valueObjc, &valueObjv) == TCL_ERROR) {
+			Tcl_AppendResult (interp, " while parsing key", NULL);
+			return TCL_ERROR;
+		}
+
+		if (valueObjc != mg->columnObjc) {
+			Tcl_ResetResult (interp);
+			Tcl_AppendResult (interp, "key '", Tcl_GetString (keyObj), "' doesn't have one value for each of the -columns", NULL);
+			return TCL_ERROR;
+		}
+	}
+
+	for (i = 0; i < valueObjc; i++) {
+		mg->pairObjv[i * 2] = mg->columnObjv[i];
+		mg->pairObjv[i * 2 + 1] = valueObjv[i];
+	}
+
+	return casstcl_bind_names_from_prepared (mg->pcd, valueObjc * 2, mg->pairObjv, mg->consistencyPtr, statementPtr);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_multiget_done --
+ *
+ *    bulk done proc for multiget, saves the rows for one key, or the
+ *    error if the read failed
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_multiget_done (casstcl_sessionClientData *ct, int index, CassFuture *future, ClientData clientData)
+{
+	casstcl_multigetState *mg = (casstcl_multigetState *)clientData;
+	CassError rc = cass_future_error_code (future);
+	Tcl_Obj *rowsObj = NULL;
+
+	if (rc != CASS_OK) {
+		mg->errorObjv[index] = casstcl_bulk_error_obj (rc, future);
+		Tcl_IncrRefCount (mg->errorObjv[index]);
+		return TCL_OK;
+	}
+
+	if (casstcl_future_rows (ct, future, &rowsObj) == TCL_ERROR) {
+		return TCL_ERROR;
+	}
+
+	mg->rowsObjv[index] = rowsObj;
+	Tcl_IncrRefCount (rowsObj);
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_multiget --
+ *
+ *    implements the multiget method of a casstcl session,
+ *
+ *      $cass multiget -prepared preparedName -keys keyList
+ *        ?-columns columnList? ?-concurrency n? ?-consistency level?
+ *        ?-dict? ?-errors varName?
+ *
+ *    which binds the prepared statement once for each key, reads them
+ *    all with at most n requests in flight and returns the rows for
+ *    each key like the future "rows" method does.
+ *
+ *    the result is a list of the rows of each key in the order the keys
+ *    were given or, with -dict, a dict of key to rows.
+ *
+ *    if any of the reads fail and -errors was given, the variable is set
+ *    to a dict of each failed key to a list of its error code, the
+ *    error's description and the message, the failed keys are left
+ *    out of the dict (or have no rows in the list) and the command
+ *    succeeds.  without -errors the first failed key (in the order
+ *    given) raises its error once all the reads are done.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_multiget (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Interp *interp = ct->interp;
+	casstcl_multigetState mg;
+	CassConsistency consistency;
+	Tcl_Obj *keysObj = NULL;
+	Tcl_Obj *errorsVarObj = NULL;
+	Tcl_Obj *resultObj = NULL;
+	Tcl_Obj *errorsObj = NULL;
+	int keyObjc = 0;
+	int concurrency = CASSTCL_DEFAULT_BULK_CONCURRENCY;
+	int dictStyle = 0;
+	int tclReturn;
+	int firstError = -1;
+	int arg = 2;
+	int i;
+
+	static CONST char *subOptions[] = {
+		"-prepared",
+		"-keys",
+		"-columns",
+		"-concurrency",
+		"-consistency",
+		"-dict",
+		"-errors",
+		NULL
+	};
+
+	enum subOptions {
+		SUBOPT_PREPARED,
+		SUBOPT_KEYS,
+		SUBOPT_COLUMNS,
+		SUBOPT_CONCURRENCY,
+		SUBOPT_CONSISTENCY,
+		SUBOPT_DICT,
+		SUBOPT_ERRORS
+	};
+
+	memset (&mg, 0, sizeof (mg));
+
+	while (arg < objc) {
+		int subOptIndex;
+
+		if (Tcl_GetIndexFromObj (interp, objv[arg++], subOptions, "subOption", TCL_EXACT, &subOptIndex) != TCL_OK) {
+			return TCL_ERROR;
+		}
+
+		if ((enum subOptions) subOptIndex == SUBOPT_DICT) {
+			dictStyle = 1;
+			continue;
+		}
+
+		if (arg >= objc) {
+			goto wrong_numargs;
+		}
+
+		switch ((enum subOptions) subOptIndex) {
+			case SUBOPT_PREPARED: {
+				char *preparedName = Tcl_GetString (objv[arg++]);
+
+				mg.pcd = casstcl_prepared_command_to_preparedClientData (interp, preparedName);
+				if (mg.pcd == NULL) {
+					Tcl_ResetResult (interp);
+					Tcl_AppendResult (interp, "-prepared argument '", preparedName, "' isn't a valid prepared statement object", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_KEYS: {
+				keysObj = objv[arg++];
+				break;
+			}
+
+			case SUBOPT_COLUMNS: {
+				if (Tcl_ListObjGetElements (interp, objv[arg++], &mg.columnObjc, &mg.columnObjv) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while parsing list of columns", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_CONCURRENCY: {
+				if (Tcl_GetIntFromObj (interp, objv[arg++], &concurrency) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting concurrency", NULL);
+					return TCL_ERROR;
+				}
+
+				if (concurrency < 1) {
+					Tcl_ResetResult (interp);
+					Tcl_AppendResult (interp, "concurrency must be at least 1", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_CONSISTENCY: {
+				Tcl_Obj *consistencyObj = objv[arg++];
+
+				if (*Tcl_GetString (consistencyObj) != '\0') {
+					if (casstcl_obj_to_cass_consistency (ct, consistencyObj, &consistency) != TCL_OK) {
+						return TCL_ERROR;
+					}
+					mg.consistencyPtr = &consistency;
+				}
+				break;
+			}
+
+			case SUBOPT_ERRORS: {
+				errorsVarObj = objv[arg++];
+				break;
+			}
+
+			case SUBOPT_DICT: {
+				break;
+			}
+		}
+	}
+
+	if (mg.pcd == NULL || keysObj == NULL) {
+	  wrong_numargs:
+		Tcl_WrongNumArgs (interp, 2, objv, "-prepared preparedName -keys keyList ?-columns columnList? ?-concurrency n? ?-consistency level? ?-dict? ?-errors varName?");
+		return TCL_ERROR;
+	}
+
+	if (Tcl_ListObjGetElements (interp, keysObj, &keyObjc, &mg.keyObjv) == TCL_ERROR) {
+		Tcl_AppendResult (interp, " while parsing list of keys", NULL);
+		return TCL_ERROR;
+	}
+
+	mg.pairObjv = (Tcl_Obj **)ckalloc (sizeof (Tcl_Obj *) * (mg.columnObjc * 2 + 1));
+	mg.rowsObjv = (Tcl_Obj **)ckalloc (sizeof (Tcl_Obj *) * (keyObjc + 1));
+	mg.errorObjv = (Tcl_Obj **)ckalloc (sizeof (Tcl_Obj *) * (keyObjc + 1));
+	memset (mg.rowsObjv, 0, sizeof (Tcl_Obj *) * (keyObjc + 1));
+	memset (mg.errorObjv, 0, sizeof (Tcl_Obj *) * (keyObjc + 1));
+
+	tclReturn = casstcl_bulk_execute (ct, mg.pcd->tableNameObj, keyObjc, concurrency, casstcl_multiget_bind, casstcl_multiget_done, (ClientData)&mg);
+
+	if (tclReturn == TCL_OK) {
+		resultObj = dictStyle ? Tcl_NewDictObj () : Tcl_NewObj ();
+		errorsObj = Tcl_NewDictObj ();
+		Tcl_IncrRefCount (errorsObj);
+
+		for (i = 0; i < keyObjc; i++) {
+			if (mg.errorObjv[i] != NULL) {
+				if (firstError < 0) {
+					firstError = i;
+				}
+				Tcl_DictObjPut (NULL, errorsObj, mg.keyObjv[i], mg.errorObjv[i]);
+				if (!dictStyle) {
+					Tcl_ListObjAppendElement (NULL, resultObj, Tcl_NewObj ());
+				}
+				continue;
+			}
+
+			if (dictStyle) {
+				Tcl_DictObjPut (NULL, resultObj, mg.keyObjv[i], mg.rowsObjv[i]);
+			} else {
+				Tcl_ListObjAppendElement (NULL, resultObj, mg.rowsObjv[i]);
+			}
+		}
+
+		if (errorsVarObj != NULL) {
+			if (Tcl_ObjSetVar2 (interp, errorsVarObj, NULL, errorsObj, TCL_LEAVE_ERR_MSG) == NULL) {
+				tclReturn = TCL_ERROR;
+			}
+		} else if (firstError >= 0) {
+			Tcl_Obj **errorObjv;
+			int errorObjc;
+
+			Tcl_ListObjGetElements (NULL, mg.errorObjv[firstError], &errorObjc, &errorObjv);
+			Tcl_ResetResult (interp);
+			Tcl_SetErrorCode (interp, "CASSANDRA", Tcl_GetString (errorObjv[0]), Tcl_GetString (errorObjv[1]), Tcl_GetString (errorObjv[2]), NULL);
+			Tcl_AppendResult (interp, "cassandra error: ", Tcl_GetString (errorObjv[1]), ": ", Tcl_GetString (errorObjv[2]), " while fetching key '", Tcl_GetString (mg.keyObjv[firstError]), "'", NULL);
+			tclReturn = TCL_ERROR;
+		}
+
+		if (tclReturn == TCL_OK) {
+			Tcl_SetObjResult (interp, resultObj);
+		} else {
+			Tcl_DecrRefCount (resultObj);
+		}
+		Tcl_DecrRefCount (errorsObj);
+	}
+
+	for (i = 0; i < keyObjc; i++) {
+		if (mg.rowsObjv[i] != NULL) {
+			Tcl_DecrRefCount (mg.rowsObjv[i]);
+		}
+
+		if (mg.errorObjv[i] != NULL) {
+			Tcl_DecrRefCount (mg.errorObjv[i]);
+		}
+	}
+
+	ckfree ((char *)mg.pairObjv);
+	ckfree ((char *)mg.rowsObjv);
+	ckfree ((char *)mg.errorObjv);
+	return tclReturn;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_exec_many_bind --
+ *
+ *    bulk bind proc for exec_many, binds one row, a list of column name
+ *    and value pairs, into the prepared statement
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_exec_many_bind (casstcl_sessionClientData *ct, int index, ClientData clientData, CassStatement **statementPtr)
+{
+	casstcl_execManyState *em = (casstcl_execManyState *)clientData;
+	Tcl_Interp *interp = ct->interp;
+	Tcl_Obj **pairObjv;
+	int pairObjc;
+	char number[32];
+
+	sprintf (number, "%d", index);
+
+	if (Tcl_ListObjGetElements (interp, em->rowObjv[index], &pairObjc, &pairObjv) == TCL_ERROR) {
+		Tcl_AppendResult (interp, " while parsing row ", number, NULL);
+		return TCL_ERROR;
+	}
+
+	if (pairObjc & 1) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "row ", number, " must contain an even number of elements", NULL);
+		return TCL_ERROR;
+	}
+
+	if (casstcl_bind_names_from_prepared (em->pcd, pairObjc, pairObjv, em->consistencyPtr, statementPtr) == TCL_ERROR) {
+		Tcl_AppendResult (interp, " while binding row ", number, NULL);
+		return TCL_ERROR;
+	}
+
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_exec_many_done --
+ *
+ *    bulk done proc for exec_many, counts a row that was written or
+ *    notes the index and error of one that wasn't
+ *
+ * Results:
+ *    TCL_OK
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_exec_many_done (casstcl_sessionClientData *ct, int index, CassFuture *future, ClientData clientData)
+{
+	casstcl_execManyState *em = (casstcl_execManyState *)clientData;
+	CassError rc = cass_future_error_code (future);
+
+	if (rc == CASS_OK) {
+		em->succeeded++;
+		return TCL_OK;
+	}
+
+	Tcl_ListObjAppendElement (NULL, em->failedObj, Tcl_NewIntObj (index));
+	Tcl_ListObjAppendElement (NULL, em->failedObj, casstcl_bulk_error_obj (rc, future));
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_exec_many --
+ *
+ *    implements the exec_many method of a casstcl session,
+ *
+ *      $cass exec_many -prepared preparedName ?-concurrency n?
+ *        ?-consistency level? rowList
+ *
+ *    which binds each row of rowList, a list of column name and value
+ *    pairs, into the prepared statement and executes them all with at
+ *    most n requests in flight.
+ *
+ *    a row that can't be bound stops things, in which case the rows
+ *    before it may or may not have been written, same as a loop of
+ *    exec would leave them.
+ *
+ * Results:
+ *    A standard Tcl result.  The result is a dict with "ok", the number
+ *    of rows written, and "failed", the index and error (a list like
+ *    the ones multiget -errors produces) of each row that wasn't, in
+ *    the order they completed.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_exec_many (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Interp *interp = ct->interp;
+	casstcl_execManyState em;
+	CassConsistency consistency;
+	int rowObjc = 0;
+	int concurrency = CASSTCL_DEFAULT_BULK_CONCURRENCY;
+	int tclReturn;
+	int arg = 2;
+
+	static CONST char *subOptions[] = {
+		"-prepared",
+		"-concurrency",
+		"-consistency",
+		NULL
+	};
+
+	enum subOptions {
+		SUBOPT_PREPARED,
+		SUBOPT_CONCURRENCY,
+		SUBOPT_CONSISTENCY
+	};
+
+	memset (&em, 0, sizeof (em));
+
+	while (arg + 2 < objc) {
+		int subOptIndex;
+
+		if (Tcl_GetIndexFromObj (interp, objv[arg++], subOptions, "subOption", TCL_EXACT, &subOptIndex) != TCL_OK) {
+			return TCL_ERROR;
+		}
+
+		switch ((enum subOptions) subOptIndex) {
+			case SUBOPT_PREPARED: {
+				char *preparedName = Tcl_GetString (objv[arg++]);
+
+				em.pcd = casstcl_prepared_command_to_preparedClientData (interp, preparedName);
+				if (em.pcd == NULL) {
+					Tcl_ResetResult (interp);
+					Tcl_AppendResult (interp, "-prepared argument '", preparedName, "' isn't a valid prepared statement object", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_CONCURRENCY: {
+				if (Tcl_GetIntFromObj (interp, objv[arg++], &concurrency) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting concurrency", NULL);
+					return TCL_ERROR;
+				}
+
+				if (concurrency < 1) {
+					Tcl_ResetResult (interp);
+					Tcl_AppendResult (interp, "concurrency must be at least 1", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_CONSISTENCY: {
+				Tcl_Obj *consistencyObj = objv[arg++];
+
+				if (*Tcl_GetString (consistencyObj) != '\0') {
+					if (casstcl_obj_to_cass_consistency (ct, consistencyObj, &consistency) != TCL_OK) {
+						return TCL_ERROR;
+					}
+					em.consistencyPtr = &consistency;
+				}
+				break;
+			}
+		}
+	}
+
+	if (em.pcd == NULL || arg + 1 != objc) {
+		Tcl_WrongNumArgs (interp, 2, objv, "-prepared preparedName ?-concurrency n? ?-consistency level? rowList");
+		return TCL_ERROR;
+	}
+
+	if (Tcl_ListObjGetElements (interp, objv[arg], &rowObjc, &em.rowObjv) == TCL_ERROR) {
+		Tcl_AppendResult (interp, " while parsing list of rows", NULL);
+		return TCL_ERROR;
+	}
+
+	em.failedObj = Tcl_NewObj ();
+	Tcl_IncrRefCount (em.failedObj);
+
+	tclReturn = casstcl_bulk_execute (ct, em.pcd->tableNameObj, rowObjc, concurrency, casstcl_exec_many_bind, casstcl_exec_many_done, (ClientData)&em);
+
+	if (tclReturn == TCL_OK) {
+		Tcl_Obj *resultObj = Tcl_NewObj ();
+
+		Tcl_ListObjAppendElement (NULL, resultObj, Tcl_NewStringObj ("ok", -1));
+		Tcl_ListObjAppendElement (NULL, resultObj, Tcl_NewIntObj (em.succeeded));
+		Tcl_ListObjAppendElement (NULL, resultObj, Tcl_NewStringObj ("failed", -1));
+		Tcl_ListObjAppendElement (NULL, resultObj, em.failedObj);
+		Tcl_SetObjResult (interp, resultObj);
+	}
+
+	Tcl_DecrRefCount (em.failedObj);
+	return tclReturn;
+}
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
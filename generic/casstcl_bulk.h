@@ -0,0 +1,109 @@
+/*
+ *
+ * Include file for casstcl_bulk
+ *
+ * Copyright (C) 2015 by FlightAware, All Rights Reserved
+ *
+ * Freely redistributable under the Berkeley copyright, see license.terms
+ * for details.
+ */
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_bulk_execute --
+ *
+ *    issue count statements against the session, keeping at most
+ *    concurrency of them in flight at once.
+ *
+ *    bindProc is called to make the statement for each item, in order,
+ *    as room opens up in the window.  doneProc is called with each
+ *    item's future as it completes, in whatever order they complete.
+ *    the thread sleeps while the window is full rather than polling.
+ *
+ *    if either proc returns TCL_ERROR, no more statements are issued but
+ *    the ones already in flight are waited for (and not passed to
+ *    doneProc) before returning.
+ *
+ *    prepared statements carry their routing key so with token aware
+ *    routing the driver sends each one straight to a replica.
+ *
+ *    each statement waits for the rate limit of the session and of
+ *    tableNameObj, which may be NULL, sleeping like the window does.
+ *    an open circuit breaker stops issuing statements as an error would
+ *    and the outcome of each one is recorded by the breakers.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_bulk_execute (casstcl_sessionClientData *ct, Tcl_Obj *tableNameObj, int count, int concurrency, casstcl_bulkBindProc *bindProc, casstcl_bulkDoneProc *doneProc, ClientData clientData);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_bulk_error_obj --
+ *
+ *    given a failed future and its error code, return a new list of the
+ *    error code like CASS_ERROR_SERVER_READ_TIMEOUT, the description of
+ *    the error and the message from the future, which is what
+ *    casstcl_future_error_to_tcl puts after CASSANDRA in errorCode
+ *
+ * Results:
+ *    A Tcl list object with a reference count of zero
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Obj *
+casstcl_bulk_error_obj (CassError rc, CassFuture *future);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_multiget --
+ *
+ *    implements the multiget method of a casstcl session,
+ *
+ *      $cass multiget -prepared preparedName -keys keyList
+ *        ?-columns columnList? ?-concurrency n? ?-consistency level?
+ *        ?-dict? ?-errors varName?
+ *
+ *    which binds the prepared statement once for each key, reads them
+ *    all with at most n requests in flight and returns the rows for
+ *    each key like the future "rows" method does.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_multiget (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[]);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_exec_many --
+ *
+ *    implements the exec_many method of a casstcl session,
+ *
+ *      $cass exec_many -prepared preparedName ?-concurrency n?
+ *        ?-consistency level? rowList
+ *
+ *    which binds each row of rowList, a list of column name and value
+ *    pairs, into the prepared statement and executes them all with at
+ *    most n requests in flight.
+ *
+ * Results:
+ *    A standard Tcl result.  The result is a dict with "ok", the number
+ *    of rows written, and "failed", the index and error of each row
+ *    that wasn't.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_exec_many (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[]);
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
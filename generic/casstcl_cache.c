@@ -0,0 +1,1150 @@
+/*
+ * casstcl_cache - Functions used to implement read-through row caches,
+ *   which keep the decoded rows a prepared select returns for each key
+ *   and fill misses asynchronously
+ *
+ * casstcl - Tcl interface to CassDB
+ *
+ * Copyright (C) 2014 FlightAware LLC
+ *
+ * freely redistributable under the Berkeley license
+ */
+
+#include "casstcl.h"
+#include "casstcl_cache.h"
+#include "casstcl_consistency.h"
+#include "casstcl_future.h"
+#include "casstcl_prepared.h"
+#include "casstcl_ratelimit.h"
+#include "casstcl_breaker.h"
+
+#include <assert.h>
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache_unlink --
+ *
+ *    take a cache entry off its cache's list of entries in order of use
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_cache_unlink (casstcl_cacheEntry *entry)
+{
+	casstcl_cacheClientData *cache = entry->cache;
+
+	if (entry->newer != NULL) {
+		entry->newer->older = entry->older;
+	} else {
+		cache->newest = entry->older;
+	}
+
+	if (entry->older != NULL) {
+		entry->older->newer = entry->newer;
+	} else {
+		cache->oldest = entry->newer;
+	}
+
+	entry->newer = NULL;
+	entry->older = NULL;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache_link --
+ *
+ *    put a cache entry at the newest end of its cache's list of entries
+ *    in order of use
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_cache_link (casstcl_cacheEntry *entry)
+{
+	casstcl_cacheClientData *cache = entry->cache;
+
+	entry->newer = NULL;
+	entry->older = cache->newest;
+
+	if (cache->newest != NULL) {
+		cache->newest->newer = entry;
+	} else {
+		cache->oldest = entry;
+	}
+	cache->newest = entry;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache_free_entry --
+ *
+ *    free a cache entry that is no longer in its cache and has no fill
+ *    in flight
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_cache_free_entry (casstcl_cacheEntry *entry)
+{
+	assert (entry->hashEntry == NULL && entry->future == NULL);
+
+	Tcl_DecrRefCount (entry->keyObj);
+	if (entry->rowsObj != NULL) {
+		Tcl_DecrRefCount (entry->rowsObj);
+	}
+	if (entry->errorObj != NULL) {
+		Tcl_DecrRefCount (entry->errorObj);
+	}
+	if (entry->errorCodeObj != NULL) {
+		Tcl_DecrRefCount (entry->errorCodeObj);
+	}
+	if (entry->waitersObj != NULL) {
+		Tcl_DecrRefCount (entry->waitersObj);
+	}
+	ckfree ((char *)entry);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache_detach --
+ *
+ *    take an entry out of its cache.  it is freed right away unless it
+ *    is still being filled, in which case it goes when the fill
+ *    completes, after whatever gets are waiting on it are answered.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_cache_detach (casstcl_cacheEntry *entry)
+{
+	casstcl_cache_unlink (entry);
+	Tcl_DeleteHashEntry (entry->hashEntry);
+	entry->hashEntry = NULL;
+
+	if (entry->future == NULL) {
+		casstcl_cache_free_entry (entry);
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache_bind --
+ *
+ *    bind a key into a cache's prepared statement.  with -columns the
+ *    key is the value of the only column, or a list of values, one for
+ *    each column.  without it the key is a list of column name and value
+ *    pairs.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_cache_bind (casstcl_cacheClientData *cache, Tcl_Obj *keyObj, CassStatement **statementPtr)
+{
+	Tcl_Interp *interp = cache->ct->interp;
+	CassConsistency *consistencyPtr = (cache->consistency == CASS_CONSISTENCY_UNKNOWN) ? NULL : &cache->consistency;
+	casstcl_preparedClientData *pcd;
+	Tcl_Obj **columnObjv;
+	Tcl_Obj **valueObjv;
+	Tcl_Obj **pairObjv;
+	int columnObjc;
+	int valueObjc;
+	int tclReturn;
+	int i;
+
+	pcd = casstcl_prepared_command_to_preparedClientData (interp, Tcl_GetString (cache->preparedObj));
+	if (pcd == NULL) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "-prepared argument '", Tcl_GetString (cache->preparedObj), "' isn't a valid prepared statement object", NULL);
+		return TCL_ERROR;
+	}
+
+	if (cache->columnsObj == NULL) {
+		if (Tcl_ListObjGetElements (interp, keyObj, &valueObjc, &valueObjv) == TCL_ERROR) {
+			Tcl_AppendResult (interp, " while parsing key", NULL);
+			return TCL_ERROR;
+		}
+
+		if (valueObjc & 1) {
+			Tcl_ResetResult (interp);
+			Tcl_AppendResult (interp, "key '", Tcl_GetString (keyObj), "' must be a list of column name and value pairs when -columns isn't given", NULL);
+			return TCL_ERROR;
+		}
+
+		return casstcl_bind_names_from_prepared (pcd, valueObjc, valueObjv, consistencyPtr, statementPtr);
+	}
+
+	// -columns was checked to be a list when it was configured
+	Tcl_ListObjGetElements (NULL, cache->columnsObj, &columnObjc, &columnObjv);
+
+	if (columnObjc == 1) {
+		valueObjc = 1;
+		valueObjv = &keyObj;
+	} else {
+		if (Tcl_ListObjGetElements (interp, keyObj, &valueObjc, &valueObjv) == TCL_ERROR) {
+			Tcl_AppendResult (interp, " while parsing key", NULL);
+			return TCL_ERROR;
+		}
+
+		if (valueObjc != columnObjc) {
+			Tcl_ResetResult (interp);
+			Tcl_AppendResult (interp, "key '", Tcl_GetString (keyObj), "' doesn't have one value for each of the -columns", NULL);
+			return TCL_ERROR;
+		}
+	}
+
+	pairObjv = (Tcl_Obj **)ckalloc (sizeof (Tcl_Obj *) * valueObjc * 2);
+	for (i = 0; i < valueObjc; i++) {
+		pairObjv[i * 2] = columnObjv[i];
+		pairObjv[i * 2 + 1] = valueObjv[i];
+	}
+
+	tclReturn = casstcl_bind_names_from_prepared (pcd, valueObjc * 2, pairObjv, consistencyPtr, statementPtr);
+	ckfree ((char *)pairObjv);
+	return tclReturn;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache_complete --
+ *
+ *    take the rows, or the error, from the completed fill of a cache
+ *    entry.  the future is left for casstcl_cache_eventProc to free.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_cache_complete (casstcl_cacheEntry *entry)
+{
+	casstcl_cacheClientData *cache = entry->cache;
+	Tcl_Interp *interp = cache->ct->interp;
+	Tcl_Obj *rowsObj = NULL;
+
+	if (casstcl_future_rows (cache->ct, entry->future, &rowsObj) == TCL_OK) {
+		entry->rowsObj = rowsObj;
+		Tcl_IncrRefCount (rowsObj);
+		entry->expires = (cache->ttl == 0) ? 0 : casstcl_now_ms () + (Tcl_WideInt)cache->ttl * 1000;
+		return;
+	}
+
+	// the error code is kept so a get that comes along later can raise
+	// the same error
+	Tcl_Obj *optionsObj = Tcl_GetReturnOptions (interp, TCL_ERROR);
+	Tcl_Obj *nameObj = Tcl_NewStringObj ("-errorcode", -1);
+	Tcl_Obj *errorCodeObj = NULL;
+
+	Tcl_IncrRefCount (optionsObj);
+	Tcl_IncrRefCount (nameObj);
+	Tcl_DictObjGet (NULL, optionsObj, nameObj, &errorCodeObj);
+	entry->errorCodeObj = (errorCodeObj != NULL) ? errorCodeObj : Tcl_NewObj ();
+	Tcl_IncrRefCount (entry->errorCodeObj);
+	Tcl_DecrRefCount (nameObj);
+	Tcl_DecrRefCount (optionsObj);
+
+	entry->errorObj = Tcl_GetObjResult (interp);
+	Tcl_IncrRefCount (entry->errorObj);
+	Tcl_ResetResult (interp);
+
+	cache->errors++;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache_invoke --
+ *
+ *    invoke a get's callback with the key, "ok" or "error", and the rows
+ *    or the error message.  if the callback gets an error, a Tcl
+ *    background exception is invoked.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_cache_invoke (Tcl_Interp *interp, Tcl_Obj *callbackObj, Tcl_Obj *keyObj, Tcl_Obj *rowsObj, Tcl_Obj *errorObj)
+{
+	Tcl_Obj *evalObj = Tcl_DuplicateObj (callbackObj);
+	int tclReturn;
+
+	Tcl_IncrRefCount (evalObj);
+
+	tclReturn = Tcl_ListObjAppendElement (interp, evalObj, keyObj);
+	if (tclReturn == TCL_OK) {
+		Tcl_ListObjAppendElement (NULL, evalObj, Tcl_NewStringObj ((rowsObj != NULL) ? "ok" : "error", -1));
+		Tcl_ListObjAppendElement (NULL, evalObj, (rowsObj != NULL) ? rowsObj : errorObj);
+		tclReturn = Tcl_EvalObjEx (interp, evalObj, TCL_EVAL_GLOBAL);
+	}
+
+	if (tclReturn == TCL_ERROR) {
+		Tcl_BackgroundError (interp);
+	}
+
+	Tcl_DecrRefCount (evalObj);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache_eventProc --
+ *
+ *    this routine is called by the Tcl event handler when the select
+ *    filling a cache entry has completed
+ *
+ * Results:
+ *    The entry gets its rows, or is dropped from the cache if the
+ *    select failed, and the callbacks of the gets waiting on it are
+ *    invoked.
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_cache_eventProc (Tcl_Event *tevPtr, int flags) {
+	casstcl_cacheEvent *evPtr = (casstcl_cacheEvent *)tevPtr;
+	casstcl_cacheEntry *entry = evPtr->entry;
+	casstcl_cacheClientData *cache = entry->cache;
+	casstcl_sessionClientData *ct = cache->ct;
+	Tcl_Obj *waitersObj = NULL;
+	Tcl_Obj *keyObj = entry->keyObj;
+	Tcl_Obj *rowsObj;
+	Tcl_Obj *errorObj;
+	casstcl_preparedClientData *pcd = NULL;
+
+	// every fill is counted once by the circuit breakers, here
+	if (!cache->deleted && cache->preparedObj != NULL) {
+		pcd = casstcl_prepared_command_to_preparedClientData (ct->interp, Tcl_GetString (cache->preparedObj));
+	}
+	casstcl_breaker_record (ct, (pcd != NULL) ? pcd->tableNameObj : NULL, cass_future_error_code (entry->future));
+
+	// a synchronous get may have already taken the result
+	if (!cache->deleted && entry->rowsObj == NULL && entry->errorObj == NULL) {
+		casstcl_cache_complete (entry);
+	}
+
+	cass_future_free (entry->future);
+	entry->future = NULL;
+
+	waitersObj = entry->waitersObj;
+	entry->waitersObj = NULL;
+
+	rowsObj = entry->rowsObj;
+	errorObj = entry->errorObj;
+	Tcl_IncrRefCount (keyObj);
+	if (rowsObj != NULL) {
+		Tcl_IncrRefCount (rowsObj);
+	}
+	if (errorObj != NULL) {
+		Tcl_IncrRefCount (errorObj);
+	}
+
+	// errors aren't cached, the next get tries again
+	if (entry->hashEntry == NULL) {
+		casstcl_cache_free_entry (entry);
+	} else if (errorObj != NULL) {
+		casstcl_cache_detach (entry);
+	}
+
+	if (waitersObj != NULL) {
+		Tcl_Obj **waiterObjv;
+		int waiterObjc;
+		int i;
+
+		Tcl_ListObjGetElements (NULL, waitersObj, &waiterObjc, &waiterObjv);
+		for (i = 0; i < waiterObjc && !Tcl_InterpDeleted (ct->interp); i++) {
+			casstcl_cache_invoke (ct->interp, waiterObjv[i], keyObj, rowsObj, errorObj);
+		}
+		Tcl_DecrRefCount (waitersObj);
+	}
+
+	Tcl_DecrRefCount (keyObj);
+	if (rowsObj != NULL) {
+		Tcl_DecrRefCount (rowsObj);
+	}
+	if (errorObj != NULL) {
+		Tcl_DecrRefCount (errorObj);
+	}
+
+	Tcl_Release ((ClientData)cache);
+	Tcl_Release ((ClientData)ct);
+	return 1;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache_callback --
+ *
+ *    this routine is called by the cassandra cpp-driver, in one of its
+ *    own threads, when the select filling a cache entry completes.  it
+ *    queues an event to the session's thread for casstcl_cache_eventProc.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_cache_callback (CassFuture *future, void *data) {
+	casstcl_cacheEntry *entry = (casstcl_cacheEntry *)data;
+	casstcl_cacheEvent *evPtr = (casstcl_cacheEvent *) ckalloc (sizeof (casstcl_cacheEvent));
+
+	evPtr->event.proc = casstcl_cache_eventProc;
+	evPtr->entry = entry;
+	Tcl_ThreadQueueEvent (entry->cache->ct->threadId, (Tcl_Event *)evPtr, TCL_QUEUE_TAIL);
+	casstcl_wait_notify ();
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache_lookup --
+ *
+ *    find the cache entry for a key, counting a hit if it has rows that
+ *    haven't expired.  if there is no entry, or it has expired, a new
+ *    one is made and the select to fill it is sent.  a key that is
+ *    already being filled is simply returned, so that any number of
+ *    gets of it share the one select.
+ *
+ *    if the cache is over its maximum size the least recently used
+ *    entries are evicted.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_cache_lookup (casstcl_cacheClientData *cache, Tcl_Obj *keyObj, casstcl_cacheEntry **entryPtr)
+{
+	casstcl_sessionClientData *ct = cache->ct;
+	casstcl_cacheEntry *entry;
+	Tcl_HashEntry *hashEntry;
+	CassStatement *statement = NULL;
+	casstcl_preparedClientData *pcd;
+	int isNew;
+
+	hashEntry = Tcl_FindHashEntry (&cache->entryTable, Tcl_GetString (keyObj));
+	if (hashEntry != NULL) {
+		entry = (casstcl_cacheEntry *)Tcl_GetHashValue (hashEntry);
+
+		if (entry->rowsObj == NULL || entry->expires == 0 || casstcl_now_ms () < entry->expires) {
+			if (entry->rowsObj != NULL) {
+				cache->hits++;
+			} else {
+				cache->misses++;
+				cache->collapsed++;
+			}
+
+			casstcl_cache_unlink (entry);
+			casstcl_cache_link (entry);
+			*entryPtr = entry;
+			return TCL_OK;
+		}
+
+		cache->expirations++;
+		casstcl_cache_detach (entry);
+	}
+
+	cache->misses++;
+
+	// a fill is refused while a circuit breaker is open
+	pcd = casstcl_prepared_command_to_preparedClientData (ct->interp, Tcl_GetString (cache->preparedObj));
+	if (casstcl_breaker_check (ct, (pcd != NULL) ? pcd->tableNameObj : NULL) == TCL_ERROR) {
+		return TCL_ERROR;
+	}
+
+	if (casstcl_cache_bind (cache, keyObj, &statement) == TCL_ERROR) {
+		return TCL_ERROR;
+	}
+
+	entry = (casstcl_cacheEntry *)ckalloc (sizeof (casstcl_cacheEntry));
+	entry->cache = cache;
+	entry->hashEntry = Tcl_CreateHashEntry (&cache->entryTable, Tcl_GetString (keyObj), &isNew);
+	Tcl_SetHashValue (entry->hashEntry, entry);
+	entry->keyObj = keyObj;
+	Tcl_IncrRefCount (keyObj);
+	entry->rowsObj = NULL;
+	entry->errorObj = NULL;
+	entry->errorCodeObj = NULL;
+	entry->expires = 0;
+	entry->waitersObj = NULL;
+	casstcl_cache_link (entry);
+
+	// the cache and the session have to stay around until the fill's
+	// event is handled, even if they're deleted in the meantime
+	Tcl_Preserve ((ClientData)cache);
+	Tcl_Preserve ((ClientData)ct);
+
+	// a fill doesn't wait for the rate limit, other gets may be waiting
+	// on it, but it counts against it
+	casstcl_rate_limit_charge (ct, (pcd != NULL) ? pcd->tableNameObj : NULL);
+
+	entry->future = cass_session_execute (ct->session, statement);
+	cass_statement_free (statement);
+	cass_future_set_callback (entry->future, casstcl_cache_callback, entry);
+	cache->fills++;
+
+	while (cache->maxEntries > 0 && cache->entryTable.numEntries > cache->maxEntries && cache->oldest != entry) {
+		casstcl_cache_detach (cache->oldest);
+		cache->evictions++;
+	}
+
+	*entryPtr = entry;
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache_get --
+ *
+ *    get the rows for a key from a cache.
+ *
+ *    without a callback, the rows are returned, waiting for the select
+ *    if the key isn't cached or is already being filled.
+ *
+ *    with a callback, it's invoked with the key, "ok" and the rows, or
+ *    the key, "error" and the error message.  on a hit that happens
+ *    right away and 1 is returned, otherwise 0 is returned and the
+ *    callback is invoked from the event loop once the fill completes.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_cache_get (casstcl_cacheClientData *cache, Tcl_Obj *keyObj, Tcl_Obj *callbackObj)
+{
+	Tcl_Interp *interp = cache->ct->interp;
+	casstcl_cacheEntry *entry;
+
+	if (casstcl_cache_lookup (cache, keyObj, &entry) == TCL_ERROR) {
+		return TCL_ERROR;
+	}
+
+	if (entry->rowsObj == NULL && entry->errorObj == NULL) {
+		if (callbackObj != NULL) {
+			if (entry->waitersObj == NULL) {
+				entry->waitersObj = Tcl_NewObj ();
+				Tcl_IncrRefCount (entry->waitersObj);
+			}
+			Tcl_ListObjAppendElement (NULL, entry->waitersObj, callbackObj);
+			Tcl_SetObjResult (interp, Tcl_NewBooleanObj (0));
+			return TCL_OK;
+		}
+
+		cass_future_wait (entry->future);
+		casstcl_cache_complete (entry);
+	}
+
+	if (callbackObj != NULL) {
+		casstcl_cache_invoke (interp, callbackObj, entry->keyObj, entry->rowsObj, entry->errorObj);
+		Tcl_SetObjResult (interp, Tcl_NewBooleanObj (1));
+		return TCL_OK;
+	}
+
+	if (entry->errorObj != NULL) {
+		Tcl_SetObjResult (interp, entry->errorObj);
+		Tcl_SetObjErrorCode (interp, entry->errorCodeObj);
+		return TCL_ERROR;
+	}
+
+	Tcl_SetObjResult (interp, entry->rowsObj);
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache_invalidate --
+ *
+ *    drop a key from a cache, or every key if keyObj is NULL, so the
+ *    next get of it reads it again.  gets waiting on a key that is
+ *    being filled still get the rows of that fill.
+ *
+ * Results:
+ *    The number of entries dropped
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_cache_invalidate (casstcl_cacheClientData *cache, Tcl_Obj *keyObj)
+{
+	Tcl_HashEntry *hashEntry;
+	int count = 0;
+
+	if (keyObj != NULL) {
+		hashEntry = Tcl_FindHashEntry (&cache->entryTable, Tcl_GetString (keyObj));
+		if (hashEntry != NULL) {
+			casstcl_cache_detach ((casstcl_cacheEntry *)Tcl_GetHashValue (hashEntry));
+			count++;
+		}
+	} else {
+		while (cache->newest != NULL) {
+			casstcl_cache_detach (cache->newest);
+			count++;
+		}
+	}
+
+	cache->invalidations += count;
+	return count;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache_configure --
+ *
+ *    set the options of a row cache from a list of option value pairs,
+ *    or with none, set the interpreter result to a list of them.
+ *    nothing is changed if any of them are bad.  changing -prepared or
+ *    -columns changes what the keys mean, so everything cached is
+ *    dropped, and lowering -max_entries evicts what no longer fits.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_cache_configure (casstcl_cacheClientData *cache, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Interp *interp = cache->ct->interp;
+	Tcl_Obj *preparedObj = cache->preparedObj;
+	Tcl_Obj *columnsObj = cache->columnsObj;
+	int ttl = cache->ttl;
+	int maxEntries = cache->maxEntries;
+	CassConsistency consistency = cache->consistency;
+	int arg;
+
+	static CONST char *subOptions[] = {
+		"-prepared",
+		"-columns",
+		"-ttl",
+		"-max_entries",
+		"-consistency",
+		NULL
+	};
+
+	enum subOptions {
+		SUBOPT_PREPARED,
+		SUBOPT_COLUMNS,
+		SUBOPT_TTL,
+		SUBOPT_MAX_ENTRIES,
+		SUBOPT_CONSISTENCY
+	};
+
+	if (objc == 0) {
+		Tcl_Obj *listObj = Tcl_NewObj ();
+
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-prepared", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, (cache->preparedObj != NULL) ? cache->preparedObj : Tcl_NewObj ());
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-columns", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, (cache->columnsObj != NULL) ? cache->columnsObj : Tcl_NewObj ());
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-ttl", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (cache->ttl));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-max_entries", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (cache->maxEntries));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-consistency", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, (cache->consistency == CASS_CONSISTENCY_UNKNOWN) ? Tcl_NewObj () : Tcl_NewStringObj (casstcl_cass_consistency_to_string (cache->consistency), -1));
+
+		Tcl_SetObjResult (interp, listObj);
+		return TCL_OK;
+	}
+
+	if (objc & 1) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "cache options must be given as option value pairs", NULL);
+		return TCL_ERROR;
+	}
+
+	for (arg = 0; arg < objc; arg += 2) {
+		int subOptIndex;
+
+		if (Tcl_GetIndexFromObj (interp, objv[arg], subOptions, "subOption", TCL_EXACT, &subOptIndex) != TCL_OK) {
+			return TCL_ERROR;
+		}
+
+		switch ((enum subOptions) subOptIndex) {
+			case SUBOPT_PREPARED: {
+				if (casstcl_prepared_command_to_preparedClientData (interp, Tcl_GetString (objv[arg + 1])) == NULL) {
+					Tcl_ResetResult (interp);
+					Tcl_AppendResult (interp, "-prepared argument '", Tcl_GetString (objv[arg + 1]), "' isn't a valid prepared statement object", NULL);
+					return TCL_ERROR;
+				}
+				preparedObj = objv[arg + 1];
+				break;
+			}
+
+			case SUBOPT_COLUMNS: {
+				int columnObjc;
+
+				if (Tcl_ListObjLength (interp, objv[arg + 1], &columnObjc) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while parsing columns", NULL);
+					return TCL_ERROR;
+				}
+				columnsObj = (columnObjc == 0) ? NULL : objv[arg + 1];
+				break;
+			}
+
+			case SUBOPT_TTL: {
+				if (Tcl_GetIntFromObj (interp, objv[arg + 1], &ttl) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting ttl", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_MAX_ENTRIES: {
+				if (Tcl_GetIntFromObj (interp, objv[arg + 1], &maxEntries) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting max_entries", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_CONSISTENCY: {
+				if (casstcl_obj_to_cass_consistency (cache->ct, objv[arg + 1], &consistency) == TCL_ERROR) {
+					return TCL_ERROR;
+				}
+				break;
+			}
+		}
+	}
+
+	if (ttl < 0 || maxEntries < 0) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "cache ttl and max_entries can't be negative", NULL);
+		return TCL_ERROR;
+	}
+
+	if (preparedObj != cache->preparedObj || columnsObj != cache->columnsObj) {
+		casstcl_cache_invalidate (cache, NULL);
+
+		if (preparedObj != NULL) {
+			Tcl_IncrRefCount (preparedObj);
+		}
+		if (cache->preparedObj != NULL) {
+			Tcl_DecrRefCount (cache->preparedObj);
+		}
+		cache->preparedObj = preparedObj;
+
+		if (columnsObj != NULL) {
+			Tcl_IncrRefCount (columnsObj);
+		}
+		if (cache->columnsObj != NULL) {
+			Tcl_DecrRefCount (cache->columnsObj);
+		}
+		cache->columnsObj = columnsObj;
+	}
+
+	cache->ttl = ttl;
+	cache->maxEntries = maxEntries;
+	cache->consistency = consistency;
+
+	while (maxEntries > 0 && cache->entryTable.numEntries > maxEntries) {
+		casstcl_cache_detach (cache->oldest);
+		cache->evictions++;
+	}
+
+	return TCL_OK;
+}
+
+/*
+ *--------------------------------------------------------------
+ *
+ *   casstcl_cache_command_to_cacheClientData -- given a row cache
+ *   command name, find it in the interpreter and return a pointer to
+ *   its client data or NULL
+ *
+ *--------------------------------------------------------------
+ */
+casstcl_cacheClientData *
+casstcl_cache_command_to_cacheClientData (Tcl_Interp *interp, char *cacheCommandName)
+{
+	Tcl_CmdInfo cacheCmdInfo;
+
+	if (!Tcl_GetCommandInfo (interp, cacheCommandName, &cacheCmdInfo)) {
+		return NULL;
+	}
+
+	casstcl_cacheClientData *cache = (casstcl_cacheClientData *)cacheCmdInfo.objClientData;
+	if (cache == NULL || cacheCmdInfo.objProc != casstcl_cacheObjectObjCmd || cache->cass_cache_magic != CASS_CACHE_MAGIC) {
+		return NULL;
+	}
+
+	return cache;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_createCacheObjectCommand --
+ *
+ *    given a casstcl_sessionClientData pointer and an object name (or
+ *    "#auto"), create a row cache object command
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_createCacheObjectCommand (casstcl_sessionClientData *ct, char *commandName)
+{
+	casstcl_cacheClientData *cache = (casstcl_cacheClientData *)ckalloc (sizeof (casstcl_cacheClientData));
+	Tcl_Interp *interp = ct->interp;
+	Tcl_HashEntry *entry;
+	int isNew;
+
+	cache->cass_cache_magic = CASS_CACHE_MAGIC;
+	cache->ct = ct;
+	cache->preparedObj = NULL;
+	cache->columnsObj = NULL;
+	cache->ttl = CASSTCL_DEFAULT_CACHE_TTL;
+	cache->maxEntries = CASSTCL_DEFAULT_CACHE_MAX_ENTRIES;
+	cache->consistency = CASS_CONSISTENCY_UNKNOWN;
+	Tcl_InitHashTable (&cache->entryTable, TCL_STRING_KEYS);
+	cache->newest = NULL;
+	cache->oldest = NULL;
+	cache->deleted = 0;
+	cache->hits = 0;
+	cache->misses = 0;
+	cache->collapsed = 0;
+	cache->fills = 0;
+	cache->errors = 0;
+	cache->evictions = 0;
+	cache->expirations = 0;
+	cache->invalidations = 0;
+
+#define CACHE_STRING_FORMAT "cache%lu"
+	// if commandName is #auto, generate a unique name for the object
+	int autoGeneratedName = 0;
+	if (strcmp (commandName, "#auto") == 0) {
+		static unsigned long nextAutoCounter = 0;
+		int baseNameLength = snprintf (NULL, 0, CACHE_STRING_FORMAT, nextAutoCounter) + 1;
+		commandName = ckalloc (baseNameLength);
+		snprintf (commandName, baseNameLength, CACHE_STRING_FORMAT, nextAutoCounter++);
+		autoGeneratedName = 1;
+	}
+
+	// create a Tcl command to interface to the row cache
+	cache->cmdToken = Tcl_CreateObjCommand (interp, commandName, casstcl_cacheObjectObjCmd, cache, casstcl_cacheObjectDelete);
+	// set the full name to the command in the interpreter result
+	Tcl_GetCommandFullName(interp, cache->cmdToken, Tcl_GetObjResult (interp));
+	if (autoGeneratedName == 1) {
+		ckfree(commandName);
+	}
+
+	// the session deletes its caches when it goes
+	entry = Tcl_CreateHashEntry (&ct->cacheObjectTable, (char *)cache, &isNew);
+	Tcl_SetHashValue (entry, cache);
+
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache --
+ *
+ *    implements the session's cache method.  "cache create name
+ *    -prepared preparedName ?options?" makes a row cache object,
+ *    "cache names" lists the session's caches.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_cache (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Interp *interp = ct->interp;
+	int subOptIndex;
+
+	static CONST char *subOptions[] = {
+		"create",
+		"names",
+		NULL
+	};
+
+	enum subOptions {
+		SUBOPT_CREATE,
+		SUBOPT_NAMES
+	};
+
+	if (objc < 3) {
+		Tcl_WrongNumArgs (interp, 2, objv, "create|names ?args?");
+		return TCL_ERROR;
+	}
+
+	if (Tcl_GetIndexFromObj (interp, objv[2], subOptions, "subcommand", TCL_EXACT, &subOptIndex) != TCL_OK) {
+		return TCL_ERROR;
+	}
+
+	switch ((enum subOptions) subOptIndex) {
+		case SUBOPT_CREATE: {
+			casstcl_cacheClientData *cache;
+			Tcl_Obj *nameObj;
+
+			if (objc < 4 || (objc & 1) == 1) {
+				Tcl_WrongNumArgs (interp, 3, objv, "name -prepared preparedName ?-columns columnList? ?-ttl seconds? ?-max_entries n? ?-consistency level?");
+				return TCL_ERROR;
+			}
+
+			if (casstcl_createCacheObjectCommand (ct, Tcl_GetString (objv[3])) == TCL_ERROR) {
+				return TCL_ERROR;
+			}
+
+			nameObj = Tcl_GetObjResult (interp);
+			Tcl_IncrRefCount (nameObj);
+			cache = casstcl_cache_command_to_cacheClientData (interp, Tcl_GetString (nameObj));
+
+			if (casstcl_cache_configure (cache, objc - 4, &objv[4]) == TCL_ERROR || cache->preparedObj == NULL) {
+				if (cache->preparedObj == NULL) {
+					Tcl_ResetResult (interp);
+					Tcl_AppendResult (interp, "a cache needs a -prepared select to fill it", NULL);
+				}
+				Tcl_DeleteCommandFromToken (interp, cache->cmdToken);
+				Tcl_DecrRefCount (nameObj);
+				return TCL_ERROR;
+			}
+
+			Tcl_SetObjResult (interp, nameObj);
+			Tcl_DecrRefCount (nameObj);
+			return TCL_OK;
+		}
+
+		case SUBOPT_NAMES: {
+			Tcl_Obj *listObj = Tcl_NewObj ();
+			Tcl_HashSearch search;
+			Tcl_HashEntry *entry;
+
+			if (objc != 3) {
+				Tcl_WrongNumArgs (interp, 3, objv, "");
+				return TCL_ERROR;
+			}
+
+			for (entry = Tcl_FirstHashEntry (&ct->cacheObjectTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+				casstcl_cacheClientData *cache = (casstcl_cacheClientData *)Tcl_GetHashValue (entry);
+				Tcl_Obj *nameObj = Tcl_NewObj ();
+
+				Tcl_GetCommandFullName (interp, cache->cmdToken, nameObj);
+				Tcl_ListObjAppendElement (NULL, listObj, nameObj);
+			}
+
+			Tcl_SetObjResult (interp, listObj);
+			return TCL_OK;
+		}
+	}
+
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cacheObjectObjCmd --
+ *
+ *    dispatches the subcommands of a casstcl row cache command
+ *
+ * Results:
+ *    stuff
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_cacheObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[])
+{
+	int optIndex;
+	casstcl_cacheClientData *cache = (casstcl_cacheClientData *)cData;
+
+	static CONST char *options[] = {
+		"get",
+		"invalidate",
+		"configure",
+		"stats",
+		"delete",
+		NULL
+	};
+
+	enum options {
+		OPT_GET,
+		OPT_INVALIDATE,
+		OPT_CONFIGURE,
+		OPT_STATS,
+		OPT_DELETE
+	};
+
+	/* basic validation of command line arguments */
+	if (objc < 2) {
+		Tcl_WrongNumArgs (interp, 1, objv, "subcommand ?args?");
+		return TCL_ERROR;
+	}
+
+	if (Tcl_GetIndexFromObj (interp, objv[1], options, "option", TCL_EXACT, &optIndex) != TCL_OK) {
+		return TCL_ERROR;
+	}
+
+	switch ((enum options) optIndex) {
+		// get ?-callback callback? key
+		case OPT_GET: {
+			if (objc == 3) {
+				return casstcl_cache_get (cache, objv[2], NULL);
+			}
+
+			if (objc != 5 || strcmp (Tcl_GetString (objv[2]), "-callback") != 0) {
+				Tcl_WrongNumArgs (interp, 2, objv, "?-callback callback? key");
+				return TCL_ERROR;
+			}
+
+			return casstcl_cache_get (cache, objv[4], objv[3]);
+		}
+
+		// invalidate ?key? - returns how many entries were dropped
+		case OPT_INVALIDATE: {
+			if (objc > 3) {
+				Tcl_WrongNumArgs (interp, 2, objv, "?key?");
+				return TCL_ERROR;
+			}
+
+			Tcl_SetObjResult (interp, Tcl_NewIntObj (casstcl_cache_invalidate (cache, (objc == 3) ? objv[2] : NULL)));
+			break;
+		}
+
+		case OPT_CONFIGURE: {
+			return casstcl_cache_configure (cache, objc - 2, &objv[2]);
+		}
+
+		// stats - how many entries there are and how the gets of them
+		// have gone.  hit_rate is the fraction of gets that were hits.
+		case OPT_STATS: {
+			Tcl_Obj *listObj = Tcl_NewObj ();
+			Tcl_WideInt gets = cache->hits + cache->misses;
+
+			if (objc != 2) {
+				Tcl_WrongNumArgs (interp, 2, objv, "");
+				return TCL_ERROR;
+			}
+
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("entries", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (cache->entryTable.numEntries));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("hits", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (cache->hits));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("misses", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (cache->misses));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("collapsed", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (cache->collapsed));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("fills", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (cache->fills));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("errors", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (cache->errors));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("evictions", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (cache->evictions));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("expirations", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (cache->expirations));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("invalidations", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (cache->invalidations));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("hit_rate", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewDoubleObj ((gets == 0) ? 0.0 : (double)cache->hits / gets));
+			Tcl_SetObjResult (interp, listObj);
+			break;
+		}
+
+		case OPT_DELETE: {
+			if (objc != 2) {
+				Tcl_WrongNumArgs (interp, 2, objv, "");
+				return TCL_ERROR;
+			}
+
+			Tcl_DeleteCommandFromToken (interp, cache->cmdToken);
+			break;
+		}
+	}
+
+	return TCL_OK;
+}
+
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_cacheObjectDelete -- command deletion callback routine.
+ *
+ * Results:
+ *      ...drops everything cached.  gets waiting on fills still in
+ *         flight are never answered.
+ *      ...destroys the row cache object.
+ *      ...frees memory once the last fill in flight completes.
+ *
+ * Side effects:
+ *      None.
+ *
+ *--------------------------------------------------------------
+ */
+void
+casstcl_cacheObjectDelete (ClientData clientData)
+{
+	casstcl_cacheClientData *cache = (casstcl_cacheClientData *)clientData;
+	casstcl_sessionClientData *ct = cache->ct;
+	Tcl_HashEntry *entry;
+
+	assert (cache->cass_cache_magic == CASS_CACHE_MAGIC);
+
+	cache->deleted = 1;
+	while (cache->newest != NULL) {
+		casstcl_cacheEntry *cacheEntry = cache->newest;
+
+		if (cacheEntry->waitersObj != NULL) {
+			Tcl_DecrRefCount (cacheEntry->waitersObj);
+			cacheEntry->waitersObj = NULL;
+		}
+		casstcl_cache_detach (cacheEntry);
+	}
+	Tcl_DeleteHashTable (&cache->entryTable);
+
+	if (cache->preparedObj != NULL) {
+		Tcl_DecrRefCount (cache->preparedObj);
+	}
+	if (cache->columnsObj != NULL) {
+		Tcl_DecrRefCount (cache->columnsObj);
+	}
+
+	entry = Tcl_FindHashEntry (&ct->cacheObjectTable, (char *)cache);
+	if (entry != NULL) {
+		Tcl_DeleteHashEntry (entry);
+	}
+
+	// fills still in flight have the cache preserved
+	Tcl_EventuallyFree (clientData, TCL_DYNAMIC);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache_delete_all --
+ *
+ *    delete all of a session's row caches.  used when the session is
+ *    deleted.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_cache_delete_all (casstcl_sessionClientData *ct)
+{
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+
+	while ((entry = Tcl_FirstHashEntry (&ct->cacheObjectTable, &search)) != NULL) {
+		casstcl_cacheClientData *cache = (casstcl_cacheClientData *)Tcl_GetHashValue (entry);
+
+		Tcl_DeleteHashEntry (entry);
+		Tcl_DeleteCommandFromToken (ct->interp, cache->cmdToken);
+	}
+}
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
@@ -0,0 +1,162 @@
+/*
+ *
+ * Include file for casstcl_cache
+ *
+ * Copyright (C) 2015 by FlightAware, All Rights Reserved
+ *
+ * Freely redistributable under the Berkeley copyright, see license.terms
+ * for details.
+ */
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache_get --
+ *
+ *    get the rows for a key from a cache.
+ *
+ *    without a callback, the rows are returned, waiting for the select
+ *    if the key isn't cached or is already being filled.
+ *
+ *    with a callback, it's invoked with the key, "ok" and the rows, or
+ *    the key, "error" and the error message.  on a hit that happens
+ *    right away and 1 is returned, otherwise 0 is returned and the
+ *    callback is invoked from the event loop once the fill completes.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_cache_get (casstcl_cacheClientData *cache, Tcl_Obj *keyObj, Tcl_Obj *callbackObj);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache_invalidate --
+ *
+ *    drop a key from a cache, or every key if keyObj is NULL, so the
+ *    next get of it reads it again.  gets waiting on a key that is
+ *    being filled still get the rows of that fill.
+ *
+ * Results:
+ *    The number of entries dropped
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_cache_invalidate (casstcl_cacheClientData *cache, Tcl_Obj *keyObj);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache_configure --
+ *
+ *    set the options of a row cache from a list of option value pairs,
+ *    or with none, set the interpreter result to a list of them.
+ *    nothing is changed if any of them are bad.  changing -prepared or
+ *    -columns changes what the keys mean, so everything cached is
+ *    dropped, and lowering -max_entries evicts what no longer fits.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_cache_configure (casstcl_cacheClientData *cache, int objc, Tcl_Obj *CONST objv[]);
+
+/*
+ *--------------------------------------------------------------
+ *
+ *   casstcl_cache_command_to_cacheClientData -- given a row cache
+ *   command name, find it in the interpreter and return a pointer to
+ *   its client data or NULL
+ *
+ *--------------------------------------------------------------
+ */
+casstcl_cacheClientData *
+casstcl_cache_command_to_cacheClientData (Tcl_Interp *interp, char *cacheCommandName);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_createCacheObjectCommand --
+ *
+ *    given a casstcl_sessionClientData pointer and an object name (or
+ *    "#auto"), create a row cache object command
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_createCacheObjectCommand (casstcl_sessionClientData *ct, char *commandName);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache --
+ *
+ *    implements the session's cache method.  "cache create name
+ *    -prepared preparedName ?options?" makes a row cache object,
+ *    "cache names" lists the session's caches.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_cache (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[]);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cacheObjectObjCmd --
+ *
+ *    dispatches the subcommands of a casstcl row cache command
+ *
+ * Results:
+ *    stuff
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_cacheObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_cacheObjectDelete -- command deletion callback routine.
+ *
+ * Results:
+ *      ...drops everything cached.  gets waiting on fills still in
+ *         flight are never answered.
+ *      ...destroys the row cache object.
+ *      ...frees memory once the last fill in flight completes.
+ *
+ * Side effects:
+ *      None.
+ *
+ *--------------------------------------------------------------
+ */
+void
+casstcl_cacheObjectDelete (ClientData clientData);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cache_delete_all --
+ *
+ *    delete all of a session's row caches.  used when the session is
+ *    deleted.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_cache_delete_all (casstcl_sessionClientData *ct);
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
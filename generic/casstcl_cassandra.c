@@ -19,16 +19,62 @@
 #include "casstcl_consistency.h"
 #include "casstcl_event.h"
 #include "casstcl_future.h"
+#include "casstcl_coro.h"
+#include "casstcl_bulk.h"
+#include "casstcl_coalesce.h"
+#include "casstcl_counter.h"
+#include "casstcl_cache.h"
+#include "casstcl_writeq.h"
+#include "casstcl_ratelimit.h"
+#include "casstcl_breaker.h"
+#include "casstcl_profile.h"
+#include "casstcl_retry.h"
+#include "casstcl_latency.h"
+#include "casstcl_slowlog.h"
+#include "casstcl_export.h"
+#include "casstcl_trace.h"
 
 #include <assert.h>
 
 // Function Declarations
 int casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+int casstcl_cassObjectNRObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
 int casstcl_reimport_column_type_map (casstcl_sessionClientData *ct);
 int casstcl_list_columns (casstcl_sessionClientData *ct, char *keyspace, char *table, 
 	int includeTypes, Tcl_Obj **objPtr);
 int casstcl_list_tables (casstcl_sessionClientData *ct, char *keyspace, Tcl_Obj **objPtr);
 int casstcl_list_keyspaces (casstcl_sessionClientData *ct, Tcl_Obj **objPtr);
+int casstcl_select_coro_page (casstcl_sessionClientData *ct, CassFuture *future, ClientData clientData);
+
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_session_future_event_filter -- Tcl_DeleteEvents filter
+ *   matching queued future callback events belonging to the session
+ *   passed as clientData
+ *
+ *--------------------------------------------------------------
+ */
+static int
+casstcl_session_future_event_filter (Tcl_Event *tevPtr, ClientData clientData)
+{
+	if (tevPtr->proc == casstcl_fireforget_eventProc) {
+		casstcl_fireForgetEvent *evPtr = (casstcl_fireForgetEvent *)tevPtr;
+
+		if (evPtr->ct != (casstcl_sessionClientData *)clientData) {
+			return 0;
+		}
+
+		cass_future_free (evPtr->future);
+		return 1;
+	}
+
+	if (tevPtr->proc != casstcl_future_eventProc) {
+		return 0;
+	}
+
+	return (((casstcl_futureEvent *)tevPtr)->fcd->ct == (casstcl_sessionClientData *)clientData);
+}
 
 // possibly unfortunately, the cassandra cpp-driver logging stuff is global
 Tcl_Obj *casstcl_loggingCallbackObj = NULL;
@@ -55,11 +101,67 @@ casstcl_cassObjectDelete (ClientData clientData)
 
     assert (ct->cass_session_magic == CASS_SESSION_MAGIC);
 
+	// send any coalesced rows still waiting while there's a session to
+	// send them with, unless the interpreter is going away
+	casstcl_coalesce_forget_all (ct, !Tcl_InterpDeleted (ct->interp));
+
+	// and whatever counter increments are waiting, which are always sent
+	casstcl_counter_delete_all (ct);
+	casstcl_cache_delete_all (ct);
+
+	// write queues save or send what they haven't written
+	casstcl_writeq_delete_all (ct);
+
+	// and requests held back by rate limits are sent regardless
+	casstcl_rate_limit_release_all (ct);
+
 	cass_ssl_free (ct->ssl);
     cass_cluster_free (ct->cluster);
     cass_session_free (ct->session);
+	ct->session = NULL;
+
+	// the session is gone, so any callbacks still sitting in the event
+	// queue would refer to it.  throw them away.
+	Tcl_DeleteEvents (casstcl_session_future_event_filter, (ClientData)ct);
+
+	// delete whatever futures, object commands or handles, were never
+	// deleted
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+	while ((entry = Tcl_FirstHashEntry (&ct->futureTable, &search)) != NULL) {
+		casstcl_future_delete (Tcl_GetHashValue (entry));
+	}
+	Tcl_DeleteHashTable (&ct->futureTable);
+
+	ct->futureDeleteAfterCallback = 0;
+	ct->futureMaxAge = 0;
+	if (ct->futureSweepTimer != NULL) {
+		Tcl_DeleteTimerHandler (ct->futureSweepTimer);
+		ct->futureSweepTimer = NULL;
+	}
+
+	Tcl_DeleteHashTable (&ct->writeStats.errorCounts);
+	Tcl_MutexFinalize (&ct->writeStats.mutex);
+	if (ct->writeStats.errorCallbackObj != NULL) {
+		Tcl_DecrRefCount (ct->writeStats.errorCallbackObj);
+	}
 
-    ckfree((char *)clientData);
+	casstcl_forget_partition_keys (ct);
+	Tcl_DeleteHashTable (&ct->partitionKeyTable);
+
+	Tcl_DeleteHashTable (&ct->coalesceTable);
+	Tcl_DeleteHashTable (&ct->counterObjectTable);
+	Tcl_DeleteHashTable (&ct->cacheObjectTable);
+	Tcl_DeleteHashTable (&ct->writeQueueObjectTable);
+	casstcl_rate_limit_forget_all (ct);
+	casstcl_breaker_forget_all (ct);
+	casstcl_profile_forget_all (ct);
+	casstcl_latency_forget_all (ct);
+	casstcl_slowlog_forget (ct);
+	casstcl_export_forget (ct);
+
+	// a future callback may have this session preserved
+    Tcl_EventuallyFree (clientData, TCL_DYNAMIC);
 }
 
 
@@ -200,6 +302,36 @@ casstcl_cassObjCmd(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj
 
 			ct->threadId = Tcl_GetCurrentThread();
 
+			Tcl_InitHashTable (&ct->futureTable, TCL_ONE_WORD_KEYS);
+			ct->nextFutureId = 0;
+			ct->futureDeleteAfterCallback = 0;
+			ct->futureMaxAge = 0;
+			ct->futureSweepTimer = NULL;
+			ct->futuresReclaimed = 0;
+
+			memset (&ct->writeStats, 0, sizeof (ct->writeStats));
+			Tcl_InitHashTable (&ct->writeStats.errorCounts, TCL_ONE_WORD_KEYS);
+			ct->writeStats.errorCallbackLimit = CASSTCL_DEFAULT_FIREFORGET_CALLBACK_LIMIT;
+
+			Tcl_InitHashTable (&ct->partitionKeyTable, TCL_STRING_KEYS);
+			Tcl_InitHashTable (&ct->coalesceTable, TCL_STRING_KEYS);
+			Tcl_InitHashTable (&ct->counterObjectTable, TCL_ONE_WORD_KEYS);
+			Tcl_InitHashTable (&ct->cacheObjectTable, TCL_ONE_WORD_KEYS);
+			Tcl_InitHashTable (&ct->writeQueueObjectTable, TCL_ONE_WORD_KEYS);
+			memset (&ct->rateLimit, 0, sizeof (ct->rateLimit));
+			ct->rateLimit.ct = ct;
+			Tcl_InitHashTable (&ct->rateLimitTable, TCL_STRING_KEYS);
+			ct->breakerMutex = NULL;
+			memset (&ct->breaker, 0, sizeof (ct->breaker));
+			Tcl_InitHashTable (&ct->breakerTable, TCL_STRING_KEYS);
+			Tcl_InitHashTable (&ct->profileTable, TCL_STRING_KEYS);
+			Tcl_InitHashTable (&ct->latencyTable, TCL_STRING_KEYS);
+			memset (&ct->slowlog, 0, sizeof (ct->slowlog));
+			ct->slowlog.sample = 1.0;
+			ct->traceSample = 0.0;
+			ct->futuresCreated = ct->callbackEvents = ct->conversionErrors = 0;
+			memset (&ct->metricsExport, 0, sizeof (ct->metricsExport));
+
 			Tcl_CreateEventSource (casstcl_EventSetupProc, casstcl_EventCheckProc, NULL);
 
 			commandName = Tcl_GetString (objv[2]);
@@ -219,7 +351,7 @@ casstcl_cassObjCmd(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj
 			}
 
 			// create a Tcl command to interface to cass
-			ct->cmdToken = Tcl_CreateObjCommand (interp, commandName, casstcl_cassObjectObjCmd, ct, casstcl_cassObjectDelete);
+			ct->cmdToken = casstcl_create_nr_command (interp, commandName, casstcl_cassObjectObjCmd, casstcl_cassObjectNRObjCmd, ct, casstcl_cassObjectDelete);
 			Tcl_SetObjResult (interp, Tcl_NewStringObj (commandName, -1));
 			if (autoGeneratedName == 1) {
 				ckfree(commandName);
@@ -272,22 +404,24 @@ casstcl_cassObjCmd(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj
 /*
  *--------------------------------------------------------------
  *
- * casstcl_metrics -- obtain session metrics and return as a
- *   list of key-value pairs.
+ * casstcl_metrics_list -- obtain session metrics as a list of
+ *   key-value pairs.
  *
  * Results:
- *      A list of metrics is returned.
+ *      A new list of metrics is returned.
  *
  * Side effects:
  *      None.
  *
  *--------------------------------------------------------------
  */
-int casstcl_metrics (Tcl_Interp *interp, CassSession *session) {
+Tcl_Obj *casstcl_metrics_list (CassSession *session) {
 	CassMetrics metrics;
+	CassSpeculativeExecutionMetrics speculative;
 
-#define MAX_SESSION_METRICS 42
+#define MAX_SESSION_METRICS (66 + 2 * CASSTCL_RETRY_REASONS)
 	cass_session_get_metrics (session, &metrics);
+	cass_session_get_speculative_execution_metrics (session, &speculative);
 
 	Tcl_Obj *listObjv[MAX_SESSION_METRICS];
 
@@ -339,12 +473,267 @@ int casstcl_metrics (Tcl_Interp *interp, CassSession *session) {
 	listObjv[i++] = Tcl_NewStringObj ("errors.request_timeouts", -1);
 	listObjv[i++] = Tcl_NewWideIntObj (metrics.errors.request_timeouts);
 
+	listObjv[i++] = Tcl_NewStringObj ("speculative.min", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (speculative.min);
+	listObjv[i++] = Tcl_NewStringObj ("speculative.max", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (speculative.max);
+	listObjv[i++] = Tcl_NewStringObj ("speculative.mean", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (speculative.mean);
+	listObjv[i++] = Tcl_NewStringObj ("speculative.stddev", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (speculative.stddev);
+	listObjv[i++] = Tcl_NewStringObj ("speculative.median", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (speculative.median);
+	listObjv[i++] = Tcl_NewStringObj ("speculative.percentile_75th", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (speculative.percentile_75th);
+	listObjv[i++] = Tcl_NewStringObj ("speculative.percentile_95th", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (speculative.percentile_95th);
+	listObjv[i++] = Tcl_NewStringObj ("speculative.percentile_98th", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (speculative.percentile_98th);
+	listObjv[i++] = Tcl_NewStringObj ("speculative.percentile_99th", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (speculative.percentile_99th);
+	listObjv[i++] = Tcl_NewStringObj ("speculative.percentile_999th", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (speculative.percentile_999th);
+	listObjv[i++] = Tcl_NewStringObj ("speculative.count", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (speculative.count);
+	listObjv[i++] = Tcl_NewStringObj ("speculative.percentage", -1);
+	listObjv[i++] = Tcl_NewDoubleObj (speculative.percentage);
+
+	i = casstcl_retry_metrics (listObjv, i);
+
 	assert (i <= MAX_SESSION_METRICS);
 
+	return Tcl_NewListObj (i, listObjv);
+}
+
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_metrics -- obtain session metrics and return as a
+ *   list of key-value pairs.
+ *
+ * Results:
+ *      A list of metrics is returned.
+ *
+ * Side effects:
+ *      None.
+ *
+ *--------------------------------------------------------------
+ */
+int casstcl_metrics (Tcl_Interp *interp, CassSession *session) {
+	Tcl_SetObjResult (interp, casstcl_metrics_list (session));
+	return TCL_OK;
+}
+
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_write_stats -- return the session's fire-and-forget
+ *   accounting as a list of key-value pairs, optionally zeroing
+ *   the counters afterwards
+ *
+ * Results:
+ *      A list of counters is returned.  The "errors" element is
+ *      itself a list of error code names and their counts.
+ *
+ * Side effects:
+ *      The counters are reset if reset is nonzero.  The number of
+ *      pending requests is never reset.
+ *
+ *--------------------------------------------------------------
+ */
+int casstcl_write_stats (Tcl_Interp *interp, casstcl_sessionClientData *ct, int reset) {
+	casstcl_writeStats *ws = &ct->writeStats;
+	Tcl_Obj *errorsObj = Tcl_NewObj ();
+	Tcl_Obj *listObjv[12];
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+	int i = 0;
+
+	Tcl_MutexLock (&ws->mutex);
+
+	listObjv[i++] = Tcl_NewStringObj ("issued", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (ws->issued);
+	listObjv[i++] = Tcl_NewStringObj ("pending", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (ws->issued - ws->succeeded - ws->failed);
+	listObjv[i++] = Tcl_NewStringObj ("succeeded", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (ws->succeeded);
+	listObjv[i++] = Tcl_NewStringObj ("failed", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (ws->failed);
+	listObjv[i++] = Tcl_NewStringObj ("suppressed", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (ws->suppressed);
+
+	for (entry = Tcl_FirstHashEntry (&ws->errorCounts, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+		CassError rc = (CassError)(long)Tcl_GetHashKey (&ws->errorCounts, entry);
+		Tcl_ListObjAppendElement (NULL, errorsObj, Tcl_NewStringObj (casstcl_cass_error_to_errorcode_string (rc), -1));
+		Tcl_ListObjAppendElement (NULL, errorsObj, Tcl_NewWideIntObj ((long)Tcl_GetHashValue (entry)));
+	}
+
+	listObjv[i++] = Tcl_NewStringObj ("errors", -1);
+	listObjv[i++] = errorsObj;
+
+	if (reset) {
+		// keep issued consistent with what's still outstanding
+		ws->issued -= ws->succeeded + ws->failed;
+		ws->succeeded = 0;
+		ws->failed = 0;
+		ws->suppressed = 0;
+		Tcl_DeleteHashTable (&ws->errorCounts);
+		Tcl_InitHashTable (&ws->errorCounts, TCL_ONE_WORD_KEYS);
+	}
+
+	Tcl_MutexUnlock (&ws->mutex);
+
 	Tcl_SetObjResult (interp, Tcl_NewListObj (i, listObjv));
 	return TCL_OK;
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_select_rows --
+ *
+ *      Fill the named array with elements from each row of one page of
+ *      select results in turn, executing code against it.  *stopPtr is
+ *      set if the code did a break, return or raised an error, meaning
+ *      no more pages should be processed either.
+ *
+ * Results:
+ *      A standard Tcl result.
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_select_rows (casstcl_sessionClientData *ct, const CassResult *result, char *arrayName, Tcl_Obj *codeObj, int withNulls, int *stopPtr) {
+	int tclReturn = TCL_OK;
+	Tcl_Interp *interp = ct->interp;
+	CassIterator* iterator = cass_iterator_from_result(result);
+	int columnCount = cass_result_column_count (result);
+
+	while (cass_iterator_next(iterator)) {
+		CassString cassNameString;
+		int i;
+
+		const CassRow* row = cass_iterator_get_row(iterator);
+
+		// process all the columns into the tcl array
+		for (i = 0; i < columnCount; i++) {
+			Tcl_Obj *newObj = NULL;
+			const char *columnName;
+			const CassValue *columnValue;
+
+			cass_result_column_name (result, i, &cassNameString.data, &cassNameString.length);
+			columnName = cassNameString.data;
+
+			columnValue = cass_row_get_column (row, i);
+
+			if (cass_value_is_null (columnValue)) {
+				if(!withNulls) {
+					Tcl_UnsetVar2 (interp, arrayName, columnName, 0);
+					continue;
+				}
+			} else {
+				if(casstcl_cass_value_to_tcl_obj (ct, columnValue, &newObj) == TCL_ERROR) {
+					tclReturn = TCL_ERROR;
+					break;
+				}
+			}
+
+			if (newObj == NULL) {
+				if(withNulls) {
+					newObj = Tcl_NewObj();
+				} else {
+					Tcl_UnsetVar2 (interp, arrayName, columnName, 0);
+					continue;
+				}
+			}
+
+			if (Tcl_SetVar2Ex (interp, arrayName, columnName, newObj, (TCL_LEAVE_ERR_MSG)) == NULL) {
+				tclReturn = TCL_ERROR;
+				break;
+			}
+		}
+
+		if (tclReturn == TCL_ERROR) {
+			*stopPtr = 1;
+			break;
+		}
+
+		// now execute the code body
+		int evalReturnCode = Tcl_EvalObjEx(interp, codeObj, 0);
+		if ((evalReturnCode != TCL_OK) && (evalReturnCode != TCL_CONTINUE)) {
+			// if it's TCL_BREAK we fall through to the break; tclReturn
+			// is still TCL_OK so we don't have to change anything and
+			// we don't want to propogate TCL_BREAK or TCL_CONTINE;
+			// they are for us, not for our caller.  TCL_RETURN,
+			// on the other hand, is return for our caller as well.
+			//
+			if (evalReturnCode == TCL_RETURN) {
+				tclReturn = TCL_RETURN;
+			} else if (evalReturnCode == TCL_ERROR) {
+				char        msg[60];
+
+				tclReturn = TCL_ERROR;
+
+				sprintf(msg, "\n    (\"select\" body line %d)",
+						Tcl_GetErrorLine(interp));
+				Tcl_AddErrorInfo(interp, msg);
+			}
+
+			*stopPtr = 1;
+			break;
+		}
+	}
+
+	cass_iterator_free(iterator);
+	return tclReturn;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_select_page_timeout --
+ *
+ *      set the request timeout for the next page of a select.  with a
+ *      deadline, the absolute time in milliseconds by which every page
+ *      has to have been fetched, the page gets whatever time is left if
+ *      that's less than timeoutMS.  a timeoutMS of -1 leaves the
+ *      cluster's request timeout in place and a deadline of 0 means
+ *      there isn't one.
+ *
+ * Results:
+ *      A standard Tcl result.  If the deadline has passed it's an error
+ *      with an errorCode of CASSTCL DEADLINE_EXCEEDED.
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_select_page_timeout (casstcl_sessionClientData *ct, CassStatement *statement, Tcl_WideInt timeoutMS, Tcl_WideInt deadline) {
+	Tcl_WideInt remaining;
+
+	if (deadline == 0) {
+		if (timeoutMS >= 0) {
+			cass_statement_set_request_timeout (statement, (cass_uint64_t)timeoutMS);
+		}
+		return TCL_OK;
+	}
+
+	remaining = deadline - casstcl_now_ms ();
+	if (remaining <= 0) {
+		Tcl_ResetResult (ct->interp);
+		Tcl_SetErrorCode (ct->interp, "CASSTCL", "DEADLINE_EXCEEDED", NULL);
+		Tcl_AppendResult (ct->interp, "select deadline exceeded", NULL);
+		return TCL_ERROR;
+	}
+
+	// a timeout of 0 means no timeout, so the deadline is the limit
+	if (timeoutMS > 0 && timeoutMS < remaining) {
+		remaining = timeoutMS;
+	}
+
+	cass_statement_set_request_timeout (statement, (cass_uint64_t)remaining);
+	return TCL_OK;
+}
+
 /*
  *----------------------------------------------------------------------
  *
@@ -359,42 +748,135 @@ int casstcl_metrics (Tcl_Interp *interp, CassSession *session) {
  *      Issuing commands with async and processing the results with
  *      async foreach allows for greater concurrency.
  *
+ *      If profileObj isn't NULL it names the execution profile to use.
+ *      timeoutMS, if not -1, is the request timeout of each page and
+ *      deadlineMS, if not 0, is how long all of the pages together may
+ *      take.  with a tagObj, the latency of each page is counted in the
+ *      tag's histogram.  the select as a whole, with the latencies of its
+ *      pages added up, is checked against the slow query log's threshold.
+ *      if trace is nonzero, or the session's trace_sample picks it, each
+ *      page is traced and the first page's tracing id goes in the slow
+ *      query log.
+ *
+ *      If coro is nonzero and we're running in a coroutine, the
+ *      coroutine yields while each page is fetched rather than blocking
+ *      (see casstcl_select_coro_page), in which case this must be called
+ *      from an NRE-enabled command and its result returned.
+ *
  * Results:
  *      A standard Tcl result.
  *
  *
  *----------------------------------------------------------------------
  */
-
-int casstcl_select (casstcl_sessionClientData *ct, char *query, char *arrayName, Tcl_Obj *codeObj, int pagingSize, CassConsistency *consistencyPtr, int withNulls) {
+int casstcl_select (casstcl_sessionClientData *ct, char *query, char *arrayName, Tcl_Obj *codeObj, int pagingSize, CassConsistency *consistencyPtr, Tcl_Obj *profileObj, Tcl_WideInt timeoutMS, Tcl_WideInt deadlineMS, Tcl_Obj *tagObj, int trace, int withNulls, int coro) {
 	CassStatement* statement = NULL;
 	int tclReturn = TCL_OK;
 	Tcl_Interp *interp = ct->interp;
 
+	if (casstcl_breaker_check (ct, NULL) == TCL_ERROR) {
+		return TCL_ERROR;
+	}
+
 	statement = cass_statement_new(query, 0);
 
 	cass_bool_t has_more_pages = cass_false;
 	const CassResult* result = NULL;
 	CassError rc = CASS_OK;
-	int columnCount = -1;
+	int stop = 0;
+	Tcl_WideInt deadline = (deadlineMS > 0) ? casstcl_now_ms () + deadlineMS : 0;
+	Tcl_Obj *latencyKeysObj;
+	Tcl_Obj *slowlogObj;
+	Tcl_WideInt submitted;
+	Tcl_WideInt requestUS = 0;
+	int pages = 0;
+	int traced = 0;
+	CassUuid tracingId;
 
 	if (casstcl_setStatementConsistency(ct, statement, consistencyPtr) != TCL_OK) {
 		return TCL_ERROR;
 	}
 
+	latencyKeysObj = casstcl_latency_keys_from_objv (ct, tagObj, 0, NULL, 0, 0);
+	slowlogObj = casstcl_slowlog_request (ct, "statement", Tcl_NewStringObj (query, -1), 0, NULL, (consistencyPtr != NULL) ? casstcl_cass_consistency_to_string (*consistencyPtr) : NULL, tagObj);
+
 	cass_statement_set_paging_size(statement, pagingSize);
 
+	if (casstcl_trace_wanted (ct, trace)) {
+		cass_statement_set_tracing (statement, cass_true);
+	}
+
+	if (profileObj != NULL) {
+		cass_statement_set_execution_profile (statement, Tcl_GetString (profileObj));
+	}
+
+	// outside of a coroutine the plain loop below does the same thing
+	// without recursing once per page
+	if (coro && casstcl_in_coroutine (interp)) {
+		casstcl_selectState *ss = (casstcl_selectState *)ckalloc (sizeof (casstcl_selectState));
+
+		ss->statement = statement;
+		ss->arrayNameObj = Tcl_NewStringObj (arrayName, -1);
+		Tcl_IncrRefCount (ss->arrayNameObj);
+		ss->codeObj = codeObj;
+		Tcl_IncrRefCount (ss->codeObj);
+		ss->withNulls = withNulls;
+		ss->timeoutMS = timeoutMS;
+		ss->deadline = deadline;
+		ss->latencyKeysObj = latencyKeysObj;
+		if (latencyKeysObj != NULL) {
+			Tcl_IncrRefCount (latencyKeysObj);
+		}
+		ss->slowlogObj = slowlogObj;
+		if (slowlogObj != NULL) {
+			Tcl_IncrRefCount (slowlogObj);
+		}
+		ss->pages = 0;
+		ss->requestUS = 0;
+		ss->traced = 0;
+
+		if (casstcl_select_page_timeout (ct, statement, timeoutMS, deadline) == TCL_ERROR) {
+			return casstcl_select_coro_page (ct, NULL, ss);
+		}
+
+		return casstcl_coro_execute (ct, statement, 0, NULL, &ss->submitted, casstcl_select_coro_page, ss);
+	}
+
+	if (latencyKeysObj != NULL) {
+		Tcl_IncrRefCount (latencyKeysObj);
+	}
+
+	if (slowlogObj != NULL) {
+		Tcl_IncrRefCount (slowlogObj);
+	}
+
 	do {
-		CassIterator* iterator;
+		// each page is a request of its own
+		casstcl_rate_limit_sleep (ct, NULL);
+		if (casstcl_select_page_timeout (ct, statement, timeoutMS, deadline) == TCL_ERROR) {
+			tclReturn = TCL_ERROR;
+			break;
+		}
+
+		submitted = casstcl_now_us ();
 		CassFuture* future = cass_session_execute(ct->session, statement);
 
 		rc = cass_future_error_code(future);
+		submitted = casstcl_now_us () - submitted;
+		casstcl_latency_record (ct, latencyKeysObj, submitted);
+		requestUS += submitted;
+		pages++;
+		casstcl_breaker_record (ct, NULL, rc);
 		if (rc != CASS_OK) {
 			tclReturn = casstcl_future_error_to_tcl (ct, rc, future);
 			cass_future_free(future);
 			break;
 		}
 
+		if (!traced) {
+			traced = (cass_future_tracing_id (future, &tracingId) == CASS_OK);
+		}
+
 		/*
 		 * NOTE: *DEFENSIVE PROGRAMMING* This NULL check is probably
 		 *       not absolutely required here; however, I discovered
@@ -402,6 +884,7 @@ int casstcl_select (casstcl_sessionClientData *ct, char *query, char *arrayName,
 		 *       no result.
 		 */
 		result = cass_future_get_result(future);
+		cass_future_free(future);
 
 		if (result == NULL) {
 			Tcl_ResetResult (interp);
@@ -410,106 +893,286 @@ int casstcl_select (casstcl_sessionClientData *ct, char *query, char *arrayName,
 			break;
 		}
 
-		iterator = cass_iterator_from_result(result);
-		cass_future_free(future);
+		tclReturn = casstcl_select_rows (ct, result, arrayName, codeObj, withNulls, &stop);
 
-		if (columnCount == -1) {
-			columnCount = cass_result_column_count (result);
+		has_more_pages = cass_result_has_more_pages(result);
+
+		if (has_more_pages) {
+			cass_statement_set_paging_state(statement, result);
 		}
 
-		while (cass_iterator_next(iterator)) {
-			CassString cassNameString;
-			int i;
+		cass_result_free(result);
+	} while (has_more_pages && !stop && tclReturn == TCL_OK);
 
-			const CassRow* row = cass_iterator_get_row(iterator);
+	if (latencyKeysObj != NULL) {
+		Tcl_DecrRefCount (latencyKeysObj);
+	}
 
-			// process all the columns into the tcl array
-			for (i = 0; i < columnCount; i++) {
-				Tcl_Obj *newObj = NULL;
-				const char *columnName;
-				const CassValue *columnValue;
+	// the whole select is one entry in the slow query log
+	if (slowlogObj != NULL) {
+		casstcl_slowlog_record_traced (ct, slowlogObj, traced ? &tracingId : NULL, pages, requestUS);
+		Tcl_DecrRefCount (slowlogObj);
+	}
 
-				cass_result_column_name (result, i, &cassNameString.data, &cassNameString.length);
-				columnName = cassNameString.data;
+	cass_statement_free(statement);
+	Tcl_UnsetVar (interp, arrayName, 0);
 
-				columnValue = cass_row_get_column (row, i);
+	return tclReturn;
+}
 
-				if (cass_value_is_null (columnValue)) {
-					if(!withNulls) {
-						Tcl_UnsetVar2 (interp, arrayName, columnName, 0);
-						continue;
-					}
-				} else {
-					if(casstcl_cass_value_to_tcl_obj (ct, columnValue, &newObj) == TCL_ERROR) {
-						tclReturn = TCL_ERROR;
-						break;
-					}
-				}
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_select_coro_page --
+ *
+ *      casstcl_coro_wait done proc for "select -coro", called with each
+ *      page of results.  the rows are processed as select always does
+ *      and, if there are more pages, the next one is requested and the
+ *      coroutine yields again.
+ *
+ * Results:
+ *      A standard Tcl result.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_select_coro_page (casstcl_sessionClientData *ct, CassFuture *future, ClientData clientData) {
+	casstcl_selectState *ss = (casstcl_selectState *)clientData;
+	Tcl_Interp *interp = ct->interp;
+	char *arrayName = Tcl_GetString (ss->arrayNameObj);
+	int tclReturn = TCL_OK;
+	int stop = 0;
 
-				if (newObj == NULL) {
-					if(withNulls) {
-						newObj = Tcl_NewObj();
-					} else {
-						Tcl_UnsetVar2 (interp, arrayName, columnName, 0);
-						continue;
-					}
-				}
+	if (future == NULL) {
+		tclReturn = TCL_ERROR;
+	} else if (ct->session == NULL) {
+		Tcl_SetObjResult (interp, Tcl_NewStringObj ("cassandra object was deleted during select", -1));
+		tclReturn = TCL_ERROR;
+	} else {
+		CassError rc = cass_future_error_code (future);
+		const CassResult *result = NULL;
 
-				if (Tcl_SetVar2Ex (interp, arrayName, columnName, newObj, (TCL_LEAVE_ERR_MSG)) == NULL) {
-					tclReturn = TCL_ERROR;
-					break;
-				}
-			}
+		Tcl_WideInt us = casstcl_now_us () - ss->submitted;
 
-			// now execute the code body
-			int evalReturnCode = Tcl_EvalObjEx(interp, codeObj, 0);
-			if ((evalReturnCode != TCL_OK) && (evalReturnCode != TCL_CONTINUE)) {
-				// if it's TCL_BREAK we fall through to the break; tclReturn
-				// is still TCL_OK so we don't have to change anything and
-				// we don't want to propogate TCL_BREAK or TCL_CONTINE;
-				// they are for us, not for our caller.  TCL_RETURN,
-				// on the other hand, is return for our caller as well.
-				//
-				if (evalReturnCode == TCL_RETURN) {
-					tclReturn = TCL_RETURN;
-				} else if (evalReturnCode == TCL_ERROR) {
-					char        msg[60];
+		casstcl_latency_record (ct, ss->latencyKeysObj, us);
+		ss->requestUS += us;
+		ss->pages++;
+		casstcl_breaker_record (ct, NULL, rc);
+		if (rc == CASS_OK && !ss->traced) {
+			ss->traced = (cass_future_tracing_id (future, &ss->tracingId) == CASS_OK);
+		}
 
-					tclReturn = TCL_ERROR;
+		if (rc != CASS_OK) {
+			tclReturn = casstcl_future_error_to_tcl (ct, rc, future);
+		} else if ((result = cass_future_get_result (future)) == NULL) {
+			Tcl_ResetResult (interp);
+			Tcl_AppendResult (interp, "future has no result", NULL);
+			tclReturn = TCL_ERROR;
+		} else {
+			tclReturn = casstcl_select_rows (ct, result, arrayName, ss->codeObj, ss->withNulls, &stop);
 
-					sprintf(msg, "\n    (\"select\" body line %d)",
-							Tcl_GetErrorLine(interp));
-					Tcl_AddErrorInfo(interp, msg);
-				}
+			if (tclReturn == TCL_OK && !stop && cass_result_has_more_pages (result)) {
+				cass_statement_set_paging_state (ss->statement, result);
+				cass_result_free (result);
 
-				break;
+				if (casstcl_select_page_timeout (ct, ss->statement, ss->timeoutMS, ss->deadline) == TCL_OK) {
+					return casstcl_coro_execute (ct, ss->statement, 0, NULL, &ss->submitted, casstcl_select_coro_page, ss);
+				}
+				return casstcl_select_coro_page (ct, NULL, ss);
 			}
+
+			cass_result_free (result);
 		}
+	}
 
-		has_more_pages = cass_result_has_more_pages(result);
+	cass_statement_free (ss->statement);
+	if (future != NULL) {
+		Tcl_UnsetVar (interp, arrayName, 0);
+	}
+	Tcl_DecrRefCount (ss->arrayNameObj);
+	Tcl_DecrRefCount (ss->codeObj);
+	if (ss->latencyKeysObj != NULL) {
+		Tcl_DecrRefCount (ss->latencyKeysObj);
+	}
+	if (ss->slowlogObj != NULL) {
+		if (ct->session != NULL) {
+			casstcl_slowlog_record_traced (ct, ss->slowlogObj, ss->traced ? &ss->tracingId : NULL, ss->pages, ss->requestUS);
+		}
+		Tcl_DecrRefCount (ss->slowlogObj);
+	}
+	ckfree ((char *)ss);
 
-		if (has_more_pages) {
-			cass_statement_set_paging_state(statement, result);
+	return tclReturn;
+}
+
+
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_exec_done --
+ *
+ *      casstcl_coro_wait done proc for "exec -coro", which turns a
+ *      failed future into a Tcl error just as a synchronous exec does.
+ *      clientData is a casstcl_execState holding the table name,
+ *      latency keys and slow query log description (any may be NULL),
+ *      which is freed here.
+ *
+ * Results:
+ *      A standard Tcl result.
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_exec_done (casstcl_sessionClientData *ct, CassFuture *future, ClientData clientData) {
+	casstcl_execState *es = (casstcl_execState *)clientData;
+	int tclReturn = TCL_ERROR;
+
+	if (future != NULL) {
+		CassError rc = cass_future_error_code (future);
+
+		// the histograms belong to the session, which may be gone
+		if (ct->session != NULL) {
+			Tcl_WideInt us = casstcl_now_us () - es->submitted;
+
+			casstcl_latency_record (ct, es->latencyKeysObj, us);
+			casstcl_slowlog_record (ct, es->slowlogObj, future, 1, us);
 		}
 
-		cass_iterator_free(iterator);
-		cass_result_free(result);
-	} while (has_more_pages && tclReturn == TCL_OK);
+		casstcl_breaker_record (ct, es->tableNameObj, rc);
+		tclReturn = (rc == CASS_OK) ? TCL_OK : casstcl_future_error_to_tcl (ct, rc, future);
+	}
 
-	cass_statement_free(statement);
-	Tcl_UnsetVar (interp, arrayName, 0);
+	if (es->tableNameObj != NULL) {
+		Tcl_DecrRefCount (es->tableNameObj);
+	}
+
+	if (es->latencyKeysObj != NULL) {
+		Tcl_DecrRefCount (es->latencyKeysObj);
+	}
+
+	if (es->slowlogObj != NULL) {
+		Tcl_DecrRefCount (es->slowlogObj);
+	}
+	ckfree ((char *)es);
 
 	return tclReturn;
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_prepared_from_future --
+ *
+ *      given a completed future from cass_session_prepare, create a
+ *      prepared statement object command named by nameObj (#auto picks
+ *      a name) for the given table and statement.  if idempotent is
+ *      nonzero the statements bound from it are marked idempotent.
+ *
+ * Results:
+ *      A standard Tcl result.  On success the name of the new command
+ *      is the interpreter result.  The future is not freed.
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_prepared_from_future (casstcl_sessionClientData *ct, CassFuture *future, Tcl_Obj *nameObj, Tcl_Obj *tableNameObj, Tcl_Obj *statementObj, int idempotent) {
+	Tcl_Interp *interp = ct->interp;
+	CassError rc = CASS_OK;
+	char *statementString;
+	int statementStringLength;
+
+	statementString = Tcl_GetStringFromObj (statementObj, &statementStringLength);
+
+	rc = cass_future_error_code (future);
+	if (rc != CASS_OK) {
+		casstcl_future_error_to_tcl (ct, rc, future);
+		Tcl_AppendResult (interp, " while attempting to prepare statement '", statementString, "'", NULL);
+		return TCL_ERROR;
+	}
+
+	const CassPrepared *cassPrepared = cass_future_get_prepared (future);
+
+	// allocate one of our cass prepared data objects for Tcl
+	// and configure it
+	casstcl_preparedClientData *pcd = (casstcl_preparedClientData *)ckalloc (sizeof (casstcl_preparedClientData));
+
+	pcd->cass_prepared_magic = CASS_PREPARED_MAGIC;
+	pcd->ct = ct;
+	pcd->prepared = cassPrepared;
+
+	pcd->string = ckalloc (statementStringLength + 1);
+	memcpy (pcd->string, statementString, statementStringLength + 1);
+
+	pcd->tableNameObj = tableNameObj;
+	Tcl_IncrRefCount (pcd->tableNameObj);
+	pcd->idempotent = idempotent;
+
+
+	char *commandName = Tcl_GetString (nameObj);
+
+#define PREPARED_STRING_FORMAT "prepared%lu"
+	// if commandName is #auto, generate a unique name for the object
+	int autoGeneratedName = 0;
+	if (strcmp (commandName, "#auto") == 0) {
+		static unsigned long nextAutoCounter = 0;
+		int baseNameLength = snprintf (NULL, 0, PREPARED_STRING_FORMAT, nextAutoCounter) + 1;
+		commandName = ckalloc (baseNameLength);
+		snprintf (commandName, baseNameLength, PREPARED_STRING_FORMAT, nextAutoCounter++);
+		autoGeneratedName = 1;
+	}
+
+	// create a Tcl command to interface to cass
+	pcd->cmdToken = Tcl_CreateObjCommand (interp, commandName, casstcl_preparedObjectObjCmd, pcd, casstcl_preparedObjectDelete);
+	Tcl_SetObjResult (interp, Tcl_NewStringObj (commandName, -1));
+	if (autoGeneratedName == 1) {
+		ckfree(commandName);
+	}
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_prepare_done --
+ *
+ *      casstcl_coro_wait done proc for "prepare -coro".  the client
+ *      data is a list of the name, table and statement arguments and
+ *      whether the statement is idempotent.
+ *
+ * Results:
+ *      A standard Tcl result.
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_prepare_done (casstcl_sessionClientData *ct, CassFuture *future, ClientData clientData) {
+	Tcl_Obj *argsObj = (Tcl_Obj *)clientData;
+	Tcl_Obj **argsObjv;
+	int argsObjc;
+	int tclReturn = TCL_ERROR;
+
+	if (future != NULL && ct->session == NULL) {
+		Tcl_SetObjResult (ct->interp, Tcl_NewStringObj ("cassandra object was deleted during prepare", -1));
+	} else if (future != NULL) {
+		Tcl_ListObjGetElements (NULL, argsObj, &argsObjc, &argsObjv);
+		int idempotent = 0;
+
+		Tcl_GetBooleanFromObj (NULL, argsObjv[3], &idempotent);
+		tclReturn = casstcl_prepared_from_future (ct, future, argsObjv[0], argsObjv[1], argsObjv[2], idempotent);
+	}
 
+	Tcl_DecrRefCount (argsObj);
+	return tclReturn;
+}
 
 /*
  *----------------------------------------------------------------------
  *
  * casstcl_cassObjectObjCmd --
  *
- *    dispatches the subcommands of a cass object command
+ *    dispatches the subcommands of a cass object command by way of
+ *    casstcl_cassObjectNRObjCmd
  *
  * Results:
  *    stuff
@@ -518,6 +1181,26 @@ int casstcl_select (casstcl_sessionClientData *ct, char *query, char *arrayName,
  */
 int
 casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[])
+{
+	return casstcl_nr_call (interp, casstcl_cassObjectNRObjCmd, cData, objc, objv);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cassObjectNRObjCmd --
+ *
+ *    dispatches the subcommands of a cass object command.  this is
+ *    NRE-enabled so that the -coro forms of exec, select and prepare
+ *    can yield the current coroutine.
+ *
+ * Results:
+ *    stuff
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_cassObjectNRObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[])
 {
     int         optIndex;
 	casstcl_sessionClientData *ct = (casstcl_sessionClientData *)cData;
@@ -529,6 +1212,21 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
         "exec",
         "connect",
 		"prepare",
+		"multiget",
+		"exec_many",
+		"coalesce",
+		"coalesce_upsert",
+		"coalesce_flush",
+		"counters",
+		"cache",
+		"write_queue",
+		"rate_limit",
+		"circuit_breaker",
+		"profile",
+		"latency",
+		"slowlog",
+		"trace_sample",
+		"export_metrics",
 		"batch",
 		"keyspaces",
 		"tables",
@@ -536,6 +1234,11 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
 		"columns_with_types",
 		"reimport_column_type_map",
 		"metrics",
+		"write_stats",
+		"fireforget_callback",
+		"futures",
+		"future_policy",
+		"future_stats",
         "cluster_version",
         "contact_points",
         "port",
@@ -564,6 +1267,8 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
 		"load_balance_dc_aware",
 		"token_aware_routing",
 		"latency_aware_routing",
+		"speculative_execution",
+		"retry_policy",
 		"tcp_keepalive",
 		"add_trusted_cert",
 		"ssl_cert",
@@ -581,6 +1286,21 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
         OPT_EXEC,
         OPT_CONNECT,
 		OPT_PREPARE,
+		OPT_MULTIGET,
+		OPT_EXEC_MANY,
+		OPT_COALESCE,
+		OPT_COALESCE_UPSERT,
+		OPT_COALESCE_FLUSH,
+		OPT_COUNTERS,
+		OPT_CACHE,
+		OPT_WRITE_QUEUE,
+		OPT_RATE_LIMIT,
+		OPT_CIRCUIT_BREAKER,
+		OPT_PROFILE,
+		OPT_LATENCY,
+		OPT_SLOWLOG,
+		OPT_TRACE_SAMPLE,
+		OPT_EXPORT_METRICS,
 		OPT_BATCH,
 		OPT_LIST_KEYSPACES,
 		OPT_LIST_TABLES,
@@ -588,6 +1308,11 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
 		OPT_LIST_COLUMN_TYPES,
 		OPT_REIMPORT_COLUMN_TYPE_MAP,
 		OPT_METRICS,
+		OPT_WRITE_STATS,
+		OPT_FIREFORGET_CALLBACK,
+		OPT_FUTURES,
+		OPT_FUTURE_POLICY,
+		OPT_FUTURE_STATS,
         OPT_CLUSTER_VERSION,
         OPT_CONTACT_POINTS,
         OPT_PORT,
@@ -616,6 +1341,8 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
 		OPT_LOAD_BALANCE_DC_AWARE,
 		OPT_TOKEN_AWARE_ROUTING,
 		OPT_LATENCY_AWARE_ROUTING,
+		OPT_SPECULATIVE_EXECUTION,
+		OPT_RETRY_POLICY,
 		OPT_TCP_KEEPALIVE,
 		OPT_ADD_TRUSTED_CERT,
 		OPT_SSL_CERT,
@@ -642,24 +1369,42 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
 			char *arrayName;
 			char *consistencyName = NULL;
 			Tcl_Obj *consistencyObj = NULL;
+			Tcl_Obj *profileObj = NULL;
 			CassConsistency consistency;
 			Tcl_Obj *code;
 			int pagingSize = 100;
 			int arg = 2;
 			int      subOptIndex;
 			int withNulls = 0;
+			int coro = 0;
+			Tcl_WideInt timeoutMS = -1;
+			Tcl_WideInt deadlineMS = 0;
+			Tcl_Obj *tagObj = NULL;
+			int trace = 0;
 
 			static CONST char *subOptions[] = {
 				"-pagesize",
 				"-consistency",
 				"-withnulls",
+				"-coro",
+				"-profile",
+				"-timeout",
+				"-deadline",
+				"-tag",
+				"-trace",
 				NULL
 			};
 
 			enum subOptions {
 				SUBOPT_PAGESIZE,
 				SUBOPT_CONSISTENCY,
-				SUBOPT_WITHNULLS
+				SUBOPT_WITHNULLS,
+				SUBOPT_CORO,
+				SUBOPT_PROFILE,
+				SUBOPT_TIMEOUT,
+				SUBOPT_DEADLINE,
+				SUBOPT_TAG,
+				SUBOPT_TRACE
 			};
 
 			while (arg + 3 < objc) {
@@ -687,11 +1432,56 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
 						withNulls = 1;
 						break;
 					}
+					case SUBOPT_CORO: {
+						coro = 1;
+						break;
+					}
+					case SUBOPT_PROFILE: {
+						profileObj = objv[arg++];
+						if (casstcl_profile_check (ct, profileObj) == TCL_ERROR) {
+							return TCL_ERROR;
+						}
+						break;
+					}
+					case SUBOPT_TIMEOUT: {
+						if (Tcl_GetWideIntFromObj (interp, objv[arg++], &timeoutMS) == TCL_ERROR) {
+							Tcl_AppendResult (interp, " while converting timeout", NULL);
+							return TCL_ERROR;
+						}
+
+						if (timeoutMS < 0) {
+							Tcl_ResetResult (interp);
+							Tcl_AppendResult (interp, "-timeout can't be negative", NULL);
+							return TCL_ERROR;
+						}
+						break;
+					}
+					case SUBOPT_DEADLINE: {
+						if (Tcl_GetWideIntFromObj (interp, objv[arg++], &deadlineMS) == TCL_ERROR) {
+							Tcl_AppendResult (interp, " while converting deadline", NULL);
+							return TCL_ERROR;
+						}
+
+						if (deadlineMS <= 0) {
+							Tcl_ResetResult (interp);
+							Tcl_AppendResult (interp, "-deadline must be greater than zero", NULL);
+							return TCL_ERROR;
+						}
+						break;
+					}
+					case SUBOPT_TAG: {
+						tagObj = objv[arg++];
+						break;
+					}
+					case SUBOPT_TRACE: {
+						trace = 1;
+						break;
+					}
 				}
 			}
 
 			if(objc - arg != 3) {
-				Tcl_WrongNumArgs (interp, 2, objv, "?-pagesize n? ?-consistency consistencyLevel? ?-withnulls? query arrayName code");
+				Tcl_WrongNumArgs (interp, 2, objv, "?-pagesize n? ?-consistency consistencyLevel? ?-profile name? ?-timeout ms? ?-deadline ms? ?-tag tag? ?-trace? ?-withnulls? ?-coro? query arrayName code");
 				return TCL_ERROR;
 			}
 
@@ -699,7 +1489,7 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
 			arrayName = Tcl_GetString (objv[arg++]);
 			code = objv[arg++];
 
-			return casstcl_select (ct, query, arrayName, code, pagingSize, (consistencyObj != NULL) ? &consistency : NULL, withNulls);
+			return casstcl_select (ct, query, arrayName, code, pagingSize, (consistencyObj != NULL) ? &consistency : NULL, profileObj, timeoutMS, deadlineMS, tagObj, trace, withNulls, coro);
 		}
 
 		case OPT_EXEC:
@@ -712,6 +1502,16 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
 			char *batchObjName = NULL;
 			int futureFlags = 0;
 			int upsert = 0;
+			int coro = 0;
+			Tcl_Obj *tableNameObj = NULL;
+			Tcl_Obj *profileObj = NULL;
+			Tcl_WideInt timeoutMS = -1;
+			Tcl_Obj *tagObj = NULL;
+			Tcl_Obj *latencyKeysObj = NULL;
+			Tcl_Obj *slowlogObj = NULL;
+			Tcl_WideInt submitted = 0;
+			int trace = 0;
+			int synchronous;
 
 			static CONST char *subOptions[] = {
 				"-callback",
@@ -719,6 +1519,13 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
 				"-head",
 				"-error_only",
 				"-upsert",
+				"-handle",
+				"-fireforget",
+				"-coro",
+				"-profile",
+				"-timeout",
+				"-tag",
+				"-trace",
 				NULL
 			};
 
@@ -727,12 +1534,19 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
 				SUBOPT_BATCH,
 				SUBOPT_HEAD,
 				SUBOPT_ERRORONLY,
-				SUBOPT_UPSERT
+				SUBOPT_UPSERT,
+				SUBOPT_HANDLE,
+				SUBOPT_FIREFORGET,
+				SUBOPT_CORO,
+				SUBOPT_PROFILE,
+				SUBOPT_TIMEOUT,
+				SUBOPT_TAG,
+				SUBOPT_TRACE
 			};
 
 			// if we don't have at least three arguments, it's an error
 			if (objc < 3) {
-				Tcl_WrongNumArgs (interp, 2, objv, "?-callback n? ?-batch batchObject? ?-head? ?-array arrayName? ?-table tableName? ?-prepared preparedName? ?-consistency level? statement ?args? OR ?-upsert ?-mapunkown columnname? ?-nocomplain? ?-ifnotexists? table args?");
+				Tcl_WrongNumArgs (interp, 2, objv, "?-callback n? ?-batch batchObject? ?-head? ?-handle? ?-fireforget? ?-coro? ?-profile name? ?-timeout ms? ?-tag tag? ?-trace? ?-array arrayName? ?-table tableName? ?-prepared preparedName? ?-consistency level? ?-idempotent? statement ?args? OR ?-upsert ?-mapunkown columnname? ?-nocomplain? ?-ifnotexists? table args?");
 				return TCL_ERROR;
 			}
 
@@ -770,10 +1584,68 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
 						upsert = 1;
 						break;
 					}
-					
+
+					case SUBOPT_HANDLE: {
+						futureFlags |= (CASSTCL_FUTURE_HANDLE);
+						break;
+					}
+
+					case SUBOPT_FIREFORGET: {
+						futureFlags |= (CASSTCL_FUTURE_FIRE_AND_FORGET);
+						break;
+					}
+
+					case SUBOPT_CORO: {
+						coro = 1;
+						break;
+					}
+
+					case SUBOPT_PROFILE: {
+						profileObj = objv[arg++];
+						if (casstcl_profile_check (ct, profileObj) == TCL_ERROR) {
+							return TCL_ERROR;
+						}
+						break;
+					}
+
+					case SUBOPT_TIMEOUT: {
+						if (Tcl_GetWideIntFromObj (interp, objv[arg++], &timeoutMS) == TCL_ERROR) {
+							Tcl_AppendResult (interp, " while converting timeout", NULL);
+							return TCL_ERROR;
+						}
+
+						if (timeoutMS < 0) {
+							Tcl_ResetResult (interp);
+							Tcl_AppendResult (interp, "-timeout can't be negative", NULL);
+							return TCL_ERROR;
+						}
+						break;
+					}
+
+					case SUBOPT_TAG: {
+						tagObj = objv[arg++];
+						break;
+					}
+
+					case SUBOPT_TRACE: {
+						trace = 1;
+						break;
+					}
 				}
 			}
 
+			// fire-and-forget requests never have a per-request callback,
+			// failures go to the session's fireforget_callback
+			if ((futureFlags & CASSTCL_FUTURE_FIRE_AND_FORGET) && callbackObj != NULL) {
+				Tcl_ResetResult (interp);
+				Tcl_AppendResult (interp, "-fireforget can't be used with -callback, set the session's fireforget_callback instead", NULL);
+				return TCL_ERROR;
+			}
+
+			// exec waits for the request, even with -coro, unless it has a
+			// callback or is fire-and-forget
+			synchronous = ((enum options) optIndex == OPT_EXEC && callbackObj == NULL && !(futureFlags & CASSTCL_FUTURE_FIRE_AND_FORGET));
+
 			if (batchObjName != NULL) {
 				if (arg != objc) {
 					Tcl_ResetResult (interp);
@@ -781,6 +1653,19 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
 					return TCL_ERROR;
 				}
 
+				if (casstcl_breaker_check (ct, NULL) == TCL_ERROR) {
+					return TCL_ERROR;
+				}
+
+				// a batch can't be held back, the batch object could be
+				// deleted meanwhile.  a blocking exec sleeps for its token,
+				// anything else takes one even if it leaves the bucket short.
+				if (synchronous && !(coro && casstcl_in_coroutine (interp))) {
+					casstcl_rate_limit_sleep (ct, NULL);
+				} else {
+					casstcl_rate_limit_charge (ct, NULL);
+				}
+
 				// get the batch object from the command name we extracted
 				casstcl_batchClientData *bcd = casstcl_batch_command_to_batchClientData (interp, batchObjName);
 				if (bcd == NULL) {
@@ -788,10 +1673,34 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
 					Tcl_AppendResult (interp, "batch object '", batchObjName, "' doesn't exist or isn't a batch object", NULL);
 					return TCL_ERROR;
 				}
-				const CassBatch *batch = bcd->batch;
 
+				// its statements are spread over one batch per partition
+				if (bcd->byPartition) {
+					Tcl_ResetResult (interp);
+					Tcl_AppendResult (interp, "batch object '", batchObjName, "' is grouped by partition, use its flush method to execute it", NULL);
+					return TCL_ERROR;
+				}
+				CassBatch *batch = bcd->batch;
+
+				// -profile and -timeout override the batch's own settings
+				// for this execution only
+				if (profileObj != NULL) {
+					cass_batch_set_execution_profile (batch, Tcl_GetString (profileObj));
+				}
+
+				if (timeoutMS >= 0) {
+					cass_batch_set_request_timeout (batch, (cass_uint64_t)timeoutMS);
+				}
+
+				cass_batch_set_tracing (batch, casstcl_trace_wanted (ct, trace || bcd->trace) ? cass_true : cass_false);
+
+				submitted = casstcl_now_us ();
 				future = cass_session_execute_batch (ct->session, batch);
 
+				if (profileObj != NULL || timeoutMS >= 0) {
+					casstcl_batch_apply_settings (bcd, batch);
+				}
+
 			} else if (upsert) {
 				int newObjc = objc - arg;
 				Tcl_Obj *CONST *newObjv = objv + arg;
@@ -800,9 +1709,31 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
 					return TCL_ERROR;
 	
 				}
+
+				tableNameObj = casstcl_rate_limit_table_from_objv (ct, newObjc, newObjv, 0, 1);
+				if (tableNameObj != NULL) {
+					Tcl_IncrRefCount (tableNameObj);
+				}
+
+				if (casstcl_breaker_check (ct, tableNameObj) == TCL_ERROR) {
+					if (tableNameObj != NULL) {
+						Tcl_DecrRefCount (tableNameObj);
+					}
+					cass_statement_free (statement);
+					return TCL_ERROR;
+				}
 				
-				future = cass_session_execute (ct->session, statement);
-				cass_statement_free (statement);
+				if (profileObj != NULL) {
+					cass_statement_set_execution_profile (statement, Tcl_GetString (profileObj));
+				}
+
+				if (timeoutMS >= 0) {
+					cass_statement_set_request_timeout (statement, (cass_uint64_t)timeoutMS);
+				}
+
+				if (casstcl_trace_wanted (ct, trace)) {
+					cass_statement_set_tracing (statement, cass_true);
+				}
 
 			} else {
 				// it's a statement, possibly with arguments
@@ -811,28 +1742,128 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
 					return TCL_ERROR;
 				}
 
-				future = cass_session_execute (ct->session, statement);
-				cass_statement_free (statement);
+				// the table name may come from a prepared statement, which
+				// could be deleted while waiting, so hold on to it
+				tableNameObj = casstcl_rate_limit_table_from_objv (ct, objc, objv, arg, 0);
+				if (tableNameObj != NULL) {
+					Tcl_IncrRefCount (tableNameObj);
+				}
+
+				if (casstcl_breaker_check (ct, tableNameObj) == TCL_ERROR) {
+					if (tableNameObj != NULL) {
+						Tcl_DecrRefCount (tableNameObj);
+					}
+					cass_statement_free (statement);
+					return TCL_ERROR;
+				}
+
+				if (profileObj != NULL) {
+					cass_statement_set_execution_profile (statement, Tcl_GetString (profileObj));
+				}
+
+				if (timeoutMS >= 0) {
+					cass_statement_set_request_timeout (statement, (cass_uint64_t)timeoutMS);
+				}
+
+				if (casstcl_trace_wanted (ct, trace)) {
+					cass_statement_set_tracing (statement, cass_true);
+				}
+			}
+
+			// the histograms the request's latency is counted in and its
+			// description for the slow query log, which fire-and-forget
+			// requests don't need
+			if (futureFlags & CASSTCL_FUTURE_FIRE_AND_FORGET) {
+				latencyKeysObj = NULL;
+			} else if (batchObjName != NULL) {
+				latencyKeysObj = casstcl_latency_keys_from_objv (ct, tagObj, 0, NULL, 0, 0);
+				slowlogObj = casstcl_slowlog_request (ct, "batch", Tcl_NewStringObj (batchObjName, -1), 0, NULL, NULL, tagObj);
+			} else if (upsert) {
+				latencyKeysObj = casstcl_latency_keys_from_objv (ct, tagObj, objc - arg, objv + arg, 0, 1);
+				slowlogObj = casstcl_slowlog_request_from_objv (ct, tagObj, objc - arg, objv + arg, 0, 1);
+			} else {
+				latencyKeysObj = casstcl_latency_keys_from_objv (ct, tagObj, objc, objv, arg, 0);
+				slowlogObj = casstcl_slowlog_request_from_objv (ct, tagObj, objc, objv, arg, 0);
+			}
+
+			if (latencyKeysObj != NULL) {
+				Tcl_IncrRefCount (latencyKeysObj);
+			}
+
+			if (slowlogObj != NULL) {
+				Tcl_IncrRefCount (slowlogObj);
 			}
 
-			// even with exec if you use -callback it's asynchronous
-			if (((enum options) optIndex == OPT_EXEC) && (callbackObj == NULL)) {
-				// synchronous
+			// even with exec if you use -callback or -fireforget it's
+			// asynchronous.  a statement (unlike a batch) hasn't been sent
+			// yet; asynchronous ones a rate limit holds back are queued and
+			// sent from a timer.
+			if (futureFlags & CASSTCL_FUTURE_FIRE_AND_FORGET) {
+				if (statement != NULL) {
+					casstcl_fireforget_execute (ct, statement, tableNameObj, futureFlags);
+				} else {
+					casstcl_fireforget (ct, future, futureFlags);
+				}
+			} else if (synchronous) {
+				// synchronous, or at least it looks that way from inside
+				// the coroutine with -coro, which yields rather than
+				// blocking while a rate limit holds the request back
+				if (coro) {
+					casstcl_execState *es = (casstcl_execState *)ckalloc (sizeof (casstcl_execState));
+
+					// our references pass to casstcl_exec_done
+					es->tableNameObj = tableNameObj;
+					es->latencyKeysObj = latencyKeysObj;
+					es->slowlogObj = slowlogObj;
+					es->submitted = submitted;
+					if (statement != NULL) {
+						return casstcl_coro_execute (ct, statement, 1, tableNameObj, &es->submitted, casstcl_exec_done, (ClientData)es);
+					}
+					return casstcl_coro_wait (ct, future, 1, casstcl_exec_done, (ClientData)es);
+				}
+
+				if (statement != NULL) {
+					casstcl_rate_limit_sleep (ct, tableNameObj);
+					submitted = casstcl_now_us ();
+					future = cass_session_execute (ct->session, statement);
+					cass_statement_free (statement);
+				}
+
 				cass_future_wait (future);
+				submitted = casstcl_now_us () - submitted;
+				casstcl_latency_record (ct, latencyKeysObj, submitted);
+				casstcl_slowlog_record (ct, slowlogObj, future, 1, submitted);
 
 				CassError rc = cass_future_error_code (future);
+				casstcl_breaker_record (ct, tableNameObj, rc);
 				if (rc != CASS_OK) {
 					resultCode = casstcl_future_error_to_tcl (ct, rc, future);
 				}
 
 				cass_future_free (future);
 			} else {
-				// asynchronous
-				if (casstcl_createFutureObjectCommand (ct, future, callbackObj, futureFlags) == TCL_ERROR) {
+				// asynchronous.  the outcome is recorded by the circuit
+				// breakers when the callback is delivered or, without
+				// one, when the future is first seen to be ready
+				futureFlags |= CASSTCL_FUTURE_BREAKER;
+				if (statement != NULL) {
+					resultCode = casstcl_future_execute (ct, statement, callbackObj, futureFlags, tableNameObj, latencyKeysObj, slowlogObj);
+				} else if (casstcl_createFutureObjectCommand (ct, future, callbackObj, futureFlags, tableNameObj, latencyKeysObj, slowlogObj) == TCL_ERROR) {
 					resultCode = TCL_ERROR;
 				}
 			}
 
+			if (tableNameObj != NULL) {
+				Tcl_DecrRefCount (tableNameObj);
+			}
+
+			if (latencyKeysObj != NULL) {
+				Tcl_DecrRefCount (latencyKeysObj);
+			}
+
+			if (slowlogObj != NULL) {
+				Tcl_DecrRefCount (slowlogObj);
+			}
 			break;
 		}
 
@@ -884,7 +1915,7 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
 
 			if (callbackObj != NULL) {
 				// asynchronous
-				if (casstcl_createFutureObjectCommand (ct, future, callbackObj, 0) == TCL_ERROR) {
+				if (casstcl_createFutureObjectCommand (ct, future, callbackObj, 0, NULL, NULL, NULL) == TCL_ERROR) {
 					resultCode = TCL_ERROR;
 				}
 			} else {
@@ -904,87 +1935,197 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
 		}
 
 		case OPT_PREPARE: {
-			char *query = NULL;
-			CassError rc = CASS_OK;
 			CassFuture *future;
-			char *statementString;
-			int statementStringLength;
+			int arg = 2;
+			int coro = 0;
+			int idempotent = 0;
 
-			if (objc != 5) {
-				Tcl_WrongNumArgs (interp, 2, objv, "name table statement");
+			while (objc - arg > 3) {
+				char *optionString = Tcl_GetString (objv[arg]);
+
+				if (strcmp (optionString, "-coro") == 0) {
+					coro = 1;
+				} else if (strcmp (optionString, "-idempotent") == 0) {
+					idempotent = 1;
+				} else {
+					break;
+				}
+				arg++;
+			}
+
+			if (objc - arg != 3) {
+				Tcl_WrongNumArgs (interp, 2, objv, "?-coro? ?-idempotent? name table statement");
 				return TCL_ERROR;
 			}
 
-			statementString = Tcl_GetStringFromObj (objv[4], &statementStringLength);
+			future = cass_session_prepare (ct->session, Tcl_GetString (objv[arg + 2]));
 
-			future = cass_session_prepare (ct->session, statementString);
+			if (coro) {
+				Tcl_Obj *argsObj = Tcl_NewListObj (3, objv + arg);
+				Tcl_ListObjAppendElement (NULL, argsObj, Tcl_NewBooleanObj (idempotent));
+				Tcl_IncrRefCount (argsObj);
+				return casstcl_coro_wait (ct, future, 1, casstcl_prepare_done, argsObj);
+			}
 
 			cass_future_wait (future);
 
-			rc = cass_future_error_code (future);
-			if (rc != CASS_OK) {
-				resultCode = casstcl_future_error_to_tcl (ct, rc, future);
-				cass_future_free (future);
-				Tcl_AppendResult (interp, " while attempting to prepare statement '", query, "'", NULL);
-				break;
+			resultCode = casstcl_prepared_from_future (ct, future, objv[arg], objv[arg + 1], objv[arg + 2], idempotent);
+			cass_future_free (future);
+			break;
+		}
+
+		case OPT_MULTIGET: {
+			return casstcl_multiget (ct, objc, objv);
+		}
+
+		case OPT_EXEC_MANY: {
+			return casstcl_exec_many (ct, objc, objv);
+		}
+
+		case OPT_COALESCE: {
+			return casstcl_coalesce (ct, objc, objv);
+		}
+
+		case OPT_COALESCE_UPSERT: {
+			return casstcl_coalesce_upsert (ct, objc, objv);
+		}
+
+		case OPT_COALESCE_FLUSH: {
+			return casstcl_coalesce_flush (ct, objc, objv);
+		}
+
+		case OPT_COUNTERS: {
+			if (objc < 3 || (objc & 1) == 0) {
+				Tcl_WrongNumArgs (interp, 2, objv, "name ?-interval ms? ?-max_keys n? ?-consistency level? ?-flush_callback callback?");
+				return TCL_ERROR;
 			}
 
-			const CassPrepared *cassPrepared = cass_future_get_prepared (future);
-			cass_future_free (future);
+			if (casstcl_createCounterObjectCommand (ct, Tcl_GetString (objv[2])) == TCL_ERROR) {
+				return TCL_ERROR;
+			}
+
+			if (objc > 3) {
+				Tcl_Obj *nameObj = Tcl_GetObjResult (interp);
+				casstcl_counterClientData *ccd;
+
+				Tcl_IncrRefCount (nameObj);
+				ccd = casstcl_counter_command_to_counterClientData (interp, Tcl_GetString (nameObj));
+
+				if (casstcl_counter_configure (ccd, objc - 3, &objv[3]) == TCL_ERROR) {
+					Tcl_DeleteCommandFromToken (interp, ccd->cmdToken);
+					Tcl_DecrRefCount (nameObj);
+					return TCL_ERROR;
+				}
+
+				Tcl_SetObjResult (interp, nameObj);
+				Tcl_DecrRefCount (nameObj);
+			}
 
-			// allocate one of our cass prepared data objects for Tcl
-			// and configure it
-			casstcl_preparedClientData *pcd = (casstcl_preparedClientData *)ckalloc (sizeof (casstcl_preparedClientData));
+			return TCL_OK;
+		}
 
-			pcd->cass_prepared_magic = CASS_PREPARED_MAGIC;
-			pcd->ct = ct;
-			pcd->prepared = cassPrepared;
+		case OPT_CACHE: {
+			return casstcl_cache (ct, objc, objv);
+		}
 
-			pcd->string = ckalloc (statementStringLength + 1);
-			strncpy (pcd->string, statementString, statementStringLength);
+		case OPT_WRITE_QUEUE: {
+			if (objc < 3 || (objc & 1) == 0) {
+				Tcl_WrongNumArgs (interp, 2, objv, "name ?-max_inflight n? ?-max_memory bytes? ?-retries n? ?-backoff ms? ?-max_backoff ms? ?-consistency level? ?-journal path? ?-fail_callback callback?");
+				return TCL_ERROR;
+			}
 
-			pcd->tableNameObj = objv[3];
-			Tcl_IncrRefCount (pcd->tableNameObj);
+			if (casstcl_createWriteQueueObjectCommand (ct, Tcl_GetString (objv[2])) == TCL_ERROR) {
+				return TCL_ERROR;
+			}
 
+			if (objc > 3) {
+				Tcl_Obj *nameObj = Tcl_GetObjResult (interp);
+				casstcl_writeQueueClientData *queue;
 
-			char *commandName = Tcl_GetString (objv[2]);
+				Tcl_IncrRefCount (nameObj);
+				queue = casstcl_writeq_command_to_writeQueueClientData (interp, Tcl_GetString (nameObj));
 
-#define PREPARED_STRING_FORMAT "prepared%lu"
-			// if commandName is #auto, generate a unique name for the object
-			int autoGeneratedName = 0;
-			if (strcmp (commandName, "#auto") == 0) {
-				static unsigned long nextAutoCounter = 0;
-				int baseNameLength = snprintf (NULL, 0, PREPARED_STRING_FORMAT, nextAutoCounter) + 1;
-				commandName = ckalloc (baseNameLength);
-				snprintf (commandName, baseNameLength, PREPARED_STRING_FORMAT, nextAutoCounter++);
-				autoGeneratedName = 1;
+				if (casstcl_writeq_configure (queue, objc - 3, &objv[3]) == TCL_ERROR) {
+					Tcl_DeleteCommandFromToken (interp, queue->cmdToken);
+					Tcl_DecrRefCount (nameObj);
+					return TCL_ERROR;
+				}
+
+				Tcl_SetObjResult (interp, nameObj);
+				Tcl_DecrRefCount (nameObj);
 			}
 
-			// create a Tcl command to interface to cass
-			pcd->cmdToken = Tcl_CreateObjCommand (interp, commandName, casstcl_preparedObjectObjCmd, pcd, casstcl_preparedObjectDelete);
-			Tcl_SetObjResult (interp, Tcl_NewStringObj (commandName, -1));
-			if (autoGeneratedName == 1) {
-				ckfree(commandName);
-			}
-			break;
+			return TCL_OK;
+		}
+
+		case OPT_RATE_LIMIT: {
+			return casstcl_rate_limit (ct, objc, objv);
+		}
+
+		case OPT_CIRCUIT_BREAKER: {
+			return casstcl_circuit_breaker (ct, objc, objv);
+		}
+
+		case OPT_PROFILE: {
+			return casstcl_profile (ct, objc, objv);
+		}
+
+		case OPT_LATENCY: {
+			return casstcl_latency (ct, objc, objv);
+		}
+
+		case OPT_SLOWLOG: {
+			return casstcl_slowlog (ct, objc, objv);
+		}
+
+		case OPT_TRACE_SAMPLE: {
+			return casstcl_trace_sample (ct, objc, objv);
+		}
+
+		case OPT_EXPORT_METRICS: {
+			return casstcl_export_metrics (ct, objc, objv);
 		}
 
 		case OPT_BATCH: {
 			CassBatchType cassBatchType = CASS_BATCH_TYPE_LOGGED;
+			int arg = 3;
 
-			if (objc < 3 || objc > 4) {
-				Tcl_WrongNumArgs (interp, 1, objv, "name ?type?");
+			// the type is optional and any batch options follow it
+			if (objc > 3 && *Tcl_GetString (objv[3]) != '-') {
+				if (casstcl_obj_to_cass_batch_type (interp, objv[3], &cassBatchType) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while determining batch type", NULL);
+					return TCL_ERROR;
+				}
+				arg++;
+			}
+
+			if (objc < 3 || ((objc - arg) & 1)) {
+				Tcl_WrongNumArgs (interp, 1, objv, "name ?type? ?-max_statements n? ?-max_bytes b? ?-flush_callback callback? ?-by_partition bool? ?-profile name? ?-timeout ms?");
 				return TCL_ERROR;
 			}
 
-			if (objc == 4) {
-				if (casstcl_obj_to_cass_batch_type (interp, objv[3], &cassBatchType) == TCL_ERROR) {
-					Tcl_AppendResult (interp, " while determining batch type", NULL);
+			if (casstcl_createBatchObjectCommand (ct, Tcl_GetString (objv[2]), cassBatchType) == TCL_ERROR) {
+				return TCL_ERROR;
+			}
+
+			if (arg < objc) {
+				Tcl_Obj *nameObj = Tcl_GetObjResult (interp);
+				casstcl_batchClientData *bcd;
+
+				Tcl_IncrRefCount (nameObj);
+				bcd = casstcl_batch_command_to_batchClientData (interp, Tcl_GetString (nameObj));
+
+				if (casstcl_batch_configure (bcd, objc - arg, &objv[arg]) == TCL_ERROR) {
+					Tcl_DeleteCommandFromToken (interp, bcd->cmdToken);
+					Tcl_DecrRefCount (nameObj);
 					return TCL_ERROR;
 				}
+
+				Tcl_SetObjResult (interp, nameObj);
+				Tcl_DecrRefCount (nameObj);
 			}
 
-			return casstcl_createBatchObjectCommand (ct, Tcl_GetString (objv[2]), cassBatchType);
+			return TCL_OK;
 		}
 
 		case OPT_LIST_KEYSPACES: {
@@ -1055,6 +2196,170 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
 			break;
 		}
 
+		case OPT_WRITE_STATS: {
+			int reset = 0;
+
+			if (objc == 3 && strcmp (Tcl_GetString (objv[2]), "-reset") == 0) {
+				reset = 1;
+			} else if (objc != 2) {
+				Tcl_WrongNumArgs (interp, 2, objv, "?-reset?");
+				return TCL_ERROR;
+			}
+
+			resultCode = casstcl_write_stats (interp, ct, reset);
+			break;
+		}
+
+		case OPT_FIREFORGET_CALLBACK: {
+			int limit = ct->writeStats.errorCallbackLimit;
+
+			if (objc < 2 || objc > 4) {
+				Tcl_WrongNumArgs (interp, 2, objv, "?callback? ?maxPerSecond?");
+				return TCL_ERROR;
+			}
+
+			if (objc == 2) {
+				if (ct->writeStats.errorCallbackObj != NULL) {
+					Tcl_SetObjResult (interp, ct->writeStats.errorCallbackObj);
+				}
+				break;
+			}
+
+			if (objc == 4) {
+				if (Tcl_GetIntFromObj (interp, objv[3], &limit) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting max callbacks per second", NULL);
+					return TCL_ERROR;
+				}
+
+				if (limit < 0) {
+					Tcl_SetObjResult (interp, Tcl_NewStringObj ("max callbacks per second can't be negative", -1));
+					return TCL_ERROR;
+				}
+			}
+
+			if (ct->writeStats.errorCallbackObj != NULL) {
+				Tcl_DecrRefCount (ct->writeStats.errorCallbackObj);
+				ct->writeStats.errorCallbackObj = NULL;
+			}
+
+			// an empty callback turns it off
+			int callbackLength;
+			Tcl_GetStringFromObj (objv[2], &callbackLength);
+			if (callbackLength > 0) {
+				ct->writeStats.errorCallbackObj = objv[2];
+				Tcl_IncrRefCount (objv[2]);
+			}
+
+			Tcl_MutexLock (&ct->writeStats.mutex);
+			ct->writeStats.errorCallbackLimit = limit;
+			Tcl_MutexUnlock (&ct->writeStats.mutex);
+			break;
+		}
+
+		case OPT_FUTURES: {
+			int which = CASSTCL_FUTURES_ALL;
+			Tcl_Obj *listObj = NULL;
+
+			static CONST char *subOptions[] = {
+				"-pending",
+				"-ready",
+				NULL
+			};
+
+			if (objc != 2 && objc != 3) {
+				Tcl_WrongNumArgs (interp, 2, objv, "?-pending|-ready?");
+				return TCL_ERROR;
+			}
+
+			if (objc == 3) {
+				int subOptIndex;
+
+				if (Tcl_GetIndexFromObj (interp, objv[2], subOptions, "subOption", TCL_EXACT, &subOptIndex) != TCL_OK) {
+					return TCL_ERROR;
+				}
+				which = (subOptIndex == 0) ? CASSTCL_FUTURES_PENDING : CASSTCL_FUTURES_READY;
+			}
+
+			if ((resultCode = casstcl_futures_list (ct, which, &listObj)) == TCL_OK) {
+				Tcl_SetObjResult (interp, listObj);
+			}
+			break;
+		}
+
+		case OPT_FUTURE_POLICY: {
+			int arg;
+			int subOptIndex;
+			int deleteAfterCallback = ct->futureDeleteAfterCallback;
+			int maxAge = ct->futureMaxAge;
+
+			static CONST char *subOptions[] = {
+				"-delete_after_callback",
+				"-max_age",
+				NULL
+			};
+
+			enum subOptions {
+				SUBOPT_DELETE_AFTER_CALLBACK,
+				SUBOPT_MAX_AGE
+			};
+
+			if ((objc & 1) != 0) {
+				Tcl_WrongNumArgs (interp, 2, objv, "?-delete_after_callback boolean? ?-max_age milliseconds?");
+				return TCL_ERROR;
+			}
+
+			for (arg = 2; arg < objc; arg += 2) {
+				if (Tcl_GetIndexFromObj (interp, objv[arg], subOptions, "subOption", TCL_EXACT, &subOptIndex) != TCL_OK) {
+					return TCL_ERROR;
+				}
+
+				switch ((enum subOptions) subOptIndex) {
+					case SUBOPT_DELETE_AFTER_CALLBACK: {
+						if (Tcl_GetBooleanFromObj (interp, objv[arg + 1], &deleteAfterCallback) == TCL_ERROR) {
+							return TCL_ERROR;
+						}
+						break;
+					}
+
+					case SUBOPT_MAX_AGE: {
+						if (Tcl_GetIntFromObj (interp, objv[arg + 1], &maxAge) == TCL_ERROR) {
+							Tcl_AppendResult (interp, " while converting max age", NULL);
+							return TCL_ERROR;
+						}
+
+						if (maxAge < 0) {
+							Tcl_SetObjResult (interp, Tcl_NewStringObj ("max age can't be negative", -1));
+							return TCL_ERROR;
+						}
+						break;
+					}
+				}
+			}
+
+			ct->futureDeleteAfterCallback = deleteAfterCallback;
+			if (maxAge != ct->futureMaxAge) {
+				casstcl_future_set_max_age (ct, maxAge);
+			}
+
+			Tcl_Obj *listObjv[4];
+			listObjv[0] = Tcl_NewStringObj ("-delete_after_callback", -1);
+			listObjv[1] = Tcl_NewBooleanObj (ct->futureDeleteAfterCallback);
+			listObjv[2] = Tcl_NewStringObj ("-max_age", -1);
+			listObjv[3] = Tcl_NewIntObj (ct->futureMaxAge);
+			Tcl_SetObjResult (interp, Tcl_NewListObj (4, listObjv));
+			break;
+		}
+
+		case OPT_FUTURE_STATS: {
+			if (objc != 2) {
+				Tcl_WrongNumArgs (interp, 2, objv, "");
+				return TCL_ERROR;
+			}
+
+			resultCode = casstcl_future_stats (interp, ct);
+			break;
+		}
+
 		case OPT_CLUSTER_VERSION: {
 		#ifdef CASS_POST_2_3_0
 			CassVersion version;
@@ -1551,6 +2856,70 @@ casstcl_cassObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj
 			break;
 		}
 
+		case OPT_SPECULATIVE_EXECUTION: {
+			Tcl_WideInt delayMs = 0;
+			int maxExecutions = 0;
+			CassError cassError;
+
+			if (objc != 4) {
+				Tcl_WrongNumArgs (interp, 2, objv, "delayMs maxExecutions");
+				return TCL_ERROR;
+			}
+
+			if (Tcl_GetWideIntFromObj (interp, objv[2], &delayMs) == TCL_ERROR) {
+				Tcl_AppendResult (interp, " while converting delayMs element", NULL);
+				return TCL_ERROR;
+			}
+
+			if (Tcl_GetIntFromObj (interp, objv[3], &maxExecutions) == TCL_ERROR) {
+				Tcl_AppendResult (interp, " while converting maxExecutions element", NULL);
+				return TCL_ERROR;
+			}
+
+			if (delayMs < 0 || maxExecutions < 0) {
+				Tcl_ResetResult (interp);
+				Tcl_AppendResult (interp, "delayMs and maxExecutions can't be negative", NULL);
+				return TCL_ERROR;
+			}
+
+			// only statements marked idempotent are ever sent more than
+			// once.  no extra executions turns it off.
+			if (maxExecutions == 0) {
+				cassError = cass_cluster_set_no_speculative_execution_policy (ct->cluster);
+			} else {
+				cassError = cass_cluster_set_constant_speculative_execution_policy (ct->cluster, delayMs, maxExecutions);
+			}
+
+			if (cassError != CASS_OK) {
+				return casstcl_cass_error_to_tcl (ct, cassError);
+			}
+			break;
+		}
+
+		case OPT_RETRY_POLICY: {
+			CassRetryPolicy *policy;
+			Tcl_Obj *policyObj;
+			int tclReturn;
+
+			if (objc < 3 || objc > 4) {
+				Tcl_WrongNumArgs (interp, 2, objv, "?logging? policy");
+				return TCL_ERROR;
+			}
+
+			policyObj = Tcl_NewListObj (objc - 2, &objv[2]);
+			Tcl_IncrRefCount (policyObj);
+			tclReturn = casstcl_obj_to_retry_policy (interp, policyObj, &policy);
+			Tcl_DecrRefCount (policyObj);
+			if (tclReturn == TCL_ERROR) {
+				return TCL_ERROR;
+			}
+
+			// the cluster keeps its own reference
+			cass_cluster_set_retry_policy (ct->cluster, policy);
+			cass_retry_policy_free (policy);
+			break;
+		}
+
 		case OPT_TCP_KEEPALIVE: {
 			int enable = 0;
 			int delaySecs = 0;
@@ -1997,6 +3366,163 @@ casstcl_list_columns (casstcl_sessionClientData *ct, char *keyspace, char *table
 	return tclReturn;
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_table_key_columns --
+ *
+ *      Given a fully qualified table name like "keyspace.table", return
+ *      a new list of the table's partition key columns, in order,
+ *      followed by its clustering columns if withClustering is set, from
+ *      the metadata managed by the driver.
+ *
+ * Results:
+ *      The list, or NULL if the table name isn't qualified or the table
+ *      can't be found.
+ *
+ *----------------------------------------------------------------------
+ */
+static Tcl_Obj *
+casstcl_table_key_columns (casstcl_sessionClientData *ct, char *tableName, int withClustering) {
+	Tcl_Obj *listObj = NULL;
+	char *dot = strchr (tableName, '.');
+
+	if (dot == NULL) {
+		return NULL;
+	}
+
+	Tcl_DString keyspace;
+	Tcl_DStringInit (&keyspace);
+	Tcl_DStringAppend (&keyspace, tableName, dot - tableName);
+
+	const CassSchemaMeta *schemaMeta = cass_session_get_schema_meta (ct->session);
+	const CassKeyspaceMeta *keyspaceMeta = cass_schema_meta_keyspace_by_name (schemaMeta, Tcl_DStringValue (&keyspace));
+	const CassTableMeta *tableMeta = NULL;
+
+	if (keyspaceMeta != NULL) {
+		tableMeta = cass_keyspace_meta_table_by_name (keyspaceMeta, dot + 1);
+	}
+
+	if (tableMeta != NULL) {
+		const char *columnName;
+		size_t columnNameLength;
+		size_t i;
+		size_t count = cass_table_meta_partition_key_count (tableMeta);
+
+		listObj = Tcl_NewObj ();
+		for (i = 0; i < count; i++) {
+			cass_column_meta_name (cass_table_meta_partition_key (tableMeta, i), &columnName, &columnNameLength);
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj (columnName, columnNameLength));
+		}
+
+		if (withClustering) {
+			count = cass_table_meta_clustering_key_count (tableMeta);
+			for (i = 0; i < count; i++) {
+				cass_column_meta_name (cass_table_meta_clustering_key (tableMeta, i), &columnName, &columnNameLength);
+				Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj (columnName, columnNameLength));
+			}
+		}
+	}
+
+	cass_schema_meta_free (schemaMeta);
+	Tcl_DStringFree (&keyspace);
+	return listObj;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_table_partition_key --
+ *
+ *      Given a fully qualified table name like "keyspace.table", set a
+ *      Tcl object pointer to a list of the table's partition key
+ *      columns, in order, from the metadata managed by the driver.
+ *
+ *      The lists are cached per session until the column type map is
+ *      reimported.  If the table name isn't qualified or the table
+ *      can't be found, the pointer is set to NULL.
+ *
+ * Results:
+ *      A standard Tcl result.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_table_partition_key (casstcl_sessionClientData *ct, char *tableName, Tcl_Obj **objPtr) {
+	Tcl_HashEntry *entry;
+	Tcl_Obj *listObj;
+	int isNew;
+
+	entry = Tcl_CreateHashEntry (&ct->partitionKeyTable, tableName, &isNew);
+	if (!isNew) {
+		*objPtr = (Tcl_Obj *)Tcl_GetHashValue (entry);
+		return TCL_OK;
+	}
+
+	listObj = casstcl_table_key_columns (ct, tableName, 0);
+	if (listObj != NULL) {
+		Tcl_IncrRefCount (listObj);
+	}
+
+	Tcl_SetHashValue (entry, listObj);
+	*objPtr = listObj;
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_table_primary_key --
+ *
+ *      Given a fully qualified table name like "keyspace.table", set a
+ *      Tcl object pointer to a new list of all of the table's primary
+ *      key columns, the partition key followed by the clustering
+ *      columns, from the metadata managed by the driver.
+ *
+ * Results:
+ *      A standard Tcl result.  It's an error if the table can't be
+ *      found.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_table_primary_key (casstcl_sessionClientData *ct, char *tableName, Tcl_Obj **objPtr) {
+	Tcl_Obj *listObj = casstcl_table_key_columns (ct, tableName, 1);
+
+	if (listObj == NULL) {
+		Tcl_ResetResult (ct->interp);
+		Tcl_AppendResult (ct->interp, "table '", tableName, "' not found, it must be given as keyspace.table", NULL);
+		return TCL_ERROR;
+	}
+
+	*objPtr = listObj;
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_forget_partition_keys --
+ *
+ *      Empty the session's cache of table partition keys.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_forget_partition_keys (casstcl_sessionClientData *ct) {
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+
+	while ((entry = Tcl_FirstHashEntry (&ct->partitionKeyTable, &search)) != NULL) {
+		Tcl_Obj *listObj = (Tcl_Obj *)Tcl_GetHashValue (entry);
+
+		if (listObj != NULL) {
+			Tcl_DecrRefCount (listObj);
+		}
+		Tcl_DeleteHashEntry (entry);
+	}
+}
+
 
 /*
  *----------------------------------------------------------------------
@@ -2256,6 +3782,8 @@ casstcl_make_statement_from_objv (casstcl_sessionClientData *ct, int objc, Tcl_O
 	char *consistencyName = NULL;
 	Tcl_Obj *consistencyObj = NULL;
 	CassConsistency consistency;
+	int idempotent = 0;
+	int tclReturn;
 	Tcl_Interp *interp = ct->interp;
 
     static CONST char *options[] = {
@@ -2263,6 +3791,7 @@ casstcl_make_statement_from_objv (casstcl_sessionClientData *ct, int objc, Tcl_O
 		"-table",
 		"-prepared",
 		"-consistency",
+		"-idempotent",
         NULL
     };
 
@@ -2270,7 +3799,8 @@ casstcl_make_statement_from_objv (casstcl_sessionClientData *ct, int objc, Tcl_O
         OPT_ARRAY,
 		OPT_TABLE,
 		OPT_PREPARED,
-		OPT_CONSISTENCY
+		OPT_CONSISTENCY,
+		OPT_IDEMPOTENT
 	};
 
 	int newObjc = objc - argOffset;
@@ -2341,6 +3871,11 @@ casstcl_make_statement_from_objv (casstcl_sessionClientData *ct, int objc, Tcl_O
 				}
 				break;
 			}
+
+			case OPT_IDEMPOTENT: {
+				idempotent = 1;
+				break;
+			}
 		}
 	}
 
@@ -2365,7 +3900,7 @@ casstcl_make_statement_from_objv (casstcl_sessionClientData *ct, int objc, Tcl_O
 	//
 	if (arg >= newObjc && preparedName == NULL) {
 	  wrong_numargs:
-		Tcl_WrongNumArgs (interp, (argOffset <= 2) ? argOffset : 2, objv, "?-array arrayName? ?-table tableName? ?-prepared preparedName? ?-consistency level? ?query? ?arg...?");
+		Tcl_WrongNumArgs (interp, (argOffset <= 2) ? argOffset : 2, objv, "?-array arrayName? ?-table tableName? ?-prepared preparedName? ?-consistency level? ?-idempotent? ?query? ?arg...?");
 		return TCL_ERROR;
 	}
 
@@ -2411,29 +3946,37 @@ casstcl_make_statement_from_objv (casstcl_sessionClientData *ct, int objc, Tcl_O
 				return TCL_ERROR;
 			}
 		}
-		return casstcl_bind_names_from_prepared (pcd, listObjc, listObjv, (consistencyObj != NULL) ? &consistency : NULL, statementPtr);
-	}
+		tclReturn = casstcl_bind_names_from_prepared (pcd, listObjc, listObjv, (consistencyObj != NULL) ? &consistency : NULL, statementPtr);
+	} else {
+		char *query = Tcl_GetString (newObjv[arg++]);
+		// (whatever is left of the newObjv from arg to the end are column-related)
 
-	char *query = Tcl_GetString (newObjv[arg++]);
-	// (whatever is left of the newObjv from arg to the end are column-related)
+		if (arrayStyle) {
+			if (tableName == NULL) {
+				Tcl_ResetResult (interp);
+				Tcl_AppendResult (interp, "-table must be specified if -array is specified", NULL);
+				return TCL_ERROR;
+			}
 
-	if (arrayStyle) {
-		if (tableName == NULL) {
-			Tcl_ResetResult (interp);
-			Tcl_AppendResult (interp, "-table must be specified if -array is specified", NULL);
-			return TCL_ERROR;
-		}
+			if (arrayName == NULL) {
+				Tcl_ResetResult (interp);
+				Tcl_AppendResult (interp, "-array must be specified if -table is specified", NULL);
+				return TCL_ERROR;
+			}
 
-		if (arrayName == NULL) {
-			Tcl_ResetResult (interp);
-			Tcl_AppendResult (interp, "-array must be specified if -table is specified", NULL);
-			return TCL_ERROR;
+			tclReturn = casstcl_bind_names_from_array (ct, tableName, query, arrayName, newObjc - arg, &newObjv[arg], (consistencyObj != NULL) ? &consistency : NULL, statementPtr);
+		} else {
+			tclReturn = casstcl_bind_values_and_types (ct, query, newObjc - arg, &newObjv[arg], (consistencyObj != NULL) ? &consistency : NULL, statementPtr);
 		}
+	}
 
-		return casstcl_bind_names_from_array (ct, tableName, query, arrayName, newObjc - arg, &newObjv[arg], (consistencyObj != NULL) ? &consistency : NULL, statementPtr);
-	} else {
-		return casstcl_bind_values_and_types (ct, query, newObjc - arg, &newObjv[arg], (consistencyObj != NULL) ? &consistency : NULL, statementPtr);
+	// tell the driver it's safe to send the statement more than once,
+	// like when speculative execution is on
+	if (tclReturn == TCL_OK && idempotent) {
+		cass_statement_set_is_idempotent (*statementPtr, cass_true);
 	}
+
+	return tclReturn;
 }
 
 
@@ -2474,6 +4017,9 @@ casstcl_reimport_column_type_map (casstcl_sessionClientData *ct)
 	Tcl_IncrRefCount (evalObjv[0]);
 	Tcl_IncrRefCount (evalObjv[1]);
 
+	// the schema may have changed, so look partition keys up again
+	casstcl_forget_partition_keys (ct);
+
 	tclReturnCode = Tcl_EvalObjv (interp, 2, evalObjv, (TCL_EVAL_GLOBAL|TCL_EVAL_DIRECT));
 
 	Tcl_DecrRefCount(evalObjv[0]);
@@ -174,4 +174,75 @@ int casstcl_make_statement_from_objv (
 	int argOffset, 
 	CassStatement **statementPtr);
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_table_partition_key --
+ *
+ *      Given a fully qualified table name like "keyspace.table", set a
+ *      Tcl object pointer to a list of the table's partition key
+ *      columns, in order, from the metadata managed by the driver.
+ *
+ *      The lists are cached per session until the column type map is
+ *      reimported.  If the table name isn't qualified or the table
+ *      can't be found, the pointer is set to NULL.
+ *
+ * Results:
+ *      A standard Tcl result.
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_table_partition_key (
+	casstcl_sessionClientData *ct,
+	char *tableName,
+	Tcl_Obj **objPtr);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_table_primary_key --
+ *
+ *      Given a fully qualified table name like "keyspace.table", set a
+ *      Tcl object pointer to a new list of all of the table's primary
+ *      key columns, the partition key followed by the clustering
+ *      columns, from the metadata managed by the driver.
+ *
+ * Results:
+ *      A standard Tcl result.  It's an error if the table can't be
+ *      found.
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_table_primary_key (
+	casstcl_sessionClientData *ct,
+	char *tableName,
+	Tcl_Obj **objPtr);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_forget_partition_keys --
+ *
+ *      Empty the session's cache of table partition keys.
+ *
+ *----------------------------------------------------------------------
+ */
+void casstcl_forget_partition_keys (casstcl_sessionClientData *ct);
+
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_metrics_list -- obtain session metrics as a list of
+ *   key-value pairs.
+ *
+ * Results:
+ *      A new list of metrics is returned.
+ *
+ * Side effects:
+ *      None.
+ *
+ *--------------------------------------------------------------
+ */
+Tcl_Obj *casstcl_metrics_list (CassSession *session);
+
 /* vim: set ts=4 sw=4 sts=4 noet : */
@@ -0,0 +1,690 @@
+/*
+ * casstcl_coalesce - Functions used to hold upserts to a table for a
+ *   window of time so that repeated writes of the same row are sent as
+ *   one, see the coalesce method
+ *
+ * casstcl - Tcl interface to CassDB
+ *
+ * Copyright (C) 2014 FlightAware LLC
+ *
+ * freely redistributable under the Berkeley license
+ */
+
+#include "casstcl.h"
+#include "casstcl_coalesce.h"
+#include "casstcl_batch.h"
+#include "casstcl_cassandra.h"
+#include "casstcl_types.h"
+
+#include <assert.h>
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coalesce_forget_rows --
+ *
+ *    throw away the rows a coalesced table has waiting
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_coalesce_forget_rows (casstcl_coalesceTable *cc)
+{
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+
+	while ((entry = Tcl_FirstHashEntry (&cc->rowTable, &search)) != NULL) {
+		Tcl_DecrRefCount ((Tcl_Obj *)Tcl_GetHashValue (entry));
+		Tcl_DeleteHashEntry (entry);
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coalesce_free_table --
+ *
+ *    stop coalescing a table, throwing away any rows it has waiting
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_coalesce_free_table (casstcl_coalesceTable *cc)
+{
+	if (cc->timer != NULL) {
+		Tcl_DeleteTimerHandler (cc->timer);
+	}
+
+	casstcl_coalesce_forget_rows (cc);
+	Tcl_DeleteHashTable (&cc->rowTable);
+
+	Tcl_DecrRefCount (cc->tableNameObj);
+	Tcl_DecrRefCount (cc->primaryKeyObj);
+	if (cc->flushCallbackObj != NULL) {
+		Tcl_DecrRefCount (cc->flushCallbackObj);
+	}
+
+	ckfree ((char *)cc);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coalesce_flush_table --
+ *
+ *    write out the rows a coalesced table has waiting, asynchronously,
+ *    as unlogged batches grouped by partition.
+ *
+ *    if the table has a flush callback, a future object is created to
+ *    invoke it as each batch completes.  otherwise the batches are
+ *    fire-and-forget, so failures are counted by write_stats and go to
+ *    the session's fireforget_callback.
+ *
+ *    a row that can't be added to a batch is skipped and the rest are
+ *    written anyway.  the waiting rows are forgotten once they've all
+ *    been added.
+ *
+ * Results:
+ *    A standard Tcl result.  On success the interpreter result is the
+ *    number of rows written.  If any rows were skipped, an error naming
+ *    them and why is returned after the others have been written.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_coalesce_flush_table (casstcl_coalesceTable *cc)
+{
+	casstcl_sessionClientData *ct = cc->ct;
+	Tcl_Interp *interp = ct->interp;
+	casstcl_batchClientData *bcd;
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+	Tcl_Obj *rowListObj;
+	Tcl_Obj *skippedObj;
+	int rows = cc->rowTable.numEntries;
+	int skipped;
+	int tclReturn;
+
+	if (cc->timer != NULL) {
+		Tcl_DeleteTimerHandler (cc->timer);
+		cc->timer = NULL;
+	}
+
+	if (rows == 0) {
+		Tcl_SetObjResult (interp, Tcl_NewIntObj (0));
+		return TCL_OK;
+	}
+
+	rowListObj = Tcl_NewObj ();
+	Tcl_IncrRefCount (rowListObj);
+	for (entry = Tcl_FirstHashEntry (&cc->rowTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+		Tcl_ListObjAppendElement (NULL, rowListObj, (Tcl_Obj *)Tcl_GetHashValue (entry));
+	}
+
+	bcd = casstcl_batch_new_client_data (ct, CASS_BATCH_TYPE_UNLOGGED);
+	bcd->byPartition = 1;
+	bcd->maxStatements = CASSTCL_FLUSH_MAX_BATCH_STATEMENTS;
+	if (cc->flushCallbackObj != NULL) {
+		bcd->flushCallbackObj = cc->flushCallbackObj;
+		Tcl_IncrRefCount (bcd->flushCallbackObj);
+	}
+
+	skippedObj = Tcl_NewObj ();
+	Tcl_IncrRefCount (skippedObj);
+
+	tclReturn = casstcl_batch_add_rows (bcd, NULL, cc->tableNameObj, rowListObj, 0, 0, skippedObj);
+	Tcl_DecrRefCount (rowListObj);
+
+	// every row has been added or skipped, so none of them are waiting
+	casstcl_coalesce_forget_rows (cc);
+
+	if (tclReturn == TCL_OK && casstcl_batch_flush (bcd) == TCL_ERROR) {
+		tclReturn = TCL_ERROR;
+	}
+
+	casstcl_batch_free_client_data (bcd);
+
+	if (tclReturn == TCL_ERROR) {
+		Tcl_DecrRefCount (skippedObj);
+		Tcl_AppendResult (interp, " while flushing coalesced rows for table '", Tcl_GetString (cc->tableNameObj), "'", NULL);
+		return TCL_ERROR;
+	}
+
+	Tcl_ListObjLength (NULL, skippedObj, &skipped);
+	skipped /= 2;
+	rows -= skipped;
+	cc->written += rows;
+
+	if (skipped > 0) {
+		char skippedString[TCL_INTEGER_SPACE];
+
+		sprintf (skippedString, "%d", skipped);
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "skipped ", skippedString, " coalesced rows for table '", Tcl_GetString (cc->tableNameObj), "' that couldn't be written: ", Tcl_GetString (skippedObj), NULL);
+		Tcl_DecrRefCount (skippedObj);
+		return TCL_ERROR;
+	}
+
+	Tcl_DecrRefCount (skippedObj);
+	Tcl_SetObjResult (interp, Tcl_NewIntObj (rows));
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coalesce_timer_proc --
+ *
+ *    called by the Tcl event loop when a coalesced table's window has
+ *    passed since its oldest waiting row arrived.  writes out its rows.
+ *
+ * Results:
+ *    If the flush fails, a Tcl background error is invoked.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_coalesce_timer_proc (ClientData clientData)
+{
+	casstcl_coalesceTable *cc = (casstcl_coalesceTable *)clientData;
+	Tcl_Interp *interp = cc->ct->interp;
+
+	cc->timer = NULL;
+
+	if (casstcl_coalesce_flush_table (cc) == TCL_ERROR) {
+		Tcl_BackgroundError (interp);
+	}
+	Tcl_ResetResult (interp);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coalesce_lookup --
+ *
+ *    find the coalescing state for a table
+ *
+ * Results:
+ *    The state, or NULL with an error message in the interpreter if the
+ *    table isn't being coalesced.
+ *
+ *----------------------------------------------------------------------
+ */
+static casstcl_coalesceTable *
+casstcl_coalesce_lookup (casstcl_sessionClientData *ct, char *tableName)
+{
+	Tcl_HashEntry *entry = Tcl_FindHashEntry (&ct->coalesceTable, tableName);
+
+	if (entry == NULL) {
+		Tcl_ResetResult (ct->interp);
+		Tcl_AppendResult (ct->interp, "table '", tableName, "' isn't being coalesced", NULL);
+		return NULL;
+	}
+
+	return (casstcl_coalesceTable *)Tcl_GetHashValue (entry);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coalesce_forget_all --
+ *
+ *    stop coalescing all of a session's tables.  if flush is set, their
+ *    waiting rows are written out first, ignoring any errors, otherwise
+ *    they're thrown away.  used when the session is deleted.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_coalesce_forget_all (casstcl_sessionClientData *ct, int flush)
+{
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+
+	while ((entry = Tcl_FirstHashEntry (&ct->coalesceTable, &search)) != NULL) {
+		casstcl_coalesceTable *cc = (casstcl_coalesceTable *)Tcl_GetHashValue (entry);
+
+		if (flush) {
+			casstcl_coalesce_flush_table (cc);
+			Tcl_ResetResult (ct->interp);
+		}
+
+		casstcl_coalesce_free_table (cc);
+		Tcl_DeleteHashEntry (entry);
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coalesce --
+ *
+ *    implements the coalesce method
+ *
+ *    $cass coalesce ?-table table? ?-window ms? ?-merge bool? ?-flush_callback callback?
+ *
+ *    with no arguments, returns the tables being coalesced.  with just
+ *    -table, returns that table's settings and counts.  otherwise sets
+ *    the table up to be coalesced, or changes its settings.  a window
+ *    of 0 writes out the table's waiting rows and stops coalescing it.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_coalesce (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Interp *interp = ct->interp;
+	casstcl_coalesceTable *cc;
+	Tcl_HashEntry *entry;
+	char *tableName = NULL;
+	int window = -1;
+	int merge = -1;
+	Tcl_Obj *flushCallbackObj = NULL;
+	int setCallback = 0;
+	int arg;
+	int subOptIndex;
+	int isNew;
+	int tclReturn;
+
+	static CONST char *subOptions[] = {
+		"-table",
+		"-window",
+		"-merge",
+		"-flush_callback",
+		NULL
+	};
+
+	enum subOptions {
+		SUBOPT_TABLE,
+		SUBOPT_WINDOW,
+		SUBOPT_MERGE,
+		SUBOPT_FLUSH_CALLBACK
+	};
+
+	if (objc == 2) {
+		Tcl_HashSearch search;
+		Tcl_Obj *listObj = Tcl_NewObj ();
+
+		for (entry = Tcl_FirstHashEntry (&ct->coalesceTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+			Tcl_ListObjAppendElement (NULL, listObj, ((casstcl_coalesceTable *)Tcl_GetHashValue (entry))->tableNameObj);
+		}
+
+		Tcl_SetObjResult (interp, listObj);
+		return TCL_OK;
+	}
+
+	if (objc & 1) {
+		Tcl_WrongNumArgs (interp, 2, objv, "?-table table? ?-window ms? ?-merge bool? ?-flush_callback callback?");
+		return TCL_ERROR;
+	}
+
+	for (arg = 2; arg < objc; arg += 2) {
+		if (Tcl_GetIndexFromObj (interp, objv[arg], subOptions, "subOption", TCL_EXACT, &subOptIndex) != TCL_OK) {
+			return TCL_ERROR;
+		}
+
+		switch ((enum subOptions) subOptIndex) {
+			case SUBOPT_TABLE: {
+				tableName = Tcl_GetString (objv[arg + 1]);
+				break;
+			}
+
+			case SUBOPT_WINDOW: {
+				if (Tcl_GetIntFromObj (interp, objv[arg + 1], &window) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting window", NULL);
+					return TCL_ERROR;
+				}
+
+				if (window < 0) {
+					Tcl_ResetResult (interp);
+					Tcl_AppendResult (interp, "coalesce window can't be negative", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_MERGE: {
+				if (Tcl_GetBooleanFromObj (interp, objv[arg + 1], &merge) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting merge", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_FLUSH_CALLBACK: {
+				int length;
+
+				Tcl_GetStringFromObj (objv[arg + 1], &length);
+				flushCallbackObj = (length == 0) ? NULL : objv[arg + 1];
+				setCallback = 1;
+				break;
+			}
+		}
+	}
+
+	if (tableName == NULL) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "coalesce requires -table", NULL);
+		return TCL_ERROR;
+	}
+
+	entry = Tcl_FindHashEntry (&ct->coalesceTable, tableName);
+
+	// just -table, report on it
+	if (objc == 4) {
+		Tcl_Obj *listObj = Tcl_NewObj ();
+
+		if ((cc = casstcl_coalesce_lookup (ct, tableName)) == NULL) {
+			return TCL_ERROR;
+		}
+
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-window", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (cc->window));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-merge", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewBooleanObj (cc->merge));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-flush_callback", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, (cc->flushCallbackObj != NULL) ? cc->flushCallbackObj : Tcl_NewObj ());
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("pending", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (cc->rowTable.numEntries));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("received", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (cc->received));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("written", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (cc->written));
+
+		Tcl_SetObjResult (interp, listObj);
+		return TCL_OK;
+	}
+
+	// a window of 0 stops coalescing the table
+	if (window == 0) {
+		if (entry == NULL) {
+			return TCL_OK;
+		}
+
+		// the rows are forgotten even if some were skipped, so stop
+		// coalescing the table either way
+		cc = (casstcl_coalesceTable *)Tcl_GetHashValue (entry);
+		tclReturn = casstcl_coalesce_flush_table (cc);
+
+		casstcl_coalesce_free_table (cc);
+		Tcl_DeleteHashEntry (entry);
+		if (tclReturn == TCL_OK) {
+			Tcl_ResetResult (interp);
+		}
+		return tclReturn;
+	}
+
+	if (entry == NULL) {
+		Tcl_Obj *primaryKeyObj;
+
+		if (window < 0) {
+			Tcl_ResetResult (interp);
+			Tcl_AppendResult (interp, "coalescing table '", tableName, "' requires -window", NULL);
+			return TCL_ERROR;
+		}
+
+		if (casstcl_table_primary_key (ct, tableName, &primaryKeyObj) == TCL_ERROR) {
+			return TCL_ERROR;
+		}
+
+		cc = (casstcl_coalesceTable *)ckalloc (sizeof (casstcl_coalesceTable));
+		cc->ct = ct;
+		cc->tableNameObj = Tcl_NewStringObj (tableName, -1);
+		Tcl_IncrRefCount (cc->tableNameObj);
+		cc->primaryKeyObj = primaryKeyObj;
+		Tcl_IncrRefCount (cc->primaryKeyObj);
+		cc->window = window;
+		cc->merge = 0;
+		cc->flushCallbackObj = NULL;
+		Tcl_InitHashTable (&cc->rowTable, TCL_STRING_KEYS);
+		cc->timer = NULL;
+		cc->received = 0;
+		cc->written = 0;
+
+		entry = Tcl_CreateHashEntry (&ct->coalesceTable, tableName, &isNew);
+		Tcl_SetHashValue (entry, cc);
+	} else {
+		cc = (casstcl_coalesceTable *)Tcl_GetHashValue (entry);
+	}
+
+	if (window > 0) {
+		cc->window = window;
+	}
+
+	if (merge >= 0) {
+		cc->merge = merge;
+	}
+
+	if (setCallback) {
+		if (cc->flushCallbackObj != NULL) {
+			Tcl_DecrRefCount (cc->flushCallbackObj);
+		}
+		cc->flushCallbackObj = flushCallbackObj;
+		if (flushCallbackObj != NULL) {
+			Tcl_IncrRefCount (flushCallbackObj);
+		}
+	}
+
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coalesce_upsert --
+ *
+ *    implements the coalesce_upsert method
+ *
+ *    $cass coalesce_upsert table keyValuePairList
+ *
+ *    holds an upsert to a coalesced table until the table's window has
+ *    passed since its oldest waiting row arrived.  if a row with the
+ *    same primary key is already waiting, this one replaces it or, if
+ *    the table is set to merge, its columns are merged into it.
+ *
+ *    the row's columns are checked against the table here, so a row
+ *    that couldn't be written is refused rather than held.
+ *
+ * Results:
+ *    A standard Tcl result.  The interpreter result is 1 if the row
+ *    replaced or was merged into one already waiting, otherwise 0.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_coalesce_upsert (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Interp *interp = ct->interp;
+	casstcl_coalesceTable *cc;
+	Tcl_HashEntry *entry;
+	Tcl_Obj **rowObjv;
+	Tcl_Obj **keyObjv;
+	Tcl_Obj *rowObj;
+	Tcl_DString key;
+	int rowObjc;
+	int keyObjc;
+	int isNew;
+	int mergeReturn = TCL_OK;
+	int i;
+
+	if (objc != 4) {
+		Tcl_WrongNumArgs (interp, 2, objv, "table keyValuePairList");
+		return TCL_ERROR;
+	}
+
+	if ((cc = casstcl_coalesce_lookup (ct, Tcl_GetString (objv[2]))) == NULL) {
+		return TCL_ERROR;
+	}
+
+	if (Tcl_ListObjGetElements (interp, objv[3], &rowObjc, &rowObjv) == TCL_ERROR) {
+		Tcl_AppendResult (interp, " while parsing list of key-value pairs", NULL);
+		return TCL_ERROR;
+	}
+
+	if (rowObjc & 1) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "key-value pair list must contain an even number of elements", NULL);
+		return TCL_ERROR;
+	}
+
+	// the row's primary key values, as a list, identify it
+	Tcl_ListObjGetElements (NULL, cc->primaryKeyObj, &keyObjc, &keyObjv);
+	Tcl_DStringInit (&key);
+
+	for (i = 0; i < keyObjc; i++) {
+		char *columnName = Tcl_GetString (keyObjv[i]);
+		int j;
+
+		for (j = 0; j < rowObjc; j += 2) {
+			if (strcmp (Tcl_GetString (rowObjv[j]), columnName) == 0) {
+				break;
+			}
+		}
+
+		if (j >= rowObjc) {
+			Tcl_DStringFree (&key);
+			Tcl_ResetResult (interp);
+			Tcl_AppendResult (interp, "row for table '", Tcl_GetString (cc->tableNameObj), "' is missing primary key column '", columnName, "'", NULL);
+			return TCL_ERROR;
+		}
+
+		Tcl_DStringAppendElement (&key, Tcl_GetString (rowObjv[j + 1]));
+	}
+
+	for (i = 0; i < rowObjc; i += 2) {
+		casstcl_cassTypeInfo typeInfo;
+		int tclReturn = casstcl_typename_obj_to_cass_value_types (interp, Tcl_GetString (cc->tableNameObj), rowObjv[i], &typeInfo);
+
+		if (tclReturn == TCL_ERROR) {
+			Tcl_DStringFree (&key);
+			return TCL_ERROR;
+		}
+
+		if (tclReturn == TCL_CONTINUE) {
+			Tcl_ResetResult (interp);
+			Tcl_AppendResult (interp, "unknown column '", Tcl_GetString (rowObjv[i]), "' in upsert for table '", Tcl_GetString (cc->tableNameObj), "'", NULL);
+			Tcl_DStringFree (&key);
+			return TCL_ERROR;
+		}
+	}
+
+	entry = Tcl_CreateHashEntry (&cc->rowTable, Tcl_DStringValue (&key), &isNew);
+	Tcl_DStringFree (&key);
+	cc->received++;
+
+	if (isNew) {
+		rowObj = objv[3];
+		Tcl_IncrRefCount (rowObj);
+		Tcl_SetHashValue (entry, rowObj);
+	} else if (cc->merge) {
+		rowObj = (Tcl_Obj *)Tcl_GetHashValue (entry);
+
+		if (Tcl_IsShared (rowObj)) {
+			Tcl_Obj *copyObj = Tcl_DuplicateObj (rowObj);
+
+			Tcl_IncrRefCount (copyObj);
+			Tcl_DecrRefCount (rowObj);
+			rowObj = copyObj;
+			Tcl_SetHashValue (entry, rowObj);
+		}
+
+		for (i = 0; i < rowObjc; i += 2) {
+			if (Tcl_DictObjPut (interp, rowObj, rowObjv[i], rowObjv[i + 1]) == TCL_ERROR) {
+				mergeReturn = TCL_ERROR;
+				break;
+			}
+		}
+	} else {
+		Tcl_DecrRefCount ((Tcl_Obj *)Tcl_GetHashValue (entry));
+		rowObj = objv[3];
+		Tcl_IncrRefCount (rowObj);
+		Tcl_SetHashValue (entry, rowObj);
+	}
+
+	// the rows already waiting have to be written even if this one
+	// couldn't be merged
+	if (cc->timer == NULL) {
+		cc->timer = Tcl_CreateTimerHandler (cc->window, casstcl_coalesce_timer_proc, (ClientData)cc);
+	}
+
+	if (mergeReturn == TCL_ERROR) {
+		return TCL_ERROR;
+	}
+
+	Tcl_SetObjResult (interp, Tcl_NewBooleanObj (!isNew));
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coalesce_flush --
+ *
+ *    implements the coalesce_flush method
+ *
+ *    $cass coalesce_flush ?table?
+ *
+ *    writes out the rows waiting for a coalesced table, or for all of
+ *    them, right away
+ *
+ * Results:
+ *    A standard Tcl result.  The interpreter result is the number of
+ *    rows written.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_coalesce_flush (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Interp *interp = ct->interp;
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+	casstcl_coalesceTable *cc;
+	Tcl_Obj *errorObj = NULL;
+	Tcl_WideInt rows = 0;
+
+	if (objc > 3) {
+		Tcl_WrongNumArgs (interp, 2, objv, "?table?");
+		return TCL_ERROR;
+	}
+
+	if (objc == 3) {
+		if ((cc = casstcl_coalesce_lookup (ct, Tcl_GetString (objv[2]))) == NULL) {
+			return TCL_ERROR;
+		}
+
+		return casstcl_coalesce_flush_table (cc);
+	}
+
+	for (entry = Tcl_FirstHashEntry (&ct->coalesceTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+		int tableRows;
+
+		cc = (casstcl_coalesceTable *)Tcl_GetHashValue (entry);
+
+		// keep flushing the other tables, raising the first error after
+		if (casstcl_coalesce_flush_table (cc) == TCL_ERROR) {
+			if (errorObj == NULL) {
+				errorObj = Tcl_GetObjResult (interp);
+				Tcl_IncrRefCount (errorObj);
+			}
+			continue;
+		}
+
+		Tcl_GetIntFromObj (NULL, Tcl_GetObjResult (interp), &tableRows);
+		rows += tableRows;
+	}
+
+	if (errorObj != NULL) {
+		Tcl_SetObjResult (interp, errorObj);
+		Tcl_DecrRefCount (errorObj);
+		return TCL_ERROR;
+	}
+
+	Tcl_SetObjResult (interp, Tcl_NewWideIntObj (rows));
+	return TCL_OK;
+}
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
@@ -0,0 +1,113 @@
+/*
+ *
+ * Include file for casstcl_coalesce
+ *
+ * Copyright (C) 2015 by FlightAware, All Rights Reserved
+ *
+ * Freely redistributable under the Berkeley copyright, see license.terms
+ * for details.
+ */
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coalesce_flush_table --
+ *
+ *    write out the rows a coalesced table has waiting, asynchronously,
+ *    as unlogged batches grouped by partition.
+ *
+ *    if the table has a flush callback, a future object is created to
+ *    invoke it as each batch completes.  otherwise the batches are
+ *    fire-and-forget, so failures are counted by write_stats and go to
+ *    the session's fireforget_callback.
+ *
+ *    a row that can't be added to a batch is skipped and the rest are
+ *    written anyway.  the waiting rows are forgotten once they've all
+ *    been added.
+ *
+ * Results:
+ *    A standard Tcl result.  On success the interpreter result is the
+ *    number of rows written.  If any rows were skipped, an error naming
+ *    them and why is returned after the others have been written.
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_coalesce_flush_table (casstcl_coalesceTable *cc);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coalesce_forget_all --
+ *
+ *    stop coalescing all of a session's tables.  if flush is set, their
+ *    waiting rows are written out first, ignoring any errors, otherwise
+ *    they're thrown away.  used when the session is deleted.
+ *
+ *----------------------------------------------------------------------
+ */
+void casstcl_coalesce_forget_all (casstcl_sessionClientData *ct, int flush);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coalesce --
+ *
+ *    implements the coalesce method
+ *
+ *    $cass coalesce ?-table table? ?-window ms? ?-merge bool? ?-flush_callback callback?
+ *
+ *    with no arguments, returns the tables being coalesced.  with just
+ *    -table, returns that table's settings and counts.  otherwise sets
+ *    the table up to be coalesced, or changes its settings.  a window
+ *    of 0 writes out the table's waiting rows and stops coalescing it.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_coalesce (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[]);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coalesce_upsert --
+ *
+ *    implements the coalesce_upsert method
+ *
+ *    $cass coalesce_upsert table keyValuePairList
+ *
+ *    holds an upsert to a coalesced table until the table's window has
+ *    passed since its oldest waiting row arrived.  if a row with the
+ *    same primary key is already waiting, this one replaces it or, if
+ *    the table is set to merge, its columns are merged into it.
+ *
+ * Results:
+ *    A standard Tcl result.  The interpreter result is 1 if the row
+ *    replaced or was merged into one already waiting, otherwise 0.
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_coalesce_upsert (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[]);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coalesce_flush --
+ *
+ *    implements the coalesce_flush method
+ *
+ *    $cass coalesce_flush ?table?
+ *
+ *    writes out the rows waiting for a coalesced table, or for all of
+ *    them, right away
+ *
+ * Results:
+ *    A standard Tcl result.  The interpreter result is the number of
+ *    rows written.
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_coalesce_flush (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[]);
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
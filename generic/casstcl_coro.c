@@ -0,0 +1,456 @@
+/*
+ * casstcl_coro - Functions used to let commands yield the current
+ *   coroutine, rather than blocking, while waiting for a future
+ *
+ * casstcl - Tcl interface to CassDB
+ *
+ * Copyright (C) 2014 FlightAware LLC
+ *
+ * freely redistributable under the Berkeley license
+ */
+
+#include "casstcl.h"
+#include "casstcl_coro.h"
+#include "casstcl_future.h"
+#include "casstcl_ratelimit.h"
+
+#include <assert.h>
+
+// nonzero if the Tcl we were loaded into has the non-recursive engine
+int casstcl_haveNRE = 0;
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coro_release --
+ *
+ *    drop a reference to a coroutine wait record, freeing it (and the
+ *    future, if the record owns it) when the last one goes
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_coro_release (casstcl_coroWait *cw)
+{
+	if (--cw->refCount > 0) {
+		return;
+	}
+
+	if (cw->ownsFuture && cw->future != NULL) {
+		cass_future_free (cw->future);
+	}
+
+	if (cw->coroObj != NULL) {
+		Tcl_DecrRefCount (cw->coroObj);
+	}
+
+	Tcl_Release ((ClientData)cw->ct);
+	ckfree ((char *)cw);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coro_eventProc --
+ *
+ *    this routine is called by the Tcl event handler when a future a
+ *    coroutine is waiting on has completed
+ *
+ * Results:
+ *    The coroutine is resumed if it is still waiting.  If resuming it
+ *    raises an error, a Tcl background exception is invoked.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_coro_eventProc (Tcl_Event *tevPtr, int flags) {
+	casstcl_coroEvent *evPtr = (casstcl_coroEvent *)tevPtr;
+	casstcl_coroWait *cw = evPtr->cw;
+	Tcl_Interp *interp = cw->ct->interp;
+	Tcl_Obj *coroObj = cw->coroObj;
+	int waiting = cw->waiting;
+
+	cw->completed = 1;
+	Tcl_IncrRefCount (coroObj);
+	casstcl_coro_release (cw);
+
+	if (waiting) {
+		if (Tcl_EvalObjEx (interp, coroObj, TCL_EVAL_GLOBAL) == TCL_ERROR) {
+			Tcl_BackgroundError (interp);
+		}
+	}
+
+	Tcl_DecrRefCount (coroObj);
+	return 1;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coro_callback --
+ *
+ *    this routine is called by the cassandra cpp-driver, in one of its
+ *    own threads, when a future a coroutine is waiting on completes.
+ *    it queues an event to the waiting interpreter's thread for
+ *    casstcl_coro_eventProc.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_coro_callback (CassFuture *future, void *data) {
+	casstcl_coroWait *cw = (casstcl_coroWait *)data;
+	casstcl_coroEvent *evPtr = (casstcl_coroEvent *) ckalloc (sizeof (casstcl_coroEvent));
+
+	evPtr->event.proc = casstcl_coro_eventProc;
+	evPtr->cw = cw;
+	Tcl_ThreadQueueEvent (cw->ct->threadId, (Tcl_Event *)evPtr, TCL_QUEUE_TAIL);
+	casstcl_wait_notify ();
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_current_coroutine --
+ *
+ *    return a new object holding the fully qualified name of the
+ *    coroutine the interpreter is currently running in, or NULL if it
+ *    isn't running in one or this Tcl doesn't have coroutines
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Obj *
+casstcl_current_coroutine (Tcl_Interp *interp)
+{
+	Tcl_Obj *coroObj = NULL;
+
+	if (!casstcl_haveNRE) {
+		return NULL;
+	}
+
+	Tcl_Obj *savedResultObj = Tcl_GetObjResult (interp);
+	Tcl_IncrRefCount (savedResultObj);
+
+	if (Tcl_EvalEx (interp, "::info coroutine", -1, 0) == TCL_OK) {
+		int length;
+
+		coroObj = Tcl_GetObjResult (interp);
+		Tcl_GetStringFromObj (coroObj, &length);
+		if (length == 0) {
+			coroObj = NULL;
+		}
+	}
+
+	if (coroObj != NULL) {
+		Tcl_IncrRefCount (coroObj);
+	}
+
+	Tcl_SetObjResult (interp, savedResultObj);
+	Tcl_DecrRefCount (savedResultObj);
+	return coroObj;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_in_coroutine --
+ *
+ *    return nonzero if the interpreter is running in a coroutine
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_in_coroutine (Tcl_Interp *interp)
+{
+	Tcl_Obj *coroObj = casstcl_current_coroutine (interp);
+
+	if (coroObj == NULL) {
+		return 0;
+	}
+
+	Tcl_DecrRefCount (coroObj);
+	return 1;
+}
+
+#ifdef CASSTCL_HAVE_NRE
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coro_resumed --
+ *
+ *    NRE callback run when the coroutine that yielded in
+ *    casstcl_coro_wait is resumed
+ *
+ * Results:
+ *    If the future has completed, the result of the wait's done proc.
+ *    If the coroutine was resumed by something else first, it yields
+ *    again.  If it is being deleted, the error is passed along.
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_coro_resumed (ClientData data[], Tcl_Interp *interp, int result)
+{
+	casstcl_coroWait *cw = (casstcl_coroWait *)data[0];
+
+	if (result != TCL_OK) {
+		cw->waiting = 0;
+
+		// a request still held back by a rate limit will never complete,
+		// so its reference goes now
+		if (cw->held != NULL) {
+			casstcl_rate_limit_cancel (cw->held);
+			cw->held = NULL;
+			cw->refCount--;
+		}
+
+		(*cw->doneProc) (cw->ct, NULL, cw->clientData);
+		casstcl_coro_release (cw);
+		return result;
+	}
+
+	if (!cw->completed) {
+		Tcl_NRAddCallback (interp, casstcl_coro_resumed, cw, NULL, NULL, NULL);
+		return Tcl_NREvalObj (interp, Tcl_NewStringObj ("::yield", -1), 0);
+	}
+
+	cw->waiting = 0;
+	Tcl_ResetResult (interp);
+	result = (*cw->doneProc) (cw->ct, cw->future, cw->clientData);
+	casstcl_coro_release (cw);
+	return result;
+}
+#endif
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coro_wait --
+ *
+ *    wait for a future to complete and then call doneProc with the
+ *    session, the future and the client data.
+ *
+ *    if the interpreter is running in a coroutine, this arranges for the
+ *    coroutine to be resumed when the future completes and yields it,
+ *    so the thread and its event loop aren't blocked.  when the
+ *    coroutine is resumed, doneProc is called and its result becomes the
+ *    result of the command that called this.  in this case this must be
+ *    called from an NRE-enabled command and its result returned.
+ *
+ *    otherwise, or if the future already has a callback set, this
+ *    just waits on the future and calls doneProc right away.
+ *
+ *    if ownsFuture is nonzero, the future is freed after doneProc
+ *    returns (or when the wait is abandoned because the coroutine was
+ *    deleted).  the session structure is preserved while the coroutine
+ *    waits, but the session may be deleted in the meantime, in which
+ *    case its CassSession pointer will be NULL when doneProc is called.
+ *
+ *    if the coroutine is deleted while waiting, doneProc is called with
+ *    a NULL future so it can clean up whatever its client data holds;
+ *    its result is ignored.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_coro_wait (casstcl_sessionClientData *ct, CassFuture *future, int ownsFuture, casstcl_coroDoneProc *doneProc, ClientData clientData)
+{
+	Tcl_Interp *interp = ct->interp;
+	int result;
+
+#ifdef CASSTCL_HAVE_NRE
+	Tcl_Obj *coroObj = NULL;
+
+	if (!cass_future_ready (future)) {
+		coroObj = casstcl_current_coroutine (interp);
+	}
+
+	if (coroObj != NULL) {
+		casstcl_coroWait *cw = (casstcl_coroWait *)ckalloc (sizeof (casstcl_coroWait));
+
+		// one reference for the completion event and one for us
+		cw->refCount = 2;
+		cw->waiting = 1;
+		cw->completed = 0;
+		cw->ownsFuture = ownsFuture;
+		cw->ct = ct;
+		cw->future = future;
+		cw->held = NULL;
+		cw->submittedPtr = NULL;
+		cw->coroObj = coroObj;
+		cw->doneProc = doneProc;
+		cw->clientData = clientData;
+		Tcl_Preserve ((ClientData)ct);
+
+		if (cass_future_set_callback (future, casstcl_coro_callback, cw) == CASS_OK) {
+			Tcl_NRAddCallback (interp, casstcl_coro_resumed, cw, NULL, NULL, NULL);
+			return Tcl_NREvalObj (interp, Tcl_NewStringObj ("::yield", -1), 0);
+		}
+
+		// somebody else already has the callback, fall back to blocking
+		cw->ownsFuture = 0;
+		cw->refCount = 1;
+		casstcl_coro_release (cw);
+	}
+#endif
+
+	cass_future_wait (future);
+	result = (*doneProc) (ct, future, clientData);
+
+	if (ownsFuture) {
+		cass_future_free (future);
+	}
+
+	return result;
+}
+
+#ifdef CASSTCL_HAVE_NRE
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coro_submitted --
+ *
+ *    submit proc for the request of a coroutine that casstcl_coro_execute
+ *    yielded while a rate limit held it back.  the coroutine is resumed
+ *    when the request completes.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_coro_submitted (casstcl_sessionClientData *ct, CassFuture *future, ClientData clientData)
+{
+	casstcl_coroWait *cw = (casstcl_coroWait *)clientData;
+
+	cw->held = NULL;
+	cw->future = future;
+	*cw->submittedPtr = casstcl_now_us ();
+	cass_future_set_callback (future, casstcl_coro_callback, cw);
+}
+#endif
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coro_execute --
+ *
+ *    send a statement, subject to the session's rate limits, and wait
+ *    for it as casstcl_coro_wait does, storing the time it was sent in
+ *    *submittedPtr before the future is passed to doneProc.  the
+ *    statement is freed once it's sent if ownsStatement is set.
+ *
+ *    if the interpreter is running in a coroutine and a rate limit
+ *    holds the request back, the coroutine yields until the request has
+ *    been sent and has completed.  otherwise this sleeps until the
+ *    limit allows the request.
+ *
+ *    if the coroutine is deleted while the request is held back, the
+ *    request is thrown away and doneProc is called with a NULL future.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_coro_execute (casstcl_sessionClientData *ct, CassStatement *statement, int ownsStatement, Tcl_Obj *tableNameObj, Tcl_WideInt *submittedPtr, casstcl_coroDoneProc *doneProc, ClientData clientData)
+{
+	CassFuture *future;
+
+#ifdef CASSTCL_HAVE_NRE
+	Tcl_Interp *interp = ct->interp;
+	Tcl_Obj *coroObj = casstcl_current_coroutine (interp);
+
+	if (coroObj != NULL) {
+		casstcl_coroWait *cw = (casstcl_coroWait *)ckalloc (sizeof (casstcl_coroWait));
+
+		// one reference for the held request, which passes to the
+		// completion event, and one for us
+		cw->refCount = 2;
+		cw->waiting = 1;
+		cw->completed = 0;
+		cw->ownsFuture = 1;
+		cw->ct = ct;
+		cw->future = NULL;
+		cw->held = NULL;
+		cw->submittedPtr = submittedPtr;
+		cw->coroObj = coroObj;
+		cw->doneProc = doneProc;
+		cw->clientData = clientData;
+		Tcl_Preserve ((ClientData)ct);
+
+		if (casstcl_rate_limit_hold (ct, tableNameObj, statement, ownsStatement, casstcl_coro_submitted, (ClientData)cw, &cw->held)) {
+			Tcl_NRAddCallback (interp, casstcl_coro_resumed, cw, NULL, NULL, NULL);
+			return Tcl_NREvalObj (interp, Tcl_NewStringObj ("::yield", -1), 0);
+		}
+
+		// it got a token, so there's nothing to wait for but the request
+		cw->refCount = 1;
+		casstcl_coro_release (cw);
+	} else {
+		casstcl_rate_limit_sleep (ct, tableNameObj);
+	}
+#else
+	casstcl_rate_limit_sleep (ct, tableNameObj);
+#endif
+
+	*submittedPtr = casstcl_now_us ();
+	future = cass_session_execute (ct->session, statement);
+	if (ownsStatement) {
+		cass_statement_free (statement);
+	}
+
+	return casstcl_coro_wait (ct, future, 1, doneProc, clientData);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_create_nr_command --
+ *
+ *    create a command with both a regular object proc and an NRE proc
+ *    if the Tcl we are running in supports it, otherwise just a regular
+ *    object command
+ *
+ * Results:
+ *    The command token
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Command
+casstcl_create_nr_command (Tcl_Interp *interp, const char *name, Tcl_ObjCmdProc *proc, Tcl_ObjCmdProc *nreProc, ClientData clientData, Tcl_CmdDeleteProc *deleteProc)
+{
+#ifdef CASSTCL_HAVE_NRE
+	if (casstcl_haveNRE) {
+		return Tcl_NRCreateCommand (interp, name, proc, nreProc, clientData, deleteProc);
+	}
+#endif
+	return Tcl_CreateObjCommand (interp, name, proc, clientData, deleteProc);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_nr_call --
+ *
+ *    call an NRE proc from a regular object command proc, running it
+ *    on the NRE trampoline if this Tcl has one
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_nr_call (Tcl_Interp *interp, Tcl_ObjCmdProc *nreProc, ClientData clientData, int objc, Tcl_Obj *CONST objv[])
+{
+#ifdef CASSTCL_HAVE_NRE
+	if (casstcl_haveNRE) {
+		return Tcl_NRCallObjProc (interp, nreProc, clientData, objc, objv);
+	}
+#endif
+	return (*nreProc) (clientData, interp, objc, objv);
+}
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
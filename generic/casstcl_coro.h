@@ -0,0 +1,149 @@
+/*
+ *
+ * Include file for casstcl_coro
+ *
+ * Copyright (C) 2015 by FlightAware, All Rights Reserved
+ *
+ * Freely redistributable under the Berkeley copyright, see license.terms
+ * for details.
+ */
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coro_eventProc --
+ *
+ *    this routine is called by the Tcl event handler when a future a
+ *    coroutine is waiting on has completed
+ *
+ * Results:
+ *    The coroutine is resumed if it is still waiting.  If resuming it
+ *    raises an error, a Tcl background exception is invoked.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_coro_eventProc (Tcl_Event *tevPtr, int flags);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_current_coroutine --
+ *
+ *    return a new object holding the fully qualified name of the
+ *    coroutine the interpreter is currently running in, or NULL if it
+ *    isn't running in one or this Tcl doesn't have coroutines
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Obj *
+casstcl_current_coroutine (Tcl_Interp *interp);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_in_coroutine --
+ *
+ *    return nonzero if the interpreter is running in a coroutine
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_in_coroutine (Tcl_Interp *interp);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coro_wait --
+ *
+ *    wait for a future to complete and then call doneProc with the
+ *    session, the future and the client data.
+ *
+ *    if the interpreter is running in a coroutine, this arranges for the
+ *    coroutine to be resumed when the future completes and yields it,
+ *    so the thread and its event loop aren't blocked.  when the
+ *    coroutine is resumed, doneProc is called and its result becomes the
+ *    result of the command that called this.  in this case this must be
+ *    called from an NRE-enabled command and its result returned.
+ *
+ *    otherwise, or if the future already has a callback set, this
+ *    just waits on the future and calls doneProc right away.
+ *
+ *    if ownsFuture is nonzero, the future is freed after doneProc
+ *    returns (or when the wait is abandoned because the coroutine was
+ *    deleted).  the session structure is preserved while the coroutine
+ *    waits, but the session may be deleted in the meantime, in which
+ *    case its CassSession pointer will be NULL when doneProc is called.
+ *
+ *    if the coroutine is deleted while waiting, doneProc is called with
+ *    a NULL future so it can clean up whatever its client data holds;
+ *    its result is ignored.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_coro_wait (casstcl_sessionClientData *ct, CassFuture *future, int ownsFuture, casstcl_coroDoneProc *doneProc, ClientData clientData);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_coro_execute --
+ *
+ *    send a statement, subject to the session's rate limits, and wait
+ *    for it as casstcl_coro_wait does, storing the time it was sent in
+ *    *submittedPtr before the future is passed to doneProc.  the
+ *    statement is freed once it's sent if ownsStatement is set.
+ *
+ *    if the interpreter is running in a coroutine and a rate limit
+ *    holds the request back, the coroutine yields until the request has
+ *    been sent and has completed.  otherwise this sleeps until the
+ *    limit allows the request.
+ *
+ *    if the coroutine is deleted while the request is held back, the
+ *    request is thrown away and doneProc is called with a NULL future.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_coro_execute (casstcl_sessionClientData *ct, CassStatement *statement, int ownsStatement, Tcl_Obj *tableNameObj, Tcl_WideInt *submittedPtr, casstcl_coroDoneProc *doneProc, ClientData clientData);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_create_nr_command --
+ *
+ *    create a command with both a regular object proc and an NRE proc
+ *    if the Tcl we are running in supports it, otherwise just a regular
+ *    object command
+ *
+ * Results:
+ *    The command token
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Command
+casstcl_create_nr_command (Tcl_Interp *interp, const char *name, Tcl_ObjCmdProc *proc, Tcl_ObjCmdProc *nreProc, ClientData clientData, Tcl_CmdDeleteProc *deleteProc);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_nr_call --
+ *
+ *    call an NRE proc from a regular object command proc, running it
+ *    on the NRE trampoline if this Tcl has one
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_nr_call (Tcl_Interp *interp, Tcl_ObjCmdProc *nreProc, ClientData clientData, int objc, Tcl_Obj *CONST objv[]);
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
@@ -0,0 +1,797 @@
+/*
+ * casstcl_counter - Functions used to implement counter accumulator
+ *   objects, which sum counter increments locally and send them as
+ *   counter batches
+ *
+ * casstcl - Tcl interface to CassDB
+ *
+ * Copyright (C) 2014 FlightAware LLC
+ *
+ * freely redistributable under the Berkeley license
+ */
+
+#include "casstcl.h"
+#include "casstcl_counter.h"
+#include "casstcl_batch.h"
+#include "casstcl_consistency.h"
+#include "casstcl_types.h"
+
+#include <assert.h>
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_counter_forget --
+ *
+ *    throw away the increments a counter accumulator has waiting
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_counter_forget (casstcl_counterClientData *ccd)
+{
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+
+	while ((entry = Tcl_FirstHashEntry (&ccd->counterTable, &search)) != NULL) {
+		casstcl_counterEntry *ce = (casstcl_counterEntry *)Tcl_GetHashValue (entry);
+
+		Tcl_DecrRefCount (ce->tableObj);
+		Tcl_DecrRefCount (ce->columnObj);
+		Tcl_DecrRefCount (ce->keyObj);
+		ckfree ((char *)ce);
+		Tcl_DeleteHashEntry (entry);
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_counter_statement --
+ *
+ *    make an UPDATE statement adding a counter entry's delta to its
+ *    counter and set a pointer to a list of name-value pairs that looks
+ *    like an upsert of the same values in the same order, so the batch
+ *    can work out the statement's partition from it.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_counter_statement (casstcl_counterClientData *ccd, casstcl_counterEntry *ce, CassStatement **statementPtr, Tcl_Obj **pairsObjPtr)
+{
+	casstcl_sessionClientData *ct = ccd->ct;
+	Tcl_Interp *interp = ct->interp;
+	char *tableName = Tcl_GetString (ce->tableObj);
+	char *columnName = Tcl_GetString (ce->columnObj);
+	casstcl_cassTypeInfo typeInfo;
+	CassStatement *statement;
+	Tcl_Obj *pairsObj;
+	Tcl_Obj **keyObjv;
+	Tcl_DString ds;
+	int keyObjc;
+	int i;
+
+	Tcl_ListObjGetElements (NULL, ce->keyObj, &keyObjc, &keyObjv);
+
+	Tcl_DStringInit (&ds);
+	Tcl_DStringAppend (&ds, "UPDATE ", -1);
+	Tcl_DStringAppend (&ds, tableName, -1);
+	Tcl_DStringAppend (&ds, " SET ", -1);
+	Tcl_DStringAppend (&ds, columnName, -1);
+	Tcl_DStringAppend (&ds, " = ", -1);
+	Tcl_DStringAppend (&ds, columnName, -1);
+	Tcl_DStringAppend (&ds, " + ? WHERE ", -1);
+
+	for (i = 0; i < keyObjc; i += 2) {
+		if (i > 0) {
+			Tcl_DStringAppend (&ds, " AND ", -1);
+		}
+		Tcl_DStringAppend (&ds, Tcl_GetString (keyObjv[i]), -1);
+		Tcl_DStringAppend (&ds, " = ?", -1);
+	}
+
+	statement = cass_statement_new (Tcl_DStringValue (&ds), 1 + keyObjc / 2);
+	Tcl_DStringFree (&ds);
+
+	pairsObj = Tcl_NewObj ();
+	Tcl_IncrRefCount (pairsObj);
+	Tcl_ListObjAppendElement (NULL, pairsObj, ce->columnObj);
+	Tcl_ListObjAppendElement (NULL, pairsObj, Tcl_NewWideIntObj (ce->delta));
+	Tcl_ListObjAppendList (NULL, pairsObj, ce->keyObj);
+
+	for (i = 0; i < keyObjc + 2; i += 2) {
+		Tcl_Obj *nameObj = (i == 0) ? ce->columnObj : keyObjv[i - 2];
+		Tcl_Obj *valueObj;
+
+		Tcl_ListObjIndex (NULL, pairsObj, i + 1, &valueObj);
+
+		if (casstcl_typename_obj_to_cass_value_types (interp, tableName, nameObj, &typeInfo) != TCL_OK ||
+			casstcl_bind_tcl_obj (ct, statement, NULL, 0, i / 2, &typeInfo, valueObj) == TCL_ERROR) {
+			Tcl_AppendResult (interp, " while binding column '", Tcl_GetString (nameObj), "' of counter '", columnName, "' in table '", tableName, "'", NULL);
+			cass_statement_free (statement);
+			Tcl_DecrRefCount (pairsObj);
+			return TCL_ERROR;
+		}
+	}
+
+	*statementPtr = statement;
+	*pairsObjPtr = pairsObj;
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_counter_flush --
+ *
+ *    send the summed increments a counter accumulator has waiting,
+ *    asynchronously, as counter batches grouped by partition, and
+ *    start over.  increments that sum to zero aren't sent.
+ *
+ *    if the accumulator has a flush callback and fireForget isn't set,
+ *    a future object is created to invoke it as each batch completes.
+ *    otherwise the batches are fire-and-forget, so failures are counted
+ *    by write_stats and go to the session's fireforget_callback.
+ *
+ *    a counter that can't be bound is dropped, the rest are still sent
+ *    and the first such error is returned.
+ *
+ * Results:
+ *    A standard Tcl result.  On success the interpreter result is the
+ *    number of counter updates sent.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_counter_flush (casstcl_counterClientData *ccd, int fireForget)
+{
+	casstcl_sessionClientData *ct = ccd->ct;
+	Tcl_Interp *interp = ct->interp;
+	casstcl_batchClientData *bcd;
+	Tcl_Obj *errorObj = NULL;
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+	int updates = 0;
+	int tclReturn = TCL_OK;
+
+	if (ccd->timer != NULL) {
+		Tcl_DeleteTimerHandler (ccd->timer);
+		ccd->timer = NULL;
+	}
+
+	if (ccd->counterTable.numEntries == 0) {
+		Tcl_SetObjResult (interp, Tcl_NewIntObj (0));
+		return TCL_OK;
+	}
+
+	bcd = casstcl_batch_new_client_data (ct, CASS_BATCH_TYPE_COUNTER);
+	bcd->byPartition = 1;
+	bcd->maxStatements = CASSTCL_FLUSH_MAX_BATCH_STATEMENTS;
+	bcd->consistency = ccd->consistency;
+	if (ccd->flushCallbackObj != NULL && !fireForget) {
+		bcd->flushCallbackObj = ccd->flushCallbackObj;
+		Tcl_IncrRefCount (bcd->flushCallbackObj);
+	}
+
+	for (entry = Tcl_FirstHashEntry (&ccd->counterTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+		casstcl_counterEntry *ce = (casstcl_counterEntry *)Tcl_GetHashValue (entry);
+		CassStatement *statement;
+		Tcl_Obj *addObjv[2];
+		Tcl_Obj *pairsObj;
+
+		if (ce->delta == 0) {
+			continue;
+		}
+
+		if (casstcl_counter_statement (ccd, ce, &statement, &pairsObj) == TCL_OK) {
+			addObjv[0] = ce->tableObj;
+			addObjv[1] = pairsObj;
+			if (casstcl_batch_add_statement (bcd, 1, 2, addObjv, statement) == TCL_OK) {
+				updates++;
+			} else {
+				tclReturn = TCL_ERROR;
+			}
+			Tcl_DecrRefCount (pairsObj);
+		} else {
+			tclReturn = TCL_ERROR;
+		}
+
+		if (tclReturn == TCL_ERROR && errorObj == NULL) {
+			errorObj = Tcl_GetObjResult (interp);
+			Tcl_IncrRefCount (errorObj);
+		}
+	}
+
+	casstcl_counter_forget (ccd);
+
+	if (casstcl_batch_flush (bcd) == TCL_ERROR && errorObj == NULL) {
+		tclReturn = TCL_ERROR;
+		errorObj = Tcl_GetObjResult (interp);
+		Tcl_IncrRefCount (errorObj);
+	}
+
+	casstcl_batch_free_client_data (bcd);
+
+	ccd->updates += updates;
+	ccd->flushes++;
+
+	if (errorObj != NULL) {
+		Tcl_SetObjResult (interp, errorObj);
+		Tcl_DecrRefCount (errorObj);
+		return TCL_ERROR;
+	}
+
+	Tcl_SetObjResult (interp, Tcl_NewIntObj (updates));
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_counter_timer_proc --
+ *
+ *    called by the Tcl event loop when a counter accumulator's interval
+ *    has passed since its oldest waiting increment.  sends them.
+ *
+ * Results:
+ *    If the flush fails, a Tcl background error is invoked.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_counter_timer_proc (ClientData clientData)
+{
+	casstcl_counterClientData *ccd = (casstcl_counterClientData *)clientData;
+	Tcl_Interp *interp = ccd->ct->interp;
+
+	ccd->timer = NULL;
+
+	if (casstcl_counter_flush (ccd, 0) == TCL_ERROR) {
+		Tcl_BackgroundError (interp);
+	}
+	Tcl_ResetResult (interp);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_counter_incr --
+ *
+ *    add delta to the waiting increment of a counter column of the row
+ *    of a table identified by a list of its primary key column names
+ *    and values.  the table and columns are checked the first time a
+ *    counter is incremented after a flush.
+ *
+ *    the increments are flushed if the accumulator now has max_keys
+ *    counters waiting, otherwise the interval timer is started if it
+ *    isn't already running.
+ *
+ * Results:
+ *    A standard Tcl result.  The interpreter result is the counter's
+ *    waiting increment, or 0 if it was flushed.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_counter_incr (casstcl_counterClientData *ccd, Tcl_Obj *tableObj, Tcl_Obj *keyObj, Tcl_Obj *columnObj, Tcl_WideInt delta)
+{
+	casstcl_sessionClientData *ct = ccd->ct;
+	Tcl_Interp *interp = ct->interp;
+	casstcl_counterEntry *ce;
+	Tcl_HashEntry *entry;
+	Tcl_DString key;
+	Tcl_Obj **keyObjv;
+	int keyObjc;
+	int isNew;
+
+	if (Tcl_ListObjGetElements (interp, keyObj, &keyObjc, &keyObjv) == TCL_ERROR) {
+		Tcl_AppendResult (interp, " while parsing list of key-value pairs", NULL);
+		return TCL_ERROR;
+	}
+
+	if (keyObjc == 0 || (keyObjc & 1)) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "key-value pair list must contain an even number of elements", NULL);
+		return TCL_ERROR;
+	}
+
+	Tcl_DStringInit (&key);
+	Tcl_DStringAppendElement (&key, Tcl_GetString (tableObj));
+	Tcl_DStringAppendElement (&key, Tcl_GetString (columnObj));
+	Tcl_DStringAppendElement (&key, Tcl_GetString (keyObj));
+
+	entry = Tcl_FindHashEntry (&ccd->counterTable, Tcl_DStringValue (&key));
+
+	if (entry == NULL) {
+		char *tableName = Tcl_GetString (tableObj);
+		casstcl_cassTypeInfo typeInfo;
+		Tcl_Obj *checkObj = columnObj;
+		int tclReturn;
+		int i;
+
+		tclReturn = casstcl_typename_obj_to_cass_value_types (interp, tableName, columnObj, &typeInfo);
+		if (tclReturn == TCL_OK && typeInfo.cassValueType != CASS_VALUE_TYPE_COUNTER) {
+			Tcl_ResetResult (interp);
+			Tcl_AppendResult (interp, "column '", Tcl_GetString (columnObj), "' of table '", tableName, "' isn't a counter", NULL);
+			tclReturn = TCL_ERROR;
+		}
+
+		for (i = 0; i < keyObjc && tclReturn == TCL_OK; i += 2) {
+			checkObj = keyObjv[i];
+			tclReturn = casstcl_typename_obj_to_cass_value_types (interp, tableName, checkObj, &typeInfo);
+		}
+
+		if (tclReturn == TCL_CONTINUE) {
+			Tcl_ResetResult (interp);
+			Tcl_AppendResult (interp, "unknown column '", Tcl_GetString (checkObj), "' in counter for table '", tableName, "'", NULL);
+			tclReturn = TCL_ERROR;
+		}
+
+		if (tclReturn == TCL_ERROR) {
+			Tcl_DStringFree (&key);
+			return TCL_ERROR;
+		}
+
+		entry = Tcl_CreateHashEntry (&ccd->counterTable, Tcl_DStringValue (&key), &isNew);
+		ce = (casstcl_counterEntry *)ckalloc (sizeof (casstcl_counterEntry));
+		ce->tableObj = tableObj;
+		ce->columnObj = columnObj;
+		ce->keyObj = keyObj;
+		ce->delta = 0;
+		Tcl_IncrRefCount (ce->tableObj);
+		Tcl_IncrRefCount (ce->columnObj);
+		Tcl_IncrRefCount (ce->keyObj);
+		Tcl_SetHashValue (entry, ce);
+	} else {
+		ce = (casstcl_counterEntry *)Tcl_GetHashValue (entry);
+	}
+
+	Tcl_DStringFree (&key);
+
+	ce->delta += delta;
+	ccd->increments++;
+
+	if (ccd->maxKeys > 0 && ccd->counterTable.numEntries >= ccd->maxKeys) {
+		if (casstcl_counter_flush (ccd, 0) == TCL_ERROR) {
+			return TCL_ERROR;
+		}
+		Tcl_SetObjResult (interp, Tcl_NewIntObj (0));
+		return TCL_OK;
+	}
+
+	if (ccd->timer == NULL && ccd->interval > 0) {
+		ccd->timer = Tcl_CreateTimerHandler (ccd->interval, casstcl_counter_timer_proc, (ClientData)ccd);
+	}
+
+	Tcl_SetObjResult (interp, Tcl_NewWideIntObj (ce->delta));
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_counter_configure --
+ *
+ *    handle ?-interval ms? ?-max_keys n? ?-consistency level?
+ *    ?-flush_callback callback? for a counter accumulator, from either
+ *    the session's counters method or the accumulator's own configure
+ *    method.  an interval or max_keys of 0 turns that threshold off,
+ *    but not both.
+ *    with no arguments, set the interpreter result to a list of the
+ *    settings.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_counter_configure (casstcl_counterClientData *ccd, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Interp *interp = ccd->ct->interp;
+	int interval = ccd->interval;
+	int maxKeys = ccd->maxKeys;
+	CassConsistency consistency = ccd->consistency;
+	Tcl_Obj *flushCallbackObj = ccd->flushCallbackObj;
+	int arg;
+	int subOptIndex;
+
+	static CONST char *subOptions[] = {
+		"-interval",
+		"-max_keys",
+		"-consistency",
+		"-flush_callback",
+		NULL
+	};
+
+	enum subOptions {
+		SUBOPT_INTERVAL,
+		SUBOPT_MAX_KEYS,
+		SUBOPT_CONSISTENCY,
+		SUBOPT_FLUSH_CALLBACK
+	};
+
+	if (objc == 0) {
+		Tcl_Obj *listObj = Tcl_NewObj ();
+
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-interval", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (ccd->interval));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-max_keys", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (ccd->maxKeys));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-consistency", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj (casstcl_cass_consistency_to_string (ccd->consistency), -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-flush_callback", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, (ccd->flushCallbackObj != NULL) ? ccd->flushCallbackObj : Tcl_NewObj ());
+
+		Tcl_SetObjResult (interp, listObj);
+		return TCL_OK;
+	}
+
+	if (objc & 1) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "counter options must be given as option value pairs", NULL);
+		return TCL_ERROR;
+	}
+
+	for (arg = 0; arg < objc; arg += 2) {
+		if (Tcl_GetIndexFromObj (interp, objv[arg], subOptions, "subOption", TCL_EXACT, &subOptIndex) != TCL_OK) {
+			return TCL_ERROR;
+		}
+
+		switch ((enum subOptions) subOptIndex) {
+			case SUBOPT_INTERVAL: {
+				if (Tcl_GetIntFromObj (interp, objv[arg + 1], &interval) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting interval", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_MAX_KEYS: {
+				if (Tcl_GetIntFromObj (interp, objv[arg + 1], &maxKeys) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting max_keys", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_CONSISTENCY: {
+				if (casstcl_obj_to_cass_consistency (ccd->ct, objv[arg + 1], &consistency) == TCL_ERROR) {
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_FLUSH_CALLBACK: {
+				int length;
+
+				Tcl_GetStringFromObj (objv[arg + 1], &length);
+				flushCallbackObj = (length == 0) ? NULL : objv[arg + 1];
+				break;
+			}
+		}
+	}
+
+	if (interval < 0 || maxKeys < 0) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "counter thresholds can't be negative", NULL);
+		return TCL_ERROR;
+	}
+
+	// with neither, nothing but an explicit flush would ever send the
+	// increments, and they'd pile up without bound
+	if (interval == 0 && maxKeys == 0) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "counter -interval and -max_keys can't both be 0", NULL);
+		return TCL_ERROR;
+	}
+
+	ccd->interval = interval;
+	ccd->maxKeys = maxKeys;
+	ccd->consistency = consistency;
+
+	if (flushCallbackObj != ccd->flushCallbackObj) {
+		if (flushCallbackObj != NULL) {
+			Tcl_IncrRefCount (flushCallbackObj);
+		}
+		if (ccd->flushCallbackObj != NULL) {
+			Tcl_DecrRefCount (ccd->flushCallbackObj);
+		}
+		ccd->flushCallbackObj = flushCallbackObj;
+	}
+
+	return TCL_OK;
+}
+
+/*
+ *--------------------------------------------------------------
+ *
+ *   casstcl_counter_command_to_counterClientData -- given a counter
+ *   accumulator command name, find it in the interpreter and return a
+ *   pointer to its client data or NULL
+ *
+ *--------------------------------------------------------------
+ */
+casstcl_counterClientData *
+casstcl_counter_command_to_counterClientData (Tcl_Interp *interp, char *counterCommandName)
+{
+	Tcl_CmdInfo counterCmdInfo;
+
+	if (!Tcl_GetCommandInfo (interp, counterCommandName, &counterCmdInfo)) {
+		return NULL;
+	}
+
+	casstcl_counterClientData *ccd = (casstcl_counterClientData *)counterCmdInfo.objClientData;
+	if (ccd == NULL || counterCmdInfo.objProc != casstcl_counterObjectObjCmd || ccd->cass_counter_magic != CASS_COUNTER_MAGIC) {
+		return NULL;
+	}
+
+	return ccd;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_createCounterObjectCommand --
+ *
+ *    given a casstcl_sessionClientData pointer and an object name (or
+ *    "#auto"), create a counter accumulator object command
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_createCounterObjectCommand (casstcl_sessionClientData *ct, char *commandName)
+{
+	casstcl_counterClientData *ccd = (casstcl_counterClientData *)ckalloc (sizeof (casstcl_counterClientData));
+	Tcl_Interp *interp = ct->interp;
+	Tcl_HashEntry *entry;
+	int isNew;
+
+	ccd->cass_counter_magic = CASS_COUNTER_MAGIC;
+	ccd->ct = ct;
+	Tcl_InitHashTable (&ccd->counterTable, TCL_STRING_KEYS);
+	ccd->interval = CASSTCL_DEFAULT_COUNTER_INTERVAL;
+	ccd->maxKeys = CASSTCL_DEFAULT_COUNTER_MAX_KEYS;
+	ccd->consistency = CASS_CONSISTENCY_ONE;
+	ccd->flushCallbackObj = NULL;
+	ccd->timer = NULL;
+	ccd->increments = 0;
+	ccd->updates = 0;
+	ccd->flushes = 0;
+
+#define COUNTER_STRING_FORMAT "counters%lu"
+	// if commandName is #auto, generate a unique name for the object
+	int autoGeneratedName = 0;
+	if (strcmp (commandName, "#auto") == 0) {
+		static unsigned long nextAutoCounter = 0;
+		int baseNameLength = snprintf (NULL, 0, COUNTER_STRING_FORMAT, nextAutoCounter) + 1;
+		commandName = ckalloc (baseNameLength);
+		snprintf (commandName, baseNameLength, COUNTER_STRING_FORMAT, nextAutoCounter++);
+		autoGeneratedName = 1;
+	}
+
+	// create a Tcl command to interface to the counter accumulator
+	ccd->cmdToken = Tcl_CreateObjCommand (interp, commandName, casstcl_counterObjectObjCmd, ccd, casstcl_counterObjectDelete);
+	// set the full name to the command in the interpreter result
+	Tcl_GetCommandFullName(interp, ccd->cmdToken, Tcl_GetObjResult (interp));
+	if (autoGeneratedName == 1) {
+		ckfree(commandName);
+	}
+
+	// the session flushes and deletes its accumulators when it goes
+	entry = Tcl_CreateHashEntry (&ct->counterObjectTable, (char *)ccd, &isNew);
+	Tcl_SetHashValue (entry, ccd);
+
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_counterObjectObjCmd --
+ *
+ *    dispatches the subcommands of a casstcl counter accumulator command
+ *
+ * Results:
+ *    stuff
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_counterObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[])
+{
+	int optIndex;
+	casstcl_counterClientData *ccd = (casstcl_counterClientData *)cData;
+
+	static CONST char *options[] = {
+		"incr",
+		"pending",
+		"flush",
+		"configure",
+		"stats",
+		"delete",
+		NULL
+	};
+
+	enum options {
+		OPT_INCR,
+		OPT_PENDING,
+		OPT_FLUSH,
+		OPT_CONFIGURE,
+		OPT_STATS,
+		OPT_DELETE
+	};
+
+	/* basic validation of command line arguments */
+	if (objc < 2) {
+		Tcl_WrongNumArgs (interp, 1, objv, "subcommand ?args?");
+		return TCL_ERROR;
+	}
+
+	if (Tcl_GetIndexFromObj (interp, objv[1], options, "option", TCL_EXACT, &optIndex) != TCL_OK) {
+		return TCL_ERROR;
+	}
+
+	switch ((enum options) optIndex) {
+		// incr table keyValuePairList column ?delta?
+		case OPT_INCR: {
+			Tcl_WideInt delta = 1;
+
+			if ((objc < 5) || (objc > 6)) {
+				Tcl_WrongNumArgs (interp, 2, objv, "table keyValuePairList column ?delta?");
+				return TCL_ERROR;
+			}
+
+			if (objc == 6 && Tcl_GetWideIntFromObj (interp, objv[5], &delta) == TCL_ERROR) {
+				Tcl_AppendResult (interp, " while converting delta", NULL);
+				return TCL_ERROR;
+			}
+
+			return casstcl_counter_incr (ccd, objv[2], objv[3], objv[4], delta);
+		}
+
+		// pending - how many counters have increments waiting
+		case OPT_PENDING: {
+			if (objc != 2) {
+				Tcl_WrongNumArgs (interp, 2, objv, "");
+				return TCL_ERROR;
+			}
+
+			Tcl_SetObjResult (interp, Tcl_NewIntObj (ccd->counterTable.numEntries));
+			break;
+		}
+
+		case OPT_FLUSH: {
+			if (objc != 2) {
+				Tcl_WrongNumArgs (interp, 2, objv, "");
+				return TCL_ERROR;
+			}
+
+			return casstcl_counter_flush (ccd, 0);
+		}
+
+		case OPT_CONFIGURE: {
+			return casstcl_counter_configure (ccd, objc - 2, &objv[2]);
+		}
+
+		// stats - the number of increments taken, counter updates sent
+		// and flushes done
+		case OPT_STATS: {
+			Tcl_Obj *listObj = Tcl_NewObj ();
+
+			if (objc != 2) {
+				Tcl_WrongNumArgs (interp, 2, objv, "");
+				return TCL_ERROR;
+			}
+
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("increments", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (ccd->increments));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("updates", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (ccd->updates));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("flushes", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (ccd->flushes));
+			Tcl_SetObjResult (interp, listObj);
+			break;
+		}
+
+		// delete - send whatever is waiting and delete the accumulator
+		case OPT_DELETE: {
+			Tcl_Obj *resultObj;
+			int tclReturn;
+
+			if (objc != 2) {
+				Tcl_WrongNumArgs (interp, 2, objv, "");
+				return TCL_ERROR;
+			}
+
+			tclReturn = casstcl_counter_flush (ccd, 0);
+			resultObj = Tcl_GetObjResult (interp);
+			Tcl_IncrRefCount (resultObj);
+
+			Tcl_DeleteCommandFromToken (interp, ccd->cmdToken);
+
+			if (tclReturn == TCL_ERROR) {
+				Tcl_SetObjResult (interp, resultObj);
+			} else {
+				Tcl_ResetResult (interp);
+			}
+			Tcl_DecrRefCount (resultObj);
+			return tclReturn;
+		}
+	}
+
+	return TCL_OK;
+}
+
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_counterObjectDelete -- command deletion callback routine.
+ *
+ * Results:
+ *      ...sends any increments still waiting, fire-and-forget.
+ *      ...destroys the counter accumulator object.
+ *      ...frees memory.
+ *
+ * Side effects:
+ *      None.
+ *
+ *--------------------------------------------------------------
+ */
+void
+casstcl_counterObjectDelete (ClientData clientData)
+{
+	casstcl_counterClientData *ccd = (casstcl_counterClientData *)clientData;
+	casstcl_sessionClientData *ct = ccd->ct;
+	Tcl_HashEntry *entry;
+
+	assert (ccd->cass_counter_magic == CASS_COUNTER_MAGIC);
+
+	// nothing is lost when an accumulator goes away
+	casstcl_counter_flush (ccd, 1);
+	Tcl_ResetResult (ct->interp);
+
+	Tcl_DeleteHashTable (&ccd->counterTable);
+	if (ccd->flushCallbackObj != NULL) {
+		Tcl_DecrRefCount (ccd->flushCallbackObj);
+	}
+
+	entry = Tcl_FindHashEntry (&ct->counterObjectTable, (char *)ccd);
+	if (entry != NULL) {
+		Tcl_DeleteHashEntry (entry);
+	}
+
+	ckfree ((char *)ccd);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_counter_delete_all --
+ *
+ *    delete all of a session's counter accumulators, sending whatever
+ *    increments they have waiting.  used when the session is deleted.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_counter_delete_all (casstcl_sessionClientData *ct)
+{
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+
+	while ((entry = Tcl_FirstHashEntry (&ct->counterObjectTable, &search)) != NULL) {
+		casstcl_counterClientData *ccd = (casstcl_counterClientData *)Tcl_GetHashValue (entry);
+
+		Tcl_DeleteHashEntry (entry);
+		Tcl_DeleteCommandFromToken (ct->interp, ccd->cmdToken);
+	}
+}
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
@@ -0,0 +1,147 @@
+/*
+ *
+ * Include file for casstcl_counter
+ *
+ * Copyright (C) 2015 by FlightAware, All Rights Reserved
+ *
+ * Freely redistributable under the Berkeley copyright, see license.terms
+ * for details.
+ */
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_counter_flush --
+ *
+ *    send the summed increments a counter accumulator has waiting,
+ *    asynchronously, as counter batches grouped by partition, and
+ *    start over.  increments that sum to zero aren't sent.
+ *
+ *    if the accumulator has a flush callback and fireForget isn't set,
+ *    a future object is created to invoke it as each batch completes.
+ *    otherwise the batches are fire-and-forget, so failures are counted
+ *    by write_stats and go to the session's fireforget_callback.
+ *
+ *    a counter that can't be bound is dropped, the rest are still sent
+ *    and the first such error is returned.
+ *
+ * Results:
+ *    A standard Tcl result.  On success the interpreter result is the
+ *    number of counter updates sent.
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_counter_flush (casstcl_counterClientData *ccd, int fireForget);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_counter_incr --
+ *
+ *    add delta to the waiting increment of a counter column of the row
+ *    of a table identified by a list of its primary key column names
+ *    and values.  the table and columns are checked the first time a
+ *    counter is incremented after a flush.
+ *
+ *    the increments are flushed if the accumulator now has max_keys
+ *    counters waiting, otherwise the interval timer is started if it
+ *    isn't already running.
+ *
+ * Results:
+ *    A standard Tcl result.  The interpreter result is the counter's
+ *    waiting increment, or 0 if it was flushed.
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_counter_incr (casstcl_counterClientData *ccd, Tcl_Obj *tableObj, Tcl_Obj *keyObj, Tcl_Obj *columnObj, Tcl_WideInt delta);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_counter_configure --
+ *
+ *    handle ?-interval ms? ?-max_keys n? ?-consistency level?
+ *    ?-flush_callback callback? for a counter accumulator, from either
+ *    the session's counters method or the accumulator's own configure
+ *    method.  an interval or max_keys of 0 turns that threshold off,
+ *    but not both.
+ *    with no arguments, set the interpreter result to a list of the
+ *    settings.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_counter_configure (casstcl_counterClientData *ccd, int objc, Tcl_Obj *CONST objv[]);
+
+/*
+ *--------------------------------------------------------------
+ *
+ *   casstcl_counter_command_to_counterClientData -- given a counter
+ *   accumulator command name, find it in the interpreter and return a
+ *   pointer to its client data or NULL
+ *
+ *--------------------------------------------------------------
+ */
+casstcl_counterClientData *casstcl_counter_command_to_counterClientData (Tcl_Interp *interp, char *counterCommandName);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_createCounterObjectCommand --
+ *
+ *    given a casstcl_sessionClientData pointer and an object name (or
+ *    "#auto"), create a counter accumulator object command
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_createCounterObjectCommand (casstcl_sessionClientData *ct, char *commandName);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_counterObjectObjCmd --
+ *
+ *    dispatches the subcommands of a casstcl counter accumulator command
+ *
+ * Results:
+ *    stuff
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_counterObjectObjCmd (ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_counterObjectDelete -- command deletion callback routine.
+ *
+ * Results:
+ *      ...sends any increments still waiting, fire-and-forget.
+ *      ...destroys the counter accumulator object.
+ *      ...frees memory.
+ *
+ * Side effects:
+ *      None.
+ *
+ *--------------------------------------------------------------
+ */
+void casstcl_counterObjectDelete (ClientData clientData);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_counter_delete_all --
+ *
+ *    delete all of a session's counter accumulators, sending whatever
+ *    increments they have waiting.  used when the session is deleted.
+ *
+ *----------------------------------------------------------------------
+ */
+void casstcl_counter_delete_all (casstcl_sessionClientData *ct);
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
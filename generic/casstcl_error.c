@@ -236,4 +236,68 @@ int casstcl_future_error_to_tcl (casstcl_sessionClientData *ct, CassError cassEr
 	return TCL_ERROR;
 }
 
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_cass_error_is_transient -- given a CassError code, return
+ *   nonzero if it's the kind of failure that sending the same request
+ *   again a little later can be expected to fix: timeouts, nodes that
+ *   are down, overloaded or starting up, and full request queues
+ *
+ * Results:
+ *      1 if the error is transient, otherwise 0
+ *
+ * Side effects:
+ *      None.
+ *
+ *--------------------------------------------------------------
+ */
+int casstcl_cass_error_is_transient (CassError cassError) {
+	switch (cassError) {
+		case CASS_ERROR_LIB_NO_STREAMS:
+		case CASS_ERROR_LIB_REQUEST_QUEUE_FULL:
+		case CASS_ERROR_LIB_NO_AVAILABLE_IO_THREAD:
+		case CASS_ERROR_LIB_WRITE_ERROR:
+		case CASS_ERROR_LIB_NO_HOSTS_AVAILABLE:
+		case CASS_ERROR_LIB_REQUEST_TIMED_OUT:
+		case CASS_ERROR_LIB_UNABLE_TO_CONNECT:
+		case CASS_ERROR_SERVER_UNAVAILABLE:
+		case CASS_ERROR_SERVER_OVERLOADED:
+		case CASS_ERROR_SERVER_IS_BOOTSTRAPPING:
+		case CASS_ERROR_SERVER_WRITE_TIMEOUT:
+		case CASS_ERROR_SERVER_READ_TIMEOUT:
+			return 1;
+
+		default:
+			return 0;
+	}
+}
+
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_cass_error_is_timeout -- given a CassError code, return
+ *   nonzero if it's a request that timed out, either waiting on the
+ *   driver or on the replicas
+ *
+ * Results:
+ *      1 if the error is a timeout, otherwise 0
+ *
+ * Side effects:
+ *      None.
+ *
+ *--------------------------------------------------------------
+ */
+int casstcl_cass_error_is_timeout (CassError cassError) {
+	switch (cassError) {
+		case CASS_ERROR_LIB_REQUEST_TIMED_OUT:
+		case CASS_ERROR_SERVER_WRITE_TIMEOUT:
+		case CASS_ERROR_SERVER_READ_TIMEOUT:
+			return 1;
+
+		default:
+			return 0;
+	}
+}
+
 /* vim: set ts=4 sw=4 sts=4 noet : */
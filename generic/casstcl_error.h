@@ -63,4 +63,39 @@ int casstcl_cass_error_to_tcl (casstcl_sessionClientData *ct, CassError cassErro
  */
 int casstcl_future_error_to_tcl (casstcl_sessionClientData *ct, CassError cassError, CassFuture *future);
 
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_cass_error_is_transient -- given a CassError code, return
+ *   nonzero if it's the kind of failure that sending the same request
+ *   again a little later can be expected to fix: timeouts, nodes that
+ *   are down, overloaded or starting up, and full request queues
+ *
+ * Results:
+ *      1 if the error is transient, otherwise 0
+ *
+ * Side effects:
+ *      None.
+ *
+ *--------------------------------------------------------------
+ */
+int casstcl_cass_error_is_transient (CassError cassError);
+
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_cass_error_is_timeout -- given a CassError code, return
+ *   nonzero if it's a request that timed out, either waiting on the
+ *   driver or on the replicas
+ *
+ * Results:
+ *      1 if the error is a timeout, otherwise 0
+ *
+ * Side effects:
+ *      None.
+ *
+ *--------------------------------------------------------------
+ */
+int casstcl_cass_error_is_timeout (CassError cassError);
+
 /* vim: set ts=4 sw=4 sts=4 noet : */
@@ -12,6 +12,7 @@
 #include "casstcl_log.h"
 #include "casstcl_event.h"
 #include "casstcl_cassandra.h"
+#include "casstcl_retry.h"
 /*
  *----------------------------------------------------------------------
  *
@@ -100,6 +101,11 @@ void casstcl_logging_callback (const CassLogMessage *message, void *data) {
 	casstcl_loggingEvent *evPtr;
 	
 	Tcl_Interp *interp = data;
+
+	// the logging retry policy's messages are counted here, on the
+	// cpp-driver's thread, as well as being passed along
+	casstcl_retry_count_log_message (message);
+
 	evPtr = (casstcl_loggingEvent *)ckalloc (sizeof(casstcl_loggingEvent));
 	evPtr->event.proc = casstcl_logging_eventProc;
 	evPtr->interp = interp;
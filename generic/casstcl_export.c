@@ -0,0 +1,691 @@
+/*
+ * casstcl_export - Functions used to render a session's metrics for
+ *   Prometheus or statsd and export them periodically
+ *
+ * casstcl - Tcl interface to CassDB
+ *
+ * Copyright (C) 2014 FlightAware LLC
+ *
+ * freely redistributable under the Berkeley license
+ */
+
+#include "casstcl.h"
+#include "casstcl_export.h"
+#include "casstcl_cassandra.h"
+#include "casstcl_latency.h"
+
+#include <ctype.h>
+
+static CONST char *casstcl_exportFormatNames[] = {
+	"prometheus",
+	"statsd",
+	NULL
+};
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_export_append_clean --
+ *
+ *    append a string to a metric name, replacing the characters the
+ *    format doesn't allow in names with underscores.  statsd names may
+ *    have dots in them, which separate their parts.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_export_append_clean (Tcl_Obj *textObj, int format, CONST char *string)
+{
+	CONST char *start = string;
+	CONST char *p;
+
+	for (p = string; *p != '\0'; p++) {
+		unsigned char c = (unsigned char)*p;
+
+		if (isalnum (c) || c == '_' || (format == CASSTCL_EXPORT_STATSD && (c == '.' || c == '-'))) {
+			continue;
+		}
+
+		Tcl_AppendToObj (textObj, start, p - start);
+		Tcl_AppendToObj (textObj, "_", 1);
+		start = p + 1;
+	}
+
+	Tcl_AppendToObj (textObj, start, p - start);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_export_append_name --
+ *
+ *    append the full name of a metric, its prefix, if any, and name
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_export_append_name (Tcl_Obj *textObj, int format, CONST char *prefix, CONST char *name)
+{
+	if (*prefix != '\0') {
+		casstcl_export_append_clean (textObj, format, prefix);
+		Tcl_AppendToObj (textObj, (format == CASSTCL_EXPORT_STATSD) ? "." : "_", 1);
+	}
+	casstcl_export_append_clean (textObj, format, name);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_export_append_label --
+ *
+ *    append a Prometheus label value, quoted, with backslashes, double
+ *    quotes and newlines escaped
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_export_append_label (Tcl_Obj *textObj, CONST char *string)
+{
+	CONST char *start = string;
+	CONST char *p;
+
+	Tcl_AppendToObj (textObj, "\"", 1);
+	for (p = string; *p != '\0'; p++) {
+		if (*p != '\\' && *p != '"' && *p != '\n') {
+			continue;
+		}
+
+		Tcl_AppendToObj (textObj, start, p - start);
+		Tcl_AppendToObj (textObj, (*p == '\n') ? "\\n" : (*p == '"') ? "\\\"" : "\\\\", 2);
+		start = p + 1;
+	}
+	Tcl_AppendToObj (textObj, start, p - start);
+	Tcl_AppendToObj (textObj, "\"", 1);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_export_sample --
+ *
+ *    append one metric without labels.  for Prometheus its type,
+ *    "counter" or "gauge", is given first.  statsd has no counters of
+ *    running totals, so everything is sent to it as a gauge.  valueObj
+ *    is freed if nothing else has a reference to it.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_export_sample (Tcl_Obj *textObj, int format, CONST char *prefix, CONST char *name, CONST char *type, Tcl_Obj *valueObj)
+{
+	Tcl_IncrRefCount (valueObj);
+
+	if (format == CASSTCL_EXPORT_PROMETHEUS) {
+		Tcl_AppendToObj (textObj, "# TYPE ", -1);
+		casstcl_export_append_name (textObj, format, prefix, name);
+		Tcl_AppendStringsToObj (textObj, " ", type, "\n", NULL);
+		casstcl_export_append_name (textObj, format, prefix, name);
+		Tcl_AppendStringsToObj (textObj, " ", Tcl_GetString (valueObj), "\n", NULL);
+	} else {
+		casstcl_export_append_name (textObj, format, prefix, name);
+		Tcl_AppendStringsToObj (textObj, ":", Tcl_GetString (valueObj), "|g\n", NULL);
+	}
+
+	Tcl_DecrRefCount (valueObj);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_export_count --
+ *
+ *    append one of casstcl's own counters, or with counter 0, gauges
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_export_count (Tcl_Obj *textObj, int format, CONST char *prefix, CONST char *name, Tcl_WideInt value, int counter)
+{
+	casstcl_export_sample (textObj, format, prefix, name, counter ? "counter" : "gauge", Tcl_NewWideIntObj (value));
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_export_latency --
+ *
+ *    append the session's latency histograms.  for Prometheus they're
+ *    one summary, with the histogram's key as a label.  for statsd each
+ *    histogram's statistics, as the latency method returns them, are
+ *    gauges named after the key.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_export_latency (casstcl_sessionClientData *ct, Tcl_Obj *textObj, int format, CONST char *prefix)
+{
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+	int i;
+
+	static CONST char *quantiles[] = {"0.5", "0.75", "0.95", "0.98", "0.99", "0.999"};
+	static double percentiles[] = {50.0, 75.0, 95.0, 98.0, 99.0, 99.9};
+	int nPercentiles = (int)(sizeof (percentiles) / sizeof (percentiles[0]));
+
+	if (format == CASSTCL_EXPORT_PROMETHEUS && ct->latencyTable.numEntries > 0) {
+		Tcl_AppendToObj (textObj, "# TYPE ", -1);
+		casstcl_export_append_name (textObj, format, prefix, "latency_microseconds");
+		Tcl_AppendToObj (textObj, " summary\n", -1);
+	}
+
+	for (entry = Tcl_FirstHashEntry (&ct->latencyTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+		casstcl_histogram *histogram = (casstcl_histogram *)Tcl_GetHashValue (entry);
+		CONST char *key = Tcl_GetHashKey (&ct->latencyTable, entry);
+		Tcl_Obj *valueObj;
+
+		if (format == CASSTCL_EXPORT_STATSD) {
+			Tcl_Obj *listObj = casstcl_histogram_to_list (histogram);
+			Tcl_Obj **listObjv;
+			int listObjc;
+
+			Tcl_IncrRefCount (listObj);
+			Tcl_ListObjGetElements (NULL, listObj, &listObjc, &listObjv);
+			for (i = 0; i + 1 < listObjc; i += 2) {
+				casstcl_export_append_name (textObj, format, prefix, "latency.");
+				casstcl_export_append_clean (textObj, CASSTCL_EXPORT_PROMETHEUS, key);
+				Tcl_AppendStringsToObj (textObj, ".", Tcl_GetString (listObjv[i]), ":", Tcl_GetString (listObjv[i + 1]), "|g\n", NULL);
+			}
+			Tcl_DecrRefCount (listObj);
+			continue;
+		}
+
+		for (i = 0; i < nPercentiles; i++) {
+			valueObj = Tcl_NewWideIntObj (casstcl_histogram_percentile (histogram, percentiles[i]));
+			Tcl_IncrRefCount (valueObj);
+			casstcl_export_append_name (textObj, format, prefix, "latency_microseconds");
+			Tcl_AppendToObj (textObj, "{key=", -1);
+			casstcl_export_append_label (textObj, key);
+			Tcl_AppendStringsToObj (textObj, ",quantile=\"", quantiles[i], "\"} ", Tcl_GetString (valueObj), "\n", NULL);
+			Tcl_DecrRefCount (valueObj);
+		}
+
+		valueObj = Tcl_NewDoubleObj (histogram->sum);
+		Tcl_IncrRefCount (valueObj);
+		casstcl_export_append_name (textObj, format, prefix, "latency_microseconds_sum");
+		Tcl_AppendToObj (textObj, "{key=", -1);
+		casstcl_export_append_label (textObj, key);
+		Tcl_AppendStringsToObj (textObj, "} ", Tcl_GetString (valueObj), "\n", NULL);
+		Tcl_DecrRefCount (valueObj);
+
+		valueObj = Tcl_NewWideIntObj (histogram->count);
+		Tcl_IncrRefCount (valueObj);
+		casstcl_export_append_name (textObj, format, prefix, "latency_microseconds_count");
+		Tcl_AppendToObj (textObj, "{key=", -1);
+		casstcl_export_append_label (textObj, key);
+		Tcl_AppendStringsToObj (textObj, "} ", Tcl_GetString (valueObj), "\n", NULL);
+		Tcl_DecrRefCount (valueObj);
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_export_render --
+ *
+ *    render a session's metrics in a format: the cpp-driver's metrics,
+ *    as the metrics method returns them, casstcl's own counters of
+ *    futures, callbacks, conversion errors, fire-and-forget requests,
+ *    rate limiting, circuit breakers, caches, write queues and the slow
+ *    query log, and the latency histograms.  each name starts with
+ *    prefix, unless it's empty.
+ *
+ * Results:
+ *    A new object holding the text, a line per metric
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Obj *
+casstcl_export_render (casstcl_sessionClientData *ct, int format, CONST char *prefix)
+{
+	Tcl_Obj *textObj = Tcl_NewObj ();
+	Tcl_Obj *metricsObj;
+	Tcl_Obj **metricsObjv;
+	int metricsObjc;
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+	Tcl_WideInt issued, succeeded, failed;
+	Tcl_WideInt trips, rejected;
+	Tcl_WideInt throttled;
+	Tcl_WideInt cacheHits = 0, cacheMisses = 0, cacheEvictions = 0;
+	Tcl_WideInt queueWritten = 0, queueRetried = 0, queueFailed = 0;
+	int i;
+
+	// the cpp-driver's own, plus the retry counts
+	metricsObj = casstcl_metrics_list (ct->session);
+	Tcl_IncrRefCount (metricsObj);
+	Tcl_ListObjGetElements (NULL, metricsObj, &metricsObjc, &metricsObjv);
+	for (i = 0; i + 1 < metricsObjc; i += 2) {
+		CONST char *name = Tcl_GetString (metricsObjv[i]);
+		int counter = (strncmp (name, "errors.", 7) == 0 || strncmp (name, "retries.", 8) == 0 || strcmp (name, "speculative.count") == 0);
+
+		casstcl_export_sample (textObj, format, prefix, name, counter ? "counter" : "gauge", metricsObjv[i + 1]);
+	}
+	Tcl_DecrRefCount (metricsObj);
+
+	// fire-and-forget requests and breakers are counted from the
+	// cpp-driver's threads
+	Tcl_MutexLock (&ct->writeStats.mutex);
+	issued = ct->writeStats.issued;
+	succeeded = ct->writeStats.succeeded;
+	failed = ct->writeStats.failed;
+	Tcl_MutexUnlock (&ct->writeStats.mutex);
+
+	Tcl_MutexLock (&ct->breakerMutex);
+	trips = ct->breaker.trips;
+	rejected = ct->breaker.rejected;
+	for (entry = Tcl_FirstHashEntry (&ct->breakerTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+		casstcl_breaker *breaker = (casstcl_breaker *)Tcl_GetHashValue (entry);
+
+		trips += breaker->trips;
+		rejected += breaker->rejected;
+	}
+	Tcl_MutexUnlock (&ct->breakerMutex);
+
+	throttled = ct->rateLimit.throttled;
+	for (entry = Tcl_FirstHashEntry (&ct->rateLimitTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+		throttled += ((casstcl_rateLimit *)Tcl_GetHashValue (entry))->throttled;
+	}
+
+	for (entry = Tcl_FirstHashEntry (&ct->cacheObjectTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+		casstcl_cacheClientData *cache = (casstcl_cacheClientData *)Tcl_GetHashValue (entry);
+
+		cacheHits += cache->hits;
+		cacheMisses += cache->misses;
+		cacheEvictions += cache->evictions;
+	}
+
+	for (entry = Tcl_FirstHashEntry (&ct->writeQueueObjectTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+		casstcl_writeQueueClientData *queue = (casstcl_writeQueueClientData *)Tcl_GetHashValue (entry);
+
+		queueWritten += queue->written;
+		queueRetried += queue->retried;
+		queueFailed += queue->failed;
+	}
+
+	casstcl_export_count (textObj, format, prefix, "futures", ct->futureTable.numEntries, 0);
+	casstcl_export_count (textObj, format, prefix, "futures_created", ct->futuresCreated, 1);
+	casstcl_export_count (textObj, format, prefix, "futures_reclaimed", ct->futuresReclaimed, 1);
+	casstcl_export_count (textObj, format, prefix, "callback_events", ct->callbackEvents, 1);
+	casstcl_export_count (textObj, format, prefix, "conversion_errors", ct->conversionErrors, 1);
+	casstcl_export_count (textObj, format, prefix, "fireforget_issued", issued, 1);
+	casstcl_export_count (textObj, format, prefix, "fireforget_succeeded", succeeded, 1);
+	casstcl_export_count (textObj, format, prefix, "fireforget_failed", failed, 1);
+	casstcl_export_count (textObj, format, prefix, "rate_limit_throttled", throttled, 1);
+	casstcl_export_count (textObj, format, prefix, "breaker_trips", trips, 1);
+	casstcl_export_count (textObj, format, prefix, "breaker_rejected", rejected, 1);
+	casstcl_export_count (textObj, format, prefix, "cache_hits", cacheHits, 1);
+	casstcl_export_count (textObj, format, prefix, "cache_misses", cacheMisses, 1);
+	casstcl_export_count (textObj, format, prefix, "cache_evictions", cacheEvictions, 1);
+	casstcl_export_count (textObj, format, prefix, "write_queue_written", queueWritten, 1);
+	casstcl_export_count (textObj, format, prefix, "write_queue_retried", queueRetried, 1);
+	casstcl_export_count (textObj, format, prefix, "write_queue_failed", queueFailed, 1);
+	casstcl_export_count (textObj, format, prefix, "slowlog_logged", ct->slowlog.logged, 1);
+	casstcl_export_count (textObj, format, prefix, "slowlog_dropped", ct->slowlog.dropped, 1);
+
+	casstcl_export_latency (ct, textObj, format, prefix);
+
+	return textObj;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_export_prefix --
+ *
+ *    return the prefix of the names of a session's exported metrics
+ *
+ *----------------------------------------------------------------------
+ */
+static CONST char *
+casstcl_export_prefix (casstcl_metricsExport *ex)
+{
+	return (ex->prefixObj != NULL) ? Tcl_GetString (ex->prefixObj) : "casstcl";
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_export_write --
+ *
+ *    render a session's metrics and pass them to the -callback if there
+ *    is one, else write them to the -channel
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_export_write (casstcl_sessionClientData *ct)
+{
+	Tcl_Interp *interp = ct->interp;
+	casstcl_metricsExport *ex = &ct->metricsExport;
+	Tcl_Obj *textObj = casstcl_export_render (ct, ex->format, casstcl_export_prefix (ex));
+	int tclReturn = TCL_OK;
+
+	Tcl_IncrRefCount (textObj);
+	ex->exports++;
+
+	if (ex->callbackObj != NULL) {
+		Tcl_Obj *evalObj = Tcl_DuplicateObj (ex->callbackObj);
+
+		Tcl_IncrRefCount (evalObj);
+		tclReturn = Tcl_ListObjAppendElement (interp, evalObj, textObj);
+		if (tclReturn == TCL_OK) {
+			tclReturn = Tcl_EvalObjEx (interp, evalObj, TCL_EVAL_GLOBAL);
+		}
+		Tcl_DecrRefCount (evalObj);
+	} else if (ex->channelNameObj != NULL) {
+		CONST char *channelName = Tcl_GetString (ex->channelNameObj);
+		Tcl_Channel channel;
+		int mode;
+
+		// looked up each time, it may have been closed
+		if ((channel = Tcl_GetChannel (interp, channelName, &mode)) == NULL) {
+			tclReturn = TCL_ERROR;
+		} else if (Tcl_WriteObj (channel, textObj) < 0 || Tcl_Flush (channel) != TCL_OK) {
+			Tcl_ResetResult (interp);
+			Tcl_AppendResult (interp, "error writing metrics to \"", channelName, "\": ", Tcl_PosixError (interp), NULL);
+			tclReturn = TCL_ERROR;
+		}
+	}
+
+	Tcl_DecrRefCount (textObj);
+	return tclReturn;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_export_timer_proc --
+ *
+ *    timer handler that exports a session's metrics and, if the
+ *    exporter is still on, schedules the next export
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_export_timer_proc (ClientData clientData)
+{
+	casstcl_sessionClientData *ct = (casstcl_sessionClientData *)clientData;
+	casstcl_metricsExport *ex = &ct->metricsExport;
+
+	ex->timer = NULL;
+
+	// a callback may delete the session or change the exporter
+	Tcl_Preserve ((ClientData)ct);
+
+	if (casstcl_export_write (ct) == TCL_ERROR) {
+		Tcl_BackgroundError (ct->interp);
+	}
+	Tcl_ResetResult (ct->interp);
+
+	if (ct->session != NULL && ex->intervalMS > 0 && ex->timer == NULL) {
+		ex->timer = Tcl_CreateTimerHandler (ex->intervalMS, casstcl_export_timer_proc, (ClientData)ct);
+	}
+
+	Tcl_Release ((ClientData)ct);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_export_metrics --
+ *
+ *    implements the export_metrics method of a session,
+ *
+ *      export_metrics ?-interval seconds? ?-format prometheus|statsd?
+ *          ?-prefix name? ?-channel chan? ?-callback proc?
+ *      export_metrics -render
+ *
+ *    with no arguments, return the settings and how many times the
+ *    metrics have been exported.  an interval of 0 turns the exporter
+ *    off; otherwise it needs a channel or a callback, and giving one
+ *    replaces the other.  -render returns the metrics in the current
+ *    format right away.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_export_metrics (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Interp *interp = ct->interp;
+	casstcl_metricsExport *ex = &ct->metricsExport;
+	int intervalMS = ex->intervalMS;
+	int format = ex->format;
+	Tcl_Obj *prefixObj = ex->prefixObj;
+	Tcl_Obj *channelNameObj = ex->channelNameObj;
+	Tcl_Obj *callbackObj = ex->callbackObj;
+	int arg;
+	int subOptIndex;
+
+	static CONST char *subOptions[] = {
+		"-interval",
+		"-format",
+		"-prefix",
+		"-channel",
+		"-callback",
+		NULL
+	};
+
+	enum subOptions {
+		SUBOPT_INTERVAL,
+		SUBOPT_FORMAT,
+		SUBOPT_PREFIX,
+		SUBOPT_CHANNEL,
+		SUBOPT_CALLBACK
+	};
+
+	if (objc == 2) {
+		Tcl_Obj *listObj = Tcl_NewObj ();
+
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-interval", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewDoubleObj (ex->intervalMS / 1000.0));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-format", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj (casstcl_exportFormatNames[ex->format], -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-prefix", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj (casstcl_export_prefix (ex), -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-channel", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, (ex->channelNameObj != NULL) ? ex->channelNameObj : Tcl_NewObj ());
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-callback", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, (ex->callbackObj != NULL) ? ex->callbackObj : Tcl_NewObj ());
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("exports", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (ex->exports));
+
+		Tcl_SetObjResult (interp, listObj);
+		return TCL_OK;
+	}
+
+	if (objc == 3 && strcmp (Tcl_GetString (objv[2]), "-render") == 0) {
+		Tcl_SetObjResult (interp, casstcl_export_render (ct, ex->format, casstcl_export_prefix (ex)));
+		return TCL_OK;
+	}
+
+	if (objc & 1) {
+		Tcl_WrongNumArgs (interp, 2, objv, "?-interval seconds? ?-format prometheus|statsd? ?-prefix name? ?-channel chan? ?-callback proc? OR -render");
+		return TCL_ERROR;
+	}
+
+	for (arg = 2; arg < objc; arg += 2) {
+		if (Tcl_GetIndexFromObj (interp, objv[arg], subOptions, "subOption", TCL_EXACT, &subOptIndex) != TCL_OK) {
+			return TCL_ERROR;
+		}
+
+		switch ((enum subOptions) subOptIndex) {
+			case SUBOPT_INTERVAL: {
+				double seconds;
+
+				if (Tcl_GetDoubleFromObj (interp, objv[arg + 1], &seconds) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting interval", NULL);
+					return TCL_ERROR;
+				}
+
+				if (seconds < 0.0 || seconds > INT_MAX / 1000) {
+					Tcl_ResetResult (interp);
+					Tcl_AppendResult (interp, "export_metrics -interval must be from 0 to ", NULL);
+					Tcl_AppendObjToObj (Tcl_GetObjResult (interp), Tcl_NewIntObj (INT_MAX / 1000));
+					Tcl_AppendResult (interp, " seconds", NULL);
+					return TCL_ERROR;
+				}
+
+				intervalMS = (int)(seconds * 1000.0);
+				if (seconds > 0.0 && intervalMS == 0) {
+					intervalMS = 1;
+				}
+				break;
+			}
+
+			case SUBOPT_FORMAT: {
+				if (Tcl_GetIndexFromObj (interp, objv[arg + 1], casstcl_exportFormatNames, "format", TCL_EXACT, &format) != TCL_OK) {
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_PREFIX: {
+				prefixObj = objv[arg + 1];
+				break;
+			}
+
+			case SUBOPT_CHANNEL: {
+				int length;
+				int mode;
+
+				Tcl_GetStringFromObj (objv[arg + 1], &length);
+				if (length == 0) {
+					channelNameObj = NULL;
+					break;
+				}
+
+				if (Tcl_GetChannel (interp, Tcl_GetString (objv[arg + 1]), &mode) == NULL) {
+					return TCL_ERROR;
+				}
+
+				if (!(mode & TCL_WRITABLE)) {
+					Tcl_ResetResult (interp);
+					Tcl_AppendResult (interp, "channel \"", Tcl_GetString (objv[arg + 1]), "\" wasn't opened for writing", NULL);
+					return TCL_ERROR;
+				}
+
+				channelNameObj = objv[arg + 1];
+				callbackObj = NULL;
+				break;
+			}
+
+			case SUBOPT_CALLBACK: {
+				int length;
+
+				Tcl_GetStringFromObj (objv[arg + 1], &length);
+				callbackObj = (length == 0) ? NULL : objv[arg + 1];
+				if (callbackObj != NULL) {
+					channelNameObj = NULL;
+				}
+				break;
+			}
+		}
+	}
+
+	if (intervalMS > 0 && channelNameObj == NULL && callbackObj == NULL) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "export_metrics -interval needs a -channel or a -callback", NULL);
+		return TCL_ERROR;
+	}
+
+	ex->format = format;
+
+	if (prefixObj != ex->prefixObj) {
+		Tcl_IncrRefCount (prefixObj);
+		if (ex->prefixObj != NULL) {
+			Tcl_DecrRefCount (ex->prefixObj);
+		}
+		ex->prefixObj = prefixObj;
+	}
+
+	if (channelNameObj != ex->channelNameObj) {
+		if (channelNameObj != NULL) {
+			Tcl_IncrRefCount (channelNameObj);
+		}
+		if (ex->channelNameObj != NULL) {
+			Tcl_DecrRefCount (ex->channelNameObj);
+		}
+		ex->channelNameObj = channelNameObj;
+	}
+
+	if (callbackObj != ex->callbackObj) {
+		if (callbackObj != NULL) {
+			Tcl_IncrRefCount (callbackObj);
+		}
+		if (ex->callbackObj != NULL) {
+			Tcl_DecrRefCount (ex->callbackObj);
+		}
+		ex->callbackObj = callbackObj;
+	}
+
+	// a new interval starts counting from now
+	if (intervalMS != ex->intervalMS) {
+		if (ex->timer != NULL) {
+			Tcl_DeleteTimerHandler (ex->timer);
+			ex->timer = NULL;
+		}
+
+		if (intervalMS > 0) {
+			ex->timer = Tcl_CreateTimerHandler (intervalMS, casstcl_export_timer_proc, (ClientData)ct);
+		}
+		ex->intervalMS = intervalMS;
+	}
+
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_export_forget --
+ *
+ *    stop exporting a session's metrics and throw away the exporter's
+ *    settings when the session is deleted
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_export_forget (casstcl_sessionClientData *ct)
+{
+	casstcl_metricsExport *ex = &ct->metricsExport;
+
+	if (ex->timer != NULL) {
+		Tcl_DeleteTimerHandler (ex->timer);
+		ex->timer = NULL;
+	}
+
+	if (ex->prefixObj != NULL) {
+		Tcl_DecrRefCount (ex->prefixObj);
+		ex->prefixObj = NULL;
+	}
+
+	if (ex->channelNameObj != NULL) {
+		Tcl_DecrRefCount (ex->channelNameObj);
+		ex->channelNameObj = NULL;
+	}
+
+	if (ex->callbackObj != NULL) {
+		Tcl_DecrRefCount (ex->callbackObj);
+		ex->callbackObj = NULL;
+	}
+
+	ex->intervalMS = 0;
+}
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
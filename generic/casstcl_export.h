@@ -0,0 +1,69 @@
+/*
+ *
+ * Include file for casstcl_export
+ *
+ * Copyright (C) 2015 by FlightAware, All Rights Reserved
+ *
+ * Freely redistributable under the Berkeley copyright, see license.terms
+ * for details.
+ */
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_export_render --
+ *
+ *    render a session's metrics in a format: the cpp-driver's metrics,
+ *    as the metrics method returns them, casstcl's own counters of
+ *    futures, callbacks, conversion errors, fire-and-forget requests,
+ *    rate limiting, circuit breakers, caches, write queues and the slow
+ *    query log, and the latency histograms.  each name starts with
+ *    prefix, unless it's empty.
+ *
+ * Results:
+ *    A new object holding the text, a line per metric
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Obj *
+casstcl_export_render (casstcl_sessionClientData *ct, int format, CONST char *prefix);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_export_metrics --
+ *
+ *    implements the export_metrics method of a session,
+ *
+ *      export_metrics ?-interval seconds? ?-format prometheus|statsd?
+ *          ?-prefix name? ?-channel chan? ?-callback proc?
+ *      export_metrics -render
+ *
+ *    with no arguments, return the settings and how many times the
+ *    metrics have been exported.  an interval of 0 turns the exporter
+ *    off; otherwise it needs a channel or a callback, and giving one
+ *    replaces the other.  -render returns the metrics in the current
+ *    format right away.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_export_metrics (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[]);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_export_forget --
+ *
+ *    stop exporting a session's metrics and throw away the exporter's
+ *    settings when the session is deleted
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_export_forget (casstcl_sessionClientData *ct);
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
@@ -13,8 +13,23 @@
 #include "casstcl_future.h"
 #include "casstcl_error.h"
 #include "casstcl_event.h"
+#include "casstcl_coro.h"
+#include "casstcl_breaker.h"
+#include "casstcl_latency.h"
+#include "casstcl_trace.h"
+#include "casstcl_slowlog.h"
+#include "casstcl_ratelimit.h"
 
 #include <assert.h>
+#include <stdlib.h>
+#include <time.h>
+
+// wait_any and wait_all sleep on this condition, which every driver
+// callback casstcl sets notifies.  the generation count lets a waiter
+// tell whether anything completed while it was looking at its futures.
+TCL_DECLARE_MUTEX(casstcl_waitMutex)
+static Tcl_Condition casstcl_waitCondition = NULL;
+static unsigned long casstcl_waitGeneration = 0;
 
 /*
  *----------------------------------------------------------------------
@@ -46,28 +61,57 @@ casstcl_future_eventProc (Tcl_Event *tevPtr, int flags) {
 	casstcl_futureEvent *evPtr = (casstcl_futureEvent *)tevPtr;
 	casstcl_futureClientData *fcd = evPtr->fcd;
 	assert (fcd->cass_future_magic == CASS_FUTURE_MAGIC);
-	Tcl_Interp *interp = fcd->ct->interp;
+	casstcl_sessionClientData *ct = fcd->ct;
+	Tcl_Interp *interp = ct->interp;
+
+	// from here on the future may be reclaimed by the session's max age
+	// policy
+	fcd->flags |= CASSTCL_FUTURE_CALLBACK_DELIVERED;
+	ct->callbackEvents++;
 
 	// eval the command.  it should be the callback we were told as the
 	// first argument and the future object we created, like future0, as
 	// the second.
 
 	CassError rc = cass_future_error_code(fcd->future);
+	if (fcd->flags & CASSTCL_FUTURE_BREAKER) {
+		casstcl_breaker_record (ct, fcd->tableNameObj, rc);
+	}
+	fcd->flags |= CASSTCL_FUTURE_LATENCY_RECORDED;
+	casstcl_latency_record (ct, fcd->latencyKeysObj, fcd->completed - fcd->submitted);
+	casstcl_slowlog_record (ct, fcd->slowlogObj, fcd->future, 1, fcd->completed - fcd->submitted);
 	
 	// Callback if we have an error OR if CASSTCL_FUTURE_CALLBACK_ON_ERROR_ONLY not set
 	if ( ((fcd->flags & CASSTCL_FUTURE_CALLBACK_ON_ERROR_ONLY) != CASSTCL_FUTURE_CALLBACK_ON_ERROR_ONLY ) || 
 		(casstcl_future_error_to_tcl(fcd->ct, rc, fcd->future) == TCL_ERROR ) ) { 
-		// get the name of the future object this callback is related to
-		// into an object so that we can pass it as an argument
+		// get the name of the future object (or its handle) this
+		// callback is related to into an object so that we can pass it
+		// as an argument
 
-		Tcl_Obj *futureObj = Tcl_NewObj();
-		Tcl_GetCommandFullName(interp, fcd->cmdToken, futureObj);
-	
+		Tcl_Obj *futureObj = casstcl_future_name_obj (fcd);
+
+		// the callback may well delete the future itself, so remember
+		// its id rather than its address
+		// (it could even delete the session, in which case the session
+		// sticks around until we release it, with its policy cleared)
+		char *futureKey = Tcl_GetHashKey (&ct->futureTable, fcd->entry);
+
+		Tcl_Preserve ((ClientData)ct);
 		casstcl_invoke_callback_with_argument (interp, fcd->callbackObj, futureObj);
+
+		if (ct->futureDeleteAfterCallback) {
+			Tcl_HashEntry *entry = Tcl_FindHashEntry (&ct->futureTable, futureKey);
+
+			if (entry != NULL) {
+				ct->futuresReclaimed++;
+				casstcl_future_delete ((casstcl_futureClientData *)Tcl_GetHashValue (entry));
+			}
+		}
+		Tcl_Release ((ClientData)ct);
 	
 	} else {
 	
-		Tcl_DeleteCommandFromToken (interp, fcd->cmdToken);
+		casstcl_future_delete (fcd);
 	}
 
 	// tell the dispatcher we handled it.  0 would mean we didn't deal with
@@ -101,241 +145,1351 @@ void casstcl_future_callback (CassFuture* future, void* data) {
 	casstcl_futureEvent *evPtr;
 
 	casstcl_futureClientData *fcd = data;
+
+	// stamped here so the latency doesn't include waiting for the event
+	// loop.  only eventProc looks at it.
+	fcd->completed = casstcl_now_us ();
+
 	evPtr = (casstcl_futureEvent *) ckalloc (sizeof (casstcl_futureEvent));
 	evPtr->event.proc = casstcl_future_eventProc;
 	evPtr->fcd = fcd;
 	int queueEnd = ((fcd->flags & CASSTCL_FUTURE_QUEUE_HEAD_FLAG) == CASSTCL_FUTURE_QUEUE_HEAD_FLAG) ? 
 					TCL_QUEUE_HEAD : TCL_QUEUE_TAIL;
 	Tcl_ThreadQueueEvent(fcd->ct->threadId, (Tcl_Event *)evPtr, queueEnd);
+	casstcl_wait_notify ();
 }
 
 /*
  *----------------------------------------------------------------------
  *
- * casstcl_createFutureObjectCommand --
+ * casstcl_fireforget_eventProc --
  *
- *    given a casstcl_sessionClientData pointer, a pointer to a
- *    CassFuture structure and a Tcl callback object (containing a
- *    function name), this routine creates a Tcl command like
- *    "future17" that can be invoked with method arguments to access,
- *    manipulate and destroy cassandra future objects.
+ *    this routine is called by the Tcl event handler when a
+ *    fire-and-forget request has failed and the session's error
+ *    callback rate limit let it through
  *
  * Results:
- *    A standard Tcl result
+ *    If the session has a fireforget callback, a future object (or
+ *    handle) is created for the failed request and the callback is
+ *    invoked with it as its argument.  The callback owns the future
+ *    and should delete it.  Without a callback the future is simply
+ *    freed.
  *
  *----------------------------------------------------------------------
  */
 int
-casstcl_createFutureObjectCommand (casstcl_sessionClientData *ct, CassFuture *future, Tcl_Obj *callbackObj, int flags)
-{
-    // allocate one of our cass future objects for Tcl and configure it
-	casstcl_futureClientData *fcd;
-
-	CassError rc = cass_future_error_code (future);
-	if (rc != CASS_OK) {
-		casstcl_future_error_to_tcl (ct, rc, future);
-		cass_future_free (future);
-		return TCL_ERROR;
-	}
-
-    fcd = (casstcl_futureClientData *)ckalloc (sizeof (casstcl_futureClientData));
-    fcd->cass_future_magic = CASS_FUTURE_MAGIC;
-	fcd->ct = ct;
-	fcd->future = future;
-	fcd->flags = flags;
+casstcl_fireforget_eventProc (Tcl_Event *tevPtr, int flags) {
+	casstcl_fireForgetEvent *evPtr = (casstcl_fireForgetEvent *)tevPtr;
+	casstcl_sessionClientData *ct = evPtr->ct;
+	assert (ct->cass_session_magic == CASS_SESSION_MAGIC);
 	Tcl_Interp *interp = ct->interp;
+	Tcl_Obj *callbackObj = ct->writeStats.errorCallbackObj;
 
-	if (callbackObj != NULL) {
-		Tcl_IncrRefCount(callbackObj);
+	if (callbackObj == NULL) {
+		cass_future_free (evPtr->future);
+		return 1;
 	}
-	fcd->callbackObj = callbackObj;
 
-	if (callbackObj != NULL) {
-		cass_future_set_callback (future, casstcl_future_callback, fcd);
+	if (casstcl_createFutureObjectCommand (ct, evPtr->future, NULL, evPtr->flags, NULL, NULL, NULL) == TCL_ERROR) {
+		Tcl_BackgroundError (interp);
+		return 1;
 	}
 
-	static unsigned long nextAutoCounter = 0;
-	char *commandName;
-	int    baseNameLength;
+	// hang on to the future's name and the callback in case the
+	// callback changes the result or replaces itself
+	Tcl_Obj *futureObj = Tcl_GetObjResult (interp);
+	Tcl_IncrRefCount (futureObj);
+	Tcl_IncrRefCount (callbackObj);
+	Tcl_ResetResult (interp);
 
-#define FUTURESTRING "future"
-	baseNameLength = sizeof(FUTURESTRING) + 8 * sizeof(nextAutoCounter) + 1; // Allocate way more space than needed
-	commandName = ckalloc (baseNameLength);
-	snprintf (commandName, baseNameLength, "%s%lu", FUTURESTRING, nextAutoCounter++);
+	casstcl_invoke_callback_with_argument (interp, callbackObj, futureObj);
 
-    // create a Tcl command to interface to cass
-    fcd->cmdToken = Tcl_CreateObjCommand (interp, commandName, casstcl_futureObjectObjCmd, fcd, casstcl_futureObjectDelete);
-    Tcl_SetObjResult (interp, Tcl_NewStringObj (commandName, -1));
-	ckfree(commandName);
-    return TCL_OK;
+	Tcl_DecrRefCount (callbackObj);
+	Tcl_DecrRefCount (futureObj);
+	return 1;
 }
 
-
 /*
  *----------------------------------------------------------------------
  *
- * casstcl_futureObjectObjCmd --
+ * casstcl_fireforget_complete --
  *
- *    dispatches the subcommands of a casstcl future-handling command
+ *    common code for the fire-and-forget driver callbacks.  this runs
+ *    in one of the cassandra cpp-driver's own threads when a request
+ *    issued with async -fireforget completes.
+ *
+ *    successful futures are freed right here without ever going near
+ *    Tcl.  failures are counted by error code and, as long as the
+ *    session's per-second error callback limit hasn't been reached,
+ *    queued to the session's thread for casstcl_fireforget_eventProc.
+ *    failures over the limit are counted as suppressed and freed.
+ *
+ *    nothing in here may touch a Tcl_Obj.
  *
  * Results:
  *    stuff
  *
  *----------------------------------------------------------------------
  */
-int
-casstcl_futureObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[])
-{
-    int         optIndex;
-	casstcl_futureClientData *fcd = (casstcl_futureClientData *)cData;
-	int resultCode = TCL_OK;
-
-    static CONST char *options[] = {
-        "isready",
-        "wait",
-        "foreach",
-		"status",
-		"error_message",
-		"delete",
-        NULL
-    };
+static void
+casstcl_fireforget_complete (CassFuture* future, casstcl_sessionClientData *ct, int flags) {
+	casstcl_writeStats *ws = &ct->writeStats;
+	int deliver = 0;
 
-    enum options {
-        OPT_ISREADY,
-        OPT_WAIT,
-        OPT_FOREACH,
-		OPT_STATUS,
-		OPT_ERRORMESSAGE,
-		OPT_DELETE
-    };
+	CassError rc = cass_future_error_code (future);
 
-    /* basic validation of command line arguments */
-    if (objc < 2) {
-        Tcl_WrongNumArgs (interp, 1, objv, "subcommand ?args?");
-        return TCL_ERROR;
-    }
+	// with no table, which is all a fire-and-forget request knows
+	casstcl_breaker_record (ct, NULL, rc);
 
-    if (Tcl_GetIndexFromObj (interp, objv[1], options, "option", TCL_EXACT, &optIndex) != TCL_OK) {
-		return TCL_ERROR;
-    }
+	Tcl_MutexLock (&ws->mutex);
+	if (rc == CASS_OK) {
+		ws->succeeded++;
+	} else {
+		int isNew;
+		Tcl_HashEntry *entry = Tcl_CreateHashEntry (&ws->errorCounts, (char *)(long)rc, &isNew);
+		Tcl_SetHashValue (entry, (ClientData)((long)Tcl_GetHashValue (entry) + 1));
+		ws->failed++;
+
+		long now = (long)time (NULL);
+		if (now != ws->errorWindow) {
+			ws->errorWindow = now;
+			ws->errorWindowCount = 0;
+		}
 
-    switch ((enum options) optIndex) {
-		case OPT_ISREADY: {
-			Tcl_SetBooleanObj (Tcl_GetObjResult(interp), cass_future_ready (fcd->future));
-			break;
+		if (ws->errorCallbackLimit == 0 || ws->errorWindowCount < ws->errorCallbackLimit) {
+			ws->errorWindowCount++;
+			deliver = 1;
+		} else {
+			ws->suppressed++;
 		}
+	}
+	Tcl_MutexUnlock (&ws->mutex);
 
-		case OPT_WAIT: {
-			int microSeconds = 0;
+	if (!deliver) {
+		cass_future_free (future);
+		return;
+	}
 
-			if (objc > 3) {
-				Tcl_WrongNumArgs (interp, 2, objv, "?us?");
-				return TCL_ERROR;
-			}
+	casstcl_fireForgetEvent *evPtr = (casstcl_fireForgetEvent *) ckalloc (sizeof (casstcl_fireForgetEvent));
+	evPtr->event.proc = casstcl_fireforget_eventProc;
+	evPtr->ct = ct;
+	evPtr->future = future;
+	evPtr->flags = flags;
+	Tcl_ThreadQueueEvent (ct->threadId, (Tcl_Event *)evPtr, TCL_QUEUE_TAIL);
+}
 
-			if (objc == 3) {
-				if (Tcl_GetIntFromObj (interp, objv[2], &microSeconds) == TCL_ERROR) {
-					Tcl_AppendResult (interp, " while converting microseconds element", NULL);
-					return TCL_ERROR;
-				}
-				Tcl_SetBooleanObj (Tcl_GetObjResult(interp), cass_future_wait_timed (fcd->future, microSeconds));
-			} else {
-				cass_future_wait (fcd->future);
-			}
-			break;
-		}
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_fireforget_callback, casstcl_fireforget_handle_callback --
+ *
+ *    the callbacks set on fire-and-forget futures with
+ *    cass_future_set_callback.  the data pointer is the session, so
+ *    nothing needs to be allocated per request; which one is used
+ *    decides whether a failure reaches Tcl as a future command or a
+ *    future handle.
+ *
+ *----------------------------------------------------------------------
+ */
+void casstcl_fireforget_callback (CassFuture* future, void* data) {
+	casstcl_fireforget_complete (future, (casstcl_sessionClientData *)data, CASSTCL_FUTURE_FIRE_AND_FORGET);
+}
 
-		case OPT_FOREACH: {
-			if (objc != 4) {
-				Tcl_WrongNumArgs (interp, 2, objv, "rowArray codeBody");
-				return TCL_ERROR;
-			}
+void casstcl_fireforget_handle_callback (CassFuture* future, void* data) {
+	casstcl_fireforget_complete (future, (casstcl_sessionClientData *)data, CASSTCL_FUTURE_FIRE_AND_FORGET|CASSTCL_FUTURE_HANDLE);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_fireforget --
+ *
+ *    arrange for a future to be handled fire-and-forget: the future is
+ *    never seen by Tcl unless it fails
+ *
+ * Results:
+ *    The request is counted as issued in the session's write stats.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_fireforget (casstcl_sessionClientData *ct, CassFuture *future, int flags)
+{
+	Tcl_MutexLock (&ct->writeStats.mutex);
+	ct->writeStats.issued++;
+	Tcl_MutexUnlock (&ct->writeStats.mutex);
 
-			char *arrayName = Tcl_GetString (objv[2]);
-			Tcl_Obj *codeObj = objv[3];
+	if (flags & CASSTCL_FUTURE_HANDLE) {
+		cass_future_set_callback (future, casstcl_fireforget_handle_callback, ct);
+	} else {
+		cass_future_set_callback (future, casstcl_fireforget_callback, ct);
+	}
+}
 
-			resultCode = casstcl_iterate_over_future (fcd->ct, fcd->future, arrayName, codeObj);
-			break;
-		}
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_fireforget_submitted --
+ *
+ *    submit proc for a fire-and-forget request a rate limit held back,
+ *    with its flags as clientData
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_fireforget_submitted (casstcl_sessionClientData *ct, CassFuture *future, ClientData clientData)
+{
+	casstcl_fireforget (ct, future, (int)(long)clientData);
+}
 
-		case OPT_DELETE: {
-			if (objc != 2) {
-				Tcl_WrongNumArgs (interp, 2, objv, "");
-				return TCL_ERROR;
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_fireforget_execute --
+ *
+ *    send a statement fire-and-forget, taking ownership of it.  if a
+ *    rate limit holds the request back, it's sent when the limit
+ *    allows.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_fireforget_execute (casstcl_sessionClientData *ct, CassStatement *statement, Tcl_Obj *tableNameObj, int flags)
+{
+	if (!casstcl_rate_limit_hold (ct, tableNameObj, statement, 1, casstcl_fireforget_submitted, (ClientData)(long)flags, NULL)) {
+		casstcl_fireforget (ct, cass_session_execute (ct->session, statement), flags);
+		cass_statement_free (statement);
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_wait_notify --
+ *
+ *    wake up any threads sleeping in wait_any or wait_all.  called from
+ *    the cpp-driver's threads whenever a future completes that casstcl
+ *    has a callback on.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_wait_notify ()
+{
+	Tcl_MutexLock (&casstcl_waitMutex);
+	casstcl_waitGeneration++;
+	Tcl_ConditionNotify (&casstcl_waitCondition);
+	Tcl_MutexUnlock (&casstcl_waitMutex);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_wait_callback --
+ *
+ *    driver callback set by wait_any and wait_all on futures that
+ *    don't have one of their own, just to get notified
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_wait_callback (CassFuture *future, void *data)
+{
+	casstcl_wait_notify ();
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_wait_watch --
+ *
+ *    set a callback on a future casstcl issued for its own use (one
+ *    that never gets a future command or handle) so that
+ *    casstcl_wait_for_ready notices when it completes
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_wait_watch (CassFuture *future)
+{
+	cass_future_set_callback (future, casstcl_wait_callback, NULL);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_wait_for_ready --
+ *
+ *    given an array of futures, some of which may be NULL, sleep until
+ *    at least one of them is ready.  the futures must have been passed
+ *    to casstcl_wait_watch (or otherwise have a casstcl callback).
+ *
+ * Results:
+ *    The index of a ready future, or -1 if all of them are NULL
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_wait_for_ready (CassFuture **futures, int count)
+{
+	while (1) {
+		unsigned long generation;
+		int pending = 0;
+		int i;
+
+		Tcl_MutexLock (&casstcl_waitMutex);
+		generation = casstcl_waitGeneration;
+		Tcl_MutexUnlock (&casstcl_waitMutex);
+
+		for (i = 0; i < count; i++) {
+			if (futures[i] == NULL) {
+				continue;
 			}
 
-			if (Tcl_DeleteCommandFromToken (interp, fcd->cmdToken) == TCL_ERROR) {
-				resultCode = TCL_ERROR;
+			if (cass_future_ready (futures[i])) {
+				return i;
 			}
-			break;
+			pending++;
 		}
 
-		case OPT_STATUS: {
-			const char *cassErrorCodeString = casstcl_cass_error_to_errorcode_string (cass_future_error_code (fcd->future));
-
-			Tcl_SetObjResult (interp, Tcl_NewStringObj (cassErrorCodeString, -1));
-			break;
+		if (pending == 0) {
+			return -1;
 		}
 
-		case OPT_ERRORMESSAGE: {
-			CassString cassErrorDesc;
-			cass_future_error_message (fcd->future, &cassErrorDesc.data, &cassErrorDesc.length);
-			Tcl_SetStringObj (Tcl_GetObjResult(interp), cassErrorDesc.data, cassErrorDesc.length);
-			break;
+		Tcl_MutexLock (&casstcl_waitMutex);
+		if (generation == casstcl_waitGeneration) {
+			Tcl_ConditionWait (&casstcl_waitCondition, &casstcl_waitMutex, NULL);
 		}
-    }
-    return resultCode;
+		Tcl_MutexUnlock (&casstcl_waitMutex);
+	}
 }
 
-
 /*
  *----------------------------------------------------------------------
  *
- * casstcl_iterate_over_future --
+ * casstcl_future_ready --
  *
- *      Given a casstcl client data structure, a cassandra cpp-driver
- *      CassFuture object, the name of an array and a Tcl object
- *      containing a code body, populate the array with each row in
- *      the result in turn and execute the code body
+ *    return nonzero if a future's request has been sent and completed
  *
- * Results:
- *      A standard Tcl result.
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_future_ready (casstcl_futureClientData *fcd)
+{
+	return (fcd->future != NULL && cass_future_ready (fcd->future));
+}
+
+/*
+ *----------------------------------------------------------------------
  *
- * Note that it is up to the caller to free the future.
+ * casstcl_future_completed --
  *
- * Also note that this code bears way too much in common with casstcl_select
- * but it doesn't quite go to call this from that because that uses paging
- * through the results
+ *    count a future without a callback in its latency histograms, and
+ *    its outcome against the circuit breakers if it has
+ *    CASSTCL_FUTURE_BREAKER, once it's first seen to be ready.  futures
+ *    with a callback have their completion time stamped by
+ *    casstcl_future_callback and are counted by casstcl_future_eventProc
+ *    instead.
  *
  *----------------------------------------------------------------------
  */
-int
-casstcl_iterate_over_future (casstcl_sessionClientData *ct, CassFuture *future, char *arrayName, Tcl_Obj *codeObj)
+static void
+casstcl_future_completed (casstcl_futureClientData *fcd)
 {
-	int tclReturn = TCL_OK;
-	const CassResult* result = NULL;
-	CassIterator* iterator;
-	int rc = cass_future_error_code(future);
+	if (fcd->flags & (CASSTCL_FUTURE_HAS_DRIVER_CALLBACK|CASSTCL_FUTURE_LATENCY_RECORDED)) {
+		return;
+	}
 
-	if (rc != CASS_OK) {
-		casstcl_future_error_to_tcl (ct, rc, future);
-		cass_future_free (future);
-		return TCL_ERROR;
+	if (!casstcl_future_ready (fcd)) {
+		return;
 	}
 
-	/*
-	 * NOTE: Apparently, an asynchronous "connect" has no result
-	 *       even when it succeeds.
+	fcd->completed = casstcl_now_us ();
+	if (fcd->flags & CASSTCL_FUTURE_BREAKER) {
+		casstcl_breaker_record (fcd->ct, fcd->tableNameObj, cass_future_error_code (fcd->future));
+	}
+	fcd->flags |= CASSTCL_FUTURE_LATENCY_RECORDED;
+	casstcl_latency_record (fcd->ct, fcd->latencyKeysObj, fcd->completed - fcd->submitted);
+	casstcl_slowlog_record (fcd->ct, fcd->slowlogObj, fcd->future, 1, fcd->completed - fcd->submitted);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_new --
+ *
+ *    make the client data for a future, file it in the session's
+ *    future table and create its command, unless it's a handle, and
+ *    set the interpreter result to its name.  the CassFuture is filled
+ *    in by casstcl_future_submitted once the request has been sent.
+ *
+ * Results:
+ *    The future's client data
+ *
+ *----------------------------------------------------------------------
+ */
+static casstcl_futureClientData *
+casstcl_future_new (casstcl_sessionClientData *ct, Tcl_Obj *callbackObj, int flags, Tcl_Obj *tableNameObj, Tcl_Obj *latencyKeysObj, Tcl_Obj *slowlogObj)
+{
+    // allocate one of our cass future objects for Tcl and configure it
+	casstcl_futureClientData *fcd;
+
+    fcd = (casstcl_futureClientData *)ckalloc (sizeof (casstcl_futureClientData));
+    fcd->cass_future_magic = CASS_FUTURE_MAGIC;
+	fcd->ct = ct;
+	fcd->future = NULL;
+	fcd->held = NULL;
+	fcd->flags = flags;
+	Tcl_Interp *interp = ct->interp;
+
+	if (callbackObj != NULL) {
+		Tcl_IncrRefCount(callbackObj);
+	}
+	fcd->callbackObj = callbackObj;
+	fcd->created = casstcl_now_ms ();
+	fcd->resultBytes = -1;
+	ct->futuresCreated++;
+	if (tableNameObj != NULL) {
+		Tcl_IncrRefCount(tableNameObj);
+	}
+	fcd->tableNameObj = tableNameObj;
+	if (latencyKeysObj != NULL) {
+		Tcl_IncrRefCount(latencyKeysObj);
+	}
+	fcd->latencyKeysObj = latencyKeysObj;
+	if (slowlogObj != NULL) {
+		Tcl_IncrRefCount(slowlogObj);
+	}
+	fcd->slowlogObj = slowlogObj;
+	fcd->submitted = 0;
+	fcd->completed = 0;
+
+	// every future is filed in the session's future table, which is what
+	// the futures method and the reclamation policy work from.  handles
+	// are looked up in it, too.
+	int isNew;
+	fcd->cmdToken = NULL;
+	fcd->entry = Tcl_CreateHashEntry (&ct->futureTable, (char *)ct->nextFutureId++, &isNew);
+	Tcl_SetHashValue (fcd->entry, fcd);
+
+	// handle mode -- no Tcl command is created for the future
+	if (flags & CASSTCL_FUTURE_HANDLE) {
+		Tcl_SetObjResult (interp, casstcl_future_name_obj (fcd));
+		return fcd;
+	}
+
+	static unsigned long nextAutoCounter = 0;
+	char *commandName;
+	int    baseNameLength;
+
+#define FUTURESTRING "future"
+	baseNameLength = sizeof(FUTURESTRING) + 8 * sizeof(nextAutoCounter) + 1; // Allocate way more space than needed
+	commandName = ckalloc (baseNameLength);
+	snprintf (commandName, baseNameLength, "%s%lu", FUTURESTRING, nextAutoCounter++);
+
+    // create a Tcl command to interface to cass
+    fcd->cmdToken = casstcl_create_nr_command (interp, commandName, casstcl_futureObjectObjCmd, casstcl_futureObjectNRObjCmd, fcd, casstcl_futureObjectDelete);
+    Tcl_SetObjResult (interp, Tcl_NewStringObj (commandName, -1));
+	ckfree(commandName);
+    return fcd;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_submitted --
+ *
+ *    give a future's client data the CassFuture of its request, now
+ *    that it has been sent, and set up its callback, if any.  this is
+ *    also the submit proc for a request a rate limit held back, with
+ *    the client data as clientData.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_future_submitted (casstcl_sessionClientData *ct, CassFuture *future, ClientData clientData)
+{
+	casstcl_futureClientData *fcd = (casstcl_futureClientData *)clientData;
+
+	fcd->held = NULL;
+	fcd->future = future;
+	fcd->submitted = casstcl_now_us ();
+
+	if (fcd->callbackObj != NULL) {
+		cass_future_set_callback (future, casstcl_future_callback, fcd);
+		fcd->flags |= CASSTCL_FUTURE_HAS_DRIVER_CALLBACK;
+	} else {
+		// a failed fire-and-forget request is already done
+		casstcl_future_completed (fcd);
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_createFutureObjectCommand --
+ *
+ *    given a casstcl_sessionClientData pointer, a pointer to a
+ *    CassFuture structure and a Tcl callback object (containing a
+ *    function name), this routine creates a Tcl command like
+ *    "future17" that can be invoked with method arguments to access,
+ *    manipulate and destroy cassandra future objects.
+ *
+ *    this doesn't wait for the request.  if it fails, the error is
+ *    reported by the future's status, error_message, foreach and rows
+ *    methods, and the callback, if any, is invoked all the same.
+ *
+ *    if flags includes CASSTCL_FUTURE_BREAKER the outcome of the request
+ *    is recorded against the circuit breaker of tableNameObj (if not NULL)
+ *    and the session's when the callback is delivered or, without a
+ *    callback, when the future is first seen to be ready
+ *
+ *    the time from now until the request completes is counted in the
+ *    latency histograms named in latencyKeysObj, if not NULL, and
+ *    checked against the slow query log's threshold with the request
+ *    described by slowlogObj, if not NULL
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_createFutureObjectCommand (casstcl_sessionClientData *ct, CassFuture *future, Tcl_Obj *callbackObj, int flags, Tcl_Obj *tableNameObj, Tcl_Obj *latencyKeysObj, Tcl_Obj *slowlogObj)
+{
+	casstcl_futureClientData *fcd = casstcl_future_new (ct, callbackObj, flags, tableNameObj, latencyKeysObj, slowlogObj);
+
+	casstcl_future_submitted (ct, future, (ClientData)fcd);
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_execute --
+ *
+ *    send a statement and create a future object (or handle) for it as
+ *    casstcl_createFutureObjectCommand does, taking ownership of the
+ *    statement.  if a rate limit holds the request back, the future is
+ *    created right away all the same and the request is sent when the
+ *    limit allows.  until then the future isn't ready, and waiting on
+ *    it sends it as soon as there's a token for it.  deleting it throws
+ *    the request away.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_future_execute (casstcl_sessionClientData *ct, CassStatement *statement, Tcl_Obj *callbackObj, int flags, Tcl_Obj *tableNameObj, Tcl_Obj *latencyKeysObj, Tcl_Obj *slowlogObj)
+{
+	casstcl_futureClientData *fcd = casstcl_future_new (ct, callbackObj, flags, tableNameObj, latencyKeysObj, slowlogObj);
+
+	if (!casstcl_rate_limit_hold (ct, tableNameObj, statement, 1, casstcl_future_submitted, (ClientData)fcd, &fcd->held)) {
+		casstcl_future_submitted (ct, cass_session_execute (ct->session, statement), (ClientData)fcd);
+		cass_statement_free (statement);
+	}
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_send_held --
+ *
+ *    if a future's request is still held back by a rate limit, send it
+ *    as soon as the limit allows, sleeping until then, so the future
+ *    can be waited on
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_future_send_held (casstcl_futureClientData *fcd)
+{
+	if (fcd->held != NULL) {
+		casstcl_rate_limit_release (fcd->held);
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_waited --
+ *
+ *    casstcl_coro_wait done proc for "wait -coro", which has nothing
+ *    to do once the future is ready
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_future_waited (casstcl_sessionClientData *ct, CassFuture *future, ClientData clientData)
+{
+	return (future == NULL) ? TCL_ERROR : TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_futureMethod --
+ *
+ *    implements the methods of a future, shared by future object
+ *    commands like "future17 wait" and by future handles operated on
+ *    through "casstcl::future wait ::cass0#17"
+ *
+ *    objv[1] is the method name and the method's own arguments start
+ *    at objv[argBase]
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_futureMethod (casstcl_futureClientData *fcd, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[], int argBase)
+{
+    int         optIndex;
+	int resultCode = TCL_OK;
+	int nArgs = objc - argBase;
+
+    static CONST char *options[] = {
+        "isready",
+        "wait",
+        "foreach",
+		"rows",
+		"status",
+		"error_message",
+		"delete",
+		"latency",
+		"coordinator",
+		"attempted_hosts",
+		"tracing_id",
+		"trace",
+        NULL
+    };
+
+    enum options {
+        OPT_ISREADY,
+        OPT_WAIT,
+        OPT_FOREACH,
+		OPT_ROWS,
+		OPT_STATUS,
+		OPT_ERRORMESSAGE,
+		OPT_DELETE,
+		OPT_LATENCY,
+		OPT_COORDINATOR,
+		OPT_ATTEMPTED_HOSTS,
+		OPT_TRACING_ID,
+		OPT_TRACE
+    };
+
+    if (Tcl_GetIndexFromObj (interp, objv[1], options, "option", TCL_EXACT, &optIndex) != TCL_OK) {
+		return TCL_ERROR;
+    }
+
+	// all but these need the request to have been sent
+	if (optIndex != OPT_ISREADY && optIndex != OPT_DELETE && optIndex != OPT_LATENCY) {
+		casstcl_future_send_held (fcd);
+	}
+
+    switch ((enum options) optIndex) {
+		case OPT_ISREADY: {
+			Tcl_SetBooleanObj (Tcl_GetObjResult(interp), casstcl_future_ready (fcd));
+			casstcl_future_completed (fcd);
+			break;
+		}
+
+		case OPT_WAIT: {
+			int microSeconds = 0;
+
+			if (nArgs == 1 && strcmp (Tcl_GetString (objv[argBase]), "-coro") == 0) {
+				return casstcl_coro_wait (fcd->ct, fcd->future, 0, casstcl_future_waited, NULL);
+			}
+
+			if (nArgs > 1) {
+				Tcl_WrongNumArgs (interp, argBase, objv, "?us|-coro?");
+				return TCL_ERROR;
+			}
+
+			if (nArgs == 1) {
+				if (Tcl_GetIntFromObj (interp, objv[argBase], &microSeconds) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting microseconds element", NULL);
+					return TCL_ERROR;
+				}
+				Tcl_SetBooleanObj (Tcl_GetObjResult(interp), cass_future_wait_timed (fcd->future, microSeconds));
+			} else {
+				cass_future_wait (fcd->future);
+			}
+			casstcl_future_completed (fcd);
+			break;
+		}
+
+		case OPT_FOREACH: {
+			if (nArgs != 2) {
+				Tcl_WrongNumArgs (interp, argBase, objv, "rowArray codeBody");
+				return TCL_ERROR;
+			}
+
+			char *arrayName = Tcl_GetString (objv[argBase]);
+			Tcl_Obj *codeObj = objv[argBase + 1];
+
+			// getting the result waits for it anyway
+			cass_future_wait (fcd->future);
+			casstcl_future_completed (fcd);
+			resultCode = casstcl_iterate_over_future (fcd->ct, fcd->future, arrayName, codeObj);
+			break;
+		}
+
+		case OPT_ROWS: {
+			Tcl_Obj *listObj = NULL;
+
+			if (nArgs != 0) {
+				Tcl_WrongNumArgs (interp, argBase, objv, "");
+				return TCL_ERROR;
+			}
+
+			cass_future_wait (fcd->future);
+			casstcl_future_completed (fcd);
+			resultCode = casstcl_future_rows (fcd->ct, fcd->future, &listObj);
+			if (resultCode == TCL_OK) {
+				Tcl_SetObjResult (interp, listObj);
+			}
+			break;
+		}
+
+		case OPT_DELETE: {
+			if (nArgs != 0) {
+				Tcl_WrongNumArgs (interp, argBase, objv, "");
+				return TCL_ERROR;
+			}
+
+			resultCode = casstcl_future_delete (fcd);
+			break;
+		}
+
+		case OPT_STATUS: {
+			const char *cassErrorCodeString = casstcl_cass_error_to_errorcode_string (cass_future_error_code (fcd->future));
+			casstcl_future_completed (fcd);
+
+			Tcl_SetObjResult (interp, Tcl_NewStringObj (cassErrorCodeString, -1));
+			break;
+		}
+
+		case OPT_ERRORMESSAGE: {
+			CassString cassErrorDesc;
+			cass_future_error_message (fcd->future, &cassErrorDesc.data, &cassErrorDesc.length);
+			casstcl_future_completed (fcd);
+			Tcl_SetStringObj (Tcl_GetObjResult(interp), cassErrorDesc.data, cassErrorDesc.length);
+			break;
+		}
+
+		case OPT_LATENCY: {
+			if (nArgs != 0) {
+				Tcl_WrongNumArgs (interp, argBase, objv, "");
+				return TCL_ERROR;
+			}
+
+			// a future with a callback is only known to be done, and its
+			// completion time to be set, once its event has been handled
+			casstcl_future_completed (fcd);
+			if (fcd->flags & CASSTCL_FUTURE_LATENCY_RECORDED) {
+				Tcl_SetObjResult (interp, Tcl_NewWideIntObj (fcd->completed - fcd->submitted));
+			}
+			break;
+		}
+
+		case OPT_TRACING_ID: {
+			CassUuid tracingId;
+			char tracingIdString[CASS_UUID_STRING_LENGTH];
+
+			if (nArgs != 0) {
+				Tcl_WrongNumArgs (interp, argBase, objv, "");
+				return TCL_ERROR;
+			}
+
+			if (casstcl_future_tracing_id (fcd, &tracingId)) {
+				cass_uuid_string (tracingId, tracingIdString);
+				Tcl_SetObjResult (interp, Tcl_NewStringObj (tracingIdString, CASS_UUID_STRING_LENGTH - 1));
+			}
+			break;
+		}
+
+		case OPT_COORDINATOR:
+		case OPT_ATTEMPTED_HOSTS: {
+			CassUuid tracingId;
+			Tcl_Obj *resultObj;
+
+			if (nArgs != 0) {
+				Tcl_WrongNumArgs (interp, argBase, objv, "");
+				return TCL_ERROR;
+			}
+
+			// the cpp-driver doesn't give out the address of the nodes a
+			// request went to, but a traced request's trace has them.
+			// looking them up blocks on a query of system_traces.
+			if (!casstcl_future_tracing_id (fcd, &tracingId)) {
+				break;
+			}
+
+			if (optIndex == OPT_COORDINATOR) {
+				resultCode = casstcl_trace_coordinator (fcd->ct, tracingId, &resultObj);
+			} else {
+				resultCode = casstcl_trace_hosts (fcd->ct, tracingId, &resultObj);
+			}
+
+			if (resultCode == TCL_OK) {
+				Tcl_SetObjResult (interp, resultObj);
+			}
+			break;
+		}
+
+		case OPT_TRACE: {
+			CassUuid tracingId;
+
+			if (nArgs > 1) {
+				Tcl_WrongNumArgs (interp, argBase, objv, "?callback?");
+				return TCL_ERROR;
+			}
+
+			// an untraced request has no trace, so it's empty
+			if (!casstcl_future_tracing_id (fcd, &tracingId)) {
+				break;
+			}
+
+			resultCode = casstcl_trace_fetch (fcd->ct, tracingId, (nArgs == 1) ? objv[argBase] : NULL);
+			break;
+		}
+    }
+    return resultCode;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_futureObjectObjCmd --
+ *
+ *    dispatches the subcommands of a casstcl future-handling command
+ *    by way of casstcl_futureObjectNRObjCmd
+ *
+ * Results:
+ *    stuff
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_futureObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[])
+{
+	return casstcl_nr_call (interp, casstcl_futureObjectNRObjCmd, cData, objc, objv);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_futureObjectNRObjCmd --
+ *
+ *    dispatches the subcommands of a casstcl future-handling command,
+ *    NRE-enabled so that "wait -coro" can yield
+ *
+ * Results:
+ *    stuff
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_futureObjectNRObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[])
+{
+	casstcl_futureClientData *fcd = (casstcl_futureClientData *)cData;
+
+    /* basic validation of command line arguments */
+    if (objc < 2) {
+        Tcl_WrongNumArgs (interp, 1, objv, "subcommand ?args?");
+        return TCL_ERROR;
+    }
+
+	return casstcl_futureMethod (fcd, interp, objc, objv, 2);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_futureHandleObjCmd --
+ *
+ *    implements "casstcl::future method handle ?args?", which operates
+ *    on futures created with -handle the same way future object
+ *    commands do, by way of casstcl_futureHandleNRObjCmd
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_futureHandleObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[])
+{
+	return casstcl_nr_call (interp, casstcl_futureHandleNRObjCmd, cData, objc, objv);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_futureHandleNRObjCmd --
+ *
+ *    the NRE-enabled implementation of "casstcl::future"
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_futureHandleNRObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[])
+{
+	casstcl_futureClientData *fcd;
+
+    if (objc < 3) {
+        Tcl_WrongNumArgs (interp, 1, objv, "subcommand handle ?args?");
+        return TCL_ERROR;
+    }
+
+	fcd = casstcl_future_handle_to_futureClientData (interp, objv[2]);
+	if (fcd == NULL) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "future handle '", Tcl_GetString (objv[2]), "' doesn't exist", NULL);
+		return TCL_ERROR;
+	}
+
+	return casstcl_futureMethod (fcd, interp, objc, objv, 3);
+}
+
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_iterate_over_future --
+ *
+ *      Given a casstcl client data structure, a cassandra cpp-driver
+ *      CassFuture object, the name of an array and a Tcl object
+ *      containing a code body, populate the array with each row in
+ *      the result in turn and execute the code body
+ *
+ * Results:
+ *      A standard Tcl result.
+ *
+ * Note that it is up to the caller to free the future.
+ *
+ * Also note that this code bears way too much in common with casstcl_select
+ * but it doesn't quite go to call this from that because that uses paging
+ * through the results
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_iterate_over_future (casstcl_sessionClientData *ct, CassFuture *future, char *arrayName, Tcl_Obj *codeObj)
+{
+	int tclReturn = TCL_OK;
+	const CassResult* result = NULL;
+	CassIterator* iterator;
+	int rc = cass_future_error_code(future);
+
+	if (rc != CASS_OK) {
+		return casstcl_future_error_to_tcl (ct, rc, future);
+	}
+
+	/*
+	 * NOTE: Apparently, an asynchronous "connect" has no result
+	 *       even when it succeeds.
 	 */
 	result = cass_future_get_result(future);
 	Tcl_Interp *interp = ct->interp;
 
 	if (result == NULL) {
-		Tcl_ResetResult(interp);
+		Tcl_ResetResult(interp);
+		return TCL_OK;
+	}
+	iterator = cass_iterator_from_result(result);
+
+	int columnCount = cass_result_column_count (result);
+
+	while (cass_iterator_next(iterator)) {
+		CassString cassNameString;
+		int i;
+
+		const CassRow* row = cass_iterator_get_row(iterator);
+
+		// process all the columns into the tcl array
+		for (i = 0; i < columnCount; i++) {
+			Tcl_Obj *newObj = NULL;
+			const char *columnName;
+			const CassValue *columnValue;
+
+			cass_result_column_name (result, i, &cassNameString.data, &cassNameString.length);
+			columnName = cassNameString.data;
+
+			columnValue = cass_row_get_column (row, i);
+
+			if (cass_value_is_null (columnValue)) {
+				Tcl_UnsetVar2 (interp, arrayName, columnName, 0);
+				continue;
+			}
+
+			if (casstcl_cass_value_to_tcl_obj (ct, columnValue, &newObj) == TCL_ERROR) {
+				tclReturn = TCL_ERROR;
+				break;
+			}
+
+			if (newObj == NULL) {
+				Tcl_UnsetVar2 (interp, arrayName, columnName, 0);
+			} else {
+				if (Tcl_SetVar2Ex (interp, arrayName, columnName, newObj, (TCL_LEAVE_ERR_MSG)) == NULL) {
+					tclReturn = TCL_ERROR;
+					break;
+				}
+			}
+		}
+
+		// now execute the code body (this version of eval does not
+		// require any reference count management of the object).
+		//
+		// as with the other place where we do this, TCL_BREAK and TCL_CONTINUE
+		// are for us, we want TCL_BREAK to break us out but return TCL_OK
+		// because our caller isn't to get a break.  TCL_RETURN, on the
+		// other hand, means a return even past our caller, so we pass that
+		// through.
+		//
+		int evalReturnCode = Tcl_EvalObjEx(interp, codeObj, 0);
+		if ((evalReturnCode != TCL_OK) && (evalReturnCode != TCL_CONTINUE)) {
+			if (evalReturnCode == TCL_RETURN) {
+				tclReturn = TCL_RETURN;
+			} else if (evalReturnCode == TCL_ERROR) {
+				char        msg[60];
+				tclReturn = TCL_ERROR;
+
+				sprintf(msg, "\n    (\"select\" body line %d)",
+						Tcl_GetErrorLine(interp));
+				Tcl_AddErrorInfo(interp, msg);
+			}
+
+			break;
+		}
+	}
+	cass_iterator_free(iterator);
+	return tclReturn;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_now_ms --
+ *
+ *      return the current time in milliseconds
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_WideInt
+casstcl_now_ms ()
+{
+	Tcl_Time now;
+
+	Tcl_GetTime (&now);
+	return ((Tcl_WideInt)now.sec * 1000) + (now.usec / 1000);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_now_us --
+ *
+ *      return the current time in microseconds
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_WideInt
+casstcl_now_us ()
+{
+	Tcl_Time now;
+
+	Tcl_GetTime (&now);
+	return ((Tcl_WideInt)now.sec * 1000000) + now.usec;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_result_bytes --
+ *
+ *      return the number of bytes of result data a future is holding
+ *      onto, taken to be the encoded size of its column values.  this
+ *      is only known once the future is ready; until then, and for
+ *      futures without a result, it is zero.  the size is computed the
+ *      first time it's asked for and remembered.
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_WideInt
+casstcl_future_result_bytes (casstcl_futureClientData *fcd)
+{
+	if (fcd->resultBytes >= 0) {
+		return fcd->resultBytes;
+	}
+
+	if (!casstcl_future_ready (fcd)) {
+		return 0;
+	}
+
+	Tcl_WideInt bytes = 0;
+	const CassResult *result = NULL;
+
+	if (cass_future_error_code (fcd->future) == CASS_OK) {
+		result = cass_future_get_result (fcd->future);
+	}
+
+	if (result != NULL) {
+		CassIterator *iterator = cass_iterator_from_result (result);
+		int columnCount = cass_result_column_count (result);
+
+		while (cass_iterator_next (iterator)) {
+			const CassRow *row = cass_iterator_get_row (iterator);
+			int i;
+
+			for (i = 0; i < columnCount; i++) {
+				const cass_byte_t *data;
+				size_t size;
+
+				if (cass_value_get_bytes (cass_row_get_column (row, i), &data, &size) == CASS_OK) {
+					bytes += size;
+				}
+			}
+		}
+
+		cass_iterator_free (iterator);
+		cass_result_free (result);
+	}
+
+	fcd->resultBytes = bytes;
+	return bytes;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_futures_list --
+ *
+ *      set the caller's object pointer to a list of the names of the
+ *      session's futures, either all of them or only those that are
+ *      pending or ready, according to the which argument
+ *
+ * Results:
+ *      A standard Tcl result.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_futures_list (casstcl_sessionClientData *ct, int which, Tcl_Obj **listObjPtr)
+{
+	Tcl_Obj *listObj = Tcl_NewObj ();
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+
+	for (entry = Tcl_FirstHashEntry (&ct->futureTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+		casstcl_futureClientData *fcd = (casstcl_futureClientData *)Tcl_GetHashValue (entry);
+
+		if (which != CASSTCL_FUTURES_ALL) {
+			int ready = casstcl_future_ready (fcd);
+
+			if ((which == CASSTCL_FUTURES_READY) != (ready != 0)) {
+				continue;
+			}
+		}
+
+		Tcl_ListObjAppendElement (NULL, listObj, casstcl_future_name_obj (fcd));
+	}
+
+	*listObjPtr = listObj;
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_stats --
+ *
+ *      set the interpreter result to a list of key-value pairs
+ *      describing the session's futures: how many there are, how many
+ *      are pending and ready, how many bytes of results they are holding
+ *      and how many have been reclaimed by the session's policy
+ *
+ * Results:
+ *      A standard Tcl result.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_future_stats (Tcl_Interp *interp, casstcl_sessionClientData *ct)
+{
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+	Tcl_WideInt pending = 0;
+	Tcl_WideInt ready = 0;
+	Tcl_WideInt bytes = 0;
+	Tcl_Obj *listObjv[10];
+	int i = 0;
+
+	for (entry = Tcl_FirstHashEntry (&ct->futureTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+		casstcl_futureClientData *fcd = (casstcl_futureClientData *)Tcl_GetHashValue (entry);
+
+		if (casstcl_future_ready (fcd)) {
+			ready++;
+			bytes += casstcl_future_result_bytes (fcd);
+		} else {
+			pending++;
+		}
+	}
+
+	listObjv[i++] = Tcl_NewStringObj ("futures", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (pending + ready);
+	listObjv[i++] = Tcl_NewStringObj ("pending", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (pending);
+	listObjv[i++] = Tcl_NewStringObj ("ready", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (ready);
+	listObjv[i++] = Tcl_NewStringObj ("result_bytes", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (bytes);
+	listObjv[i++] = Tcl_NewStringObj ("reclaimed", -1);
+	listObjv[i++] = Tcl_NewWideIntObj (ct->futuresReclaimed);
+
+	Tcl_SetObjResult (interp, Tcl_NewListObj (i, listObjv));
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_sweep --
+ *
+ *      timer handler that deletes futures older than the session's
+ *      maximum future age, then reschedules itself.  futures that are
+ *      still pending, or whose callback hasn't been invoked yet, are
+ *      left alone no matter how old they are.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_future_sweep (ClientData clientData)
+{
+	casstcl_sessionClientData *ct = (casstcl_sessionClientData *)clientData;
+	Tcl_WideInt now = casstcl_now_ms ();
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+	casstcl_futureClientData **victims;
+	int nVictims = 0;
+	int i;
+
+	ct->futureSweepTimer = NULL;
+
+	// collect first, deleting futures modifies the table we're walking
+	victims = (casstcl_futureClientData **)ckalloc (sizeof (casstcl_futureClientData *) * (ct->futureTable.numEntries + 1));
+
+	for (entry = Tcl_FirstHashEntry (&ct->futureTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+		casstcl_futureClientData *fcd = (casstcl_futureClientData *)Tcl_GetHashValue (entry);
+
+		if (now - fcd->created < ct->futureMaxAge) {
+			continue;
+		}
+
+		if (fcd->callbackObj != NULL && !(fcd->flags & CASSTCL_FUTURE_CALLBACK_DELIVERED)) {
+			continue;
+		}
+
+		if (!casstcl_future_ready (fcd)) {
+			continue;
+		}
+
+		victims[nVictims++] = fcd;
+	}
+
+	for (i = 0; i < nVictims; i++) {
+		casstcl_future_delete (victims[i]);
+	}
+	ct->futuresReclaimed += nVictims;
+	ckfree ((char *)victims);
+
+	casstcl_future_set_max_age (ct, ct->futureMaxAge);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_set_max_age --
+ *
+ *      set the age in milliseconds after which the session's ready
+ *      futures are deleted automatically, zero meaning never, and
+ *      (re)schedule or cancel the sweep accordingly.  the sweep runs
+ *      at half the age, but at least every second.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_future_set_max_age (casstcl_sessionClientData *ct, int maxAge)
+{
+	if (ct->futureSweepTimer != NULL) {
+		Tcl_DeleteTimerHandler (ct->futureSweepTimer);
+		ct->futureSweepTimer = NULL;
+	}
+
+	ct->futureMaxAge = maxAge;
+	if (maxAge <= 0) {
+		return;
+	}
+
+	int interval = maxAge / 2;
+	if (interval < 10) {
+		interval = 10;
+	} else if (interval > 1000) {
+		interval = 1000;
+	}
+
+	ct->futureSweepTimer = Tcl_CreateTimerHandler (interval, casstcl_future_sweep, (ClientData)ct);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_rows --
+ *
+ *      Given a casstcl client data structure and a completed cassandra
+ *      cpp-driver CassFuture object, set the caller's object pointer to
+ *      a list of the rows of the result, each row being a list of
+ *      column name and value pairs like "array get" produces.  As with
+ *      foreach, null columns are omitted.
+ *
+ * Results:
+ *      A standard Tcl result.
+ *
+ * Note that it is up to the caller to free the future.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_future_rows (casstcl_sessionClientData *ct, CassFuture *future, Tcl_Obj **listObjPtr)
+{
+	int tclReturn = TCL_OK;
+	const CassResult* result = NULL;
+	CassIterator* iterator;
+	Tcl_Interp *interp = ct->interp;
+	CassError rc = cass_future_error_code(future);
+
+	if (rc != CASS_OK) {
+		return casstcl_future_error_to_tcl (ct, rc, future);
+	}
+
+	Tcl_Obj *listObj = Tcl_NewObj();
+
+	result = cass_future_get_result(future);
+	if (result == NULL) {
+		*listObjPtr = listObj;
 		return TCL_OK;
 	}
-	iterator = cass_iterator_from_result(result);
 
+	iterator = cass_iterator_from_result(result);
 	int columnCount = cass_result_column_count (result);
 
 	while (cass_iterator_next(iterator)) {
@@ -343,20 +1497,13 @@ casstcl_iterate_over_future (casstcl_sessionClientData *ct, CassFuture *future,
 		int i;
 
 		const CassRow* row = cass_iterator_get_row(iterator);
+		Tcl_Obj *rowObj = Tcl_NewObj();
 
-		// process all the columns into the tcl array
 		for (i = 0; i < columnCount; i++) {
 			Tcl_Obj *newObj = NULL;
-			const char *columnName;
-			const CassValue *columnValue;
-
-			cass_result_column_name (result, i, &cassNameString.data, &cassNameString.length);
-			columnName = cassNameString.data;
-
-			columnValue = cass_row_get_column (row, i);
+			const CassValue *columnValue = cass_row_get_column (row, i);
 
 			if (cass_value_is_null (columnValue)) {
-				Tcl_UnsetVar2 (interp, arrayName, columnName, 0);
 				continue;
 			}
 
@@ -366,44 +1513,103 @@ casstcl_iterate_over_future (casstcl_sessionClientData *ct, CassFuture *future,
 			}
 
 			if (newObj == NULL) {
-				Tcl_UnsetVar2 (interp, arrayName, columnName, 0);
-			} else {
-				if (Tcl_SetVar2Ex (interp, arrayName, columnName, newObj, (TCL_LEAVE_ERR_MSG)) == NULL) {
-					tclReturn = TCL_ERROR;
-					break;
-				}
+				continue;
 			}
-		}
-
-		// now execute the code body (this version of eval does not
-		// require any reference count management of the object).
-		//
-		// as with the other place where we do this, TCL_BREAK and TCL_CONTINUE
-		// are for us, we want TCL_BREAK to break us out but return TCL_OK
-		// because our caller isn't to get a break.  TCL_RETURN, on the
-		// other hand, means a return even past our caller, so we pass that
-		// through.
-		//
-		int evalReturnCode = Tcl_EvalObjEx(interp, codeObj, 0);
-		if ((evalReturnCode != TCL_OK) && (evalReturnCode != TCL_CONTINUE)) {
-			if (evalReturnCode == TCL_RETURN) {
-				tclReturn = TCL_RETURN;
-			} else if (evalReturnCode == TCL_ERROR) {
-				char        msg[60];
-				tclReturn = TCL_ERROR;
 
-				sprintf(msg, "\n    (\"select\" body line %d)",
-						Tcl_GetErrorLine(interp));
-				Tcl_AddErrorInfo(interp, msg);
-			}
+			cass_result_column_name (result, i, &cassNameString.data, &cassNameString.length);
+			Tcl_ListObjAppendElement (interp, rowObj, Tcl_NewStringObj (cassNameString.data, cassNameString.length));
+			Tcl_ListObjAppendElement (interp, rowObj, newObj);
+		}
 
+		if (tclReturn == TCL_ERROR) {
+			Tcl_DecrRefCount (rowObj);
 			break;
 		}
+
+		Tcl_ListObjAppendElement (interp, listObj, rowObj);
 	}
+
 	cass_iterator_free(iterator);
+	cass_result_free(result);
+
+	if (tclReturn == TCL_OK) {
+		*listObjPtr = listObj;
+	} else {
+		Tcl_DecrRefCount (listObj);
+	}
 	return tclReturn;
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_name_obj --
+ *
+ *    return a new Tcl object naming the future, either the fully
+ *    qualified name of its object command or, for futures created
+ *    with -handle, its handle
+ *
+ * Results:
+ *    A Tcl object with a reference count of zero
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Obj *
+casstcl_future_name_obj (casstcl_futureClientData *fcd)
+{
+	casstcl_sessionClientData *ct = fcd->ct;
+	Tcl_Obj *nameObj = Tcl_NewObj();
+
+	if (fcd->cmdToken != NULL) {
+		Tcl_GetCommandFullName (ct->interp, fcd->cmdToken, nameObj);
+		return nameObj;
+	}
+
+	unsigned long id = (unsigned long)Tcl_GetHashKey (&ct->futureTable, fcd->entry);
+
+	int sessionNameLength;
+
+	Tcl_GetCommandFullName (ct->interp, ct->cmdToken, nameObj);
+	Tcl_GetStringFromObj (nameObj, &sessionNameLength);
+	Tcl_AppendPrintfToObj (nameObj, "%c%lu", CASSTCL_FUTURE_HANDLE_SEPARATOR, id);
+	Tcl_GetString (nameObj);
+
+	// we know what this parses to, so save the conversion
+	if (nameObj->typePtr != NULL && nameObj->typePtr->freeIntRepProc != NULL) {
+		nameObj->typePtr->freeIntRepProc (nameObj);
+	}
+	nameObj->internalRep.twoPtrValue.ptr1 = (void *)id;
+	nameObj->internalRep.twoPtrValue.ptr2 = (void *)(long)sessionNameLength;
+	nameObj->typePtr = &casstcl_futureHandleTclType;
+
+	return nameObj;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_delete --
+ *
+ *    delete a future, whether it is a future object command or a
+ *    future handle
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_future_delete (casstcl_futureClientData *fcd)
+{
+	if (fcd->cmdToken != NULL) {
+		Tcl_DeleteCommandFromToken (fcd->ct->interp, fcd->cmdToken);
+		return TCL_OK;
+	}
+
+	casstcl_futureObjectDelete (fcd);
+	return TCL_OK;
+}
+
 /*
  *--------------------------------------------------------------
  *
@@ -425,12 +1631,33 @@ casstcl_futureObjectDelete (ClientData clientData)
 
     assert (fcd->cass_future_magic == CASS_FUTURE_MAGIC);
 
-	cass_future_free (fcd->future);
+	Tcl_DeleteHashEntry (fcd->entry);
+
+	// a request still held back by a rate limit is never sent
+	if (fcd->held != NULL) {
+		casstcl_rate_limit_cancel (fcd->held);
+	} else {
+		// count a request nobody looked at if it's done by now
+		casstcl_future_completed (fcd);
+		cass_future_free (fcd->future);
+	}
 
 	if (fcd->callbackObj != NULL) {
 		Tcl_DecrRefCount(fcd->callbackObj);
 	}
 
+	if (fcd->tableNameObj != NULL) {
+		Tcl_DecrRefCount(fcd->tableNameObj);
+	}
+
+	if (fcd->latencyKeysObj != NULL) {
+		Tcl_DecrRefCount(fcd->latencyKeysObj);
+	}
+
+	if (fcd->slowlogObj != NULL) {
+		Tcl_DecrRefCount(fcd->slowlogObj);
+	}
+
     ckfree((char *)clientData);
 }
 
@@ -466,4 +1693,304 @@ casstcl_future_command_to_futureClientData (Tcl_Interp *interp, char *futureComm
 	return fcd;
 }
 
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_future_handle_to_futureClientData -- given a future handle
+ *   like ::cass0#17, find the session it belongs to and return a pointer
+ *   to the future's client data from the session's table or NULL
+ *
+ * Results:
+ *
+ * Side effects:
+ *      The handle object is converted to casstcl_futureHandleTclType.
+ *
+ *--------------------------------------------------------------
+ */
+casstcl_futureClientData *
+casstcl_future_handle_to_futureClientData (Tcl_Interp *interp, Tcl_Obj *handleObj)
+{
+	Tcl_CmdInfo sessionCmdInfo;
+	Tcl_DString ds;
+	int found;
+
+	if (Tcl_ConvertToType (NULL, handleObj, &casstcl_futureHandleTclType) == TCL_ERROR) {
+		return NULL;
+	}
+
+	unsigned long id = (unsigned long)handleObj->internalRep.twoPtrValue.ptr1;
+	int sessionNameLength = (int)(long)handleObj->internalRep.twoPtrValue.ptr2;
+
+	Tcl_DStringInit (&ds);
+	Tcl_DStringAppend (&ds, Tcl_GetString (handleObj), sessionNameLength);
+	found = Tcl_GetCommandInfo (interp, Tcl_DStringValue (&ds), &sessionCmdInfo);
+	Tcl_DStringFree (&ds);
+
+	if (!found) {
+		return NULL;
+	}
+
+	casstcl_sessionClientData *ct = (casstcl_sessionClientData *)sessionCmdInfo.objClientData;
+	if (ct == NULL || ct->cass_session_magic != CASS_SESSION_MAGIC) {
+		return NULL;
+	}
+
+	Tcl_HashEntry *entry = Tcl_FindHashEntry (&ct->futureTable, (char *)id);
+	if (entry == NULL) {
+		return NULL;
+	}
+
+	// future object commands are in the table too but they don't have
+	// handles
+	casstcl_futureClientData *fcd = (casstcl_futureClientData *)Tcl_GetHashValue (entry);
+	if (fcd->cmdToken != NULL) {
+		return NULL;
+	}
+
+	return fcd;
+}
+
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_obj_to_futureClientData -- given an object holding
+ *   either a future object command name or a future handle, return
+ *   a pointer to its future client data or NULL
+ *
+ *--------------------------------------------------------------
+ */
+casstcl_futureClientData *
+casstcl_obj_to_futureClientData (Tcl_Interp *interp, Tcl_Obj *futureObj)
+{
+	Tcl_CmdInfo futureCmdInfo;
+	casstcl_futureClientData *fcd = casstcl_future_handle_to_futureClientData (interp, futureObj);
+
+	if (fcd != NULL) {
+		return fcd;
+	}
+
+	if (!Tcl_GetCommandInfo (interp, Tcl_GetString (futureObj), &futureCmdInfo)) {
+		return NULL;
+	}
+
+	if (futureCmdInfo.objProc != casstcl_futureObjectObjCmd) {
+		return NULL;
+	}
+
+	return (casstcl_futureClientData *)futureCmdInfo.objClientData;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_wait_futures --
+ *
+ *    implements casstcl::wait_all and casstcl::wait_any, which take
+ *    ?-timeout us? futureList and block until all (or any) of the
+ *    futures are ready or the timeout expires.  the list may mix future
+ *    object commands and future handles.
+ *
+ *    rather than polling, the thread sleeps on a condition variable
+ *    that is notified from the driver callbacks.  futures that don't
+ *    have a callback get one that does nothing but notify.
+ *
+ * Results:
+ *    A standard Tcl result.  The result is a list of the futures that
+ *    are ready, in the order given, which on timeout may be fewer than
+ *    wanted, or none.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_wait_futures (Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[], int waitAll)
+{
+	Tcl_WideInt timeout = -1;
+	Tcl_WideInt deadline = 0;
+	Tcl_Obj **listObjv;
+	casstcl_futureClientData **fcds;
+	Tcl_Obj *readyObj = NULL;
+	int listObjc;
+	int i;
+
+	if (objc == 4 && strcmp (Tcl_GetString (objv[1]), "-timeout") == 0) {
+		if (Tcl_GetWideIntFromObj (interp, objv[2], &timeout) == TCL_ERROR) {
+			Tcl_AppendResult (interp, " while converting timeout", NULL);
+			return TCL_ERROR;
+		}
+	} else if (objc != 2) {
+		Tcl_WrongNumArgs (interp, 1, objv, "?-timeout us? futureList");
+		return TCL_ERROR;
+	}
+
+	if (Tcl_ListObjGetElements (interp, objv[objc - 1], &listObjc, &listObjv) == TCL_ERROR) {
+		return TCL_ERROR;
+	}
+
+	fcds = (casstcl_futureClientData **)ckalloc (sizeof (casstcl_futureClientData *) * (listObjc + 1));
+
+	for (i = 0; i < listObjc; i++) {
+		fcds[i] = casstcl_obj_to_futureClientData (interp, listObjv[i]);
+
+		if (fcds[i] == NULL) {
+			Tcl_ResetResult (interp);
+			Tcl_AppendResult (interp, "future '", Tcl_GetString (listObjv[i]), "' doesn't exist", NULL);
+			ckfree ((char *)fcds);
+			return TCL_ERROR;
+		}
+
+		// a request a rate limit is holding back has to be sent before
+		// it can complete
+		casstcl_future_send_held (fcds[i]);
+
+		// a future only gets one callback so if the set fails, somebody
+		// already has one, and all of ours notify.  this one isn't a
+		// callback of the future's own, so it doesn't stop the future
+		// being counted by casstcl_future_completed
+		if (!(fcds[i]->flags & (CASSTCL_FUTURE_HAS_DRIVER_CALLBACK|CASSTCL_FUTURE_WAIT_WATCHED))) {
+			cass_future_set_callback (fcds[i]->future, casstcl_wait_callback, NULL);
+			fcds[i]->flags |= CASSTCL_FUTURE_WAIT_WATCHED;
+		}
+	}
+
+	if (timeout >= 0) {
+		deadline = casstcl_now_us () + timeout;
+	}
+
+	while (1) {
+		unsigned long generation;
+		int nReady = 0;
+
+		Tcl_MutexLock (&casstcl_waitMutex);
+		generation = casstcl_waitGeneration;
+		Tcl_MutexUnlock (&casstcl_waitMutex);
+
+		for (i = 0; i < listObjc; i++) {
+			if (casstcl_future_ready (fcds[i])) {
+				nReady++;
+			}
+		}
+
+		if ((waitAll && nReady == listObjc) || (!waitAll && nReady > 0) || listObjc == 0) {
+			break;
+		}
+
+		Tcl_MutexLock (&casstcl_waitMutex);
+		if (generation == casstcl_waitGeneration) {
+			if (timeout < 0) {
+				Tcl_ConditionWait (&casstcl_waitCondition, &casstcl_waitMutex, NULL);
+			} else {
+				Tcl_WideInt remaining = deadline - casstcl_now_us ();
+				Tcl_Time waitTime;
+
+				if (remaining <= 0) {
+					Tcl_MutexUnlock (&casstcl_waitMutex);
+					break;
+				}
+
+				waitTime.sec = remaining / 1000000;
+				waitTime.usec = remaining % 1000000;
+				Tcl_ConditionWait (&casstcl_waitCondition, &casstcl_waitMutex, &waitTime);
+			}
+		}
+		Tcl_MutexUnlock (&casstcl_waitMutex);
+	}
+
+	readyObj = Tcl_NewObj ();
+	for (i = 0; i < listObjc; i++) {
+		if (casstcl_future_ready (fcds[i])) {
+			casstcl_future_completed (fcds[i]);
+			Tcl_ListObjAppendElement (NULL, readyObj, listObjv[i]);
+		}
+	}
+
+	ckfree ((char *)fcds);
+	Tcl_SetObjResult (interp, readyObj);
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_waitAllObjCmd, casstcl_waitAnyObjCmd --
+ *
+ *    implement "casstcl::wait_all ?-timeout us? futureList" and
+ *    "casstcl::wait_any ?-timeout us? futureList"
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_waitAllObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[])
+{
+	return casstcl_wait_futures (interp, objc, objv, 1);
+}
+
+int
+casstcl_waitAnyObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[])
+{
+	return casstcl_wait_futures (interp, objc, objv, 0);
+}
+
+// Tcl type definition for caching the parse of a future handle.
+//
+// the internal representation is the future's id within its session in
+// ptr1 and the length of the session command name prefix in ptr2.  we
+// never invalidate the string representation so UpdateStringOf... is NULL
+// and there's nothing to free
+
+void DupFutureHandleInternalRep (Tcl_Obj *srcPtr, Tcl_Obj *copyPtr);
+int SetFutureHandleFromAny (Tcl_Interp *interp, Tcl_Obj *obj);
+
+Tcl_ObjType casstcl_futureHandleTclType = {
+  "casstcl_future_handle",
+  NULL,
+  DupFutureHandleInternalRep,
+  NULL,
+  SetFutureHandleFromAny
+};
+
+void
+DupFutureHandleInternalRep (Tcl_Obj *srcPtr, Tcl_Obj *copyPtr)
+{
+	copyPtr->internalRep.twoPtrValue = srcPtr->internalRep.twoPtrValue;
+	copyPtr->typePtr = &casstcl_futureHandleTclType;
+}
+
+// parse "sessionCommand#id" into its parts
+int
+SetFutureHandleFromAny (Tcl_Interp *interp, Tcl_Obj *obj)
+{
+	char *string = Tcl_GetString (obj);
+	char *separator = strrchr (string, CASSTCL_FUTURE_HANDLE_SEPARATOR);
+	char *end;
+
+	if (separator == NULL || separator == string || separator[1] == '\0') {
+		goto bad_handle;
+	}
+
+	errno = 0;
+	unsigned long id = strtoul (separator + 1, &end, 10);
+	if (*end != '\0' || errno != 0) {
+		goto bad_handle;
+	}
+
+	if (obj->typePtr != NULL && obj->typePtr->freeIntRepProc != NULL) {
+		obj->typePtr->freeIntRepProc (obj);
+	}
+
+	obj->internalRep.twoPtrValue.ptr1 = (void *)id;
+	obj->internalRep.twoPtrValue.ptr2 = (void *)(long)(separator - string);
+	obj->typePtr = &casstcl_futureHandleTclType;
+	return TCL_OK;
+
+  bad_handle:
+	if (interp != NULL) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "malformed future handle '", string, "'", NULL);
+	}
+	return TCL_ERROR;
+}
+
 /* vim: set ts=4 sw=4 sts=4 noet : */
@@ -53,6 +53,87 @@ int casstcl_future_eventProc (Tcl_Event *tevPtr, int flags);
  */
 void casstcl_future_callback (CassFuture* future, void* data);
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_wait_notify --
+ *
+ *    wake up any threads sleeping in wait_any or wait_all.  called from
+ *    the cpp-driver's threads whenever a future completes that casstcl
+ *    has a callback on.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_wait_notify ();
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_fireforget_eventProc --
+ *
+ *    this routine is called by the Tcl event handler when a
+ *    fire-and-forget request has failed and the session's error
+ *    callback rate limit let it through
+ *
+ * Results:
+ *    If the session has a fireforget callback, a future object (or
+ *    handle) is created for the failed request and the callback is
+ *    invoked with it as its argument.  The callback owns the future
+ *    and should delete it.  Without a callback the future is simply
+ *    freed.
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_fireforget_eventProc (Tcl_Event *tevPtr, int flags);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_fireforget_callback, casstcl_fireforget_handle_callback --
+ *
+ *    the callbacks set on fire-and-forget futures with
+ *    cass_future_set_callback.  the data pointer is the session, so
+ *    nothing needs to be allocated per request; which one is used
+ *    decides whether a failure reaches Tcl as a future command or a
+ *    future handle.
+ *
+ *----------------------------------------------------------------------
+ */
+void casstcl_fireforget_callback (CassFuture* future, void* data);
+
+void casstcl_fireforget_handle_callback (CassFuture* future, void* data);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_fireforget --
+ *
+ *    arrange for a future to be handled fire-and-forget: the future is
+ *    never seen by Tcl unless it fails
+ *
+ * Results:
+ *    The request is counted as issued in the session's write stats.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_fireforget (casstcl_sessionClientData *ct, CassFuture *future, int flags);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_fireforget_execute --
+ *
+ *    send a statement fire-and-forget, taking ownership of it.  if a
+ *    rate limit holds the request back, it's sent when the limit
+ *    allows.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_fireforget_execute (casstcl_sessionClientData *ct, CassStatement *statement, Tcl_Obj *tableNameObj, int flags);
+
 /*
  *----------------------------------------------------------------------
  *
@@ -64,6 +145,20 @@ void casstcl_future_callback (CassFuture* future, void* data);
  *    "future17" that can be invoked with method arguments to access,
  *    manipulate and destroy cassandra future objects.
  *
+ *    this doesn't wait for the request.  if it fails, the error is
+ *    reported by the future's status, error_message, foreach and rows
+ *    methods, and the callback, if any, is invoked all the same.
+ *
+ *    if flags includes CASSTCL_FUTURE_BREAKER the outcome of the request
+ *    is recorded against the circuit breaker of tableNameObj (if not NULL)
+ *    and the session's when the callback is delivered or, without a
+ *    callback, when the future is first seen to be ready
+ *
+ *    the time from now until the request completes is counted in the
+ *    latency histograms named in latencyKeysObj, if not NULL, and
+ *    checked against the slow query log's threshold with the request
+ *    described by slowlogObj, if not NULL
+ *
  * Results:
  *    A standard Tcl result
  *
@@ -73,15 +168,70 @@ int casstcl_createFutureObjectCommand (
 	casstcl_sessionClientData *ct, 
 	CassFuture *future, 
 	Tcl_Obj *callbackObj, 
-	int flags);
+	int flags,
+	Tcl_Obj *tableNameObj,
+	Tcl_Obj *latencyKeysObj,
+	Tcl_Obj *slowlogObj);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_execute --
+ *
+ *    send a statement and create a future object (or handle) for it as
+ *    casstcl_createFutureObjectCommand does, taking ownership of the
+ *    statement.  if a rate limit holds the request back, the future is
+ *    created right away all the same and the request is sent when the
+ *    limit allows.  until then the future isn't ready, and waiting on
+ *    it sends it as soon as there's a token for it.  deleting it throws
+ *    the request away.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_future_execute (
+	casstcl_sessionClientData *ct,
+	CassStatement *statement,
+	Tcl_Obj *callbackObj,
+	int flags,
+	Tcl_Obj *tableNameObj,
+	Tcl_Obj *latencyKeysObj,
+	Tcl_Obj *slowlogObj);
 
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_futureMethod --
+ *
+ *    implements the methods of a future, shared by future object
+ *    commands like "future17 wait" and by future handles operated on
+ *    through "casstcl::future wait ::cass0#17"
+ *
+ *    objv[1] is the method name and the method's own arguments start
+ *    at objv[argBase]
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_futureMethod (
+	casstcl_futureClientData *fcd,
+	Tcl_Interp *interp,
+	int objc,
+	Tcl_Obj *CONST objv[],
+	int argBase);
+
 /*
  *----------------------------------------------------------------------
  *
  * casstcl_futureObjectObjCmd --
  *
  *    dispatches the subcommands of a casstcl future-handling command
+ *    by way of casstcl_futureObjectNRObjCmd
  *
  * Results:
  *    stuff
@@ -94,6 +244,25 @@ int casstcl_futureObjectObjCmd(
 	int objc, 
 	Tcl_Obj *CONST objv[]);
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_futureObjectNRObjCmd --
+ *
+ *    dispatches the subcommands of a casstcl future-handling command,
+ *    NRE-enabled so that "wait -coro" can yield
+ *
+ * Results:
+ *    stuff
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_futureObjectNRObjCmd(
+	ClientData cData, 
+	Tcl_Interp *interp, 
+	int objc, 
+	Tcl_Obj *CONST objv[]);
+
 
 /*
  *----------------------------------------------------------------------
@@ -121,6 +290,165 @@ int casstcl_iterate_over_future (
 	CassFuture *future, char *arrayName, 
 	Tcl_Obj *codeObj);
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_now_ms --
+ *
+ *      return the current time in milliseconds
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_WideInt
+casstcl_now_ms ();
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_now_us --
+ *
+ *      return the current time in microseconds
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_WideInt
+casstcl_now_us ();
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_result_bytes --
+ *
+ *      return the number of bytes of result data a future is holding
+ *      onto, taken to be the encoded size of its column values.  this
+ *      is only known once the future is ready; until then, and for
+ *      futures without a result, it is zero.  the size is computed the
+ *      first time it's asked for and remembered.
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_WideInt
+casstcl_future_result_bytes (casstcl_futureClientData *fcd);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_futures_list --
+ *
+ *      set the caller's object pointer to a list of the names of the
+ *      session's futures, either all of them or only those that are
+ *      pending or ready, according to the which argument
+ *
+ * Results:
+ *      A standard Tcl result.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_futures_list (casstcl_sessionClientData *ct, int which, Tcl_Obj **listObjPtr);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_stats --
+ *
+ *      set the interpreter result to a list of key-value pairs
+ *      describing the session's futures: how many there are, how many
+ *      are pending and ready, how many bytes of results they are holding
+ *      and how many have been reclaimed by the session's policy
+ *
+ * Results:
+ *      A standard Tcl result.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_future_stats (Tcl_Interp *interp, casstcl_sessionClientData *ct);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_sweep --
+ *
+ *      timer handler that deletes futures older than the session's
+ *      maximum future age, then reschedules itself.  futures that are
+ *      still pending, or whose callback hasn't been invoked yet, are
+ *      left alone no matter how old they are.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_future_sweep (ClientData clientData);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_set_max_age --
+ *
+ *      set the age in milliseconds after which the session's ready
+ *      futures are deleted automatically, zero meaning never, and
+ *      (re)schedule or cancel the sweep accordingly.  the sweep runs
+ *      at half the age, but at least every second.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_future_set_max_age (casstcl_sessionClientData *ct, int maxAge);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_rows --
+ *
+ *      Given a casstcl client data structure and a completed cassandra
+ *      cpp-driver CassFuture object, set the caller's object pointer to
+ *      a list of the rows of the result, each row being a list of
+ *      column name and value pairs like "array get" produces.  As with
+ *      foreach, null columns are omitted.
+ *
+ * Results:
+ *      A standard Tcl result.
+ *
+ * Note that it is up to the caller to free the future.
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_future_rows (
+	casstcl_sessionClientData *ct,
+	CassFuture *future,
+	Tcl_Obj **listObjPtr);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_name_obj --
+ *
+ *    return a new Tcl object naming the future, either the fully
+ *    qualified name of its object command or, for futures created
+ *    with -handle, its handle
+ *
+ * Results:
+ *    A Tcl object with a reference count of zero
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Obj *casstcl_future_name_obj (casstcl_futureClientData *fcd);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_delete --
+ *
+ *    delete a future, whether it is a future object command or a
+ *    future handle
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int casstcl_future_delete (casstcl_futureClientData *fcd);
+
 /*
  *--------------------------------------------------------------
  *
@@ -154,4 +482,87 @@ void casstcl_futureObjectDelete (ClientData clientData);
  */
 casstcl_futureClientData * casstcl_future_command_to_futureClientData (Tcl_Interp *interp, char *futureCommandName);
 
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_future_handle_to_futureClientData -- given a future handle
+ *   like ::cass0#17, find the session it belongs to and return a pointer
+ *   to the future's client data from the session's table or NULL
+ *
+ * Results:
+ *
+ * Side effects:
+ *      The handle object is converted to casstcl_futureHandleTclType.
+ *
+ *--------------------------------------------------------------
+ */
+casstcl_futureClientData * casstcl_future_handle_to_futureClientData (Tcl_Interp *interp, Tcl_Obj *handleObj);
+
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_obj_to_futureClientData -- given an object holding
+ *   either a future object command name or a future handle, return
+ *   a pointer to its future client data or NULL
+ *
+ *--------------------------------------------------------------
+ */
+casstcl_futureClientData *
+casstcl_obj_to_futureClientData (Tcl_Interp *interp, Tcl_Obj *futureObj);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_wait_futures --
+ *
+ *    implements casstcl::wait_all and casstcl::wait_any, which take
+ *    ?-timeout us? futureList and block until all (or any) of the
+ *    futures are ready or the timeout expires.  the list may mix future
+ *    object commands and future handles.
+ *
+ *    rather than polling, the thread sleeps on a condition variable
+ *    that is notified from the driver callbacks.  futures that don't
+ *    have a callback get one that does nothing but notify.
+ *
+ * Results:
+ *    A standard Tcl result.  The result is a list of the futures that
+ *    are ready, in the order given, which on timeout may be fewer than
+ *    wanted, or none.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_wait_futures (Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[], int waitAll);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_wait_watch --
+ *
+ *    set a callback on a future casstcl issued for its own use (one
+ *    that never gets a future command or handle) so that
+ *    casstcl_wait_for_ready notices when it completes
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_wait_watch (CassFuture *future);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_wait_for_ready --
+ *
+ *    given an array of futures, some of which may be NULL, sleep until
+ *    at least one of them is ready.  the futures must have been passed
+ *    to casstcl_wait_watch (or otherwise have a casstcl callback).
+ *
+ * Results:
+ *    The index of a ready future, or -1 if all of them are NULL
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_wait_for_ready (CassFuture **futures, int count);
+
 /* vim: set ts=4 sw=4 sts=4 noet : */
@@ -0,0 +1,412 @@
+/*
+ * casstcl_latency - Functions used to keep latency histograms of the
+ *   requests made through a session, per tag, prepared statement and
+ *   table
+ *
+ * casstcl - Tcl interface to CassDB
+ *
+ * Copyright (C) 2014 FlightAware LLC
+ *
+ * freely redistributable under the Berkeley license
+ */
+
+#include "casstcl.h"
+#include "casstcl_latency.h"
+#include "casstcl_prepared.h"
+
+#include <math.h>
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_latency_bucket --
+ *
+ *    find the histogram bucket a latency in microseconds is counted in.
+ *    latencies below CASSTCL_LATENCY_SUB_BUCKETS get a bucket each,
+ *    after that every power of two is split into that many buckets, so
+ *    a bucket is never wider than 1/CASSTCL_LATENCY_SUB_BUCKETS of the
+ *    latencies in it.  latencies too large for the last bucket are
+ *    counted in it.
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_latency_bucket (Tcl_WideInt us)
+{
+	int shift = 0;
+	int bucket;
+
+	if (us < CASSTCL_LATENCY_SUB_BUCKETS) {
+		return (us < 0) ? 0 : (int)us;
+	}
+
+	while ((us >> shift) >= 2 * CASSTCL_LATENCY_SUB_BUCKETS) {
+		shift++;
+	}
+
+	bucket = CASSTCL_LATENCY_SUB_BUCKETS * (shift + 1) + (int)((us >> shift) - CASSTCL_LATENCY_SUB_BUCKETS);
+	return (bucket < CASSTCL_LATENCY_BUCKETS) ? bucket : CASSTCL_LATENCY_BUCKETS - 1;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_latency_bucket_value --
+ *
+ *    return the largest latency in microseconds counted in a bucket
+ *
+ *----------------------------------------------------------------------
+ */
+static Tcl_WideInt
+casstcl_latency_bucket_value (int bucket)
+{
+	int shift;
+	int sub;
+
+	if (bucket < CASSTCL_LATENCY_SUB_BUCKETS) {
+		return bucket;
+	}
+
+	shift = bucket / CASSTCL_LATENCY_SUB_BUCKETS - 1;
+	sub = bucket % CASSTCL_LATENCY_SUB_BUCKETS;
+	return (((Tcl_WideInt)(CASSTCL_LATENCY_SUB_BUCKETS + sub + 1)) << shift) - 1;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_histogram_record --
+ *
+ *    count a latency in microseconds in a histogram
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_histogram_record (casstcl_histogram *histogram, Tcl_WideInt us)
+{
+	if (us < 0) {
+		us = 0;
+	}
+
+	if (histogram->count == 0 || us < histogram->min) {
+		histogram->min = us;
+	}
+
+	if (us > histogram->max) {
+		histogram->max = us;
+	}
+
+	histogram->count++;
+	histogram->sum += (double)us;
+	histogram->sumSquares += (double)us * (double)us;
+	histogram->buckets[casstcl_latency_bucket (us)]++;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_histogram_percentile --
+ *
+ *    return the latency in microseconds that percentile percent of the
+ *    latencies counted in a histogram are at or below, to within the
+ *    width of its bucket
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_WideInt
+casstcl_histogram_percentile (casstcl_histogram *histogram, double percentile)
+{
+	Tcl_WideInt target;
+	Tcl_WideInt seen = 0;
+	int bucket;
+
+	if (histogram->count == 0) {
+		return 0;
+	}
+
+	target = (Tcl_WideInt)ceil (histogram->count * percentile / 100.0);
+	if (target < 1) {
+		target = 1;
+	}
+
+	for (bucket = 0; bucket < CASSTCL_LATENCY_BUCKETS; bucket++) {
+		seen += histogram->buckets[bucket];
+		if (seen >= target) {
+			Tcl_WideInt value = casstcl_latency_bucket_value (bucket);
+
+			if (value > histogram->max) {
+				return histogram->max;
+			}
+			return (value < histogram->min) ? histogram->min : value;
+		}
+	}
+
+	return histogram->max;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_histogram_to_list --
+ *
+ *    return a new list of key-value pairs of a histogram's count and,
+ *    in microseconds, its min, max, mean, standard deviation, median
+ *    and percentiles, named like the cpp-driver's own metrics
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Obj *
+casstcl_histogram_to_list (casstcl_histogram *histogram)
+{
+	Tcl_Obj *listObj = Tcl_NewObj ();
+	Tcl_WideInt mean = 0;
+	Tcl_WideInt stddev = 0;
+	size_t i;
+
+	static CONST char *percentileNames[] = {
+		"median",
+		"percentile_75th",
+		"percentile_95th",
+		"percentile_98th",
+		"percentile_99th",
+		"percentile_999th"
+	};
+
+	static double percentiles[] = {50.0, 75.0, 95.0, 98.0, 99.0, 99.9};
+
+	if (histogram->count > 0) {
+		double meanValue = histogram->sum / histogram->count;
+		double variance = histogram->sumSquares / histogram->count - meanValue * meanValue;
+
+		mean = (Tcl_WideInt)meanValue;
+		stddev = (variance > 0) ? (Tcl_WideInt)sqrt (variance) : 0;
+	}
+
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("count", -1));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (histogram->count));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("min", -1));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (histogram->min));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("max", -1));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (histogram->max));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("mean", -1));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (mean));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("stddev", -1));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (stddev));
+
+	for (i = 0; i < sizeof (percentiles) / sizeof (percentiles[0]); i++) {
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj (percentileNames[i], -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (casstcl_histogram_percentile (histogram, percentiles[i])));
+	}
+
+	return listObj;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_latency_keys_from_objv --
+ *
+ *    work out the histograms a request made with the arguments of
+ *    async, exec or select is counted in: "tag:" and its -tag, if
+ *    given, "prepared:" and the name of its -prepared statement and
+ *    "table:" and its table, from an upsert, -table or the prepared
+ *    statement.  objv and arg are as they are passed to
+ *    casstcl_make_statement_from_objv or, for an upsert, objv holds the
+ *    upsert's arguments.  with an objc of 0 only the tag is used.
+ *
+ * Results:
+ *    A new list of the keys, with a reference count of zero, or NULL if
+ *    the request isn't counted anywhere
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Obj *
+casstcl_latency_keys_from_objv (casstcl_sessionClientData *ct, Tcl_Obj *tagObj, int objc, Tcl_Obj *CONST objv[], int arg, int upsert)
+{
+	Tcl_Obj *keysObj = NULL;
+	Tcl_Obj *preparedObj = NULL;
+	Tcl_Obj *tableNameObj = NULL;
+
+	if (upsert) {
+		tableNameObj = (objc >= 2) ? objv[objc - 2] : NULL;
+	} else {
+		while (arg + 1 < objc) {
+			char *optionString = Tcl_GetString (objv[arg]);
+
+			if (*optionString != '-') {
+				break;
+			}
+
+			// the only option without a value
+			if (strcmp (optionString, "-idempotent") == 0) {
+				arg++;
+				continue;
+			}
+
+			if (strcmp (optionString, "-table") == 0) {
+				tableNameObj = objv[arg + 1];
+			} else if (strcmp (optionString, "-prepared") == 0) {
+				casstcl_preparedClientData *pcd = casstcl_prepared_command_to_preparedClientData (ct->interp, Tcl_GetString (objv[arg + 1]));
+
+				preparedObj = objv[arg + 1];
+				if (pcd != NULL && tableNameObj == NULL) {
+					tableNameObj = pcd->tableNameObj;
+				}
+			}
+
+			arg += 2;
+		}
+	}
+
+	if (tagObj == NULL && preparedObj == NULL && tableNameObj == NULL) {
+		return NULL;
+	}
+
+	keysObj = Tcl_NewObj ();
+	if (tagObj != NULL) {
+		Tcl_ListObjAppendElement (NULL, keysObj, Tcl_ObjPrintf ("tag:%s", Tcl_GetString (tagObj)));
+	}
+
+	if (preparedObj != NULL) {
+		Tcl_ListObjAppendElement (NULL, keysObj, Tcl_ObjPrintf ("prepared:%s", Tcl_GetString (preparedObj)));
+	}
+
+	if (tableNameObj != NULL) {
+		Tcl_ListObjAppendElement (NULL, keysObj, Tcl_ObjPrintf ("table:%s", Tcl_GetString (tableNameObj)));
+	}
+
+	return keysObj;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_latency_record --
+ *
+ *    count a request that took us microseconds in the session's
+ *    histograms named in keysObj, as made by
+ *    casstcl_latency_keys_from_objv, creating them as needed.  keysObj
+ *    may be NULL.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_latency_record (casstcl_sessionClientData *ct, Tcl_Obj *keysObj, Tcl_WideInt us)
+{
+	Tcl_Obj **keysObjv;
+	int keysObjc;
+	int i;
+
+	if (keysObj == NULL || Tcl_ListObjGetElements (NULL, keysObj, &keysObjc, &keysObjv) == TCL_ERROR) {
+		return;
+	}
+
+	for (i = 0; i < keysObjc; i++) {
+		int isNew;
+		Tcl_HashEntry *entry = Tcl_CreateHashEntry (&ct->latencyTable, Tcl_GetString (keysObjv[i]), &isNew);
+		casstcl_histogram *histogram;
+
+		if (isNew) {
+			histogram = (casstcl_histogram *)ckalloc (sizeof (casstcl_histogram));
+			memset (histogram, 0, sizeof (casstcl_histogram));
+			Tcl_SetHashValue (entry, histogram);
+		} else {
+			histogram = (casstcl_histogram *)Tcl_GetHashValue (entry);
+		}
+
+		casstcl_histogram_record (histogram, us);
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_latency --
+ *
+ *    implements the latency method of a session,
+ *
+ *      latency ?-reset? ?key?
+ *
+ *    with a key, return the statistics of that histogram, or of an
+ *    empty one if nothing has been counted in it.  without, return a
+ *    list of each key and its statistics.  -reset empties the histograms
+ *    returned.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_latency (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Interp *interp = ct->interp;
+	int arg = 2;
+	int reset = 0;
+
+	if (arg < objc && strcmp (Tcl_GetString (objv[arg]), "-reset") == 0) {
+		reset = 1;
+		arg++;
+	}
+
+	if (objc - arg > 1) {
+		Tcl_WrongNumArgs (interp, 2, objv, "?-reset? ?key?");
+		return TCL_ERROR;
+	}
+
+	if (arg < objc) {
+		Tcl_HashEntry *entry = Tcl_FindHashEntry (&ct->latencyTable, Tcl_GetString (objv[arg]));
+		casstcl_histogram empty;
+
+		if (entry == NULL) {
+			memset (&empty, 0, sizeof (empty));
+			Tcl_SetObjResult (interp, casstcl_histogram_to_list (&empty));
+			return TCL_OK;
+		}
+
+		Tcl_SetObjResult (interp, casstcl_histogram_to_list ((casstcl_histogram *)Tcl_GetHashValue (entry)));
+		if (reset) {
+			ckfree ((char *)Tcl_GetHashValue (entry));
+			Tcl_DeleteHashEntry (entry);
+		}
+	} else {
+		Tcl_Obj *listObj = Tcl_NewObj ();
+		Tcl_HashSearch search;
+		Tcl_HashEntry *entry;
+
+		for (entry = Tcl_FirstHashEntry (&ct->latencyTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj (Tcl_GetHashKey (&ct->latencyTable, entry), -1));
+			Tcl_ListObjAppendElement (NULL, listObj, casstcl_histogram_to_list ((casstcl_histogram *)Tcl_GetHashValue (entry)));
+			if (reset) {
+				ckfree ((char *)Tcl_GetHashValue (entry));
+				Tcl_DeleteHashEntry (entry);
+			}
+		}
+		Tcl_SetObjResult (interp, listObj);
+	}
+
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_latency_forget_all --
+ *
+ *    free a session's latency histograms when it's deleted
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_latency_forget_all (casstcl_sessionClientData *ct)
+{
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+
+	for (entry = Tcl_FirstHashEntry (&ct->latencyTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+		ckfree ((char *)Tcl_GetHashValue (entry));
+	}
+	Tcl_DeleteHashTable (&ct->latencyTable);
+}
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
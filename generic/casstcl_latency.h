@@ -0,0 +1,122 @@
+/*
+ *
+ * Include file for latency
+ *
+ * Copyright (C) 2015 by FlightAware, All Rights Reserved
+ *
+ * Freely redistributable under the Berkeley copyright, see license.terms
+ * for details.
+ */
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_histogram_record --
+ *
+ *    count a latency in microseconds in a histogram
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_histogram_record (casstcl_histogram *histogram, Tcl_WideInt us);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_histogram_percentile --
+ *
+ *    return the latency in microseconds that percentile percent of the
+ *    latencies counted in a histogram are at or below, to within the
+ *    width of its bucket
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_WideInt
+casstcl_histogram_percentile (casstcl_histogram *histogram, double percentile);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_histogram_to_list --
+ *
+ *    return a new list of key-value pairs of a histogram's count and,
+ *    in microseconds, its min, max, mean, standard deviation, median
+ *    and percentiles, named like the cpp-driver's own metrics
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Obj *
+casstcl_histogram_to_list (casstcl_histogram *histogram);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_latency_keys_from_objv --
+ *
+ *    work out the histograms a request made with the arguments of
+ *    async, exec or select is counted in: "tag:" and its -tag, if
+ *    given, "prepared:" and the name of its -prepared statement and
+ *    "table:" and its table, from an upsert, -table or the prepared
+ *    statement.  objv and arg are as they are passed to
+ *    casstcl_make_statement_from_objv or, for an upsert, objv holds the
+ *    upsert's arguments.  with an objc of 0 only the tag is used.
+ *
+ * Results:
+ *    A new list of the keys, with a reference count of zero, or NULL if
+ *    the request isn't counted anywhere
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Obj *
+casstcl_latency_keys_from_objv (casstcl_sessionClientData *ct, Tcl_Obj *tagObj, int objc, Tcl_Obj *CONST objv[], int arg, int upsert);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_latency_record --
+ *
+ *    count a request that took us microseconds in the session's
+ *    histograms named in keysObj, as made by
+ *    casstcl_latency_keys_from_objv, creating them as needed.  keysObj
+ *    may be NULL.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_latency_record (casstcl_sessionClientData *ct, Tcl_Obj *keysObj, Tcl_WideInt us);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_latency --
+ *
+ *    implements the latency method of a session,
+ *
+ *      latency ?-reset? ?key?
+ *
+ *    with a key, return the statistics of that histogram, or of an
+ *    empty one if nothing has been counted in it.  without, return a
+ *    list of each key and its statistics.  -reset empties the histograms
+ *    returned.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_latency (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[]);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_latency_forget_all --
+ *
+ *    free a session's latency histograms when it's deleted
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_latency_forget_all (casstcl_sessionClientData *ct);
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
@@ -118,6 +118,10 @@ casstcl_bind_names_from_prepared (casstcl_preparedClientData *pcd, int objc, Tcl
 		return TCL_ERROR;
 	}
 
+	if (pcd->idempotent) {
+		cass_statement_set_is_idempotent (statement, cass_true);
+	}
+
 //printf("objc = %d\n", objc);
 	for (i = 0; i < objc; i += 2) {
 // printf("i = %d, objv[i] = '%s', objc = %d\n", i, Tcl_GetString(objv[i]), objc);
@@ -0,0 +1,319 @@
+/*
+ * casstcl_profile - Functions used to define named execution profiles,
+ *   which give requests their own consistency, timeout, retry policy and
+ *   routing
+ *
+ * casstcl - Tcl interface to CassDB
+ *
+ * Copyright (C) 2014 FlightAware LLC
+ *
+ * freely redistributable under the Berkeley license
+ */
+
+#include "casstcl.h"
+#include "casstcl_profile.h"
+#include "casstcl_consistency.h"
+#include "casstcl_error.h"
+#include "casstcl_retry.h"
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_profile_from_objv --
+ *
+ *    set up a cpp-driver execution profile from option value pairs
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_profile_from_objv (casstcl_sessionClientData *ct, CassExecProfile *profile, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Interp *interp = ct->interp;
+	int arg;
+
+	static CONST char *subOptions[] = {
+		"-request_timeout",
+		"-consistency",
+		"-serial_consistency",
+		"-retry",
+		"-dc_aware",
+		NULL
+	};
+
+	enum subOptions {
+		SUBOPT_REQUEST_TIMEOUT,
+		SUBOPT_CONSISTENCY,
+		SUBOPT_SERIAL_CONSISTENCY,
+		SUBOPT_RETRY,
+		SUBOPT_DC_AWARE
+	};
+
+	if (objc & 1) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "profile options must be given as option value pairs", NULL);
+		return TCL_ERROR;
+	}
+
+	for (arg = 0; arg < objc; arg += 2) {
+		CassError cassError = CASS_OK;
+		int subOptIndex;
+
+		if (Tcl_GetIndexFromObj (interp, objv[arg], subOptions, "subOption", TCL_EXACT, &subOptIndex) != TCL_OK) {
+			return TCL_ERROR;
+		}
+
+		switch ((enum subOptions) subOptIndex) {
+			case SUBOPT_REQUEST_TIMEOUT: {
+				Tcl_WideInt timeoutMS;
+
+				if (Tcl_GetWideIntFromObj (interp, objv[arg + 1], &timeoutMS) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting request_timeout", NULL);
+					return TCL_ERROR;
+				}
+
+				if (timeoutMS < 0) {
+					Tcl_ResetResult (interp);
+					Tcl_AppendResult (interp, "profile -request_timeout can't be negative", NULL);
+					return TCL_ERROR;
+				}
+
+				cassError = cass_execution_profile_set_request_timeout (profile, (cass_uint64_t)timeoutMS);
+				break;
+			}
+
+			case SUBOPT_CONSISTENCY: {
+				CassConsistency consistency;
+
+				if (casstcl_obj_to_cass_consistency (ct, objv[arg + 1], &consistency) == TCL_ERROR) {
+					return TCL_ERROR;
+				}
+
+				cassError = cass_execution_profile_set_consistency (profile, consistency);
+				break;
+			}
+
+			case SUBOPT_SERIAL_CONSISTENCY: {
+				CassConsistency consistency;
+
+				if (casstcl_obj_to_cass_consistency (ct, objv[arg + 1], &consistency) == TCL_ERROR) {
+					return TCL_ERROR;
+				}
+
+				if (consistency != CASS_CONSISTENCY_SERIAL && consistency != CASS_CONSISTENCY_LOCAL_SERIAL) {
+					Tcl_ResetResult (interp);
+					Tcl_AppendResult (interp, "profile -serial_consistency must be serial or local_serial", NULL);
+					return TCL_ERROR;
+				}
+
+				cassError = cass_execution_profile_set_serial_consistency (profile, consistency);
+				break;
+			}
+
+			case SUBOPT_RETRY: {
+				CassRetryPolicy *policy;
+
+				if (casstcl_obj_to_retry_policy (interp, objv[arg + 1], &policy) == TCL_ERROR) {
+					return TCL_ERROR;
+				}
+
+				// the profile keeps its own reference
+				cassError = cass_execution_profile_set_retry_policy (profile, policy);
+				cass_retry_policy_free (policy);
+				break;
+			}
+
+			case SUBOPT_DC_AWARE: {
+				cassError = cass_execution_profile_set_load_balance_dc_aware (profile, Tcl_GetString (objv[arg + 1]), 0, cass_false);
+				break;
+			}
+		}
+
+		if (cassError != CASS_OK) {
+			return casstcl_cass_error_to_tcl (ct, cassError);
+		}
+	}
+
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_profile --
+ *
+ *    implements the profile method of a session,
+ *
+ *      profile create name ?-request_timeout ms? ?-consistency level?
+ *          ?-serial_consistency level? ?-retry policy? ?-dc_aware dc?
+ *      profile configure name
+ *      profile names
+ *
+ *    profiles are part of the cluster's configuration, so like the
+ *    other cluster settings they have to be created before connecting.
+ *    creating a profile that already exists replaces it.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_profile (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Interp *interp = ct->interp;
+	int optIndex;
+
+	static CONST char *options[] = {
+		"create",
+		"configure",
+		"names",
+		NULL
+	};
+
+	enum options {
+		OPT_CREATE,
+		OPT_CONFIGURE,
+		OPT_NAMES
+	};
+
+	if (objc < 3) {
+		Tcl_WrongNumArgs (interp, 2, objv, "subcommand ?args?");
+		return TCL_ERROR;
+	}
+
+	if (Tcl_GetIndexFromObj (interp, objv[2], options, "subcommand", TCL_EXACT, &optIndex) != TCL_OK) {
+		return TCL_ERROR;
+	}
+
+	switch ((enum options) optIndex) {
+		case OPT_CREATE: {
+			CassExecProfile *profile;
+			CassError cassError;
+			Tcl_HashEntry *entry;
+			Tcl_Obj *optionsObj;
+			int isNew;
+
+			if (objc < 4) {
+				Tcl_WrongNumArgs (interp, 3, objv, "name ?-request_timeout ms? ?-consistency level? ?-serial_consistency level? ?-retry policy? ?-dc_aware dc?");
+				return TCL_ERROR;
+			}
+
+			profile = cass_execution_profile_new ();
+			if (casstcl_profile_from_objv (ct, profile, objc - 4, &objv[4]) == TCL_ERROR) {
+				cass_execution_profile_free (profile);
+				return TCL_ERROR;
+			}
+
+			// the cluster keeps a copy
+			cassError = cass_cluster_set_execution_profile (ct->cluster, Tcl_GetString (objv[3]), profile);
+			cass_execution_profile_free (profile);
+			if (cassError != CASS_OK) {
+				return casstcl_cass_error_to_tcl (ct, cassError);
+			}
+
+			optionsObj = Tcl_NewListObj (objc - 4, &objv[4]);
+			Tcl_IncrRefCount (optionsObj);
+
+			entry = Tcl_CreateHashEntry (&ct->profileTable, Tcl_GetString (objv[3]), &isNew);
+			if (!isNew) {
+				Tcl_DecrRefCount ((Tcl_Obj *)Tcl_GetHashValue (entry));
+			}
+			Tcl_SetHashValue (entry, optionsObj);
+
+			Tcl_SetObjResult (interp, objv[3]);
+			break;
+		}
+
+		case OPT_CONFIGURE: {
+			Tcl_HashEntry *entry;
+
+			if (objc != 4) {
+				Tcl_WrongNumArgs (interp, 3, objv, "name");
+				return TCL_ERROR;
+			}
+
+			if (casstcl_profile_check (ct, objv[3]) == TCL_ERROR) {
+				return TCL_ERROR;
+			}
+
+			entry = Tcl_FindHashEntry (&ct->profileTable, Tcl_GetString (objv[3]));
+			Tcl_SetObjResult (interp, (Tcl_Obj *)Tcl_GetHashValue (entry));
+			break;
+		}
+
+		case OPT_NAMES: {
+			Tcl_Obj *listObj = Tcl_NewObj ();
+			Tcl_HashSearch search;
+			Tcl_HashEntry *entry;
+
+			if (objc != 3) {
+				Tcl_WrongNumArgs (interp, 3, objv, "");
+				return TCL_ERROR;
+			}
+
+			for (entry = Tcl_FirstHashEntry (&ct->profileTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+				Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj (Tcl_GetHashKey (&ct->profileTable, entry), -1));
+			}
+			Tcl_SetObjResult (interp, listObj);
+			break;
+		}
+	}
+
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_profile_check --
+ *
+ *    make sure a profile named by a -profile option exists, since the
+ *    cpp-driver would only say so when the request fails
+ *
+ * Results:
+ *    A standard Tcl result.  An unknown profile is an error with an
+ *    errorCode of CASSTCL UNKNOWN_PROFILE and the name.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_profile_check (casstcl_sessionClientData *ct, Tcl_Obj *profileObj)
+{
+	Tcl_Interp *interp = ct->interp;
+	char *profileName = Tcl_GetString (profileObj);
+
+	if (Tcl_FindHashEntry (&ct->profileTable, profileName) != NULL) {
+		return TCL_OK;
+	}
+
+	Tcl_ResetResult (interp);
+	Tcl_SetErrorCode (interp, "CASSTCL", "UNKNOWN_PROFILE", profileName, NULL);
+	Tcl_AppendResult (interp, "unknown execution profile \"", profileName, "\"", NULL);
+	return TCL_ERROR;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_profile_forget_all --
+ *
+ *    forget a session's execution profiles when it's deleted
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_profile_forget_all (casstcl_sessionClientData *ct)
+{
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+
+	for (entry = Tcl_FirstHashEntry (&ct->profileTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+		Tcl_DecrRefCount ((Tcl_Obj *)Tcl_GetHashValue (entry));
+	}
+	Tcl_DeleteHashTable (&ct->profileTable);
+}
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
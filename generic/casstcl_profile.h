@@ -0,0 +1,64 @@
+/*
+ *
+ * Include file for profile
+ *
+ * Copyright (C) 2015 by FlightAware, All Rights Reserved
+ *
+ * Freely redistributable under the Berkeley copyright, see license.terms
+ * for details.
+ */
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_profile --
+ *
+ *    implements the profile method of a session,
+ *
+ *      profile create name ?-request_timeout ms? ?-consistency level?
+ *          ?-serial_consistency level? ?-retry policy? ?-dc_aware dc?
+ *      profile configure name
+ *      profile names
+ *
+ *    profiles are part of the cluster's configuration, so like the
+ *    other cluster settings they have to be created before connecting.
+ *    creating a profile that already exists replaces it.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_profile (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[]);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_profile_check --
+ *
+ *    make sure a profile named by a -profile option exists, since the
+ *    cpp-driver would only say so when the request fails
+ *
+ * Results:
+ *    A standard Tcl result.  An unknown profile is an error with an
+ *    errorCode of CASSTCL UNKNOWN_PROFILE and the name.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_profile_check (casstcl_sessionClientData *ct, Tcl_Obj *profileObj);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_profile_forget_all --
+ *
+ *    forget a session's execution profiles when it's deleted
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_profile_forget_all (casstcl_sessionClientData *ct);
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
@@ -0,0 +1,736 @@
+/*
+ * casstcl_ratelimit - Functions used to limit the rate requests are sent
+ *   to the cluster, for a whole session or for one table, with token
+ *   buckets
+ *
+ * casstcl - Tcl interface to CassDB
+ *
+ * Copyright (C) 2014 FlightAware LLC
+ *
+ * freely redistributable under the Berkeley license
+ */
+
+#include "casstcl.h"
+#include "casstcl_ratelimit.h"
+#include "casstcl_prepared.h"
+#include "casstcl_future.h"
+
+#include <assert.h>
+
+static void casstcl_rate_limit_timer_proc (ClientData clientData);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_refill --
+ *
+ *    add the tokens a bucket has earned since it was last refilled, up
+ *    to its burst
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_rate_limit_refill (casstcl_rateLimit *limit, Tcl_WideInt now)
+{
+	limit->tokens += (now - limit->updated) * limit->rate / 1000000.0;
+	if (limit->tokens > limit->burst) {
+		limit->tokens = limit->burst;
+	}
+	limit->updated = now;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_wait_ms --
+ *
+ *    return how many milliseconds until a bucket has a whole token,
+ *    rounded up
+ *
+ *----------------------------------------------------------------------
+ */
+static Tcl_WideInt
+casstcl_rate_limit_wait_ms (casstcl_rateLimit *limit)
+{
+	if (limit->tokens >= 1.0) {
+		return 0;
+	}
+	return (Tcl_WideInt)((1.0 - limit->tokens) * 1000.0 / limit->rate) + 1;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_find --
+ *
+ *    return the session's bucket for a table, or NULL if the table
+ *    isn't limited or tableNameObj is NULL
+ *
+ *----------------------------------------------------------------------
+ */
+static casstcl_rateLimit *
+casstcl_rate_limit_find (casstcl_sessionClientData *ct, Tcl_Obj *tableNameObj)
+{
+	Tcl_HashEntry *entry;
+
+	if (tableNameObj == NULL || ct->rateLimitTable.numEntries == 0) {
+		return NULL;
+	}
+
+	entry = Tcl_FindHashEntry (&ct->rateLimitTable, Tcl_GetString (tableNameObj));
+	if (entry == NULL) {
+		return NULL;
+	}
+	return (casstcl_rateLimit *)Tcl_GetHashValue (entry);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_acquire --
+ *
+ *    take a token for a request to a table, which may be NULL if the
+ *    table isn't known, from the session's bucket and the table's, if
+ *    they're limited.  a token is only taken if both have one.
+ *
+ * Results:
+ *    0 if the request can be sent, otherwise the number of
+ *    milliseconds to wait before trying again
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_WideInt
+casstcl_rate_limit_acquire (casstcl_sessionClientData *ct, Tcl_Obj *tableNameObj)
+{
+	casstcl_rateLimit *sessionLimit = (ct->rateLimit.rate > 0) ? &ct->rateLimit : NULL;
+	casstcl_rateLimit *tableLimit = casstcl_rate_limit_find (ct, tableNameObj);
+	Tcl_WideInt now;
+	Tcl_WideInt wait = 0;
+
+	if (sessionLimit == NULL && tableLimit == NULL) {
+		return 0;
+	}
+
+	now = casstcl_now_us ();
+
+	if (sessionLimit != NULL) {
+		casstcl_rate_limit_refill (sessionLimit, now);
+		if ((wait = casstcl_rate_limit_wait_ms (sessionLimit)) > 0) {
+			sessionLimit->throttled++;
+		}
+	}
+
+	if (tableLimit != NULL) {
+		Tcl_WideInt tableWait;
+
+		casstcl_rate_limit_refill (tableLimit, now);
+		if ((tableWait = casstcl_rate_limit_wait_ms (tableLimit)) > 0) {
+			tableLimit->throttled++;
+			if (tableWait > wait) {
+				wait = tableWait;
+			}
+		}
+	}
+
+	if (wait > 0) {
+		return wait;
+	}
+
+	if (sessionLimit != NULL) {
+		sessionLimit->tokens -= 1.0;
+	}
+	if (tableLimit != NULL) {
+		tableLimit->tokens -= 1.0;
+	}
+	return 0;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_charge --
+ *
+ *    take a token for a request that is sent without waiting, like a
+ *    batch flushed from a timer, even if it leaves the buckets short so
+ *    the requests after it wait to make up for it
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_rate_limit_charge (casstcl_sessionClientData *ct, Tcl_Obj *tableNameObj)
+{
+	casstcl_rateLimit *tableLimit = casstcl_rate_limit_find (ct, tableNameObj);
+	Tcl_WideInt now;
+
+	if (ct->rateLimit.rate == 0 && tableLimit == NULL) {
+		return;
+	}
+
+	now = casstcl_now_us ();
+
+	if (ct->rateLimit.rate > 0) {
+		casstcl_rate_limit_refill (&ct->rateLimit, now);
+		ct->rateLimit.tokens -= 1.0;
+	}
+
+	if (tableLimit != NULL) {
+		casstcl_rate_limit_refill (tableLimit, now);
+		tableLimit->tokens -= 1.0;
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_schedule --
+ *
+ *    arrange for a bucket's queue to be looked at again in ms
+ *    milliseconds, unless it's already going to be
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_rate_limit_schedule (casstcl_rateLimit *limit, Tcl_WideInt ms)
+{
+	if (limit->timer == NULL) {
+		limit->timer = Tcl_CreateTimerHandler ((int)ms, casstcl_rate_limit_timer_proc, (ClientData)limit);
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_unlink --
+ *
+ *    take a held request out of its bucket's queue
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_rate_limit_unlink (casstcl_rateLimitHeld *held)
+{
+	casstcl_rateLimit *limit = held->limit;
+	casstcl_rateLimitHeld **heldPtr = &limit->heldHead;
+	casstcl_rateLimitHeld *prev = NULL;
+
+	while (*heldPtr != held) {
+		prev = *heldPtr;
+		heldPtr = &prev->next;
+	}
+
+	*heldPtr = held->next;
+	if (limit->heldTail == held) {
+		limit->heldTail = prev;
+	}
+	held->next = NULL;
+
+	if (limit->heldHead == NULL && limit->timer != NULL) {
+		Tcl_DeleteTimerHandler (limit->timer);
+		limit->timer = NULL;
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_append --
+ *
+ *    add a held request to the end of a bucket's queue
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_rate_limit_append (casstcl_rateLimit *limit, casstcl_rateLimitHeld *held)
+{
+	held->limit = limit;
+	held->next = NULL;
+
+	if (limit->heldTail == NULL) {
+		limit->heldHead = held;
+	} else {
+		limit->heldTail->next = held;
+	}
+	limit->heldTail = held;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_free_held --
+ *
+ *    free a held request that's out of its queue
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_rate_limit_free_held (casstcl_rateLimitHeld *held)
+{
+	if (held->ownsStatement) {
+		cass_statement_free (held->statement);
+	}
+
+	if (held->tableNameObj != NULL) {
+		Tcl_DecrRefCount (held->tableNameObj);
+	}
+	ckfree ((char *)held);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_send --
+ *
+ *    send a held request that's been taken out of its queue and hand
+ *    its future to its submit proc
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_rate_limit_send (casstcl_rateLimitHeld *held)
+{
+	casstcl_sessionClientData *ct = held->limit->ct;
+	CassFuture *future = cass_session_execute (ct->session, held->statement);
+
+	(*held->submitProc) (ct, future, held->clientData);
+	casstcl_rate_limit_free_held (held);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_timer_proc --
+ *
+ *    called by the Tcl event loop when a bucket with requests waiting in
+ *    its queue should have a token.  sends as many of them, in order, as
+ *    there are tokens for and looks again when the next one should be
+ *    able to go.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_rate_limit_timer_proc (ClientData clientData)
+{
+	casstcl_rateLimit *limit = (casstcl_rateLimit *)clientData;
+	casstcl_rateLimitHeld *held;
+
+	limit->timer = NULL;
+
+	while ((held = limit->heldHead) != NULL) {
+		Tcl_WideInt wait = casstcl_rate_limit_acquire (limit->ct, held->tableNameObj);
+
+		if (wait > 0) {
+			casstcl_rate_limit_schedule (limit, wait);
+			return;
+		}
+
+		casstcl_rate_limit_unlink (held);
+		casstcl_rate_limit_send (held);
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_hold --
+ *
+ *    take a token for a request to a table, which may be NULL, or if
+ *    there isn't one, or other requests are already waiting, hold the
+ *    request in the table's queue, or the session's if the table isn't
+ *    limited.  a held request is sent from a timer when its turn comes
+ *    and a token is there for it, and submitProc is then called with
+ *    its future and clientData.
+ *
+ *    if heldPtr isn't NULL, it's set to the held request, which can be
+ *    passed to casstcl_rate_limit_release or casstcl_rate_limit_cancel
+ *    until submitProc is called.
+ *
+ * Results:
+ *    1 if the request is held, in which case the statement belongs to
+ *    the queue if ownsStatement is set, or 0 if the caller should send
+ *    it now
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_rate_limit_hold (casstcl_sessionClientData *ct, Tcl_Obj *tableNameObj, CassStatement *statement, int ownsStatement, casstcl_rateLimitSubmitProc *submitProc, ClientData clientData, casstcl_rateLimitHeld **heldPtr)
+{
+	casstcl_rateLimit *limit = casstcl_rate_limit_find (ct, tableNameObj);
+	casstcl_rateLimitHeld *held;
+	Tcl_WideInt wait = 0;
+
+	if (limit == NULL) {
+		if (ct->rateLimit.rate == 0 && ct->rateLimit.heldHead == NULL) {
+			return 0;
+		}
+		limit = &ct->rateLimit;
+	}
+
+	// don't jump ahead of the requests already waiting
+	if (limit->heldHead == NULL && ct->rateLimit.heldHead == NULL) {
+		if ((wait = casstcl_rate_limit_acquire (ct, tableNameObj)) == 0) {
+			return 0;
+		}
+	}
+
+	held = (casstcl_rateLimitHeld *)ckalloc (sizeof (casstcl_rateLimitHeld));
+	held->tableNameObj = tableNameObj;
+	if (tableNameObj != NULL) {
+		Tcl_IncrRefCount (tableNameObj);
+	}
+	held->statement = statement;
+	held->ownsStatement = ownsStatement;
+	held->submitProc = submitProc;
+	held->clientData = clientData;
+
+	casstcl_rate_limit_append (limit, held);
+	casstcl_rate_limit_schedule (limit, wait);
+
+	if (heldPtr != NULL) {
+		*heldPtr = held;
+	}
+	return 1;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_release --
+ *
+ *    send a held request now, ahead of its queue, as soon as there's a
+ *    token for it, sleeping until there is.  for when somebody is
+ *    blocking on it anyway, like a wait on a future that hasn't been
+ *    sent yet.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_rate_limit_release (casstcl_rateLimitHeld *held)
+{
+	casstcl_rateLimit *limit = held->limit;
+	Tcl_WideInt wait;
+
+	while ((wait = casstcl_rate_limit_acquire (limit->ct, held->tableNameObj)) > 0) {
+		Tcl_Sleep ((int)wait);
+	}
+
+	casstcl_rate_limit_unlink (held);
+	casstcl_rate_limit_send (held);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_cancel --
+ *
+ *    throw away a held request without sending it, like when the future
+ *    it's for is deleted
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_rate_limit_cancel (casstcl_rateLimitHeld *held)
+{
+	casstcl_rate_limit_unlink (held);
+	casstcl_rate_limit_free_held (held);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_release_queue --
+ *
+ *    send all of the requests in a bucket's queue now, without taking
+ *    tokens for them
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_rate_limit_release_queue (casstcl_rateLimit *limit)
+{
+	casstcl_rateLimitHeld *held;
+
+	while ((held = limit->heldHead) != NULL) {
+		casstcl_rate_limit_unlink (held);
+		casstcl_rate_limit_send (held);
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_release_all --
+ *
+ *    send all of a session's held requests now, ignoring its limits.
+ *    used when the session is deleted, while there's still a session to
+ *    send them with.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_rate_limit_release_all (casstcl_sessionClientData *ct)
+{
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+
+	casstcl_rate_limit_release_queue (&ct->rateLimit);
+
+	for (entry = Tcl_FirstHashEntry (&ct->rateLimitTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+		casstcl_rate_limit_release_queue ((casstcl_rateLimit *)Tcl_GetHashValue (entry));
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_sleep --
+ *
+ *    wait until a request to a table, which may be NULL, can be sent,
+ *    without servicing events.  for callers like exec, select and
+ *    exec_many that block while they work anyway.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_rate_limit_sleep (casstcl_sessionClientData *ct, Tcl_Obj *tableNameObj)
+{
+	Tcl_WideInt wait;
+
+	while ((wait = casstcl_rate_limit_acquire (ct, tableNameObj)) > 0) {
+		Tcl_Sleep ((int)wait);
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_table_from_objv --
+ *
+ *    find the table a request made with the arguments of async or exec
+ *    is for, from the table of an upsert, -table or the table of the
+ *    -prepared statement.  objv and arg are as they are passed to
+ *    casstcl_make_statement_from_objv or, for an upsert, objv holds the
+ *    upsert's arguments.
+ *
+ *    it's only needed when some table has a rate limit or a circuit
+ *    breaker of its own, so otherwise this doesn't bother looking.
+ *
+ * Results:
+ *    The table name object or NULL if there isn't one (or it isn't needed)
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Obj *
+casstcl_rate_limit_table_from_objv (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[], int arg, int upsert)
+{
+	if (ct->rateLimitTable.numEntries == 0 && ct->breakerTable.numEntries == 0) {
+		return NULL;
+	}
+
+	if (upsert) {
+		return (objc >= 2) ? objv[objc - 2] : NULL;
+	}
+
+	while (arg + 1 < objc) {
+		char *optionString = Tcl_GetString (objv[arg]);
+
+		if (*optionString != '-') {
+			break;
+		}
+
+		// the only option without a value
+		if (strcmp (optionString, "-idempotent") == 0) {
+			arg++;
+			continue;
+		}
+
+		if (strcmp (optionString, "-table") == 0) {
+			return objv[arg + 1];
+		}
+
+		if (strcmp (optionString, "-prepared") == 0) {
+			casstcl_preparedClientData *pcd = casstcl_prepared_command_to_preparedClientData (ct->interp, Tcl_GetString (objv[arg + 1]));
+
+			return (pcd != NULL) ? pcd->tableNameObj : NULL;
+		}
+
+		arg += 2;
+	}
+
+	return NULL;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_to_list --
+ *
+ *    return a new list of a bucket's rate, burst and throttled count
+ *
+ *----------------------------------------------------------------------
+ */
+static Tcl_Obj *
+casstcl_rate_limit_to_list (casstcl_rateLimit *limit)
+{
+	Tcl_Obj *listObj = Tcl_NewObj ();
+
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("ops_per_sec", -1));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewDoubleObj ((limit != NULL) ? limit->rate : 0));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("burst", -1));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewDoubleObj ((limit != NULL) ? limit->burst : 0));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("throttled", -1));
+	Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj ((limit != NULL) ? limit->throttled : 0));
+	return listObj;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit --
+ *
+ *    implements the rate_limit method of a session,
+ *
+ *      rate_limit ?-table tableName? ?opsPerSec ?burst??
+ *
+ *    sets the number of requests per second the session, or with
+ *    -table the requests to one table, may send, allowing bursts of up
+ *    to burst requests, which defaults to one second's worth.  0 removes
+ *    the limit.  with no rate, returns the limit as a list of
+ *    ops_per_sec, burst and throttled, the number of times a request
+ *    was held back.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_rate_limit (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Interp *interp = ct->interp;
+	Tcl_Obj *tableNameObj = NULL;
+	casstcl_rateLimit *limit;
+	double rate;
+	double burst;
+	int arg = 2;
+
+	if (objc > 3 && strcmp (Tcl_GetString (objv[arg]), "-table") == 0) {
+		tableNameObj = objv[arg + 1];
+		arg += 2;
+	}
+
+	if (objc - arg > 2) {
+		Tcl_WrongNumArgs (interp, 2, objv, "?-table tableName? ?opsPerSec ?burst??");
+		return TCL_ERROR;
+	}
+
+	if (tableNameObj != NULL) {
+		limit = casstcl_rate_limit_find (ct, tableNameObj);
+	} else {
+		limit = (ct->rateLimit.rate > 0) ? &ct->rateLimit : NULL;
+	}
+
+	if (arg == objc) {
+		Tcl_SetObjResult (interp, casstcl_rate_limit_to_list (limit));
+		return TCL_OK;
+	}
+
+	if (Tcl_GetDoubleFromObj (interp, objv[arg], &rate) == TCL_ERROR) {
+		Tcl_AppendResult (interp, " while converting opsPerSec", NULL);
+		return TCL_ERROR;
+	}
+
+	burst = (rate < 1.0) ? 1.0 : rate;
+	if (arg + 1 < objc && Tcl_GetDoubleFromObj (interp, objv[arg + 1], &burst) == TCL_ERROR) {
+		Tcl_AppendResult (interp, " while converting burst", NULL);
+		return TCL_ERROR;
+	}
+
+	if (rate < 0) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "rate limit can't be negative", NULL);
+		return TCL_ERROR;
+	}
+
+	if (burst < 1.0) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "rate limit burst must be at least 1", NULL);
+		return TCL_ERROR;
+	}
+
+	if (tableNameObj == NULL) {
+		limit = &ct->rateLimit;
+	} else if (rate == 0) {
+		// no limit for a table means no bucket for it.  whatever it was
+		// holding back goes to the end of the session's queue.
+		Tcl_HashEntry *entry = Tcl_FindHashEntry (&ct->rateLimitTable, Tcl_GetString (tableNameObj));
+
+		if (entry != NULL) {
+			casstcl_rateLimitHeld *held;
+
+			limit = (casstcl_rateLimit *)Tcl_GetHashValue (entry);
+			while ((held = limit->heldHead) != NULL) {
+				casstcl_rate_limit_unlink (held);
+				casstcl_rate_limit_append (&ct->rateLimit, held);
+				casstcl_rate_limit_schedule (&ct->rateLimit, 0);
+			}
+
+			ckfree ((char *)limit);
+			Tcl_DeleteHashEntry (entry);
+		}
+		return TCL_OK;
+	} else if (limit == NULL) {
+		int isNew;
+		Tcl_HashEntry *entry = Tcl_CreateHashEntry (&ct->rateLimitTable, Tcl_GetString (tableNameObj), &isNew);
+
+		limit = (casstcl_rateLimit *)ckalloc (sizeof (casstcl_rateLimit));
+		memset (limit, 0, sizeof (casstcl_rateLimit));
+		limit->ct = ct;
+		Tcl_SetHashValue (entry, limit);
+	}
+
+	// a new or changed limit starts with a full bucket, so look at
+	// what's waiting right away
+	limit->rate = rate;
+	limit->burst = burst;
+	limit->tokens = burst;
+	limit->updated = casstcl_now_us ();
+
+	if (limit->heldHead != NULL) {
+		if (limit->timer != NULL) {
+			Tcl_DeleteTimerHandler (limit->timer);
+			limit->timer = NULL;
+		}
+		casstcl_rate_limit_schedule (limit, 0);
+	}
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_forget_all --
+ *
+ *    free all of a session's per-table rate limits.  used when the
+ *    session is deleted, after casstcl_rate_limit_release_all has sent
+ *    whatever they were holding.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_rate_limit_forget_all (casstcl_sessionClientData *ct)
+{
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+
+	assert (ct->rateLimit.heldHead == NULL);
+
+	for (entry = Tcl_FirstHashEntry (&ct->rateLimitTable, &search); entry != NULL; entry = Tcl_NextHashEntry (&search)) {
+		casstcl_rateLimit *limit = (casstcl_rateLimit *)Tcl_GetHashValue (entry);
+
+		assert (limit->heldHead == NULL);
+		ckfree ((char *)limit);
+	}
+	Tcl_DeleteHashTable (&ct->rateLimitTable);
+}
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
@@ -0,0 +1,185 @@
+/*
+ *
+ * Include file for ratelimit
+ *
+ * Copyright (C) 2015 by FlightAware, All Rights Reserved
+ *
+ * Freely redistributable under the Berkeley copyright, see license.terms
+ * for details.
+ */
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_acquire --
+ *
+ *    take a token for a request to a table, which may be NULL if the
+ *    table isn't known, from the session's bucket and the table's, if
+ *    they're limited.  a token is only taken if both have one.
+ *
+ * Results:
+ *    0 if the request can be sent, otherwise the number of
+ *    milliseconds to wait before trying again
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_WideInt
+casstcl_rate_limit_acquire (casstcl_sessionClientData *ct, Tcl_Obj *tableNameObj);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_charge --
+ *
+ *    take a token for a request that is sent without waiting, like a
+ *    batch flushed from a timer, even if it leaves the buckets short so
+ *    the requests after it wait to make up for it
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_rate_limit_charge (casstcl_sessionClientData *ct, Tcl_Obj *tableNameObj);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_hold --
+ *
+ *    take a token for a request to a table, which may be NULL, or if
+ *    there isn't one, or other requests are already waiting, hold the
+ *    request in the table's queue, or the session's if the table isn't
+ *    limited.  a held request is sent from a timer when its turn comes
+ *    and a token is there for it, and submitProc is then called with
+ *    its future and clientData.
+ *
+ *    if heldPtr isn't NULL, it's set to the held request, which can be
+ *    passed to casstcl_rate_limit_release or casstcl_rate_limit_cancel
+ *    until submitProc is called.
+ *
+ * Results:
+ *    1 if the request is held, in which case the statement belongs to
+ *    the queue if ownsStatement is set, or 0 if the caller should send
+ *    it now
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_rate_limit_hold (casstcl_sessionClientData *ct, Tcl_Obj *tableNameObj, CassStatement *statement, int ownsStatement, casstcl_rateLimitSubmitProc *submitProc, ClientData clientData, casstcl_rateLimitHeld **heldPtr);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_release --
+ *
+ *    send a held request now, ahead of its queue, as soon as there's a
+ *    token for it, sleeping until there is.  for when somebody is
+ *    blocking on it anyway, like a wait on a future that hasn't been
+ *    sent yet.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_rate_limit_release (casstcl_rateLimitHeld *held);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_cancel --
+ *
+ *    throw away a held request without sending it, like when the future
+ *    it's for is deleted
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_rate_limit_cancel (casstcl_rateLimitHeld *held);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_release_all --
+ *
+ *    send all of a session's held requests now, ignoring its limits.
+ *    used when the session is deleted, while there's still a session to
+ *    send them with.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_rate_limit_release_all (casstcl_sessionClientData *ct);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_sleep --
+ *
+ *    wait until a request to a table, which may be NULL, can be sent,
+ *    without servicing events.  for callers like exec, select and
+ *    exec_many that block while they work anyway.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_rate_limit_sleep (casstcl_sessionClientData *ct, Tcl_Obj *tableNameObj);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_table_from_objv --
+ *
+ *    find the table a request made with the arguments of async or exec
+ *    is for, from the table of an upsert, -table or the table of the
+ *    -prepared statement.  objv and arg are as they are passed to
+ *    casstcl_make_statement_from_objv or, for an upsert, objv holds the
+ *    upsert's arguments.
+ *
+ *    it's only needed when some table has a rate limit or a circuit
+ *    breaker of its own, so otherwise this doesn't bother looking.
+ *
+ * Results:
+ *    The table name object or NULL if there isn't one (or it isn't needed)
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Obj *
+casstcl_rate_limit_table_from_objv (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[], int arg, int upsert);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit --
+ *
+ *    implements the rate_limit method of a session,
+ *
+ *      rate_limit ?-table tableName? ?opsPerSec ?burst??
+ *
+ *    sets the number of requests per second the session, or with
+ *    -table the requests to one table, may send, allowing bursts of up
+ *    to burst requests, which defaults to one second's worth.  0 removes
+ *    the limit.  with no rate, returns the limit as a list of
+ *    ops_per_sec, burst and throttled, the number of times a request
+ *    was held back.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_rate_limit (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[]);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_rate_limit_forget_all --
+ *
+ *    free all of a session's per-table rate limits.  used when the
+ *    session is deleted, after casstcl_rate_limit_release_all has sent
+ *    whatever they were holding.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_rate_limit_forget_all (casstcl_sessionClientData *ct);
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
@@ -0,0 +1,196 @@
+/*
+ * casstcl_retry - Functions used to choose the cpp-driver's retry policy
+ *   and to count the retries the logging retry policy reports
+ *
+ * casstcl - Tcl interface to CassDB
+ *
+ * Copyright (C) 2014 FlightAware LLC
+ *
+ * freely redistributable under the Berkeley license
+ */
+
+#include "casstcl.h"
+#include "casstcl_retry.h"
+
+// the logging retry policy reports its decisions through the cpp-driver's
+// logging, which is global, so like the logging callback the counts are
+// for the whole process.  they're updated from the cpp-driver's threads.
+TCL_DECLARE_MUTEX(casstcl_retryMutex)
+static Tcl_WideInt casstcl_retryCounts[CASSTCL_RETRY_REASONS];
+
+static CONST char *casstcl_retryReasonNames[CASSTCL_RETRY_REASONS] = {
+	"retries.read_timeout",
+	"retries.write_timeout",
+	"retries.unavailable",
+	"retries.request_error",
+	"retries.ignored"
+};
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_obj_to_retry_policy --
+ *
+ *    make a new cpp-driver retry policy from a Tcl object holding
+ *    "?logging? policy", where policy is one of default,
+ *    downgrading_consistency or fallthrough.  logging wraps the policy
+ *    so that its decisions are logged and counted.
+ *
+ * Results:
+ *    A standard Tcl result.  On success the caller owns the policy in
+ *    *policyPtr and frees it with cass_retry_policy_free once it has
+ *    been set.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_obj_to_retry_policy (Tcl_Interp *interp, Tcl_Obj *policyObj, CassRetryPolicy **policyPtr)
+{
+	Tcl_Obj **listObjv;
+	int listObjc;
+	int policyIndex;
+	int logging = 0;
+	CassRetryPolicy *policy = NULL;
+
+	static CONST char *policies[] = {
+		"default",
+		"downgrading_consistency",
+		"fallthrough",
+		NULL
+	};
+
+	enum policies {
+		POLICY_DEFAULT,
+		POLICY_DOWNGRADING_CONSISTENCY,
+		POLICY_FALLTHROUGH
+	};
+
+	if (Tcl_ListObjGetElements (interp, policyObj, &listObjc, &listObjv) == TCL_ERROR) {
+		Tcl_AppendResult (interp, " while converting retry policy", NULL);
+		return TCL_ERROR;
+	}
+
+	if (listObjc == 2 && strcmp (Tcl_GetString (listObjv[0]), "logging") == 0) {
+		logging = 1;
+		listObjv++;
+		listObjc--;
+	}
+
+	if (listObjc != 1) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "retry policy must be \"?logging? policy\"", NULL);
+		return TCL_ERROR;
+	}
+
+	if (Tcl_GetIndexFromObj (interp, listObjv[0], policies, "retry policy", TCL_EXACT, &policyIndex) != TCL_OK) {
+		return TCL_ERROR;
+	}
+
+	switch ((enum policies) policyIndex) {
+		case POLICY_DEFAULT: {
+			policy = cass_retry_policy_default_new ();
+			break;
+		}
+
+		case POLICY_DOWNGRADING_CONSISTENCY: {
+			policy = cass_retry_policy_downgrading_consistency_new ();
+			break;
+		}
+
+		case POLICY_FALLTHROUGH: {
+			policy = cass_retry_policy_fallthrough_new ();
+			break;
+		}
+	}
+
+	if (logging) {
+		// the logging policy keeps its own reference to the child
+		CassRetryPolicy *loggingPolicy = cass_retry_policy_logging_new (policy);
+		cass_retry_policy_free (policy);
+		policy = loggingPolicy;
+	}
+
+	*policyPtr = policy;
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_retry_count_log_message --
+ *
+ *    count a retry, or an error the retry policy decided to ignore, if
+ *    the log message is one the logging retry policy wrote.  called from
+ *    the cpp-driver's logging callback, so from the driver's threads.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_retry_count_log_message (const CassLogMessage *message)
+{
+	const char *text = message->message;
+	int reason;
+
+	static const char retrying[] = "Retrying on ";
+
+	if (message->severity != CASS_LOG_INFO) {
+		return;
+	}
+
+	if (strncmp (text, retrying, sizeof (retrying) - 1) == 0) {
+		text += sizeof (retrying) - 1;
+
+		if (strncmp (text, "read timeout", 12) == 0) {
+			reason = CASSTCL_RETRY_READ_TIMEOUT;
+		} else if (strncmp (text, "write timeout", 13) == 0) {
+			reason = CASSTCL_RETRY_WRITE_TIMEOUT;
+		} else if (strncmp (text, "unavailable", 11) == 0) {
+			reason = CASSTCL_RETRY_UNAVAILABLE;
+		} else if (strncmp (text, "request error", 13) == 0) {
+			reason = CASSTCL_RETRY_REQUEST_ERROR;
+		} else {
+			return;
+		}
+	} else if (strncmp (text, "Ignoring ", 9) == 0) {
+		reason = CASSTCL_RETRY_IGNORED;
+	} else {
+		return;
+	}
+
+	Tcl_MutexLock (&casstcl_retryMutex);
+	casstcl_retryCounts[reason]++;
+	Tcl_MutexUnlock (&casstcl_retryMutex);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_retry_metrics --
+ *
+ *    add the retry counts to a list of metrics as key-value pairs,
+ *    starting at listObjv[i]
+ *
+ * Results:
+ *    The index after the last element added
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_retry_metrics (Tcl_Obj **listObjv, int i)
+{
+	Tcl_WideInt counts[CASSTCL_RETRY_REASONS];
+	int reason;
+
+	Tcl_MutexLock (&casstcl_retryMutex);
+	memcpy (counts, casstcl_retryCounts, sizeof (counts));
+	Tcl_MutexUnlock (&casstcl_retryMutex);
+
+	for (reason = 0; reason < CASSTCL_RETRY_REASONS; reason++) {
+		listObjv[i++] = Tcl_NewStringObj (casstcl_retryReasonNames[reason], -1);
+		listObjv[i++] = Tcl_NewWideIntObj (counts[reason]);
+	}
+
+	return i;
+}
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
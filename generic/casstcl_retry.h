@@ -0,0 +1,61 @@
+/*
+ *
+ * Include file for retry
+ *
+ * Copyright (C) 2015 by FlightAware, All Rights Reserved
+ *
+ * Freely redistributable under the Berkeley copyright, see license.terms
+ * for details.
+ */
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_obj_to_retry_policy --
+ *
+ *    make a new cpp-driver retry policy from a Tcl object holding
+ *    "?logging? policy", where policy is one of default,
+ *    downgrading_consistency or fallthrough.  logging wraps the policy
+ *    so that its decisions are logged and counted.
+ *
+ * Results:
+ *    A standard Tcl result.  On success the caller owns the policy in
+ *    *policyPtr and frees it with cass_retry_policy_free once it has
+ *    been set.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_obj_to_retry_policy (Tcl_Interp *interp, Tcl_Obj *policyObj, CassRetryPolicy **policyPtr);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_retry_count_log_message --
+ *
+ *    count a retry, or an error the retry policy decided to ignore, if
+ *    the log message is one the logging retry policy wrote.  called from
+ *    the cpp-driver's logging callback, so from the driver's threads.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_retry_count_log_message (const CassLogMessage *message);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_retry_metrics --
+ *
+ *    add the retry counts to a list of metrics as key-value pairs,
+ *    starting at listObjv[i]
+ *
+ * Results:
+ *    The index after the last element added
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_retry_metrics (Tcl_Obj **listObjv, int i);
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
@@ -0,0 +1,643 @@
+/*
+ * casstcl_slowlog - Functions used to keep a log of the requests made
+ *   through a session that took longer than a threshold
+ *
+ * casstcl - Tcl interface to CassDB
+ *
+ * Copyright (C) 2014 FlightAware LLC
+ *
+ * freely redistributable under the Berkeley license
+ */
+
+#include "casstcl.h"
+#include "casstcl_slowlog.h"
+#include "casstcl_future.h"
+#include "casstcl_trace.h"
+
+#include <stdlib.h>
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_slowlog_request --
+ *
+ *    describe a request for the slow query log, if it's on, as a list
+ *    of key-value pairs: its tag, if given, kindName ("statement",
+ *    "prepared", "upsert" or "batch") with textObj, the statement or
+ *    the name of what was executed, the first
+ *    CASSTCL_SLOWLOG_MAX_PARAMS_LENGTH characters of its parameters and
+ *    its consistency, if given.  this is done when the request is made,
+ *    since its arguments are gone by the time it's known to be slow.
+ *
+ * Results:
+ *    A new list with a reference count of zero, or NULL if the slow
+ *    query log is off
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Obj *
+casstcl_slowlog_request (casstcl_sessionClientData *ct, CONST char *kindName, Tcl_Obj *textObj, int paramc, Tcl_Obj *CONST paramv[], CONST char *consistencyName, Tcl_Obj *tagObj)
+{
+	Tcl_Obj *requestObj;
+	Tcl_Obj *paramsObj;
+
+	if (ct->slowlog.thresholdMS == 0) {
+		return NULL;
+	}
+
+	requestObj = Tcl_NewObj ();
+	if (tagObj != NULL) {
+		Tcl_ListObjAppendElement (NULL, requestObj, Tcl_NewStringObj ("tag", -1));
+		Tcl_ListObjAppendElement (NULL, requestObj, tagObj);
+	}
+
+	Tcl_ListObjAppendElement (NULL, requestObj, Tcl_NewStringObj (kindName, -1));
+	Tcl_ListObjAppendElement (NULL, requestObj, (textObj != NULL) ? textObj : Tcl_NewObj ());
+
+	paramsObj = Tcl_NewListObj (paramc, paramv);
+	if (Tcl_GetCharLength (paramsObj) > CASSTCL_SLOWLOG_MAX_PARAMS_LENGTH) {
+		Tcl_Obj *shortObj = Tcl_GetRange (paramsObj, 0, CASSTCL_SLOWLOG_MAX_PARAMS_LENGTH - 1);
+
+		Tcl_AppendToObj (shortObj, "...", -1);
+		Tcl_DecrRefCount (paramsObj);
+		paramsObj = shortObj;
+	}
+	Tcl_ListObjAppendElement (NULL, requestObj, Tcl_NewStringObj ("params", -1));
+	Tcl_ListObjAppendElement (NULL, requestObj, paramsObj);
+
+	Tcl_ListObjAppendElement (NULL, requestObj, Tcl_NewStringObj ("consistency", -1));
+	Tcl_ListObjAppendElement (NULL, requestObj, Tcl_NewStringObj ((consistencyName != NULL) ? consistencyName : "", -1));
+
+	return requestObj;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_slowlog_request_from_objv --
+ *
+ *    describe a request made with the arguments of async or exec for
+ *    the slow query log, like casstcl_slowlog_request.  objv and arg
+ *    are as they are passed to casstcl_make_statement_from_objv or, for
+ *    an upsert, objv holds the upsert's arguments.
+ *
+ * Results:
+ *    A new list with a reference count of zero, or NULL if the slow
+ *    query log is off
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Obj *
+casstcl_slowlog_request_from_objv (casstcl_sessionClientData *ct, Tcl_Obj *tagObj, int objc, Tcl_Obj *CONST objv[], int arg, int upsert)
+{
+	Tcl_Obj *preparedObj = NULL;
+	CONST char *consistencyName = NULL;
+
+	if (ct->slowlog.thresholdMS == 0) {
+		return NULL;
+	}
+
+	// the table and the list of column names and values are last
+	if (upsert) {
+		if (objc < 2) {
+			return casstcl_slowlog_request (ct, "upsert", NULL, 0, NULL, NULL, tagObj);
+		}
+		return casstcl_slowlog_request (ct, "upsert", objv[objc - 2], 1, &objv[objc - 1], NULL, tagObj);
+	}
+
+	while (arg + 1 < objc) {
+		char *optionString = Tcl_GetString (objv[arg]);
+
+		if (*optionString != '-') {
+			break;
+		}
+
+		// the only option without a value
+		if (strcmp (optionString, "-idempotent") == 0) {
+			arg++;
+			continue;
+		}
+
+		if (strcmp (optionString, "-prepared") == 0) {
+			preparedObj = objv[arg + 1];
+		} else if (strcmp (optionString, "-consistency") == 0) {
+			consistencyName = Tcl_GetString (objv[arg + 1]);
+		}
+
+		arg += 2;
+	}
+
+	if (preparedObj != NULL) {
+		return casstcl_slowlog_request (ct, "prepared", preparedObj, objc - arg, &objv[arg], consistencyName, tagObj);
+	}
+
+	if (arg >= objc) {
+		return casstcl_slowlog_request (ct, "statement", NULL, 0, NULL, consistencyName, tagObj);
+	}
+
+	return casstcl_slowlog_request (ct, "statement", objv[arg], objc - arg - 1, &objv[arg + 1], consistencyName, tagObj);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_slowlog_write --
+ *
+ *    write out one slow query log record, to the -callback if there is
+ *    one, else as a line to the -channel or to stderr
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_slowlog_write (casstcl_sessionClientData *ct, Tcl_Obj *recordObj)
+{
+	Tcl_Interp *interp = ct->interp;
+	casstcl_slowLog *sl = &ct->slowlog;
+	int tclReturn = TCL_OK;
+
+	if (sl->callbackObj != NULL) {
+		Tcl_Obj *evalObj = Tcl_DuplicateObj (sl->callbackObj);
+
+		Tcl_IncrRefCount (evalObj);
+		tclReturn = Tcl_ListObjAppendElement (interp, evalObj, recordObj);
+		if (tclReturn == TCL_OK) {
+			tclReturn = Tcl_EvalObjEx (interp, evalObj, TCL_EVAL_GLOBAL);
+		}
+		Tcl_DecrRefCount (evalObj);
+	} else {
+		CONST char *channelName = (sl->channelNameObj != NULL) ? Tcl_GetString (sl->channelNameObj) : "stderr";
+		Tcl_Channel channel;
+		int mode;
+
+		// looked up each time, it may have been closed
+		if ((channel = Tcl_GetChannel (interp, channelName, &mode)) == NULL) {
+			return TCL_ERROR;
+		}
+
+		if (Tcl_WriteObj (channel, recordObj) < 0 || Tcl_WriteChars (channel, "\n", 1) < 0 || Tcl_Flush (channel) != TCL_OK) {
+			Tcl_ResetResult (interp);
+			Tcl_AppendResult (interp, "error writing slow query log to \"", channelName, "\": ", Tcl_PosixError (interp), NULL);
+			return TCL_ERROR;
+		}
+	}
+
+	return tclReturn;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_slowlog_flush_proc --
+ *
+ *    called by the Tcl event loop when it's idle to write out the slow
+ *    query log records that have piled up since it was last idle.
+ *
+ * Results:
+ *    If a record can't be written, a Tcl background error is invoked
+ *    and the records after it are dropped.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_slowlog_flush_proc (ClientData clientData)
+{
+	casstcl_sessionClientData *ct = (casstcl_sessionClientData *)clientData;
+	Tcl_Interp *interp = ct->interp;
+	Tcl_Obj *pendingObj = ct->slowlog.pendingObj;
+	Tcl_Obj **recordObjv;
+	int recordObjc;
+	int i;
+
+	ct->slowlog.pendingObj = NULL;
+	ct->slowlog.flushScheduled = 0;
+
+	if (pendingObj == NULL) {
+		return;
+	}
+
+	// a callback may delete the session
+	Tcl_Preserve ((ClientData)ct);
+
+	Tcl_ListObjGetElements (NULL, pendingObj, &recordObjc, &recordObjv);
+	for (i = 0; i < recordObjc && ct->session != NULL; i++) {
+		if (casstcl_slowlog_write (ct, recordObjv[i]) == TCL_ERROR) {
+			Tcl_BackgroundError (interp);
+			ct->slowlog.dropped += recordObjc - i - 1;
+			break;
+		}
+	}
+	Tcl_ResetResult (interp);
+
+	Tcl_DecrRefCount (pendingObj);
+	Tcl_Release ((ClientData)ct);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_slowlog_queue --
+ *
+ *    add a record to those waiting to be written when the event loop
+ *    is next idle, unless too many already are
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_slowlog_queue (casstcl_sessionClientData *ct, Tcl_Obj *recordObj)
+{
+	casstcl_slowLog *sl = &ct->slowlog;
+	int pendingCount = 0;
+
+	if (sl->pendingObj != NULL) {
+		Tcl_ListObjLength (NULL, sl->pendingObj, &pendingCount);
+	}
+
+	if (pendingCount >= CASSTCL_SLOWLOG_MAX_PENDING) {
+		sl->dropped++;
+		return;
+	}
+
+	if (sl->pendingObj == NULL) {
+		sl->pendingObj = Tcl_NewObj ();
+		Tcl_IncrRefCount (sl->pendingObj);
+	}
+	Tcl_ListObjAppendElement (NULL, sl->pendingObj, recordObj);
+	sl->logged++;
+
+	if (!sl->flushScheduled) {
+		Tcl_DoWhenIdle (casstcl_slowlog_flush_proc, (ClientData)ct);
+		sl->flushScheduled = 1;
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_slowlog_eventProc --
+ *
+ *    called from the event loop once the query for the coordinator of
+ *    a traced request's record has been answered.  the coordinator is
+ *    added to the record and the record queued to be written, unless
+ *    the session has been deleted or its log turned off meanwhile.
+ *
+ * Results:
+ *    1, the event has been handled
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_slowlog_eventProc (Tcl_Event *tevPtr, int flags) {
+	casstcl_slowlogEvent *evPtr = (casstcl_slowlogEvent *)tevPtr;
+	casstcl_slowlogLookup *lookup = evPtr->lookup;
+	casstcl_sessionClientData *ct = lookup->ct;
+	Tcl_Obj *coordinatorObj;
+
+	// the query is done, so this doesn't wait
+	if (casstcl_trace_coordinator_finish (ct, lookup->future, &coordinatorObj) == TCL_OK) {
+		Tcl_ListObjAppendElement (NULL, lookup->recordObj, Tcl_NewStringObj ("coordinator", -1));
+		Tcl_ListObjAppendElement (NULL, lookup->recordObj, coordinatorObj);
+	}
+	Tcl_ResetResult (ct->interp);
+
+	if (ct->session != NULL && ct->slowlog.thresholdMS != 0) {
+		casstcl_slowlog_queue (ct, lookup->recordObj);
+	}
+
+	Tcl_DecrRefCount (lookup->recordObj);
+	ckfree ((char *)lookup);
+
+	Tcl_Release ((ClientData)ct);
+	return 1;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_slowlog_callback --
+ *
+ *    cpp-driver callback for the query of a record's coordinator,
+ *    which queues an event to the session's thread for
+ *    casstcl_slowlog_eventProc
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_slowlog_callback (CassFuture *future, void *data) {
+	casstcl_slowlogLookup *lookup = (casstcl_slowlogLookup *)data;
+	casstcl_slowlogEvent *evPtr = (casstcl_slowlogEvent *) ckalloc (sizeof (casstcl_slowlogEvent));
+
+	evPtr->event.proc = casstcl_slowlog_eventProc;
+	evPtr->lookup = lookup;
+	Tcl_ThreadQueueEvent (lookup->ct->threadId, (Tcl_Event *)evPtr, TCL_QUEUE_TAIL);
+	casstcl_wait_notify ();
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_slowlog_record_traced --
+ *
+ *    if the slow query log is on and a request took at least its
+ *    threshold, and the request is sampled, add a record of it to
+ *    those waiting to be written when the event loop is next idle.
+ *    requestObj is the request's description from
+ *    casstcl_slowlog_request and may be NULL.  tracingIdPtr, if not
+ *    NULL, points to the tracing id of a traced request.  pages is how
+ *    many requests it took and us the total of their latencies in
+ *    microseconds.
+ *
+ *    the record of a traced request isn't queued until the query for
+ *    its coordinator has been answered, which is left to the event
+ *    loop rather than waited for here or when the record is written.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_slowlog_record_traced (casstcl_sessionClientData *ct, Tcl_Obj *requestObj, CassUuid *tracingIdPtr, int pages, Tcl_WideInt us)
+{
+	casstcl_slowLog *sl = &ct->slowlog;
+	Tcl_Obj *recordObj;
+
+	if (requestObj == NULL || sl->thresholdMS == 0 || us < sl->thresholdMS * 1000) {
+		return;
+	}
+
+	if (sl->sample < 1.0 && rand () > sl->sample * RAND_MAX) {
+		sl->sampledOut++;
+		return;
+	}
+
+	recordObj = Tcl_NewListObj (0, NULL);
+	Tcl_ListObjAppendElement (NULL, recordObj, Tcl_NewStringObj ("time", -1));
+	Tcl_ListObjAppendElement (NULL, recordObj, Tcl_NewWideIntObj (casstcl_now_ms ()));
+	Tcl_ListObjAppendList (NULL, recordObj, requestObj);
+	Tcl_ListObjAppendElement (NULL, recordObj, Tcl_NewStringObj ("pages", -1));
+	Tcl_ListObjAppendElement (NULL, recordObj, Tcl_NewIntObj (pages));
+	Tcl_ListObjAppendElement (NULL, recordObj, Tcl_NewStringObj ("latency", -1));
+	Tcl_ListObjAppendElement (NULL, recordObj, Tcl_NewWideIntObj (us));
+
+	if (tracingIdPtr != NULL && ct->session != NULL) {
+		char tracingIdString[CASS_UUID_STRING_LENGTH];
+		casstcl_slowlogLookup *lookup;
+
+		cass_uuid_string (*tracingIdPtr, tracingIdString);
+		Tcl_ListObjAppendElement (NULL, recordObj, Tcl_NewStringObj ("tracing_id", -1));
+		Tcl_ListObjAppendElement (NULL, recordObj, Tcl_NewStringObj (tracingIdString, CASS_UUID_STRING_LENGTH - 1));
+
+		lookup = (casstcl_slowlogLookup *)ckalloc (sizeof (casstcl_slowlogLookup));
+		lookup->ct = ct;
+		lookup->recordObj = recordObj;
+		Tcl_IncrRefCount (recordObj);
+
+		// the session has to stay around until the event is handled
+		Tcl_Preserve ((ClientData)ct);
+
+		lookup->future = casstcl_trace_coordinator_start (ct, *tracingIdPtr);
+		cass_future_set_callback (lookup->future, casstcl_slowlog_callback, lookup);
+		return;
+	}
+
+	casstcl_slowlog_queue (ct, recordObj);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_slowlog_record --
+ *
+ *    like casstcl_slowlog_record_traced, for a request made with one
+ *    future.  future, if not NULL, is the request's completed future,
+ *    from which its tracing id is taken.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_slowlog_record (casstcl_sessionClientData *ct, Tcl_Obj *requestObj, CassFuture *future, int pages, Tcl_WideInt us)
+{
+	CassUuid tracingId;
+
+	if (requestObj == NULL) {
+		return;
+	}
+
+	if (future != NULL && cass_future_tracing_id (future, &tracingId) == CASS_OK) {
+		casstcl_slowlog_record_traced (ct, requestObj, &tracingId, pages, us);
+	} else {
+		casstcl_slowlog_record_traced (ct, requestObj, NULL, pages, us);
+	}
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_slowlog --
+ *
+ *    implements the slowlog method of a session,
+ *
+ *      slowlog ?-threshold ms? ?-sample rate? ?-channel chan?
+ *          ?-callback proc?
+ *
+ *    with no arguments, return the settings and the counts of records
+ *    logged, sampled out and dropped.  a threshold of 0 turns the slow
+ *    query log off.  giving -channel or -callback replaces the other;
+ *    with neither, records go to stderr.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_slowlog (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Interp *interp = ct->interp;
+	casstcl_slowLog *sl = &ct->slowlog;
+	Tcl_WideInt thresholdMS = sl->thresholdMS;
+	double sample = sl->sample;
+	Tcl_Obj *channelNameObj = sl->channelNameObj;
+	Tcl_Obj *callbackObj = sl->callbackObj;
+	int arg;
+	int subOptIndex;
+
+	static CONST char *subOptions[] = {
+		"-threshold",
+		"-sample",
+		"-channel",
+		"-callback",
+		NULL
+	};
+
+	enum subOptions {
+		SUBOPT_THRESHOLD,
+		SUBOPT_SAMPLE,
+		SUBOPT_CHANNEL,
+		SUBOPT_CALLBACK
+	};
+
+	if (objc == 2) {
+		Tcl_Obj *listObj = Tcl_NewObj ();
+
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-threshold", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (sl->thresholdMS));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-sample", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewDoubleObj (sl->sample));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-channel", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, (sl->channelNameObj != NULL) ? sl->channelNameObj : Tcl_NewObj ());
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-callback", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, (sl->callbackObj != NULL) ? sl->callbackObj : Tcl_NewObj ());
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("logged", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (sl->logged));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("sampled_out", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (sl->sampledOut));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("dropped", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (sl->dropped));
+
+		Tcl_SetObjResult (interp, listObj);
+		return TCL_OK;
+	}
+
+	if (objc & 1) {
+		Tcl_WrongNumArgs (interp, 2, objv, "?-threshold ms? ?-sample rate? ?-channel chan? ?-callback proc?");
+		return TCL_ERROR;
+	}
+
+	for (arg = 2; arg < objc; arg += 2) {
+		if (Tcl_GetIndexFromObj (interp, objv[arg], subOptions, "subOption", TCL_EXACT, &subOptIndex) != TCL_OK) {
+			return TCL_ERROR;
+		}
+
+		switch ((enum subOptions) subOptIndex) {
+			case SUBOPT_THRESHOLD: {
+				if (Tcl_GetWideIntFromObj (interp, objv[arg + 1], &thresholdMS) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting threshold", NULL);
+					return TCL_ERROR;
+				}
+
+				if (thresholdMS < 0) {
+					Tcl_ResetResult (interp);
+					Tcl_AppendResult (interp, "slowlog -threshold can't be negative", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_SAMPLE: {
+				if (Tcl_GetDoubleFromObj (interp, objv[arg + 1], &sample) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting sample", NULL);
+					return TCL_ERROR;
+				}
+
+				if (sample <= 0.0 || sample > 1.0) {
+					Tcl_ResetResult (interp);
+					Tcl_AppendResult (interp, "slowlog -sample must be greater than 0 and at most 1", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_CHANNEL: {
+				int length;
+				int mode;
+
+				Tcl_GetStringFromObj (objv[arg + 1], &length);
+				if (length == 0) {
+					channelNameObj = NULL;
+					break;
+				}
+
+				if (Tcl_GetChannel (interp, Tcl_GetString (objv[arg + 1]), &mode) == NULL) {
+					return TCL_ERROR;
+				}
+
+				if (!(mode & TCL_WRITABLE)) {
+					Tcl_ResetResult (interp);
+					Tcl_AppendResult (interp, "channel \"", Tcl_GetString (objv[arg + 1]), "\" wasn't opened for writing", NULL);
+					return TCL_ERROR;
+				}
+
+				channelNameObj = objv[arg + 1];
+				callbackObj = NULL;
+				break;
+			}
+
+			case SUBOPT_CALLBACK: {
+				int length;
+
+				Tcl_GetStringFromObj (objv[arg + 1], &length);
+				callbackObj = (length == 0) ? NULL : objv[arg + 1];
+				if (callbackObj != NULL) {
+					channelNameObj = NULL;
+				}
+				break;
+			}
+		}
+	}
+
+	sl->thresholdMS = thresholdMS;
+	sl->sample = sample;
+
+	if (channelNameObj != sl->channelNameObj) {
+		if (channelNameObj != NULL) {
+			Tcl_IncrRefCount (channelNameObj);
+		}
+		if (sl->channelNameObj != NULL) {
+			Tcl_DecrRefCount (sl->channelNameObj);
+		}
+		sl->channelNameObj = channelNameObj;
+	}
+
+	if (callbackObj != sl->callbackObj) {
+		if (callbackObj != NULL) {
+			Tcl_IncrRefCount (callbackObj);
+		}
+		if (sl->callbackObj != NULL) {
+			Tcl_DecrRefCount (sl->callbackObj);
+		}
+		sl->callbackObj = callbackObj;
+	}
+
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_slowlog_forget --
+ *
+ *    throw away a session's slow query log settings, and any records
+ *    not yet written, when it's deleted
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_slowlog_forget (casstcl_sessionClientData *ct)
+{
+	casstcl_slowLog *sl = &ct->slowlog;
+
+	if (sl->flushScheduled) {
+		Tcl_CancelIdleCall (casstcl_slowlog_flush_proc, (ClientData)ct);
+		sl->flushScheduled = 0;
+	}
+
+	if (sl->pendingObj != NULL) {
+		Tcl_DecrRefCount (sl->pendingObj);
+		sl->pendingObj = NULL;
+	}
+
+	if (sl->channelNameObj != NULL) {
+		Tcl_DecrRefCount (sl->channelNameObj);
+		sl->channelNameObj = NULL;
+	}
+
+	if (sl->callbackObj != NULL) {
+		Tcl_DecrRefCount (sl->callbackObj);
+		sl->callbackObj = NULL;
+	}
+
+	sl->thresholdMS = 0;
+}
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
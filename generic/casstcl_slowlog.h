@@ -0,0 +1,121 @@
+/*
+ *
+ * Include file for slowlog
+ *
+ * Copyright (C) 2015 by FlightAware, All Rights Reserved
+ *
+ * Freely redistributable under the Berkeley copyright, see license.terms
+ * for details.
+ */
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_slowlog_request --
+ *
+ *    describe a request for the slow query log, if it's on, as a list
+ *    of key-value pairs: its tag, if given, kindName ("statement",
+ *    "prepared", "upsert" or "batch") with textObj, the statement or
+ *    the name of what was executed, the first
+ *    CASSTCL_SLOWLOG_MAX_PARAMS_LENGTH characters of its parameters and
+ *    its consistency, if given.  this is done when the request is made,
+ *    since its arguments are gone by the time it's known to be slow.
+ *
+ * Results:
+ *    A new list with a reference count of zero, or NULL if the slow
+ *    query log is off
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Obj *
+casstcl_slowlog_request (casstcl_sessionClientData *ct, CONST char *kindName, Tcl_Obj *textObj, int paramc, Tcl_Obj *CONST paramv[], CONST char *consistencyName, Tcl_Obj *tagObj);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_slowlog_request_from_objv --
+ *
+ *    describe a request made with the arguments of async or exec for
+ *    the slow query log, like casstcl_slowlog_request.  objv and arg
+ *    are as they are passed to casstcl_make_statement_from_objv or, for
+ *    an upsert, objv holds the upsert's arguments.
+ *
+ * Results:
+ *    A new list with a reference count of zero, or NULL if the slow
+ *    query log is off
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_Obj *
+casstcl_slowlog_request_from_objv (casstcl_sessionClientData *ct, Tcl_Obj *tagObj, int objc, Tcl_Obj *CONST objv[], int arg, int upsert);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_slowlog_record_traced --
+ *
+ *    if the slow query log is on and a request took at least its
+ *    threshold, and the request is sampled, add a record of it to
+ *    those waiting to be written when the event loop is next idle.
+ *    requestObj is the request's description from
+ *    casstcl_slowlog_request and may be NULL.  tracingIdPtr, if not
+ *    NULL, points to the tracing id of a traced request.  pages is how
+ *    many requests it took and us the total of their latencies in
+ *    microseconds.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_slowlog_record_traced (casstcl_sessionClientData *ct, Tcl_Obj *requestObj, CassUuid *tracingIdPtr, int pages, Tcl_WideInt us);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_slowlog_record --
+ *
+ *    like casstcl_slowlog_record_traced, for a request made with one
+ *    future.  future, if not NULL, is the request's completed future,
+ *    from which its tracing id is taken.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_slowlog_record (casstcl_sessionClientData *ct, Tcl_Obj *requestObj, CassFuture *future, int pages, Tcl_WideInt us);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_slowlog --
+ *
+ *    implements the slowlog method of a session,
+ *
+ *      slowlog ?-threshold ms? ?-sample rate? ?-channel chan?
+ *          ?-callback proc?
+ *
+ *    with no arguments, return the settings and the counts of records
+ *    logged, sampled out and dropped.  a threshold of 0 turns the slow
+ *    query log off.  giving -channel or -callback replaces the other;
+ *    with neither, records go to stderr.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_slowlog (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[]);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_slowlog_forget --
+ *
+ *    throw away a session's slow query log settings, and any records
+ *    not yet written, when it's deleted
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_slowlog_forget (casstcl_sessionClientData *ct);
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
@@ -0,0 +1,531 @@
+/*
+ * casstcl_trace - Functions used to decide which requests are traced and
+ *   to look up what Cassandra recorded in the trace of a request
+ *
+ * casstcl - Tcl interface to CassDB
+ *
+ * Copyright (C) 2014 FlightAware LLC
+ *
+ * freely redistributable under the Berkeley license
+ */
+
+#include "casstcl.h"
+#include "casstcl_trace.h"
+#include "casstcl_future.h"
+
+#include <stdlib.h>
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_tracing_id --
+ *
+ *    get the tracing id of a future's request, waiting for the request
+ *    to complete if it hasn't
+ *
+ * Results:
+ *    1 if the request was traced and the id is in *tracingIdPtr, else 0
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_future_tracing_id (casstcl_futureClientData *fcd, CassUuid *tracingIdPtr)
+{
+	return (cass_future_tracing_id (fcd->future, tracingIdPtr) == CASS_OK);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_rows --
+ *
+ *    run a query of the system_traces tables with the tracing id bound
+ *    to its one parameter and wait for the rows.  the cpp-driver waits
+ *    for the trace to be written before completing a traced request, so
+ *    it's there by the time anyone has the tracing id.
+ *
+ * Results:
+ *    A standard Tcl result.  On success *listObjPtr is set to a list of
+ *    the rows, each a list of column name and value pairs, as made by
+ *    casstcl_future_rows.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_trace_rows (casstcl_sessionClientData *ct, CONST char *query, CassUuid tracingId, Tcl_Obj **listObjPtr)
+{
+	CassStatement *statement;
+	CassFuture *future;
+	int tclReturn;
+
+	if (ct->session == NULL) {
+		Tcl_ResetResult (ct->interp);
+		Tcl_AppendResult (ct->interp, "not connected", NULL);
+		return TCL_ERROR;
+	}
+
+	statement = cass_statement_new (query, 1);
+	cass_statement_bind_uuid (statement, 0, tracingId);
+
+	future = cass_session_execute (ct->session, statement);
+	cass_future_wait (future);
+	tclReturn = casstcl_future_rows (ct, future, listObjPtr);
+
+	cass_future_free (future);
+	cass_statement_free (statement);
+	return tclReturn;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_coordinator_start --
+ *
+ *    start the query for the address of the node that coordinated a
+ *    traced request, without waiting for it.  the session must be
+ *    connected.
+ *
+ * Results:
+ *    The query's future, for casstcl_trace_coordinator_finish
+ *
+ *----------------------------------------------------------------------
+ */
+CassFuture *
+casstcl_trace_coordinator_start (casstcl_sessionClientData *ct, CassUuid tracingId)
+{
+	CassStatement *statement;
+	CassFuture *future;
+
+	statement = cass_statement_new ("SELECT coordinator FROM system_traces.sessions WHERE session_id = ?", 1);
+	cass_statement_bind_uuid (statement, 0, tracingId);
+	future = cass_session_execute (ct->session, statement);
+	cass_statement_free (statement);
+	return future;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_coordinator_finish --
+ *
+ *    wait for the query started by casstcl_trace_coordinator_start,
+ *    if it isn't done, and free its future
+ *
+ * Results:
+ *    A standard Tcl result.  On success *addressObjPtr is set to the
+ *    address, or to an empty object if the trace doesn't have it.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_trace_coordinator_finish (casstcl_sessionClientData *ct, CassFuture *future, Tcl_Obj **addressObjPtr)
+{
+	Tcl_Obj *rowsObj;
+	Tcl_Obj *rowObj;
+	Tcl_Obj *addressObj = NULL;
+	int tclReturn;
+
+	cass_future_wait (future);
+	tclReturn = casstcl_future_rows (ct, future, &rowsObj);
+	cass_future_free (future);
+
+	if (tclReturn == TCL_ERROR) {
+		return TCL_ERROR;
+	}
+
+	Tcl_IncrRefCount (rowsObj);
+	if (Tcl_ListObjIndex (NULL, rowsObj, 0, &rowObj) == TCL_OK && rowObj != NULL) {
+		Tcl_Obj *keyObj = Tcl_NewStringObj ("coordinator", -1);
+
+		Tcl_IncrRefCount (keyObj);
+		Tcl_DictObjGet (NULL, rowObj, keyObj, &addressObj);
+		Tcl_DecrRefCount (keyObj);
+	}
+
+	// copied, since it goes away with the rows
+	*addressObjPtr = (addressObj != NULL) ? Tcl_DuplicateObj (addressObj) : Tcl_NewObj ();
+	Tcl_DecrRefCount (rowsObj);
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_coordinator --
+ *
+ *    look up the address of the node that coordinated a traced request.
+ *    this runs a query and blocks until it's answered, so it's only for
+ *    the future methods, never for an event or idle handler.
+ *
+ * Results:
+ *    A standard Tcl result.  On success *addressObjPtr is set to the
+ *    address, or to an empty object if the trace doesn't have it.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_trace_coordinator (casstcl_sessionClientData *ct, CassUuid tracingId, Tcl_Obj **addressObjPtr)
+{
+	if (ct->session == NULL) {
+		Tcl_ResetResult (ct->interp);
+		Tcl_AppendResult (ct->interp, "not connected", NULL);
+		return TCL_ERROR;
+	}
+
+	return casstcl_trace_coordinator_finish (ct, casstcl_trace_coordinator_start (ct, tracingId), addressObjPtr);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_hosts --
+ *
+ *    look up the addresses of the nodes that did any of the work of a
+ *    traced request, the coordinator and the replicas it asked, in the
+ *    order they first show up in the trace.  like
+ *    casstcl_trace_coordinator, this blocks on its queries.
+ *
+ * Results:
+ *    A standard Tcl result.  On success *listObjPtr is set to a new
+ *    list of the addresses.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_trace_hosts (casstcl_sessionClientData *ct, CassUuid tracingId, Tcl_Obj **listObjPtr)
+{
+	Tcl_Obj *rowsObj;
+	Tcl_Obj **rowsObjv;
+	int rowsObjc;
+	Tcl_Obj *coordinatorObj;
+	Tcl_Obj *listObj;
+	Tcl_Obj *sourceKeyObj;
+	Tcl_HashTable seenTable;
+	int isNew;
+	int i;
+
+	if (casstcl_trace_coordinator (ct, tracingId, &coordinatorObj) == TCL_ERROR) {
+		return TCL_ERROR;
+	}
+
+	if (casstcl_trace_rows (ct, "SELECT source FROM system_traces.events WHERE session_id = ?", tracingId, &rowsObj) == TCL_ERROR) {
+		Tcl_DecrRefCount (coordinatorObj);
+		return TCL_ERROR;
+	}
+
+	Tcl_IncrRefCount (rowsObj);
+	Tcl_ListObjGetElements (NULL, rowsObj, &rowsObjc, &rowsObjv);
+
+	sourceKeyObj = Tcl_NewStringObj ("source", -1);
+	Tcl_IncrRefCount (sourceKeyObj);
+
+	listObj = Tcl_NewObj ();
+	Tcl_InitHashTable (&seenTable, TCL_STRING_KEYS);
+
+	// the coordinator is always first, even if it logged no events
+	if (Tcl_GetCharLength (coordinatorObj) > 0) {
+		Tcl_CreateHashEntry (&seenTable, Tcl_GetString (coordinatorObj), &isNew);
+		Tcl_ListObjAppendElement (NULL, listObj, coordinatorObj);
+	} else {
+		Tcl_DecrRefCount (coordinatorObj);
+	}
+
+	for (i = 0; i < rowsObjc; i++) {
+		Tcl_Obj *sourceObj = NULL;
+
+		if (Tcl_DictObjGet (NULL, rowsObjv[i], sourceKeyObj, &sourceObj) != TCL_OK || sourceObj == NULL) {
+			continue;
+		}
+
+		Tcl_CreateHashEntry (&seenTable, Tcl_GetString (sourceObj), &isNew);
+		if (isNew) {
+			Tcl_ListObjAppendElement (NULL, listObj, sourceObj);
+		}
+	}
+
+	Tcl_DeleteHashTable (&seenTable);
+	Tcl_DecrRefCount (sourceKeyObj);
+	Tcl_DecrRefCount (rowsObj);
+
+	*listObjPtr = listObj;
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_wanted --
+ *
+ *    decide whether a request should be traced.  it is if trace is
+ *    nonzero, because -trace was given, or else if it's picked by the
+ *    session's trace_sample rate.
+ *
+ * Results:
+ *    1 if the request should be traced, else 0
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_trace_wanted (casstcl_sessionClientData *ct, int trace)
+{
+	if (trace) {
+		return 1;
+	}
+
+	return (ct->traceSample > 0.0 && rand () <= ct->traceSample * RAND_MAX);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_start --
+ *
+ *    start the queries of the system_traces session and events of a
+ *    traced request, without waiting for either
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_trace_start (casstcl_sessionClientData *ct, CassUuid tracingId, casstcl_traceFetch *fetch)
+{
+	CassStatement *statement;
+
+	statement = cass_statement_new ("SELECT * FROM system_traces.sessions WHERE session_id = ?", 1);
+	cass_statement_bind_uuid (statement, 0, tracingId);
+	fetch->sessionFuture = cass_session_execute (ct->session, statement);
+	cass_statement_free (statement);
+
+	statement = cass_statement_new ("SELECT * FROM system_traces.events WHERE session_id = ?", 1);
+	cass_statement_bind_uuid (statement, 0, tracingId);
+	fetch->eventsFuture = cass_session_execute (ct->session, statement);
+	cass_statement_free (statement);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_finish --
+ *
+ *    wait for the queries started by casstcl_trace_start and free
+ *    their futures
+ *
+ * Results:
+ *    A standard Tcl result.  On success *traceObjPtr is set to a new
+ *    list of "session", the session's columns as name value pairs
+ *    (empty if it isn't there), "events" and a list of the events,
+ *    each as name value pairs, in the order they happened.
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_trace_finish (casstcl_sessionClientData *ct, casstcl_traceFetch *fetch, Tcl_Obj **traceObjPtr)
+{
+	Tcl_Obj *sessionsObj = NULL;
+	Tcl_Obj *eventsObj = NULL;
+	Tcl_Obj *sessionObj = NULL;
+	int tclReturn;
+
+	cass_future_wait (fetch->sessionFuture);
+	cass_future_wait (fetch->eventsFuture);
+
+	tclReturn = casstcl_future_rows (ct, fetch->sessionFuture, &sessionsObj);
+	if (tclReturn == TCL_OK) {
+		Tcl_IncrRefCount (sessionsObj);
+		tclReturn = casstcl_future_rows (ct, fetch->eventsFuture, &eventsObj);
+	}
+
+	if (tclReturn == TCL_OK) {
+		Tcl_Obj *traceObj = Tcl_NewObj ();
+
+		Tcl_ListObjIndex (NULL, sessionsObj, 0, &sessionObj);
+		Tcl_ListObjAppendElement (NULL, traceObj, Tcl_NewStringObj ("session", -1));
+		Tcl_ListObjAppendElement (NULL, traceObj, (sessionObj != NULL) ? sessionObj : Tcl_NewObj ());
+		Tcl_ListObjAppendElement (NULL, traceObj, Tcl_NewStringObj ("events", -1));
+		Tcl_ListObjAppendElement (NULL, traceObj, eventsObj);
+		*traceObjPtr = traceObj;
+	}
+
+	if (sessionsObj != NULL) {
+		Tcl_DecrRefCount (sessionsObj);
+	}
+
+	cass_future_free (fetch->sessionFuture);
+	cass_future_free (fetch->eventsFuture);
+	return tclReturn;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_eventProc --
+ *
+ *    called from the event loop once the events of a trace being
+ *    fetched with a callback have arrived.  the callback is invoked
+ *    with "ok" and the trace, or "error" and the error message.
+ *
+ * Results:
+ *    1, the event has been handled
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_trace_eventProc (Tcl_Event *tevPtr, int flags) {
+	casstcl_traceEvent *evPtr = (casstcl_traceEvent *)tevPtr;
+	casstcl_traceFetch *fetch = evPtr->fetch;
+	casstcl_sessionClientData *ct = fetch->ct;
+	Tcl_Interp *interp = ct->interp;
+	Tcl_Obj *traceObj;
+	Tcl_Obj *commandObj;
+
+	commandObj = Tcl_DuplicateObj (fetch->callbackObj);
+	Tcl_IncrRefCount (commandObj);
+
+	if (casstcl_trace_finish (ct, fetch, &traceObj) == TCL_OK) {
+		Tcl_ListObjAppendElement (NULL, commandObj, Tcl_NewStringObj ("ok", -1));
+		Tcl_ListObjAppendElement (NULL, commandObj, traceObj);
+	} else {
+		Tcl_ListObjAppendElement (NULL, commandObj, Tcl_NewStringObj ("error", -1));
+		Tcl_ListObjAppendElement (NULL, commandObj, Tcl_GetObjResult (interp));
+	}
+
+	if (!Tcl_InterpDeleted (interp) && Tcl_EvalObjEx (interp, commandObj, TCL_EVAL_GLOBAL) == TCL_ERROR) {
+		Tcl_BackgroundError (interp);
+	}
+
+	Tcl_DecrRefCount (commandObj);
+	Tcl_DecrRefCount (fetch->callbackObj);
+	ckfree ((char *)fetch);
+
+	Tcl_Release ((ClientData)ct);
+	return 1;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_callback --
+ *
+ *    cpp-driver callback for the events query of a trace being
+ *    fetched, which queues an event to the session's thread for
+ *    casstcl_trace_eventProc.  the sessions query was started first,
+ *    so it's nearly always done by then.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_trace_callback (CassFuture *future, void *data) {
+	casstcl_traceFetch *fetch = (casstcl_traceFetch *)data;
+	casstcl_traceEvent *evPtr = (casstcl_traceEvent *) ckalloc (sizeof (casstcl_traceEvent));
+
+	evPtr->event.proc = casstcl_trace_eventProc;
+	evPtr->fetch = fetch;
+	Tcl_ThreadQueueEvent (fetch->ct->threadId, (Tcl_Event *)evPtr, TCL_QUEUE_TAIL);
+	casstcl_wait_notify ();
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_fetch --
+ *
+ *    fetch what Cassandra recorded in system_traces about a traced
+ *    request, its session and its events, with both queries running
+ *    at once.
+ *
+ *    the trace is a list of "session" and the session's columns as
+ *    name value pairs, and "events" and a list of the events, each as
+ *    name value pairs.  without a callback, wait for the queries and
+ *    set the interpreter result to the trace.  with one, return right
+ *    away and invoke the callback from the event loop with "ok" and the
+ *    trace or "error" and the error message.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_trace_fetch (casstcl_sessionClientData *ct, CassUuid tracingId, Tcl_Obj *callbackObj)
+{
+	casstcl_traceFetch fetch;
+	casstcl_traceFetch *fetchPtr;
+	Tcl_Obj *traceObj;
+
+	if (ct->session == NULL) {
+		Tcl_ResetResult (ct->interp);
+		Tcl_AppendResult (ct->interp, "not connected", NULL);
+		return TCL_ERROR;
+	}
+
+	if (callbackObj == NULL) {
+		casstcl_trace_start (ct, tracingId, &fetch);
+		if (casstcl_trace_finish (ct, &fetch, &traceObj) == TCL_ERROR) {
+			return TCL_ERROR;
+		}
+		Tcl_SetObjResult (ct->interp, traceObj);
+		return TCL_OK;
+	}
+
+	fetchPtr = (casstcl_traceFetch *)ckalloc (sizeof (casstcl_traceFetch));
+	fetchPtr->ct = ct;
+	fetchPtr->callbackObj = callbackObj;
+	Tcl_IncrRefCount (callbackObj);
+
+	// the session has to stay around until the event is handled
+	Tcl_Preserve ((ClientData)ct);
+
+	casstcl_trace_start (ct, tracingId, fetchPtr);
+	cass_future_set_callback (fetchPtr->eventsFuture, casstcl_trace_callback, fetchPtr);
+
+	Tcl_ResetResult (ct->interp);
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_sample --
+ *
+ *    implements the trace_sample method of a session,
+ *
+ *      trace_sample ?rate?
+ *
+ *    sets the fraction, from 0 to 1, of the requests made without
+ *    -trace that are traced anyway.  with no argument, returns it.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_trace_sample (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Interp *interp = ct->interp;
+	double sample;
+
+	if (objc > 3) {
+		Tcl_WrongNumArgs (interp, 2, objv, "?rate?");
+		return TCL_ERROR;
+	}
+
+	if (objc == 3) {
+		if (Tcl_GetDoubleFromObj (interp, objv[2], &sample) == TCL_ERROR) {
+			Tcl_AppendResult (interp, " while converting trace sample rate", NULL);
+			return TCL_ERROR;
+		}
+
+		if (sample < 0.0 || sample > 1.0) {
+			Tcl_ResetResult (interp);
+			Tcl_AppendResult (interp, "trace sample rate must be from 0 to 1", NULL);
+			return TCL_ERROR;
+		}
+
+		ct->traceSample = sample;
+	}
+
+	Tcl_SetObjResult (interp, Tcl_NewDoubleObj (ct->traceSample));
+	return TCL_OK;
+}
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
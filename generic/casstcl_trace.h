@@ -0,0 +1,179 @@
+/*
+ *
+ * Include file for trace
+ *
+ * Copyright (C) 2015 by FlightAware, All Rights Reserved
+ *
+ * Freely redistributable under the Berkeley copyright, see license.terms
+ * for details.
+ */
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_future_tracing_id --
+ *
+ *    get the tracing id of a future's request, waiting for the request
+ *    to complete if it hasn't
+ *
+ * Results:
+ *    1 if the request was traced and the id is in *tracingIdPtr, else 0
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_future_tracing_id (casstcl_futureClientData *fcd, CassUuid *tracingIdPtr);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_rows --
+ *
+ *    run a query of the system_traces tables with the tracing id bound
+ *    to its one parameter and wait for the rows.  the cpp-driver waits
+ *    for the trace to be written before completing a traced request, so
+ *    it's there by the time anyone has the tracing id.
+ *
+ * Results:
+ *    A standard Tcl result.  On success *listObjPtr is set to a list of
+ *    the rows, each a list of column name and value pairs, as made by
+ *    casstcl_future_rows.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_trace_rows (casstcl_sessionClientData *ct, CONST char *query, CassUuid tracingId, Tcl_Obj **listObjPtr);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_coordinator_start --
+ *
+ *    start the query for the address of the node that coordinated a
+ *    traced request, without waiting for it.  the session must be
+ *    connected.
+ *
+ * Results:
+ *    The query's future, for casstcl_trace_coordinator_finish
+ *
+ *----------------------------------------------------------------------
+ */
+CassFuture *
+casstcl_trace_coordinator_start (casstcl_sessionClientData *ct, CassUuid tracingId);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_coordinator_finish --
+ *
+ *    wait for the query started by casstcl_trace_coordinator_start,
+ *    if it isn't done, and free its future
+ *
+ * Results:
+ *    A standard Tcl result.  On success *addressObjPtr is set to the
+ *    address, or to an empty object if the trace doesn't have it.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_trace_coordinator_finish (casstcl_sessionClientData *ct, CassFuture *future, Tcl_Obj **addressObjPtr);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_coordinator --
+ *
+ *    look up the address of the node that coordinated a traced request.
+ *    this runs a query and blocks until it's answered, so it's only for
+ *    the future methods, never for an event or idle handler.
+ *
+ * Results:
+ *    A standard Tcl result.  On success *addressObjPtr is set to the
+ *    address, or to an empty object if the trace doesn't have it.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_trace_coordinator (casstcl_sessionClientData *ct, CassUuid tracingId, Tcl_Obj **addressObjPtr);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_hosts --
+ *
+ *    look up the addresses of the nodes that did any of the work of a
+ *    traced request, the coordinator and the replicas it asked, in the
+ *    order they first show up in the trace.  like
+ *    casstcl_trace_coordinator, this blocks on its queries.
+ *
+ * Results:
+ *    A standard Tcl result.  On success *listObjPtr is set to a new
+ *    list of the addresses.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_trace_hosts (casstcl_sessionClientData *ct, CassUuid tracingId, Tcl_Obj **listObjPtr);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_wanted --
+ *
+ *    decide whether a request should be traced.  it is if trace is
+ *    nonzero, because -trace was given, or else if it's picked by the
+ *    session's trace_sample rate.
+ *
+ * Results:
+ *    1 if the request should be traced, else 0
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_trace_wanted (casstcl_sessionClientData *ct, int trace);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_fetch --
+ *
+ *    fetch what Cassandra recorded in system_traces about a traced
+ *    request, its session and its events, with both queries running
+ *    at once.
+ *
+ *    the trace is a list of "session" and the session's columns as
+ *    name value pairs, and "events" and a list of the events, each as
+ *    name value pairs.  without a callback, wait for the queries and
+ *    set the interpreter result to the trace.  with one, return right
+ *    away and invoke the callback from the event loop with "ok" and the
+ *    trace or "error" and the error message.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_trace_fetch (casstcl_sessionClientData *ct, CassUuid tracingId, Tcl_Obj *callbackObj);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_trace_sample --
+ *
+ *    implements the trace_sample method of a session,
+ *
+ *      trace_sample ?rate?
+ *
+ *    sets the fraction, from 0 to 1, of the requests made without
+ *    -trace that are traced anyway.  with no argument, returns it.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_trace_sample (casstcl_sessionClientData *ct, int objc, Tcl_Obj *CONST objv[]);
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
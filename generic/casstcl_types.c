@@ -593,7 +593,7 @@ casstcl_typename_obj_to_cass_value_types (Tcl_Interp *interp, char *table, Tcl_O
 /*
  *----------------------------------------------------------------------
  *
- * casstcl_cass_value_to_tcl_obj --
+ * casstcl_value_to_tcl_obj --
  *
  *      Given a cassandra CassValue, generate a Tcl_Obj of a corresponding
  *      type
@@ -607,7 +607,7 @@ casstcl_typename_obj_to_cass_value_types (Tcl_Interp *interp, char *table, Tcl_O
  *----------------------------------------------------------------------
  */
 
-int casstcl_cass_value_to_tcl_obj (casstcl_sessionClientData *ct, const CassValue *cassValue, Tcl_Obj **tclObj)
+static int casstcl_value_to_tcl_obj (casstcl_sessionClientData *ct, const CassValue *cassValue, Tcl_Obj **tclObj)
 {
   char msg[60];
   CassValueType valueType = cass_value_type (cassValue);
@@ -882,14 +882,14 @@ int casstcl_cass_value_to_tcl_obj (casstcl_sessionClientData *ct, const CassValu
       Tcl_Obj *mapValue;
 
       while (cass_iterator_next(iterator)) {
-        if (casstcl_cass_value_to_tcl_obj (ct, cass_iterator_get_map_key (iterator), &mapKey) == TCL_ERROR) {
+        if (casstcl_value_to_tcl_obj (ct, cass_iterator_get_map_key (iterator), &mapKey) == TCL_ERROR) {
           cass_iterator_free (iterator);
           *tclObj = NULL;
           return TCL_ERROR;
 
         }
 
-        if (casstcl_cass_value_to_tcl_obj (ct, cass_iterator_get_map_value (iterator), &mapValue)  == TCL_ERROR) {
+        if (casstcl_value_to_tcl_obj (ct, cass_iterator_get_map_value (iterator), &mapValue)  == TCL_ERROR) {
           cass_iterator_free (iterator);
           *tclObj = NULL;
           return TCL_ERROR;
@@ -915,7 +915,7 @@ int casstcl_cass_value_to_tcl_obj (casstcl_sessionClientData *ct, const CassValu
       while (cass_iterator_next(iterator)) {
         Tcl_Obj *collectionValue;
 
-        if (casstcl_cass_value_to_tcl_obj (ct, cass_iterator_get_value (iterator), &collectionValue) == TCL_ERROR) {
+        if (casstcl_value_to_tcl_obj (ct, cass_iterator_get_value (iterator), &collectionValue) == TCL_ERROR) {
           cass_iterator_free (iterator);
           *tclObj = NULL;
           return TCL_ERROR;
@@ -940,6 +940,30 @@ int casstcl_cass_value_to_tcl_obj (casstcl_sessionClientData *ct, const CassValu
   return TCL_ERROR;
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_cass_value_to_tcl_obj --
+ *
+ *      Given a cassandra CassValue, generate a Tcl_Obj of a corresponding
+ *      type, counting the values that can't be converted in the
+ *      session's conversion errors
+ *
+ * Results:
+ *      A standard Tcl result.
+ *
+ *----------------------------------------------------------------------
+ */
+
+int casstcl_cass_value_to_tcl_obj (casstcl_sessionClientData *ct, const CassValue *cassValue, Tcl_Obj **tclObj)
+{
+  if (casstcl_value_to_tcl_obj (ct, cassValue, tclObj) == TCL_ERROR) {
+    ct->conversionErrors++;
+    return TCL_ERROR;
+  }
+  return TCL_OK;
+}
+
 
 /*
  *----------------------------------------------------------------------
@@ -1568,7 +1592,7 @@ int casstcl_append_tcl_obj_to_collection (casstcl_sessionClientData *ct, CassCol
 /*
  *----------------------------------------------------------------------
  *
- * casstcl_bind_tcl_obj --
+ * casstcl_bind_one_tcl_obj --
  *
  * This routine binds Tcl objects to ?-substitution parameters in nascent
  * cassandra statements.
@@ -1595,9 +1619,9 @@ int casstcl_append_tcl_obj_to_collection (casstcl_sessionClientData *ct, CassCol
  *----------------------------------------------------------------------
  */
 
-int casstcl_bind_tcl_obj (casstcl_sessionClientData *ct, CassStatement *statement, char *name, int name_length, cass_size_t index, casstcl_cassTypeInfo *typeInfo, Tcl_Obj *obj)
+static int casstcl_bind_one_tcl_obj (casstcl_sessionClientData *ct, CassStatement *statement, char *name, int name_length, cass_size_t index, casstcl_cassTypeInfo *typeInfo, Tcl_Obj *obj)
 {
-// printf("casstcl_bind_tcl_obj called, index %d, valueType %d\n", index, typeInfo->cassValueType);
+// printf("casstcl_bind_one_tcl_obj called, index %d, valueType %d\n", index, typeInfo->cassValueType);
   Tcl_Interp *interp = ct->interp;
   CassError cassError = CASS_OK;
 
@@ -1977,6 +2001,30 @@ int casstcl_bind_tcl_obj (casstcl_sessionClientData *ct, CassStatement *statemen
   return TCL_OK;
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_bind_tcl_obj --
+ *
+ * Bind a Tcl object to a ?-substitution parameter of a statement, as
+ * casstcl_bind_one_tcl_obj does, counting the objects that can't be
+ * converted in the session's conversion errors.
+ *
+ * Results:
+ *      A standard Tcl result.
+ *
+ *----------------------------------------------------------------------
+ */
+
+int casstcl_bind_tcl_obj (casstcl_sessionClientData *ct, CassStatement *statement, char *name, int name_length, cass_size_t index, casstcl_cassTypeInfo *typeInfo, Tcl_Obj *obj)
+{
+  if (casstcl_bind_one_tcl_obj (ct, statement, name, name_length, index, typeInfo, obj) == TCL_ERROR) {
+    ct->conversionErrors++;
+    return TCL_ERROR;
+  }
+  return TCL_OK;
+}
+
 /*
  *----------------------------------------------------------------------
  *
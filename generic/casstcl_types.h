@@ -291,7 +291,8 @@ int casstcl_typename_obj_to_cass_value_types (
  * casstcl_cass_value_to_tcl_obj --
  *
  *      Given a cassandra CassValue, generate a Tcl_Obj of a corresponding
- *      type
+ *      type, counting the values that can't be converted in the
+ *      session's conversion errors
  *
  *      This is a vital routine to the entire edifice.
  *
@@ -348,7 +349,8 @@ int casstcl_append_tcl_obj_to_collection (
  * It takes a statement, an index (which parameter to substitute left to
  * right from 0 to n-1), the cassandra data type (and subtype(s) if it is
  * a list, set or map), and it will convert the Tcl object to the specified
- * data type and bind it to the statement.
+ * data type and bind it to the statement.  Objects that can't be converted
+ * are counted in the session's conversion errors.
  *
  * This is a really important routine.
  *
@@ -0,0 +1,1547 @@
+/*
+ * casstcl_writeq - Functions used to implement write queues, which send
+ *   upserts with a limited number in flight, retry the ones that fail
+ *   with exponential backoff, and spill to a journal file when too many
+ *   are waiting
+ *
+ * casstcl - Tcl interface to CassDB
+ *
+ * Copyright (C) 2014 FlightAware LLC
+ *
+ * freely redistributable under the Berkeley license
+ */
+
+#include "casstcl.h"
+#include "casstcl_writeq.h"
+#include "casstcl_cassandra.h"
+#include "casstcl_consistency.h"
+#include "casstcl_error.h"
+#include "casstcl_future.h"
+#include "casstcl_ratelimit.h"
+#include "casstcl_breaker.h"
+
+#include <assert.h>
+#include <unistd.h>
+
+static void casstcl_writeq_pump (casstcl_writeQueueClientData *queue);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_append --
+ *
+ *    add a write to the end of one of a write queue's lists
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_writeq_append (casstcl_writeQueueList *list, casstcl_writeQueueItem *item)
+{
+	item->next = NULL;
+	item->prev = list->tail;
+
+	if (list->tail != NULL) {
+		list->tail->next = item;
+	} else {
+		list->head = item;
+	}
+	list->tail = item;
+	list->count++;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_insert_by_time --
+ *
+ *    add a write to a list kept in order of when the writes are ready
+ *    to be retried
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_writeq_insert_by_time (casstcl_writeQueueList *list, casstcl_writeQueueItem *item)
+{
+	casstcl_writeQueueItem *after = list->tail;
+
+	while (after != NULL && after->readyAt > item->readyAt) {
+		after = after->prev;
+	}
+
+	item->prev = after;
+	item->next = (after != NULL) ? after->next : list->head;
+
+	if (item->next != NULL) {
+		item->next->prev = item;
+	} else {
+		list->tail = item;
+	}
+
+	if (after != NULL) {
+		after->next = item;
+	} else {
+		list->head = item;
+	}
+	list->count++;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_remove --
+ *
+ *    take a write off whichever of a write queue's lists it is on
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_writeq_remove (casstcl_writeQueueList *list, casstcl_writeQueueItem *item)
+{
+	if (item->prev != NULL) {
+		item->prev->next = item->next;
+	} else {
+		list->head = item->next;
+	}
+
+	if (item->next != NULL) {
+		item->next->prev = item->prev;
+	} else {
+		list->tail = item->prev;
+	}
+
+	item->prev = NULL;
+	item->next = NULL;
+	list->count--;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_size --
+ *
+ *    return what a write counts as against a write queue's -max_memory
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_writeq_size (Tcl_Obj *writeObj)
+{
+	int length;
+
+	Tcl_GetStringFromObj (writeObj, &length);
+	return length + sizeof (casstcl_writeQueueItem);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_new_item --
+ *
+ *    make a write queue item for a write and count it against the
+ *    queue's memory.  it isn't on any list yet.
+ *
+ *----------------------------------------------------------------------
+ */
+static casstcl_writeQueueItem *
+casstcl_writeq_new_item (casstcl_writeQueueClientData *queue, Tcl_Obj *writeObj)
+{
+	casstcl_writeQueueItem *item = (casstcl_writeQueueItem *)ckalloc (sizeof (casstcl_writeQueueItem));
+
+	item->queue = queue;
+	item->writeObj = writeObj;
+	Tcl_IncrRefCount (writeObj);
+	item->size = casstcl_writeq_size (writeObj);
+	item->attempts = 0;
+	item->readyAt = 0;
+	item->prev = NULL;
+	item->next = NULL;
+
+	queue->memory += item->size;
+	return item;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_free_item --
+ *
+ *    free a write queue item that is no longer on any list
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_writeq_free_item (casstcl_writeQueueItem *item)
+{
+	item->queue->memory -= item->size;
+	Tcl_DecrRefCount (item->writeObj);
+	ckfree ((char *)item);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_statement --
+ *
+ *    make the upsert statement for a write
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_writeq_statement (casstcl_writeQueueClientData *queue, int objc, Tcl_Obj *CONST objv[], CassStatement **statementPtr)
+{
+	CassConsistency *consistencyPtr = (queue->consistency == CASS_CONSISTENCY_UNKNOWN) ? NULL : &queue->consistency;
+
+	return casstcl_make_upsert_statement_from_objv (queue->ct, objc, objv, consistencyPtr, statementPtr);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_fail --
+ *
+ *    give up on a write, taking the error message from the interpreter
+ *    result.  if the queue has a -fail_callback it's invoked with the
+ *    write and the error message; if that gets an error, a Tcl
+ *    background exception is invoked.  the callback may delete the
+ *    queue.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_writeq_fail (casstcl_writeQueueClientData *queue, casstcl_writeQueueItem *item)
+{
+	Tcl_Interp *interp = queue->ct->interp;
+	Tcl_Obj *errorObj = Tcl_GetObjResult (interp);
+	Tcl_Obj *evalObj;
+	int tclReturn;
+
+	queue->failed++;
+
+	Tcl_IncrRefCount (errorObj);
+	Tcl_ResetResult (interp);
+
+	if (queue->failCallbackObj != NULL && !Tcl_InterpDeleted (interp)) {
+		evalObj = Tcl_DuplicateObj (queue->failCallbackObj);
+		Tcl_IncrRefCount (evalObj);
+
+		tclReturn = Tcl_ListObjAppendElement (interp, evalObj, item->writeObj);
+		if (tclReturn == TCL_OK) {
+			Tcl_ListObjAppendElement (NULL, evalObj, errorObj);
+			tclReturn = Tcl_EvalObjEx (interp, evalObj, TCL_EVAL_GLOBAL);
+		}
+
+		if (tclReturn == TCL_ERROR) {
+			Tcl_BackgroundError (interp);
+		}
+		Tcl_DecrRefCount (evalObj);
+	}
+
+	Tcl_DecrRefCount (errorObj);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_retry_delay --
+ *
+ *    return how many milliseconds a write that has been sent attempts
+ *    times should wait before it's sent again.  the backoff doubles with
+ *    each attempt up to -max_backoff, and a random half of it is taken
+ *    off so that writes that failed together don't all come back at
+ *    once.
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_writeq_retry_delay (casstcl_writeQueueClientData *queue, int attempts)
+{
+	Tcl_WideInt delay = queue->backoff;
+	int i;
+
+	for (i = 1; i < attempts && delay < queue->maxBackoff; i++) {
+		delay *= 2;
+	}
+
+	if (delay > queue->maxBackoff) {
+		delay = queue->maxBackoff;
+	}
+
+	queue->jitterSeed = queue->jitterSeed * 1103515245 + 12345;
+	return (int)(delay / 2 + ((queue->jitterSeed >> 16) % (delay / 2 + 1)));
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_journal_error --
+ *
+ *    set the interpreter result to an error about the journal file
+ *    from errno
+ *
+ * Results:
+ *    TCL_ERROR
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_writeq_journal_error (Tcl_Interp *interp, char *action, Tcl_Obj *pathObj)
+{
+	Tcl_ResetResult (interp);
+	Tcl_AppendResult (interp, "couldn't ", action, " write queue journal \"", Tcl_GetString (pathObj), "\": ", Tcl_PosixError (interp), NULL);
+	return TCL_ERROR;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_journal_write --
+ *
+ *    write one write to a journal channel.  each write is the length of
+ *    its upsert arguments as a list, a newline, the list and a newline.
+ *
+ * Results:
+ *    A standard Tcl result, the caller sets the error message
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_writeq_journal_write (Tcl_Channel channel, Tcl_Obj *writeObj)
+{
+	char header[32];
+	int length;
+	const char *string = Tcl_GetStringFromObj (writeObj, &length);
+	int headerLength = snprintf (header, sizeof (header), "%d\n", length);
+
+	if (Tcl_Write (channel, header, headerLength) < 0 || Tcl_Write (channel, string, length) < 0 || Tcl_Write (channel, "\n", 1) < 0) {
+		return TCL_ERROR;
+	}
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_journal_read --
+ *
+ *    read the next write from a journal channel
+ *
+ * Results:
+ *    1 and the write in a new object if there was one, 0 at the end of
+ *    the journal or if what's left of it is damaged, such as a write
+ *    cut short by a crash
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_writeq_journal_read (Tcl_Channel channel, Tcl_Obj **writeObjPtr)
+{
+	Tcl_Obj *lineObj = Tcl_NewObj ();
+	char *buffer;
+	char newline;
+	int length;
+
+	Tcl_IncrRefCount (lineObj);
+	if (Tcl_GetsObj (channel, lineObj) < 0 || Tcl_GetIntFromObj (NULL, lineObj, &length) == TCL_ERROR || length <= 0) {
+		Tcl_DecrRefCount (lineObj);
+		return 0;
+	}
+	Tcl_DecrRefCount (lineObj);
+
+	buffer = ckalloc (length);
+	if (Tcl_Read (channel, buffer, length) != length || Tcl_Read (channel, &newline, 1) != 1 || newline != '\n') {
+		ckfree (buffer);
+		return 0;
+	}
+
+	*writeObjPtr = Tcl_NewStringObj (buffer, length);
+	ckfree (buffer);
+	return 1;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_journal_count --
+ *
+ *    count the writes in a journal file, which needn't exist
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_writeq_journal_count (Tcl_Interp *interp, Tcl_Obj *pathObj, Tcl_WideInt *countPtr)
+{
+	Tcl_Channel channel;
+	Tcl_Obj *writeObj;
+
+	*countPtr = 0;
+
+	if (Tcl_FSAccess (pathObj, F_OK) != 0) {
+		return TCL_OK;
+	}
+
+	channel = Tcl_FSOpenFileChannel (interp, pathObj, "r", 0);
+	if (channel == NULL) {
+		Tcl_AppendResult (interp, " while opening write queue journal", NULL);
+		return TCL_ERROR;
+	}
+	Tcl_SetChannelOption (NULL, channel, "-translation", "binary");
+
+	while (casstcl_writeq_journal_read (channel, &writeObj)) {
+		Tcl_IncrRefCount (writeObj);
+		Tcl_DecrRefCount (writeObj);
+		(*countPtr)++;
+	}
+
+	Tcl_Close (NULL, channel);
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_journal_truncate --
+ *
+ *    empty a write queue's journal file once everything in it has been
+ *    read back
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_writeq_journal_truncate (casstcl_writeQueueClientData *queue)
+{
+	Tcl_Channel channel;
+
+	if (queue->journalChannel != NULL) {
+		Tcl_Close (NULL, queue->journalChannel);
+		queue->journalChannel = NULL;
+	}
+
+	channel = Tcl_FSOpenFileChannel (NULL, queue->journalObj, "w", 0644);
+	if (channel != NULL) {
+		Tcl_Close (NULL, channel);
+	}
+	queue->journalOffset = 0;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_spill --
+ *
+ *    append a write to a write queue's journal
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_writeq_spill (casstcl_writeQueueClientData *queue, Tcl_Obj *writeObj)
+{
+	Tcl_Interp *interp = queue->ct->interp;
+
+	if (queue->journalChannel == NULL) {
+		queue->journalChannel = Tcl_FSOpenFileChannel (interp, queue->journalObj, "a", 0644);
+		if (queue->journalChannel == NULL) {
+			Tcl_AppendResult (interp, " while opening write queue journal", NULL);
+			return TCL_ERROR;
+		}
+		Tcl_SetChannelOption (NULL, queue->journalChannel, "-translation", "binary");
+	}
+
+	// flushed each time so a crash loses as little as possible
+	if (casstcl_writeq_journal_write (queue->journalChannel, writeObj) == TCL_ERROR || Tcl_Flush (queue->journalChannel) != TCL_OK) {
+		return casstcl_writeq_journal_error (interp, "write", queue->journalObj);
+	}
+
+	queue->journaled++;
+	queue->spilled++;
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_replay --
+ *
+ *    once the writes in memory are down to half of -max_memory, read
+ *    writes back from the journal, oldest first, until it's full again
+ *    or the journal is empty, in which case the file is truncated.
+ *
+ *    if the rest of the journal is damaged it's given up on.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_writeq_replay (casstcl_writeQueueClientData *queue)
+{
+	Tcl_Interp *interp = queue->ct->interp;
+	Tcl_Channel channel;
+	Tcl_Obj *writeObj;
+
+	if (queue->journaled == 0 || queue->memory * 2 > queue->maxMemory) {
+		return TCL_OK;
+	}
+
+	channel = Tcl_FSOpenFileChannel (interp, queue->journalObj, "r", 0);
+	if (channel == NULL) {
+		// don't keep trying on every write that completes
+		queue->journaled = 0;
+		Tcl_AppendResult (interp, " while replaying write queue journal", NULL);
+		return TCL_ERROR;
+	}
+	Tcl_SetChannelOption (NULL, channel, "-translation", "binary");
+	Tcl_Seek (channel, queue->journalOffset, SEEK_SET);
+
+	while (queue->journaled > 0 && queue->memory < queue->maxMemory) {
+		if (!casstcl_writeq_journal_read (channel, &writeObj)) {
+			queue->journaled = 0;
+			break;
+		}
+
+		casstcl_writeq_append (&queue->waiting, casstcl_writeq_new_item (queue, writeObj));
+		queue->journaled--;
+		queue->replayed++;
+	}
+
+	queue->journalOffset = Tcl_Tell (channel);
+	Tcl_Close (NULL, channel);
+
+	if (queue->journaled == 0) {
+		casstcl_writeq_journal_truncate (queue);
+	}
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_journal_all --
+ *
+ *    rewrite a write queue's journal to hold every write that isn't
+ *    known to be written: the ones waiting to be retried, in flight and
+ *    waiting to be sent, followed by what hasn't been read back from the
+ *    journal, so they're all replayed the next time the journal is
+ *    used.  used when the queue is deleted.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_writeq_journal_all (casstcl_writeQueueClientData *queue)
+{
+	Tcl_Interp *interp = queue->ct->interp;
+	casstcl_writeQueueList *lists[3] = {&queue->retrying, &queue->inflight, &queue->waiting};
+	casstcl_writeQueueItem *item;
+	Tcl_Channel out;
+	Tcl_Obj *tempObj;
+	int tclReturn = TCL_OK;
+	int i;
+
+	if (queue->retrying.count + queue->inflight.count + queue->waiting.count == 0) {
+		if (queue->journaled == 0) {
+			casstcl_writeq_journal_truncate (queue);
+		}
+
+		if (queue->journalOffset == 0) {
+			return TCL_OK;
+		}
+	}
+
+	if (queue->journalChannel != NULL) {
+		Tcl_Close (NULL, queue->journalChannel);
+		queue->journalChannel = NULL;
+	}
+
+	tempObj = Tcl_ObjPrintf ("%s.tmp", Tcl_GetString (queue->journalObj));
+	Tcl_IncrRefCount (tempObj);
+
+	out = Tcl_FSOpenFileChannel (interp, tempObj, "w", 0644);
+	if (out == NULL) {
+		Tcl_AppendResult (interp, " while saving write queue", NULL);
+		Tcl_DecrRefCount (tempObj);
+		return TCL_ERROR;
+	}
+	Tcl_SetChannelOption (NULL, out, "-translation", "binary");
+
+	for (i = 0; i < 3 && tclReturn == TCL_OK; i++) {
+		for (item = lists[i]->head; item != NULL; item = item->next) {
+			if (casstcl_writeq_journal_write (out, item->writeObj) == TCL_ERROR) {
+				tclReturn = casstcl_writeq_journal_error (interp, "write", tempObj);
+				break;
+			}
+		}
+	}
+
+	if (tclReturn == TCL_OK && queue->journaled > 0) {
+		Tcl_Channel in = Tcl_FSOpenFileChannel (interp, queue->journalObj, "r", 0);
+		char buffer[8192];
+		int count;
+
+		if (in == NULL) {
+			Tcl_AppendResult (interp, " while saving write queue", NULL);
+			tclReturn = TCL_ERROR;
+		} else {
+			Tcl_SetChannelOption (NULL, in, "-translation", "binary");
+			Tcl_Seek (in, queue->journalOffset, SEEK_SET);
+
+			while ((count = Tcl_Read (in, buffer, sizeof (buffer))) > 0) {
+				if (Tcl_Write (out, buffer, count) < 0) {
+					tclReturn = casstcl_writeq_journal_error (interp, "write", tempObj);
+					break;
+				}
+			}
+			Tcl_Close (NULL, in);
+		}
+	}
+
+	if (Tcl_Close (interp, out) != TCL_OK) {
+		tclReturn = TCL_ERROR;
+	}
+
+	if (tclReturn == TCL_OK && Tcl_FSRenameFile (tempObj, queue->journalObj) != 0) {
+		tclReturn = casstcl_writeq_journal_error (interp, "replace", queue->journalObj);
+	}
+
+	if (tclReturn == TCL_OK) {
+		queue->journaled += queue->retrying.count + queue->inflight.count + queue->waiting.count;
+		queue->journalOffset = 0;
+	} else {
+		Tcl_FSDeleteFile (tempObj);
+	}
+
+	Tcl_DecrRefCount (tempObj);
+	return tclReturn;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_eventProc --
+ *
+ *    this routine is called by the Tcl event handler when a write a
+ *    write queue sent has completed
+ *
+ * Results:
+ *    A write that succeeded is done.  One that failed in a way that
+ *    may not happen again is put back to be retried after its backoff,
+ *    unless it has run out of retries.  Otherwise it's given up on.
+ *    Then more writes are sent if there's room.
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+casstcl_writeq_eventProc (Tcl_Event *tevPtr, int flags) {
+	casstcl_writeQueueEvent *evPtr = (casstcl_writeQueueEvent *)tevPtr;
+	casstcl_writeQueueItem *item = evPtr->item;
+	casstcl_writeQueueClientData *queue = item->queue;
+	casstcl_sessionClientData *ct = queue->ct;
+	CassError rc = cass_future_error_code (evPtr->future);
+	Tcl_Obj **objv;
+	int objc;
+
+	if (Tcl_ListObjGetElements (NULL, item->writeObj, &objc, &objv) == TCL_OK) {
+		casstcl_breaker_record (ct, casstcl_rate_limit_table_from_objv (ct, objc, objv, 0, 1), rc);
+	}
+
+	casstcl_writeq_remove (&queue->inflight, item);
+
+	if (rc == CASS_OK) {
+		queue->written++;
+		casstcl_writeq_free_item (item);
+	} else if (queue->shutDown) {
+		// it was saved in the journal, or there's nothing to do about it
+		casstcl_writeq_free_item (item);
+	} else if (casstcl_cass_error_is_transient (rc) && item->attempts <= queue->retries) {
+		item->readyAt = casstcl_now_ms () + casstcl_writeq_retry_delay (queue, item->attempts);
+		casstcl_writeq_insert_by_time (&queue->retrying, item);
+		queue->retried++;
+	} else {
+		casstcl_future_error_to_tcl (ct, rc, evPtr->future);
+		casstcl_writeq_fail (queue, item);
+		casstcl_writeq_free_item (item);
+	}
+
+	cass_future_free (evPtr->future);
+
+	if (!queue->shutDown) {
+		casstcl_writeq_pump (queue);
+	}
+
+	Tcl_Release ((ClientData)queue);
+	Tcl_Release ((ClientData)ct);
+	return 1;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_callback --
+ *
+ *    this routine is called by the cassandra cpp-driver, in one of its
+ *    own threads, when a write a write queue sent completes.  it queues
+ *    an event to the session's thread for casstcl_writeq_eventProc.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_writeq_callback (CassFuture *future, void *data) {
+	casstcl_writeQueueItem *item = (casstcl_writeQueueItem *)data;
+	casstcl_writeQueueEvent *evPtr = (casstcl_writeQueueEvent *) ckalloc (sizeof (casstcl_writeQueueEvent));
+
+	evPtr->event.proc = casstcl_writeq_eventProc;
+	evPtr->item = item;
+	evPtr->future = future;
+	Tcl_ThreadQueueEvent (item->queue->ct->threadId, (Tcl_Event *)evPtr, TCL_QUEUE_TAIL);
+	casstcl_wait_notify ();
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_send --
+ *
+ *    send a write with its statement, which is freed
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_writeq_send (casstcl_writeQueueClientData *queue, casstcl_writeQueueItem *item, CassStatement *statement)
+{
+	casstcl_sessionClientData *ct = queue->ct;
+	CassFuture *future;
+
+	item->attempts++;
+	casstcl_writeq_append (&queue->inflight, item);
+
+	// the queue and the session have to stay around until the write's
+	// event is handled, even if they're deleted in the meantime
+	Tcl_Preserve ((ClientData)queue);
+	Tcl_Preserve ((ClientData)ct);
+
+	future = cass_session_execute (ct->session, statement);
+	cass_statement_free (statement);
+	cass_future_set_callback (future, casstcl_writeq_callback, item);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_timer_proc --
+ *
+ *    timer callback for when the first write waiting out its backoff is
+ *    ready to be retried
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_writeq_timer_proc (ClientData clientData)
+{
+	casstcl_writeQueueClientData *queue = (casstcl_writeQueueClientData *)clientData;
+
+	queue->timer = NULL;
+	casstcl_writeq_pump (queue);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_schedule --
+ *
+ *    set a write queue's timer for when the first write waiting out its
+ *    backoff is ready to be retried or, if throttle isn't 0, when the
+ *    circuit breakers and rate limits will let the next write be sent,
+ *    whichever is sooner
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_writeq_schedule (casstcl_writeQueueClientData *queue, Tcl_WideInt now, Tcl_WideInt throttle)
+{
+	Tcl_WideInt wait = throttle;
+
+	if (queue->timer != NULL) {
+		Tcl_DeleteTimerHandler (queue->timer);
+		queue->timer = NULL;
+	}
+
+	if (queue->shutDown) {
+		return;
+	}
+
+	if (queue->retrying.head != NULL && (wait == 0 || queue->retrying.head->readyAt - now < wait)) {
+		wait = queue->retrying.head->readyAt - now;
+		if (wait < 0) {
+			wait = 0;
+		}
+	} else if (wait == 0) {
+		return;
+	}
+
+	queue->timer = Tcl_CreateTimerHandler ((int)wait, casstcl_writeq_timer_proc, (ClientData)queue);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_admit --
+ *
+ *    see if an upsert, objv holding its arguments, can be sent now,
+ *    past the circuit breakers and rate limits of the session and of
+ *    its table
+ *
+ * Results:
+ *    0 if it can, otherwise the number of milliseconds to hold it back
+ *
+ *----------------------------------------------------------------------
+ */
+static Tcl_WideInt
+casstcl_writeq_admit (casstcl_writeQueueClientData *queue, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Obj *tableNameObj = casstcl_rate_limit_table_from_objv (queue->ct, objc, objv, 0, 1);
+	Tcl_WideInt retry = 0;
+
+	if (!casstcl_breaker_admit (queue->ct, tableNameObj, &retry)) {
+		return retry;
+	}
+
+	return casstcl_rate_limit_acquire (queue->ct, tableNameObj);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_pump --
+ *
+ *    send as many writes as -max_inflight, the circuit breakers and the
+ *    rate limits allow, retries that are ready first, reading writes
+ *    back from the journal if there's room for them, and set a timer for
+ *    when more can be sent
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+casstcl_writeq_pump (casstcl_writeQueueClientData *queue)
+{
+	Tcl_Interp *interp = queue->ct->interp;
+	Tcl_WideInt now = casstcl_now_ms ();
+	Tcl_WideInt throttle = 0;
+
+	// a -fail_callback may delete the queue
+	Tcl_Preserve ((ClientData)queue);
+
+	if (casstcl_writeq_replay (queue) == TCL_ERROR) {
+		Tcl_BackgroundError (interp);
+	}
+
+	while (!queue->shutDown && queue->inflight.count < queue->maxInflight) {
+		casstcl_writeQueueList *list;
+		casstcl_writeQueueItem *item;
+		CassStatement *statement = NULL;
+		Tcl_Obj **objv;
+		int objc;
+
+		if (queue->retrying.head != NULL && queue->retrying.head->readyAt <= now) {
+			list = &queue->retrying;
+		} else if (queue->waiting.head != NULL) {
+			list = &queue->waiting;
+		} else {
+			break;
+		}
+		item = list->head;
+
+		// writes were checked when they were queued, but ones read back
+		// from the journal weren't, and the schema may have changed
+		if (Tcl_ListObjGetElements (interp, item->writeObj, &objc, &objv) == TCL_OK) {
+			// a write held back by a circuit breaker or the rate limit
+			// stays where it is
+			if ((throttle = casstcl_writeq_admit (queue, objc, objv)) > 0) {
+				break;
+			}
+		}
+
+		casstcl_writeq_remove (list, item);
+
+		if (Tcl_ListObjGetElements (interp, item->writeObj, &objc, &objv) == TCL_ERROR || casstcl_writeq_statement (queue, objc, objv, &statement) == TCL_ERROR) {
+			casstcl_writeq_fail (queue, item);
+			casstcl_writeq_free_item (item);
+			continue;
+		}
+
+		casstcl_writeq_send (queue, item, statement);
+	}
+
+	casstcl_writeq_schedule (queue, now, throttle);
+	Tcl_Release ((ClientData)queue);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_upsert --
+ *
+ *    queue an upsert.  objv holds the upsert arguments, ?-mapunknown
+ *    columnName? ?-nocomplain? ?-ifnotexists? table keyValuePairList.
+ *
+ *    the statement is made right away, so a write that can't be made
+ *    into one is an error here.  if the queue has room in flight and
+ *    nothing is waiting ahead of it the write is sent, otherwise it
+ *    waits its turn.  if it doesn't fit in -max_memory, or writes are
+ *    already in the journal, it goes to the journal, so writes are
+ *    always sent in the order they were queued (retries aside).
+ *
+ * Results:
+ *    A standard Tcl result.  Without a journal, a write that doesn't
+ *    fit is an error with an errorCode of CASSTCL WRITE_QUEUE_FULL.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_writeq_upsert (casstcl_writeQueueClientData *queue, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Interp *interp = queue->ct->interp;
+	CassStatement *statement = NULL;
+	Tcl_Obj *writeObj;
+	int tclReturn = TCL_OK;
+
+	if (casstcl_writeq_statement (queue, objc, objv, &statement) == TCL_ERROR) {
+		return TCL_ERROR;
+	}
+
+	writeObj = Tcl_NewListObj (objc, objv);
+	Tcl_IncrRefCount (writeObj);
+
+	if (queue->journaled == 0 && queue->memory + casstcl_writeq_size (writeObj) <= queue->maxMemory) {
+		casstcl_writeQueueItem *item = casstcl_writeq_new_item (queue, writeObj);
+
+		if (queue->waiting.count == 0 && queue->inflight.count < queue->maxInflight) {
+			Tcl_WideInt throttle = casstcl_writeq_admit (queue, objc, objv);
+
+			if (throttle == 0) {
+				casstcl_writeq_send (queue, item, statement);
+				statement = NULL;
+			} else {
+				casstcl_writeq_append (&queue->waiting, item);
+				casstcl_writeq_schedule (queue, casstcl_now_ms (), throttle);
+			}
+		} else {
+			casstcl_writeq_append (&queue->waiting, item);
+		}
+		queue->queued++;
+	} else if (queue->journalObj != NULL) {
+		tclReturn = casstcl_writeq_spill (queue, writeObj);
+		if (tclReturn == TCL_OK) {
+			queue->queued++;
+
+			// if nothing is in flight, nothing else will read it back
+			casstcl_writeq_pump (queue);
+		}
+	} else {
+		Tcl_ResetResult (interp);
+		Tcl_SetErrorCode (interp, "CASSTCL", "WRITE_QUEUE_FULL", NULL);
+		Tcl_AppendResult (interp, "write queue is full", NULL);
+		tclReturn = TCL_ERROR;
+	}
+
+	if (statement != NULL) {
+		cass_statement_free (statement);
+	}
+	Tcl_DecrRefCount (writeObj);
+	return tclReturn;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_configure --
+ *
+ *    set the options of a write queue from a list of option value
+ *    pairs, or with none, set the interpreter result to a list of them.
+ *    nothing is changed if any of them are bad.
+ *
+ *    setting -journal counts the writes already in the file, which are
+ *    then replayed.  it can't be changed while writes are journaled.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_writeq_configure (casstcl_writeQueueClientData *queue, int objc, Tcl_Obj *CONST objv[])
+{
+	Tcl_Interp *interp = queue->ct->interp;
+	int maxInflight = queue->maxInflight;
+	Tcl_WideInt maxMemory = queue->maxMemory;
+	int retries = queue->retries;
+	int backoff = queue->backoff;
+	int maxBackoff = queue->maxBackoff;
+	CassConsistency consistency = queue->consistency;
+	Tcl_Obj *journalObj = queue->journalObj;
+	Tcl_Obj *failCallbackObj = queue->failCallbackObj;
+	Tcl_WideInt journaled = queue->journaled;
+	int arg;
+
+	static CONST char *subOptions[] = {
+		"-max_inflight",
+		"-max_memory",
+		"-retries",
+		"-backoff",
+		"-max_backoff",
+		"-consistency",
+		"-journal",
+		"-fail_callback",
+		NULL
+	};
+
+	enum subOptions {
+		SUBOPT_MAX_INFLIGHT,
+		SUBOPT_MAX_MEMORY,
+		SUBOPT_RETRIES,
+		SUBOPT_BACKOFF,
+		SUBOPT_MAX_BACKOFF,
+		SUBOPT_CONSISTENCY,
+		SUBOPT_JOURNAL,
+		SUBOPT_FAIL_CALLBACK
+	};
+
+	if (objc == 0) {
+		Tcl_Obj *listObj = Tcl_NewObj ();
+
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-max_inflight", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (queue->maxInflight));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-max_memory", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (queue->maxMemory));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-retries", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (queue->retries));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-backoff", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (queue->backoff));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-max_backoff", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (queue->maxBackoff));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-consistency", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, (queue->consistency == CASS_CONSISTENCY_UNKNOWN) ? Tcl_NewObj () : Tcl_NewStringObj (casstcl_cass_consistency_to_string (queue->consistency), -1));
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-journal", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, (queue->journalObj != NULL) ? queue->journalObj : Tcl_NewObj ());
+		Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("-fail_callback", -1));
+		Tcl_ListObjAppendElement (NULL, listObj, (queue->failCallbackObj != NULL) ? queue->failCallbackObj : Tcl_NewObj ());
+
+		Tcl_SetObjResult (interp, listObj);
+		return TCL_OK;
+	}
+
+	if (objc & 1) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "write queue options must be given as option value pairs", NULL);
+		return TCL_ERROR;
+	}
+
+	for (arg = 0; arg < objc; arg += 2) {
+		int subOptIndex;
+
+		if (Tcl_GetIndexFromObj (interp, objv[arg], subOptions, "subOption", TCL_EXACT, &subOptIndex) != TCL_OK) {
+			return TCL_ERROR;
+		}
+
+		switch ((enum subOptions) subOptIndex) {
+			case SUBOPT_MAX_INFLIGHT: {
+				if (Tcl_GetIntFromObj (interp, objv[arg + 1], &maxInflight) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting max_inflight", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_MAX_MEMORY: {
+				if (Tcl_GetWideIntFromObj (interp, objv[arg + 1], &maxMemory) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting max_memory", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_RETRIES: {
+				if (Tcl_GetIntFromObj (interp, objv[arg + 1], &retries) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting retries", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_BACKOFF: {
+				if (Tcl_GetIntFromObj (interp, objv[arg + 1], &backoff) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting backoff", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_MAX_BACKOFF: {
+				if (Tcl_GetIntFromObj (interp, objv[arg + 1], &maxBackoff) == TCL_ERROR) {
+					Tcl_AppendResult (interp, " while converting max_backoff", NULL);
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_CONSISTENCY: {
+				if (casstcl_obj_to_cass_consistency (queue->ct, objv[arg + 1], &consistency) == TCL_ERROR) {
+					return TCL_ERROR;
+				}
+				break;
+			}
+
+			case SUBOPT_JOURNAL: {
+				int length;
+
+				Tcl_GetStringFromObj (objv[arg + 1], &length);
+				journalObj = (length == 0) ? NULL : objv[arg + 1];
+				break;
+			}
+
+			case SUBOPT_FAIL_CALLBACK: {
+				int length;
+
+				Tcl_GetStringFromObj (objv[arg + 1], &length);
+				failCallbackObj = (length == 0) ? NULL : objv[arg + 1];
+				break;
+			}
+		}
+	}
+
+	if (maxInflight < 1) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "write queue -max_inflight must be at least 1", NULL);
+		return TCL_ERROR;
+	}
+
+	if (maxMemory < 0 || retries < 0 || backoff < 0 || maxBackoff < 0) {
+		Tcl_ResetResult (interp);
+		Tcl_AppendResult (interp, "write queue limits can't be negative", NULL);
+		return TCL_ERROR;
+	}
+
+	if (journalObj != queue->journalObj) {
+		if (queue->journaled > 0) {
+			Tcl_ResetResult (interp);
+			Tcl_AppendResult (interp, "can't change the journal of a write queue while writes are waiting in it", NULL);
+			return TCL_ERROR;
+		}
+
+		journaled = 0;
+		if (journalObj != NULL && casstcl_writeq_journal_count (interp, journalObj, &journaled) == TCL_ERROR) {
+			return TCL_ERROR;
+		}
+
+		if (queue->journalChannel != NULL) {
+			Tcl_Close (NULL, queue->journalChannel);
+			queue->journalChannel = NULL;
+		}
+
+		if (journalObj != NULL) {
+			Tcl_IncrRefCount (journalObj);
+		}
+		if (queue->journalObj != NULL) {
+			Tcl_DecrRefCount (queue->journalObj);
+		}
+		queue->journalObj = journalObj;
+		queue->journalOffset = 0;
+		queue->journaled = journaled;
+	}
+
+	queue->maxInflight = maxInflight;
+	queue->maxMemory = maxMemory;
+	queue->retries = retries;
+	queue->backoff = backoff;
+	queue->maxBackoff = maxBackoff;
+	queue->consistency = consistency;
+
+	if (failCallbackObj != queue->failCallbackObj) {
+		if (failCallbackObj != NULL) {
+			Tcl_IncrRefCount (failCallbackObj);
+		}
+		if (queue->failCallbackObj != NULL) {
+			Tcl_DecrRefCount (queue->failCallbackObj);
+		}
+		queue->failCallbackObj = failCallbackObj;
+	}
+
+	// a bigger limit or a journal to replay may mean there's more to send
+	casstcl_writeq_pump (queue);
+	Tcl_ResetResult (interp);
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_shutdown --
+ *
+ *    stop a write queue, which is about to be deleted.  if it has a
+ *    journal, every write that isn't known to be written is saved in
+ *    it to be replayed the next time it's used.  otherwise, or if that
+ *    fails, the writes that haven't been sent are sent one last time,
+ *    fire-and-forget.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_writeq_shutdown (casstcl_writeQueueClientData *queue)
+{
+	casstcl_sessionClientData *ct = queue->ct;
+	casstcl_writeQueueList *lists[2] = {&queue->retrying, &queue->waiting};
+	int tclReturn = TCL_OK;
+	int i;
+
+	if (queue->shutDown) {
+		return TCL_OK;
+	}
+	queue->shutDown = 1;
+
+	if (queue->timer != NULL) {
+		Tcl_DeleteTimerHandler (queue->timer);
+		queue->timer = NULL;
+	}
+
+	if (queue->journalObj != NULL) {
+		tclReturn = casstcl_writeq_journal_all (queue);
+	}
+
+	for (i = 0; i < 2; i++) {
+		casstcl_writeQueueItem *item;
+
+		while ((item = lists[i]->head) != NULL) {
+			casstcl_writeq_remove (lists[i], item);
+
+			if (queue->journalObj == NULL || tclReturn == TCL_ERROR) {
+				CassStatement *statement = NULL;
+				Tcl_Obj **objv;
+				int objc;
+
+				if (Tcl_ListObjGetElements (NULL, item->writeObj, &objc, &objv) == TCL_OK && casstcl_writeq_statement (queue, objc, objv, &statement) == TCL_OK) {
+					casstcl_fireforget (ct, cass_session_execute (ct->session, statement), CASSTCL_FUTURE_FIRE_AND_FORGET);
+					cass_statement_free (statement);
+				}
+			}
+			casstcl_writeq_free_item (item);
+		}
+	}
+
+	if (queue->journalChannel != NULL) {
+		Tcl_Close (NULL, queue->journalChannel);
+		queue->journalChannel = NULL;
+	}
+
+	return tclReturn;
+}
+
+/*
+ *--------------------------------------------------------------
+ *
+ *   casstcl_writeq_command_to_writeQueueClientData -- given a write
+ *   queue command name, find it in the interpreter and return a pointer
+ *   to its client data or NULL
+ *
+ *--------------------------------------------------------------
+ */
+casstcl_writeQueueClientData *
+casstcl_writeq_command_to_writeQueueClientData (Tcl_Interp *interp, char *queueCommandName)
+{
+	Tcl_CmdInfo queueCmdInfo;
+
+	if (!Tcl_GetCommandInfo (interp, queueCommandName, &queueCmdInfo)) {
+		return NULL;
+	}
+
+	casstcl_writeQueueClientData *queue = (casstcl_writeQueueClientData *)queueCmdInfo.objClientData;
+	if (queue == NULL || queueCmdInfo.objProc != casstcl_writeQueueObjectObjCmd || queue->cass_write_queue_magic != CASS_WRITE_QUEUE_MAGIC) {
+		return NULL;
+	}
+
+	return queue;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_createWriteQueueObjectCommand --
+ *
+ *    given a casstcl_sessionClientData pointer and an object name (or
+ *    "#auto"), create a write queue object command
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_createWriteQueueObjectCommand (casstcl_sessionClientData *ct, char *commandName)
+{
+	casstcl_writeQueueClientData *queue = (casstcl_writeQueueClientData *)ckalloc (sizeof (casstcl_writeQueueClientData));
+	Tcl_Interp *interp = ct->interp;
+	Tcl_HashEntry *entry;
+	int isNew;
+
+	memset (queue, 0, sizeof (casstcl_writeQueueClientData));
+	queue->cass_write_queue_magic = CASS_WRITE_QUEUE_MAGIC;
+	queue->ct = ct;
+	queue->maxInflight = CASSTCL_DEFAULT_WRITE_QUEUE_MAX_INFLIGHT;
+	queue->maxMemory = CASSTCL_DEFAULT_WRITE_QUEUE_MAX_MEMORY;
+	queue->retries = CASSTCL_DEFAULT_WRITE_QUEUE_RETRIES;
+	queue->backoff = CASSTCL_DEFAULT_WRITE_QUEUE_BACKOFF;
+	queue->maxBackoff = CASSTCL_DEFAULT_WRITE_QUEUE_MAX_BACKOFF;
+	queue->consistency = CASS_CONSISTENCY_UNKNOWN;
+	queue->jitterSeed = (unsigned long)casstcl_now_us ();
+
+#define WRITE_QUEUE_STRING_FORMAT "writequeue%lu"
+	// if commandName is #auto, generate a unique name for the object
+	int autoGeneratedName = 0;
+	if (strcmp (commandName, "#auto") == 0) {
+		static unsigned long nextAutoCounter = 0;
+		int baseNameLength = snprintf (NULL, 0, WRITE_QUEUE_STRING_FORMAT, nextAutoCounter) + 1;
+		commandName = ckalloc (baseNameLength);
+		snprintf (commandName, baseNameLength, WRITE_QUEUE_STRING_FORMAT, nextAutoCounter++);
+		autoGeneratedName = 1;
+	}
+
+	// create a Tcl command to interface to the write queue
+	queue->cmdToken = Tcl_CreateObjCommand (interp, commandName, casstcl_writeQueueObjectObjCmd, queue, casstcl_writeQueueObjectDelete);
+	// set the full name to the command in the interpreter result
+	Tcl_GetCommandFullName(interp, queue->cmdToken, Tcl_GetObjResult (interp));
+	if (autoGeneratedName == 1) {
+		ckfree(commandName);
+	}
+
+	// the session shuts down and deletes its queues when it goes
+	entry = Tcl_CreateHashEntry (&ct->writeQueueObjectTable, (char *)queue, &isNew);
+	Tcl_SetHashValue (entry, queue);
+
+	return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeQueueObjectObjCmd --
+ *
+ *    dispatches the subcommands of a casstcl write queue command
+ *
+ * Results:
+ *    stuff
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_writeQueueObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[])
+{
+	int optIndex;
+	casstcl_writeQueueClientData *queue = (casstcl_writeQueueClientData *)cData;
+
+	static CONST char *options[] = {
+		"upsert",
+		"pending",
+		"configure",
+		"stats",
+		"delete",
+		NULL
+	};
+
+	enum options {
+		OPT_UPSERT,
+		OPT_PENDING,
+		OPT_CONFIGURE,
+		OPT_STATS,
+		OPT_DELETE
+	};
+
+	/* basic validation of command line arguments */
+	if (objc < 2) {
+		Tcl_WrongNumArgs (interp, 1, objv, "subcommand ?args?");
+		return TCL_ERROR;
+	}
+
+	if (Tcl_GetIndexFromObj (interp, objv[1], options, "option", TCL_EXACT, &optIndex) != TCL_OK) {
+		return TCL_ERROR;
+	}
+
+	switch ((enum options) optIndex) {
+		case OPT_UPSERT: {
+			if (objc < 4) {
+				Tcl_WrongNumArgs (interp, 2, objv, "?-mapunknown columnName? ?-nocomplain? ?-ifnotexists? keyspace.tableName keyValuePairList");
+				return TCL_ERROR;
+			}
+
+			return casstcl_writeq_upsert (queue, objc - 2, &objv[2]);
+		}
+
+		// pending - how many writes haven't been written yet
+		case OPT_PENDING: {
+			if (objc != 2) {
+				Tcl_WrongNumArgs (interp, 2, objv, "");
+				return TCL_ERROR;
+			}
+
+			Tcl_SetObjResult (interp, Tcl_NewWideIntObj (queue->waiting.count + queue->inflight.count + queue->retrying.count + queue->journaled));
+			break;
+		}
+
+		case OPT_CONFIGURE: {
+			return casstcl_writeq_configure (queue, objc - 2, &objv[2]);
+		}
+
+		case OPT_STATS: {
+			Tcl_Obj *listObj = Tcl_NewObj ();
+
+			if (objc != 2) {
+				Tcl_WrongNumArgs (interp, 2, objv, "");
+				return TCL_ERROR;
+			}
+
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("queued", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (queue->queued));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("written", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (queue->written));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("retried", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (queue->retried));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("failed", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (queue->failed));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("spilled", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (queue->spilled));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("replayed", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (queue->replayed));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("waiting", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (queue->waiting.count));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("inflight", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (queue->inflight.count));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("retrying", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewIntObj (queue->retrying.count));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("journaled", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (queue->journaled));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewStringObj ("memory", -1));
+			Tcl_ListObjAppendElement (NULL, listObj, Tcl_NewWideIntObj (queue->memory));
+			Tcl_SetObjResult (interp, listObj);
+			break;
+		}
+
+		// delete - save or send what hasn't been written and delete
+		// the queue
+		case OPT_DELETE: {
+			Tcl_Obj *resultObj;
+			int tclReturn;
+
+			if (objc != 2) {
+				Tcl_WrongNumArgs (interp, 2, objv, "");
+				return TCL_ERROR;
+			}
+
+			tclReturn = casstcl_writeq_shutdown (queue);
+			resultObj = Tcl_GetObjResult (interp);
+			Tcl_IncrRefCount (resultObj);
+
+			Tcl_DeleteCommandFromToken (interp, queue->cmdToken);
+
+			if (tclReturn == TCL_ERROR) {
+				Tcl_SetObjResult (interp, resultObj);
+			} else {
+				Tcl_ResetResult (interp);
+			}
+			Tcl_DecrRefCount (resultObj);
+			return tclReturn;
+		}
+	}
+
+	return TCL_OK;
+}
+
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_writeQueueObjectDelete -- command deletion callback routine.
+ *
+ * Results:
+ *      ...shuts the write queue down, if the delete method didn't.
+ *         if saving the writes in the journal fails, a Tcl background
+ *         exception is invoked.
+ *      ...destroys the write queue object.
+ *      ...frees memory once the last write in flight completes.
+ *
+ * Side effects:
+ *      None.
+ *
+ *--------------------------------------------------------------
+ */
+void
+casstcl_writeQueueObjectDelete (ClientData clientData)
+{
+	casstcl_writeQueueClientData *queue = (casstcl_writeQueueClientData *)clientData;
+	casstcl_sessionClientData *ct = queue->ct;
+	Tcl_HashEntry *entry;
+
+	assert (queue->cass_write_queue_magic == CASS_WRITE_QUEUE_MAGIC);
+
+	// don't disturb the result of whatever deleted the command
+	if (!queue->shutDown) {
+		Tcl_InterpState state = Tcl_SaveInterpState (ct->interp, TCL_OK);
+
+		if (casstcl_writeq_shutdown (queue) == TCL_ERROR && !Tcl_InterpDeleted (ct->interp)) {
+			Tcl_BackgroundError (ct->interp);
+		}
+		Tcl_RestoreInterpState (ct->interp, state);
+	}
+
+	if (queue->journalObj != NULL) {
+		Tcl_DecrRefCount (queue->journalObj);
+		queue->journalObj = NULL;
+	}
+	if (queue->failCallbackObj != NULL) {
+		Tcl_DecrRefCount (queue->failCallbackObj);
+		queue->failCallbackObj = NULL;
+	}
+
+	entry = Tcl_FindHashEntry (&ct->writeQueueObjectTable, (char *)queue);
+	if (entry != NULL) {
+		Tcl_DeleteHashEntry (entry);
+	}
+
+	// writes still in flight have the queue preserved
+	Tcl_EventuallyFree (clientData, TCL_DYNAMIC);
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_delete_all --
+ *
+ *    shut down and delete all of a session's write queues.  used when
+ *    the session is deleted.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_writeq_delete_all (casstcl_sessionClientData *ct)
+{
+	Tcl_HashSearch search;
+	Tcl_HashEntry *entry;
+
+	while ((entry = Tcl_FirstHashEntry (&ct->writeQueueObjectTable, &search)) != NULL) {
+		casstcl_writeQueueClientData *queue = (casstcl_writeQueueClientData *)Tcl_GetHashValue (entry);
+
+		Tcl_DeleteHashEntry (entry);
+		Tcl_DeleteCommandFromToken (ct->interp, queue->cmdToken);
+	}
+}
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
@@ -0,0 +1,150 @@
+/*
+ *
+ * Include file for casstcl_writeq
+ *
+ * Copyright (C) 2015 by FlightAware, All Rights Reserved
+ *
+ * Freely redistributable under the Berkeley copyright, see license.terms
+ * for details.
+ */
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_upsert --
+ *
+ *    queue an upsert.  objv holds the upsert arguments, ?-mapunknown
+ *    columnName? ?-nocomplain? ?-ifnotexists? table keyValuePairList.
+ *
+ *    the statement is made right away, so a write that can't be made
+ *    into one is an error here.  if the queue has room in flight and
+ *    nothing is waiting ahead of it the write is sent, otherwise it
+ *    waits its turn.  if it doesn't fit in -max_memory, or writes are
+ *    already in the journal, it goes to the journal, so writes are
+ *    always sent in the order they were queued (retries aside).
+ *
+ * Results:
+ *    A standard Tcl result.  Without a journal, a write that doesn't
+ *    fit is an error with an errorCode of CASSTCL WRITE_QUEUE_FULL.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_writeq_upsert (casstcl_writeQueueClientData *queue, int objc, Tcl_Obj *CONST objv[]);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_configure --
+ *
+ *    set the options of a write queue from a list of option value
+ *    pairs, or with none, set the interpreter result to a list of them.
+ *    nothing is changed if any of them are bad.
+ *
+ *    setting -journal counts the writes already in the file, which are
+ *    then replayed.  it can't be changed while writes are journaled.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_writeq_configure (casstcl_writeQueueClientData *queue, int objc, Tcl_Obj *CONST objv[]);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_shutdown --
+ *
+ *    stop a write queue, which is about to be deleted.  if it has a
+ *    journal, every write that isn't known to be written is saved in
+ *    it to be replayed the next time it's used.  otherwise, or if that
+ *    fails, the writes that haven't been sent are sent one last time,
+ *    fire-and-forget.
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_writeq_shutdown (casstcl_writeQueueClientData *queue);
+
+/*
+ *--------------------------------------------------------------
+ *
+ *   casstcl_writeq_command_to_writeQueueClientData -- given a write
+ *   queue command name, find it in the interpreter and return a pointer
+ *   to its client data or NULL
+ *
+ *--------------------------------------------------------------
+ */
+casstcl_writeQueueClientData *
+casstcl_writeq_command_to_writeQueueClientData (Tcl_Interp *interp, char *queueCommandName);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_createWriteQueueObjectCommand --
+ *
+ *    given a casstcl_sessionClientData pointer and an object name (or
+ *    "#auto"), create a write queue object command
+ *
+ * Results:
+ *    A standard Tcl result
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_createWriteQueueObjectCommand (casstcl_sessionClientData *ct, char *commandName);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeQueueObjectObjCmd --
+ *
+ *    dispatches the subcommands of a casstcl write queue command
+ *
+ * Results:
+ *    stuff
+ *
+ *----------------------------------------------------------------------
+ */
+int
+casstcl_writeQueueObjectObjCmd(ClientData cData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST objv[]);
+
+/*
+ *--------------------------------------------------------------
+ *
+ * casstcl_writeQueueObjectDelete -- command deletion callback routine.
+ *
+ * Results:
+ *      ...shuts the write queue down, if the delete method didn't.
+ *         if saving the writes in the journal fails, a Tcl background
+ *         exception is invoked.
+ *      ...destroys the write queue object.
+ *      ...frees memory once the last write in flight completes.
+ *
+ * Side effects:
+ *      None.
+ *
+ *--------------------------------------------------------------
+ */
+void
+casstcl_writeQueueObjectDelete (ClientData clientData);
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * casstcl_writeq_delete_all --
+ *
+ *    shut down and delete all of a session's write queues.  used when
+ *    the session is deleted.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+casstcl_writeq_delete_all (casstcl_sessionClientData *ct);
+
+/* vim: set ts=4 sw=4 sts=4 noet : */
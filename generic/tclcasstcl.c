@@ -10,6 +10,7 @@
 #include <tcl.h>
 #include <tclTomMath.h>
 #include "casstcl.h"
+#include "casstcl_coro.h"
 
 #undef TCL_STORAGE_CLASS
 #define TCL_STORAGE_CLASS DLLEXPORT
@@ -57,13 +58,29 @@ Casstcl_Init(Tcl_Interp *interp)
 		return TCL_ERROR;
     }
 
+	/* coroutine support needs the NRE API, which arrived with 8.6 */
+	{
+		int major, minor;
+
+		Tcl_GetVersion (&major, &minor, NULL, NULL);
+		casstcl_haveNRE = (major > 8) || (major == 8 && minor >= 6);
+	}
+
 	Tcl_RegisterObjType(&casstcl_cassTypeTclType);
+	Tcl_RegisterObjType(&casstcl_futureHandleTclType);
 
     namespace = Tcl_CreateNamespace (interp, "::casstcl", NULL, NULL);
 
     /* Create the create command  */
     Tcl_CreateObjCommand(interp, "::casstcl::cass", (Tcl_ObjCmdProc *) casstcl_cassObjCmd, (ClientData)NULL, (Tcl_CmdDeleteProc *)NULL);
 
+    /* Create the command for operating on future handles */
+    casstcl_create_nr_command(interp, "::casstcl::future", (Tcl_ObjCmdProc *) casstcl_futureHandleObjCmd, (Tcl_ObjCmdProc *) casstcl_futureHandleNRObjCmd, (ClientData)NULL, (Tcl_CmdDeleteProc *)NULL);
+
+    /* Create the commands for waiting on sets of futures */
+    Tcl_CreateObjCommand(interp, "::casstcl::wait_all", (Tcl_ObjCmdProc *) casstcl_waitAllObjCmd, (ClientData)NULL, (Tcl_CmdDeleteProc *)NULL);
+    Tcl_CreateObjCommand(interp, "::casstcl::wait_any", (Tcl_ObjCmdProc *) casstcl_waitAnyObjCmd, (ClientData)NULL, (Tcl_CmdDeleteProc *)NULL);
+
     Tcl_Export (interp, namespace, "*", 0);
 
     return TCL_OK;